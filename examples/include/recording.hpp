@@ -0,0 +1,493 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef RECORDING_HPP
+#define RECORDING_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace sl_oc {
+namespace tools {
+
+// ----> Recording layout
+// A recording is a directory containing:
+//  * `left/<timestamp>.png` and `right/<timestamp>.png`: the stereo images, named by timestamp in nanoseconds
+//  * `imu.csv` (optional): the IMU samples, one per line, starting with the timestamp in nanoseconds
+//  * `index.zoci`: the sidecar index created by \ref RecordingIndex
+static const char REC_LEFT_DIR[] = "left";
+static const char REC_RIGHT_DIR[] = "right";
+static const char REC_IMU_FILE[] = "imu.csv";
+static const char REC_INDEX_FILE[] = "index.zoci";
+static const char REC_IMU_CSV_HEADER[] = "#timestamp [ns],aX [m/s^2],aY [m/s^2],aZ [m/s^2],gX [deg/s],gY [deg/s],gZ [deg/s],temp [C],sync";
+// <---- Recording layout
+
+static const uint32_t REC_INDEX_MAGIC = 0x49434F5A;   //!< "ZOCI" marker at the beginning of the index
+static const uint32_t REC_INDEX_VERSION = 1;          //!< Version of the index layout
+
+/*!
+ * \brief Header of the index file. It is followed by `frame_count` \ref RecFrameEntry and by `imu_count`
+ *        \ref RecImuEntry, both sorted by timestamp
+ */
+struct RecIndexHeader
+{
+    uint32_t magic;             //!< Must be equal to \ref REC_INDEX_MAGIC
+    uint32_t version;           //!< Must be equal to \ref REC_INDEX_VERSION
+    uint64_t frame_count;       //!< Number of frame entries
+    uint64_t imu_count;         //!< Number of IMU entries
+    uint64_t imu_file_size;     //!< Size of `imu.csv` when the index was built
+    int64_t left_dir_mtime;     //!< Modification time of the `left` folder when the index was built [nsec]
+    int64_t right_dir_mtime;    //!< Modification time of the `right` folder when the index was built [nsec]
+    uint64_t reserved[2];       //!< Reserved, must be zero
+};
+
+/*!
+ * \brief Flags of a frame entry
+ */
+enum REC_FRAME_FLAGS {
+    REC_FRAME_LEFT = 0x01,      //!< The left image is available
+    REC_FRAME_RIGHT = 0x02      //!< The right image is available
+};
+
+/*!
+ * \brief Index entry of a stereo frame
+ */
+struct RecFrameEntry
+{
+    uint64_t timestamp;         //!< Frame timestamp in nanoseconds, used as file name
+    uint32_t flags;             //!< Available images, see \ref REC_FRAME_FLAGS
+    uint32_t reserved;          //!< Reserved, must be zero
+};
+
+/*!
+ * \brief Index entry of an IMU sample
+ */
+struct RecImuEntry
+{
+    uint64_t timestamp;         //!< Sample timestamp in nanoseconds
+    uint64_t offset;            //!< Offset of the sample line in `imu.csv`
+};
+
+/*!
+ * \brief The RecordingIndex class builds, repairs and maps the sidecar index of a recording.
+ *
+ * The index is memory mapped and searched by binary search, so the lookup of a time range does not depend
+ * on the number of files in the recording and does not access the file system.
+ */
+class RecordingIndex
+{
+public:
+    RecordingIndex() {}
+    virtual ~RecordingIndex() {close();}
+
+    /*!
+     * \brief Map the index of a recording. The index is built if missing, or rebuilt if the recording has been
+     *        modified after its creation (new or deleted images, longer IMU file)
+     * \param rec_dir the recording folder
+     * \param force_rebuild rebuild the index even if it is up to date
+     * \return true if the index is available
+     */
+    bool open(const std::string& rec_dir, bool force_rebuild=false)
+    {
+        close();
+        mRecDir = rec_dir;
+
+        if( force_rebuild || !mapIndex() )
+        {
+            close();
+            mRecDir = rec_dir;
+            if( !build(rec_dir) || !mapIndex() )
+            {
+                close();
+                return false;
+            }
+        }
+
+        mapImuFile();
+        return true;
+    }
+
+    /*!
+     * \brief Unmap the index and the IMU file
+     */
+    void close()
+    {
+        if(mIndexMap) munmap(mIndexMap, mIndexSize);
+        if(mImuMap) munmap(mImuMap, mImuSize);
+        mIndexMap = nullptr;
+        mIndexSize = 0;
+        mImuMap = nullptr;
+        mImuSize = 0;
+        mHeader = nullptr;
+        mFrames = nullptr;
+        mImu = nullptr;
+    }
+
+    /*!
+     * \brief Scan a recording and write its index file
+     * \param rec_dir the recording folder
+     * \return true if the index has been written
+     */
+    static bool build(const std::string& rec_dir)
+    {
+        namespace fs = std::filesystem;
+
+        RecIndexHeader hdr;
+        memset(&hdr, 0, sizeof(RecIndexHeader));
+        hdr.magic = REC_INDEX_MAGIC;
+        hdr.version = REC_INDEX_VERSION;
+
+        // ----> Frames
+        std::vector<RecFrameEntry> frames;
+        const char* dirs[2] = {REC_LEFT_DIR, REC_RIGHT_DIR};
+        const uint32_t flags[2] = {REC_FRAME_LEFT, REC_FRAME_RIGHT};
+        for( int s=0; s<2; s++ )
+        {
+            fs::path dir = fs::path(rec_dir) / dirs[s];
+            std::error_code ec;
+            if( !fs::is_directory(dir, ec) )
+                continue;
+
+            for( const auto& f : fs::directory_iterator(dir, ec) )
+            {
+                uint64_t ts;
+                if( f.path().extension()!=".png" || !parseTimestamp(f.path().stem().string(), ts) )
+                    continue;
+
+                RecFrameEntry e;
+                e.timestamp = ts;
+                e.flags = flags[s];
+                e.reserved = 0;
+                frames.push_back(e);
+            }
+        }
+
+        std::sort(frames.begin(), frames.end(),
+                  [](const RecFrameEntry& a, const RecFrameEntry& b){return a.timestamp<b.timestamp;});
+
+        // Merge the left and right entries with the same timestamp
+        size_t n = 0;
+        for( size_t i=0; i<frames.size(); i++ )
+        {
+            if( n>0 && frames[n-1].timestamp==frames[i].timestamp )
+                frames[n-1].flags |= frames[i].flags;
+            else
+                frames[n++] = frames[i];
+        }
+        frames.resize(n);
+
+        hdr.left_dir_mtime = dirMTime(rec_dir, REC_LEFT_DIR);
+        hdr.right_dir_mtime = dirMTime(rec_dir, REC_RIGHT_DIR);
+        // <---- Frames
+
+        // ----> IMU
+        std::vector<RecImuEntry> imu;
+        std::string imu_path = (fs::path(rec_dir) / REC_IMU_FILE).string();
+        int fd = ::open(imu_path.c_str(), O_RDONLY);
+        if( fd>=0 )
+        {
+            struct stat st;
+            if( fstat(fd, &st)==0 && st.st_size>0 )
+            {
+                size_t size = st.st_size;
+                const char* data = static_cast<const char*>(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+                if( data!=MAP_FAILED )
+                {
+                    madvise(const_cast<char*>(data), size, MADV_SEQUENTIAL);
+
+                    size_t pos = 0;
+                    while( pos<size )
+                    {
+                        const char* eol = static_cast<const char*>(memchr(data+pos, '\n', size-pos));
+                        size_t end = eol ? (eol-data) : size;
+
+                        // The last line is indexed only when complete, the recording could be in progress
+                        uint64_t ts;
+                        if( eol && data[pos]!='#' && parseTimestamp(std::string(data+pos, std::min<size_t>(end-pos,24)), ts) )
+                        {
+                            RecImuEntry e;
+                            e.timestamp = ts;
+                            e.offset = pos;
+                            imu.push_back(e);
+                        }
+
+                        if(!eol)
+                            break;
+                        pos = end+1;
+                        hdr.imu_file_size = pos;
+                    }
+                    munmap(const_cast<char*>(data), size);
+
+                    std::stable_sort(imu.begin(), imu.end(),
+                                     [](const RecImuEntry& a, const RecImuEntry& b){return a.timestamp<b.timestamp;});
+                }
+            }
+            ::close(fd);
+        }
+        // <---- IMU
+
+        hdr.frame_count = frames.size();
+        hdr.imu_count = imu.size();
+
+        // ----> Write the index
+        // Written to a temporary file and renamed, so that a reader never maps a partial index
+        std::string idx_path = (fs::path(rec_dir) / REC_INDEX_FILE).string();
+        std::string tmp_path = idx_path + ".tmp";
+        std::ofstream out(tmp_path, std::ios::binary|std::ios::trunc);
+        if( !out.is_open() )
+        {
+            std::cerr << "Cannot write the index file: " << tmp_path << std::endl;
+            return false;
+        }
+
+        out.write(reinterpret_cast<const char*>(&hdr), sizeof(RecIndexHeader));
+        out.write(reinterpret_cast<const char*>(frames.data()), frames.size()*sizeof(RecFrameEntry));
+        out.write(reinterpret_cast<const char*>(imu.data()), imu.size()*sizeof(RecImuEntry));
+        out.close();
+
+        if( !out || rename(tmp_path.c_str(), idx_path.c_str())!=0 )
+        {
+            std::cerr << "Cannot write the index file: " << idx_path << std::endl;
+            unlink(tmp_path.c_str());
+            return false;
+        }
+        // <---- Write the index
+
+        return true;
+    }
+
+    /*!
+     * \brief Find the frames in a time range
+     * \param t_start first timestamp of the range [nsec]
+     * \param t_end last timestamp of the range, included [nsec]
+     * \param first index of the first frame in the range
+     * \param last index following the last frame in the range
+     */
+    void findFrames(uint64_t t_start, uint64_t t_end, size_t& first, size_t& last) const
+    {
+        const RecFrameEntry* end = mFrames+frameCount();
+        auto cmp_lo = [](const RecFrameEntry& e, uint64_t t){return e.timestamp<t;};
+        auto cmp_hi = [](uint64_t t, const RecFrameEntry& e){return t<e.timestamp;};
+        first = std::lower_bound(mFrames, end, t_start, cmp_lo) - mFrames;
+        last = std::max(first, static_cast<size_t>(std::upper_bound(mFrames, end, t_end, cmp_hi) - mFrames));
+    }
+
+    /*!
+     * \brief Find the IMU samples in a time range
+     * \param t_start first timestamp of the range [nsec]
+     * \param t_end last timestamp of the range, included [nsec]
+     * \param first index of the first sample in the range
+     * \param last index following the last sample in the range
+     */
+    void findImu(uint64_t t_start, uint64_t t_end, size_t& first, size_t& last) const
+    {
+        const RecImuEntry* end = mImu+imuCount();
+        auto cmp_lo = [](const RecImuEntry& e, uint64_t t){return e.timestamp<t;};
+        auto cmp_hi = [](uint64_t t, const RecImuEntry& e){return t<e.timestamp;};
+        first = std::lower_bound(mImu, end, t_start, cmp_lo) - mImu;
+        last = std::max(first, static_cast<size_t>(std::upper_bound(mImu, end, t_end, cmp_hi) - mImu));
+    }
+
+    /*!
+     * \brief Get the text of an IMU sample, directly from the mapped `imu.csv`
+     * \param idx index of the sample
+     * \return the line of the sample, without the line terminator
+     */
+    std::string imuLine(size_t idx) const
+    {
+        if( idx>=imuCount() || mImuMap==nullptr || mImu[idx].offset>=mImuSize )
+            return std::string();
+
+        const char* start = static_cast<const char*>(mImuMap) + mImu[idx].offset;
+        size_t avail = mImuSize - mImu[idx].offset;
+        const char* eol = static_cast<const char*>(memchr(start, '\n', avail));
+        return std::string(start, eol ? (eol-start) : avail);
+    }
+
+    /*!
+     * \brief Get the path of an image
+     * \param idx index of the frame
+     * \param left true for the left image, false for the right image
+     * \return the path of the image
+     */
+    std::string imagePath(size_t idx, bool left) const
+    {
+        return (std::filesystem::path(mRecDir) / (left?REC_LEFT_DIR:REC_RIGHT_DIR) /
+                (std::to_string(mFrames[idx].timestamp) + ".png")).string();
+    }
+
+    inline size_t frameCount() const {return mHeader?mHeader->frame_count:0;}   //!< Number of indexed frames
+    inline size_t imuCount() const {return mHeader?mHeader->imu_count:0;}       //!< Number of indexed IMU samples
+    inline const RecFrameEntry& frame(size_t idx) const {return mFrames[idx];}  //!< Frame entry
+    inline const RecImuEntry& imu(size_t idx) const {return mImu[idx];}         //!< IMU entry
+    inline const std::string& recordingDir() const {return mRecDir;}            //!< Recording folder
+
+    /*!
+     * \brief Parse a timestamp in nanoseconds from the beginning of a string
+     * \param str the string
+     * \param ts the parsed timestamp
+     * \return true if the string starts with a valid timestamp
+     */
+    static bool parseTimestamp(const std::string& str, uint64_t& ts)
+    {
+        ts = 0;
+        size_t i = 0;
+        for( ; i<str.size() && str[i]>='0' && str[i]<='9'; i++ )
+            ts = ts*10 + (str[i]-'0');
+        return i>0 && (i==str.size() || str[i]==',' || str[i]=='.' || str[i]==' ');
+    }
+
+private:
+    static int64_t dirMTime(const std::string& rec_dir, const char* sub)
+    {
+        struct stat st;
+        std::string path = (std::filesystem::path(rec_dir) / sub).string();
+        if( stat(path.c_str(), &st)!=0 )
+            return 0;
+        return static_cast<int64_t>(st.st_mtim.tv_sec)*1000000000LL + st.st_mtim.tv_nsec;
+    }
+
+    // Map the index file and check that it matches the recording
+    bool mapIndex()
+    {
+        std::string idx_path = (std::filesystem::path(mRecDir) / REC_INDEX_FILE).string();
+        int fd = ::open(idx_path.c_str(), O_RDONLY);
+        if( fd<0 )
+            return false;
+
+        struct stat st;
+        if( fstat(fd, &st)!=0 || static_cast<size_t>(st.st_size)<sizeof(RecIndexHeader) )
+        {
+            ::close(fd);
+            return false;
+        }
+
+        mIndexSize = st.st_size;
+        mIndexMap = mmap(nullptr, mIndexSize, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if( mIndexMap==MAP_FAILED )
+        {
+            mIndexMap = nullptr;
+            return false;
+        }
+
+        mHeader = static_cast<const RecIndexHeader*>(mIndexMap);
+        if( mHeader->magic!=REC_INDEX_MAGIC || mHeader->version!=REC_INDEX_VERSION ||
+                mIndexSize != sizeof(RecIndexHeader) + mHeader->frame_count*sizeof(RecFrameEntry) +
+                mHeader->imu_count*sizeof(RecImuEntry) )
+            return false;
+
+        mFrames = reinterpret_cast<const RecFrameEntry*>(mHeader+1);
+        mImu = reinterpret_cast<const RecImuEntry*>(mFrames+mHeader->frame_count);
+
+        // ----> Check if the index is stale
+        if( mHeader->left_dir_mtime!=dirMTime(mRecDir, REC_LEFT_DIR) ||
+                mHeader->right_dir_mtime!=dirMTime(mRecDir, REC_RIGHT_DIR) )
+            return false;
+
+        if( hasNewImuLines(mHeader->imu_file_size) )
+            return false;
+        // <---- Check if the index is stale
+
+        return true;
+    }
+
+    // Check if `imu.csv` changed after the last indexed line. An incomplete last line is ignored: it is indexed
+    // when completed
+    bool hasNewImuLines(uint64_t indexed_size) const
+    {
+        std::string imu_path = (std::filesystem::path(mRecDir) / REC_IMU_FILE).string();
+        int fd = ::open(imu_path.c_str(), O_RDONLY);
+        if( fd<0 )
+            return indexed_size!=0;
+
+        struct stat st;
+        bool changed = true;
+        if( fstat(fd, &st)==0 && static_cast<uint64_t>(st.st_size)>=indexed_size )
+        {
+            changed = false;
+
+            char buf[4096];
+            uint64_t pos = indexed_size;
+            while( !changed && pos<static_cast<uint64_t>(st.st_size) )
+            {
+                ssize_t len = pread(fd, buf, sizeof(buf), pos);
+                if( len<=0 )
+                    break;
+                changed = (memchr(buf, '\n', len)!=nullptr);
+                pos += len;
+            }
+        }
+        ::close(fd);
+
+        return changed;
+    }
+
+    // Map `imu.csv` to read the samples lines
+    void mapImuFile()
+    {
+        std::string imu_path = (std::filesystem::path(mRecDir) / REC_IMU_FILE).string();
+        int fd = ::open(imu_path.c_str(), O_RDONLY);
+        if( fd<0 )
+            return;
+
+        struct stat st;
+        if( fstat(fd, &st)==0 && st.st_size>0 )
+        {
+            mImuSize = st.st_size;
+            mImuMap = mmap(nullptr, mImuSize, PROT_READ, MAP_SHARED, fd, 0);
+            if( mImuMap==MAP_FAILED )
+            {
+                mImuMap = nullptr;
+                mImuSize = 0;
+            }
+        }
+        ::close(fd);
+    }
+
+private:
+    std::string mRecDir;                        //!< Recording folder
+
+    void* mIndexMap=nullptr;                    //!< Mapped index file
+    size_t mIndexSize=0;                        //!< Size of the mapped index file
+    void* mImuMap=nullptr;                      //!< Mapped IMU file
+    size_t mImuSize=0;                          //!< Size of the mapped IMU file
+
+    const RecIndexHeader* mHeader=nullptr;      //!< Index header
+    const RecFrameEntry* mFrames=nullptr;       //!< Frame entries
+    const RecImuEntry* mImu=nullptr;            //!< IMU entries
+};
+
+} // namespace tools
+} // namespace sl_oc
+
+#endif // RECORDING_HPP
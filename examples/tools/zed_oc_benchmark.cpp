@@ -0,0 +1,561 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ----> Includes
+#include "videocapture.hpp"
+#include "mockvideodevice.hpp"
+#include "sensorcapture.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+// OpenCV includes
+#include <opencv2/opencv.hpp>
+// <---- Includes
+
+// ----> Benchmark results
+struct BenchStats
+{
+    size_t iterations = 0;  // Number of measures
+    double mean = 0.0;      // Mean duration [usec]
+    double p50 = 0.0;       // Median duration [usec]
+    double p99 = 0.0;       // 99th percentile of the duration [usec]
+    double max = 0.0;       // Maximum duration [usec]
+};
+
+struct BenchResult
+{
+    std::string name;                   // Benchmark name
+    std::string res;                    // Resolution name, empty if not relevant
+    int fps = 0;                        // Frame rate, 0 if not relevant
+    BenchStats stats;                   // Duration statistics
+    std::vector<std::pair<std::string,double>> extra; // Additional benchmark specific values
+};
+// <---- Benchmark results
+
+// ----> Functions
+void usage(const char* name);
+BenchStats computeStats(std::vector<double>& samples);
+bool isValid(sl_oc::video::RESOLUTION res, sl_oc::video::FPS fps);
+std::string resName(sl_oc::video::RESOLUTION res);
+void fillSynthetic(std::vector<uint8_t>& buf);
+void benchFrameCopy(sl_oc::video::RESOLUTION res, int iterations, std::vector<std::pair<std::string,BenchStats>>& stats);
+BenchStats benchColorConversion(sl_oc::video::RESOLUTION res, int iterations);
+BenchStats benchRemap(sl_oc::video::RESOLUTION res, int iterations);
+BenchResult benchImuDecode(int iterations);
+BenchResult benchHandoff(sl_oc::video::RESOLUTION res, sl_oc::video::FPS fps, double duration);
+std::string toJson(const std::vector<BenchResult>& results);
+// <---- Functions
+
+static const int IMU_BATCH = 100;       // IMU packets decoded for each measure
+
+// The main function
+int main(int argc, char *argv[])
+{
+    // ----> Parse the options
+    int iterations = 100;
+    double duration = 2.0;
+    bool capture = true;
+    std::string only;
+    std::string out_file;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::string opt = argv[i];
+        if(opt=="--iterations" && i+1<argc)
+            iterations = std::max(1, std::stoi(argv[++i]));
+        else if(opt=="--duration" && i+1<argc)
+            duration = std::max(0.1, std::stod(argv[++i]));
+        else if(opt=="--only" && i+1<argc)
+            only = std::string(",") + argv[++i] + ",";
+        else if(opt=="--no-capture")
+            capture = false;
+        else if(opt=="--output" && i+1<argc)
+            out_file = argv[++i];
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto enabled = [&only](const std::string& name) {
+        return only.empty() || only.find(","+name+",")!=std::string::npos;
+    };
+    // <---- Parse the options
+
+    std::vector<BenchResult> results;
+
+    // ----> Frame processing benchmarks, for each resolution
+    for(int r=0; r<static_cast<int>(sl_oc::video::RESOLUTION::LAST); r++)
+    {
+        sl_oc::video::RESOLUTION res = static_cast<sl_oc::video::RESOLUTION>(r);
+
+        std::vector<std::pair<std::string,BenchStats>> stats;
+        if(enabled("frame_copy"))
+        {
+            std::cerr << "frame_copy " << resName(res) << std::endl;
+            benchFrameCopy(res, iterations, stats);
+        }
+        if(enabled("yuv2bgr"))
+        {
+            std::cerr << "yuv2bgr " << resName(res) << std::endl;
+            stats.push_back(std::make_pair("yuv2bgr", benchColorConversion(res, iterations)));
+        }
+        if(enabled("remap"))
+        {
+            std::cerr << "remap " << resName(res) << std::endl;
+            stats.push_back(std::make_pair("remap", benchRemap(res, iterations)));
+        }
+
+        // The durations do not depend on the frame rate: the share of the frame period is reported for each one
+        for(const auto& s : stats)
+        {
+            for(int fps : {15,30,60,100})
+            {
+                if(!isValid(res, static_cast<sl_oc::video::FPS>(fps)))
+                    continue;
+
+                BenchResult result;
+                result.name = s.first;
+                result.res = resName(res);
+                result.fps = fps;
+                result.stats = s.second;
+                result.extra.push_back(std::make_pair("frame_budget_pct", s.second.mean*fps/1e4));
+                if(s.first.compare(0, 10, "frame_copy")==0)
+                {
+                    // Bytes written in the frame: a single image is half the side-by-side stream
+                    const sl_oc::video::Resolution& size = sl_oc::video::cameraResolution[r];
+                    double bytes = size.width*2*size.height*2;
+                    if(s.first=="frame_copy_left")
+                        bytes /= 2;
+                    result.extra.push_back(std::make_pair("throughput_gbytes_s", bytes/(s.second.mean*1e3)));
+                }
+                results.push_back(result);
+            }
+        }
+    }
+    // <---- Frame processing benchmarks, for each resolution
+
+    // ----> IMU decoding
+    if(enabled("imu_decode"))
+    {
+        std::cerr << "imu_decode" << std::endl;
+        results.push_back(benchImuDecode(iterations));
+    }
+    // <---- IMU decoding
+
+    // ----> Capture hand-off, for each resolution and frame rate, using the emulated camera
+    if(capture && enabled("handoff"))
+    {
+        for(int r=0; r<static_cast<int>(sl_oc::video::RESOLUTION::LAST); r++)
+        {
+            for(int fps : {15,30,60,100})
+            {
+                sl_oc::video::RESOLUTION res = static_cast<sl_oc::video::RESOLUTION>(r);
+                if(!isValid(res, static_cast<sl_oc::video::FPS>(fps)))
+                    continue;
+
+                std::cerr << "handoff " << resName(res) << "@" << fps << std::endl;
+                results.push_back(benchHandoff(res, static_cast<sl_oc::video::FPS>(fps), duration));
+            }
+        }
+    }
+    // <---- Capture hand-off, for each resolution and frame rate, using the emulated camera
+
+    // ----> Output
+    std::string json = toJson(results);
+    if(out_file.empty())
+    {
+        std::cout << json;
+    }
+    else
+    {
+        std::ofstream out(out_file);
+        out << json;
+        if(!out)
+        {
+            std::cerr << "Cannot write '" << out_file << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cerr << "Results saved in '" << out_file << "'" << std::endl;
+    }
+    // <---- Output
+
+    return EXIT_SUCCESS;
+}
+
+void usage(const char* name)
+{
+    std::cout << "Usage: " << name << " [options]" << std::endl;
+    std::cout << "Benchmarks of the capture path on synthetic data, for each resolution and frame rate." << std::endl;
+    std::cout << "The results are written in JSON format." << std::endl;
+    std::cout << " * frame_copy: copy of a frame from the mapped driver buffer by the grabbing thread, using an" << std::endl;
+    std::cout << "               emulated camera. Also measured with the luma statistics (frame_copy_stats), with a" << std::endl;
+    std::cout << "               tone curve (frame_copy_tone) and for the left image only (frame_copy_left)" << std::endl;
+    std::cout << " * yuv2bgr:    YUV 4:2:2 to BGR conversion of a side-by-side frame" << std::endl;
+    std::cout << " * remap:      rectification of a stereo pair" << std::endl;
+    std::cout << " * imu_decode: decoding of a sensor data packet (per packet)" << std::endl;
+    std::cout << " * handoff:    delay from the capture of a frame to its reception with `getLastFrame`, using an" << std::endl;
+    std::cout << "               emulated camera. It includes the emulated USB transfer (the synthetic frame drawing)" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "   --iterations <N>   number of measures of each micro benchmark [default: 100]" << std::endl;
+    std::cout << "   --duration <sec>   duration of each hand-off measure [default: 2]" << std::endl;
+    std::cout << "   --only <list>      comma separated list of the benchmarks to run" << std::endl;
+    std::cout << "   --no-capture       do not run the hand-off benchmarks" << std::endl;
+    std::cout << "   --output <file>    save the results in a file instead of the standard output" << std::endl;
+}
+
+BenchStats computeStats(std::vector<double>& samples)
+{
+    BenchStats stats;
+    if(samples.empty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0.0;
+    for(double s : samples)
+        sum += s;
+
+    stats.iterations = samples.size();
+    stats.mean = sum/samples.size();
+    stats.p50 = samples[samples.size()/2];
+    stats.p99 = samples[std::min(samples.size()-1, (samples.size()*99)/100)];
+    stats.max = samples.back();
+
+    return stats;
+}
+
+bool isValid(sl_oc::video::RESOLUTION res, sl_oc::video::FPS fps)
+{
+    // Same rules of `VideoCapture::checkResFps`
+    switch(res)
+    {
+    case sl_oc::video::RESOLUTION::HD2K:
+        return fps==sl_oc::video::FPS::FPS_15;
+    case sl_oc::video::RESOLUTION::HD1080:
+        return fps==sl_oc::video::FPS::FPS_15 || fps==sl_oc::video::FPS::FPS_30;
+    case sl_oc::video::RESOLUTION::HD720:
+        return fps!=sl_oc::video::FPS::FPS_100;
+    case sl_oc::video::RESOLUTION::VGA:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::string resName(sl_oc::video::RESOLUTION res)
+{
+    switch(res)
+    {
+    case sl_oc::video::RESOLUTION::HD2K: return "HD2K";
+    case sl_oc::video::RESOLUTION::HD1080: return "HD1080";
+    case sl_oc::video::RESOLUTION::HD720: return "HD720";
+    case sl_oc::video::RESOLUTION::VGA: return "VGA";
+    default: return "";
+    }
+}
+
+static inline double elapsedUsec(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-start).count();
+}
+
+void fillSynthetic(std::vector<uint8_t>& buf)
+{
+    uint32_t state = 0x12345678;
+    for(auto& b : buf)
+    {
+        // Linear congruential generator: no pattern that the compiler or the caches could exploit
+        state = state*1664525u + 1013904223u;
+        b = static_cast<uint8_t>(state>>24);
+    }
+}
+
+void benchFrameCopy(sl_oc::video::RESOLUTION res, int iterations, std::vector<std::pair<std::string,BenchStats>>& stats)
+{
+    // The copy of the grabbing thread is measured with the emulated camera, from its mapped driver buffers
+    for(sl_oc::video::CAPTURE_MODE mode : {sl_oc::video::CAPTURE_MODE::STEREO, sl_oc::video::CAPTURE_MODE::LEFT})
+    {
+        sl_oc::video::VideoParams params;
+        params.res = res;
+        params.fps = sl_oc::video::FPS::FPS_15;
+        params.capture_mode = mode;
+        params.verbose = sl_oc::VERBOSITY::ERROR;
+        params.device_io = std::make_shared<sl_oc::video::MockVideoDevice>();
+
+        sl_oc::video::VideoCapture cap(params);
+        if( !cap.initializeVideo(0) )
+        {
+            std::cerr << "Cannot open the emulated camera" << std::endl;
+            return;
+        }
+
+        // Wait for the first frame
+        for(int i=0; i<50 && cap.getLastFrame(100).frame_id==0; i++) {}
+
+        auto measure = [&](const std::string& name) {
+            cap.measureFrameCopy(); // Warm-up: the destination pages are mapped and the tone curve is activated
+
+            std::vector<double> samples;
+            for(int i=0; i<iterations; i++)
+            {
+                uint64_t elapsed = cap.measureFrameCopy();
+                if(elapsed==0)
+                {
+                    std::cerr << "No frame received from the emulated camera" << std::endl;
+                    break;
+                }
+                samples.push_back(static_cast<double>(elapsed)*1e-3);
+            }
+            stats.push_back(std::make_pair(name, computeStats(samples)));
+        };
+
+        if(mode==sl_oc::video::CAPTURE_MODE::LEFT)
+        {
+            measure("frame_copy_left");
+            continue;
+        }
+
+        measure("frame_copy");
+
+        if(cap.enableFrameStats())
+        {
+            measure("frame_copy_stats");
+            cap.disableFrameStats();
+        }
+
+        cap.setToneCurve(sl_oc::video::ToneCurve::gamma(2.2f));
+        measure("frame_copy_tone");
+        cap.disableToneCurve();
+    }
+}
+
+BenchStats benchColorConversion(sl_oc::video::RESOLUTION res, int iterations)
+{
+    const sl_oc::video::Resolution& size = sl_oc::video::cameraResolution[static_cast<int>(res)];
+
+    std::vector<uint8_t> data(size.width*2*size.height*2);
+    fillSynthetic(data);
+
+    cv::Mat frameYUV(size.height, size.width*2, CV_8UC2, data.data());
+    cv::Mat frameBGR;
+    cv::cvtColor(frameYUV,frameBGR,cv::COLOR_YUV2BGR_YUYV); // Warm-up: the output is allocated
+
+    std::vector<double> samples;
+    for(int i=0; i<iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        cv::cvtColor(frameYUV,frameBGR,cv::COLOR_YUV2BGR_YUYV);
+        samples.push_back(elapsedUsec(start));
+    }
+
+    return computeStats(samples);
+}
+
+BenchStats benchRemap(sl_oc::video::RESOLUTION res, int iterations)
+{
+    const sl_oc::video::Resolution& size = sl_oc::video::cameraResolution[static_cast<int>(res)];
+    cv::Size image_size(size.width, size.height);
+
+    // ----> Synthetic calibration with the typical lens distortion of the cameras
+    double f = 0.5*size.width;
+    cv::Mat K = (cv::Mat_<double>(3,3) << f, 0, size.width/2.0, 0, f, size.height/2.0, 0, 0, 1);
+    cv::Mat D = (cv::Mat_<double>(1,5) << -0.17, 0.027, 0.0, 0.0, 0.0);
+    cv::Mat R = cv::Mat::eye(3,3,CV_64F);
+
+    cv::Mat map_x, map_y;
+    cv::initUndistortRectifyMap(K, D, R, K, image_size, CV_32FC1, map_x, map_y);
+    // <---- Synthetic calibration with the typical lens distortion of the cameras
+
+    std::vector<uint8_t> data(size.width*size.height*3);
+    fillSynthetic(data);
+    cv::Mat left_raw(image_size, CV_8UC3, data.data());
+    cv::Mat right_raw = left_raw.clone();
+    cv::Mat left_rect, right_rect;
+    cv::remap(left_raw, left_rect, map_x, map_y, cv::INTER_LINEAR ); // Warm-up: the outputs are allocated
+    cv::remap(right_raw, right_rect, map_x, map_y, cv::INTER_LINEAR );
+
+    std::vector<double> samples;
+    for(int i=0; i<iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        cv::remap(left_raw, left_rect, map_x, map_y, cv::INTER_LINEAR );
+        cv::remap(right_raw, right_rect, map_x, map_y, cv::INTER_LINEAR );
+        samples.push_back(elapsedUsec(start));
+    }
+
+    return computeStats(samples);
+}
+
+BenchResult benchImuDecode(int iterations)
+{
+    // ----> Synthetic packets at 400 Hz, with magnetometer data at 50 Hz and environmental data at 25 Hz
+    const int count = iterations*IMU_BATCH;
+    std::vector<sl_oc::sensors::usb::RawData> packets(count);
+    const uint64_t ts_step = static_cast<uint64_t>(2500000.0/TS_SCALE); // 2.5 msec in MCU ticks
+
+    for(int i=0; i<count; i++)
+    {
+        sl_oc::sensors::usb::RawData& p = packets[i];
+        memset(&p, 0, sizeof(p));
+        p.struct_id = 0; // Report ID expected when no device is connected
+        p.imu_not_valid = 0;
+        p.timestamp = 1000 + i*ts_step;
+        p.gX = static_cast<int16_t>(i%200);
+        p.aZ = 16384;
+        p.imu_temp = 3500;
+        p.mag_valid = (i%8==0)?sl_oc::sensors::data::Magnetometer::NEW_VAL:sl_oc::sensors::data::Magnetometer::OLD_VAL;
+        p.mX = 100;
+        p.env_valid = (i%16==0)?sl_oc::sensors::data::Environment::NEW_VAL:sl_oc::sensors::data::Environment::OLD_VAL;
+        p.temp = 3000;
+        p.press = 101325;
+        p.humid = 40*1024;
+        p.temp_cam_left = 4000;
+        p.temp_cam_right = 4100;
+    }
+    // <---- Synthetic packets
+
+    sl_oc::sensors::SensorCapture sens(sl_oc::VERBOSITY::ERROR);
+
+    std::vector<double> samples;
+    int rejected = 0;
+    for(int b=0; b<iterations; b++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for(int i=0; i<IMU_BATCH; i++)
+        {
+            const uint8_t* buf = reinterpret_cast<const uint8_t*>(&packets[b*IMU_BATCH+i]);
+            if(!sens.processRawData(buf, sizeof(sl_oc::sensors::usb::RawData), sl_oc::getMonotonicTimestamp()))
+                rejected++;
+        }
+        samples.push_back(elapsedUsec(start)/IMU_BATCH);
+    }
+
+    BenchResult result;
+    result.name = "imu_decode";
+    result.stats = computeStats(samples);
+    result.extra.push_back(std::make_pair("rejected", rejected));
+    return result;
+}
+
+BenchResult benchHandoff(sl_oc::video::RESOLUTION res, sl_oc::video::FPS fps, double duration)
+{
+    BenchResult result;
+    result.name = "handoff";
+    result.res = resName(res);
+    result.fps = static_cast<int>(fps);
+
+    sl_oc::video::VideoParams params;
+    params.res = res;
+    params.fps = fps;
+    params.verbose = sl_oc::VERBOSITY::ERROR;
+    params.device_io = std::make_shared<sl_oc::video::MockVideoDevice>();
+
+    sl_oc::video::VideoCapture cap(params);
+    if( !cap.initializeVideo(0) )
+    {
+        std::cerr << "Cannot open the emulated camera" << std::endl;
+        return result;
+    }
+
+    std::vector<double> samples;
+    uint64_t last_id = 0;
+    uint64_t first_id = 0;
+    uint64_t missed = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while( elapsedUsec(start)<duration*1e6 )
+    {
+        const sl_oc::video::Frame& frame = cap.getLastFrame(1);
+        if(frame.data==nullptr || frame.frame_id==last_id)
+            continue;
+
+        uint64_t now = sl_oc::getMonotonicTimestamp();
+        samples.push_back(static_cast<double>(now-frame.timestamp_mono)*1e-3);
+
+        if(first_id==0)
+            first_id = frame.frame_id;
+        else if(frame.frame_id>last_id+1)
+            missed += frame.frame_id-last_id-1;
+        last_id = frame.frame_id;
+    }
+
+    result.stats = computeStats(samples);
+    result.extra.push_back(std::make_pair("received_fps", samples.size()/duration));
+    result.extra.push_back(std::make_pair("missed_frames", static_cast<double>(missed)));
+    return result;
+}
+
+std::string toJson(const std::vector<BenchResult>& results)
+{
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    std::string cpu;
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while(cpu.empty() && std::getline(cpuinfo, line))
+    {
+        if(line.compare(0, 10, "model name")==0 && line.find(':')!=std::string::npos)
+            cpu = line.substr(line.find(':')+2);
+    }
+
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << "{" << std::endl;
+    ss << "  \"date\": \"" << date << "\"," << std::endl;
+    ss << "  \"cpu\": \"" << cpu << "\"," << std::endl;
+    ss << "  \"cores\": " << std::thread::hardware_concurrency() << "," << std::endl;
+    ss << "  \"unit\": \"usec\"," << std::endl;
+    ss << "  \"results\": [";
+
+    for(size_t i=0; i<results.size(); i++)
+    {
+        const BenchResult& r = results[i];
+        ss << (i?",":"") << std::endl;
+        ss << "    {\"name\": \"" << r.name << "\"";
+        if(!r.res.empty())
+            ss << ", \"res\": \"" << r.res << "\"";
+        if(r.fps!=0)
+            ss << ", \"fps\": " << r.fps;
+        ss << ", \"iterations\": " << r.stats.iterations
+           << ", \"mean\": " << r.stats.mean
+           << ", \"p50\": " << r.stats.p50
+           << ", \"p99\": " << r.stats.p99
+           << ", \"max\": " << r.stats.max;
+        for(const auto& e : r.extra)
+            ss << ", \"" << e.first << "\": " << e.second;
+        ss << "}";
+    }
+
+    ss << std::endl << "  ]" << std::endl << "}" << std::endl;
+    return ss.str();
+}
@@ -0,0 +1,480 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ----> Includes
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <filesystem>
+#include <cmath>
+#include <ctime>
+
+// OpenCV includes
+#include <opencv2/opencv.hpp>
+
+// Sample includes
+#include "calibration.hpp"
+#include "recording.hpp"
+#include "stopwatch.hpp"
+// <---- Includes
+
+namespace fs = std::filesystem;
+
+// ----> Dataset layouts
+enum class LAYOUT {
+    EUROC,  //!< mav0/cam0/data/<ts>.png, mav0/cam1/data/<ts>.png, mav0/imu0/data.csv
+    KITTI   //!< image_00/data/<index>.png, image_01/data/<index>.png, timestamps.txt, calib.txt, imu.csv
+};
+// <---- Dataset layouts
+
+/*!
+ * \brief A stereo pair moving through the conversion pipeline
+ */
+struct StereoItem
+{
+    size_t seq;             //!< Position of the pair in the output dataset
+    uint64_t timestamp;     //!< Frame timestamp in nanoseconds
+    cv::Mat left;           //!< Left image
+    cv::Mat right;          //!< Right image
+};
+
+/*!
+ * \brief Bounded queue between two stages of the pipeline. `push` blocks when the queue is full, so the memory used
+ *        by the pipeline does not depend on the speed of each stage
+ */
+class StageQueue
+{
+public:
+    StageQueue(size_t capacity, int producers) : mCapacity(capacity), mProducers(producers) {}
+
+    void push(StereoItem&& item)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mNotFull.wait(lock, [this]{return mQueue.size()<mCapacity;});
+        mQueue.push_back(std::move(item));
+        mNotEmpty.notify_one();
+    }
+
+    // Returns false when all the producers are done and the queue is empty
+    bool pop(StereoItem& item)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mNotEmpty.wait(lock, [this]{return !mQueue.empty() || mProducers==0;});
+        if(mQueue.empty())
+            return false;
+        item = std::move(mQueue.front());
+        mQueue.pop_front();
+        mNotFull.notify_one();
+        return true;
+    }
+
+    // Called by each producer thread when it has no more items
+    void producerDone()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(--mProducers==0)
+            mNotEmpty.notify_all();
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mNotEmpty;
+    std::condition_variable mNotFull;
+    std::deque<StereoItem> mQueue;
+    size_t mCapacity;
+    int mProducers;
+};
+
+// ----> Functions
+void usage(const char* name);
+std::string imagePath(const std::string& out_dir, LAYOUT layout, bool left, size_t seq, uint64_t ts);
+bool writeImuCsv(const sl_oc::tools::RecordingIndex& index, const std::string& out_dir, LAYOUT layout);
+void writeCalibration(const std::string& out_dir, LAYOUT layout, const cv::Mat& P1, const cv::Mat& P2, double baseline, cv::Size size);
+// <---- Functions
+
+// The main function
+int main(int argc, char *argv[])
+{
+    if(argc<3)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // ----> Parse the options
+    std::string rec_dir = argv[1];
+    std::string out_dir = argv[2];
+
+    LAYOUT layout = LAYOUT::EUROC;
+    std::string calib_file;
+    int sn = -1;
+    int png_level = 1;
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    int decode_threads = std::max(1u, cores*3/8);
+    int rectify_threads = std::max(1u, cores/4);
+    int encode_threads = std::max(1, static_cast<int>(cores)-decode_threads-rectify_threads);
+
+    for(int i=3; i<argc; i++)
+    {
+        std::string opt = argv[i];
+        if(opt=="--kitti")
+            layout = LAYOUT::KITTI;
+        else if(opt=="--euroc")
+            layout = LAYOUT::EUROC;
+        else if(opt=="--calib" && i+1<argc)
+            calib_file = argv[++i];
+        else if(opt=="--sn" && i+1<argc)
+            sn = std::stoi(argv[++i]);
+        else if(opt=="--png-level" && i+1<argc)
+            png_level = std::stoi(argv[++i]);
+        else if(opt=="--decode" && i+1<argc)
+            decode_threads = std::max(1, std::stoi(argv[++i]));
+        else if(opt=="--rectify" && i+1<argc)
+            rectify_threads = std::max(1, std::stoi(argv[++i]));
+        else if(opt=="--encode" && i+1<argc)
+            encode_threads = std::max(1, std::stoi(argv[++i]));
+        else
+        {
+            std::cerr << "Unknown option: " << opt << std::endl;
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    // <---- Parse the options
+
+    // ----> Open the recording
+    sl_oc::tools::RecordingIndex index;
+    if( !index.open(rec_dir) )
+    {
+        std::cerr << "Cannot open the index of the recording " << rec_dir << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Only the complete stereo pairs are converted
+    std::vector<size_t> pairs;
+    for(size_t i=0; i<index.frameCount(); i++)
+        if(index.frame(i).flags==(sl_oc::tools::REC_FRAME_LEFT|sl_oc::tools::REC_FRAME_RIGHT))
+            pairs.push_back(i);
+
+    if(pairs.empty())
+    {
+        std::cerr << "No stereo pairs found in " << rec_dir << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Converting " << pairs.size() << " stereo pairs and " << index.imuCount() << " IMU samples" << std::endl;
+    // <---- Open the recording
+
+    // ----> Calibration
+    if(calib_file.empty())
+    {
+        if(sn<0)
+        {
+            std::cerr << "Please specify the calibration file ('--calib') or the camera serial number ('--sn')" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if( !sl_oc::tools::downloadCalibrationFile(sn, calib_file) )
+        {
+            std::cerr << "Could not load calibration file from Stereolabs servers" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    cv::Mat first = cv::imread(index.imagePath(pairs[0],true), cv::IMREAD_UNCHANGED);
+    if(first.empty())
+    {
+        std::cerr << "Cannot read " << index.imagePath(pairs[0],true) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    cv::Mat map_left_x, map_left_y;
+    cv::Mat map_right_x, map_right_y;
+    cv::Mat cameraMatrix_left, cameraMatrix_right;
+    double baseline=0.0;
+    if( !sl_oc::tools::initCalibration(calib_file, first.size(), map_left_x, map_left_y, map_right_x, map_right_y,
+                                       cameraMatrix_left, cameraMatrix_right, &baseline) )
+    {
+        std::cerr << "Cannot initialize the rectification maps from " << calib_file << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The maps are computed once and converted to the fixed point format, faster to be applied by `cv::remap`
+    cv::Mat fmap_left_1, fmap_left_2, fmap_right_1, fmap_right_2;
+    cv::convertMaps(map_left_x, map_left_y, fmap_left_1, fmap_left_2, CV_16SC2);
+    cv::convertMaps(map_right_x, map_right_y, fmap_right_1, fmap_right_2, CV_16SC2);
+    // <---- Calibration
+
+    // ----> Output folders
+    if(layout==LAYOUT::EUROC)
+    {
+        fs::create_directories(fs::path(out_dir) / "mav0/cam0/data");
+        fs::create_directories(fs::path(out_dir) / "mav0/cam1/data");
+        fs::create_directories(fs::path(out_dir) / "mav0/imu0");
+    }
+    else
+    {
+        fs::create_directories(fs::path(out_dir) / "image_00/data");
+        fs::create_directories(fs::path(out_dir) / "image_01/data");
+    }
+
+    writeCalibration(out_dir, layout, cameraMatrix_left, cameraMatrix_right, baseline, first.size());
+
+    if( index.imuCount()>0 && !writeImuCsv(index, out_dir, layout) )
+        return EXIT_FAILURE;
+    // <---- Output folders
+
+    // The stages run in parallel on their own pools: OpenCV internal threads would only compete with them
+    cv::setNumThreads(1);
+
+    std::cout << "Pipeline: " << decode_threads << " decode, " << rectify_threads << " rectify, "
+              << encode_threads << " encode threads" << std::endl;
+
+    // ----> Pipeline
+    StageQueue rectQueue(2*rectify_threads, decode_threads);
+    StageQueue encodeQueue(2*encode_threads, rectify_threads);
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> done(0);
+    std::atomic<size_t> errors(0);
+
+    auto decode = [&]()
+    {
+        for(size_t i=next++; i<pairs.size(); i=next++)
+        {
+            StereoItem item;
+            item.seq = i;
+            item.timestamp = index.frame(pairs[i]).timestamp;
+            item.left = cv::imread(index.imagePath(pairs[i],true), cv::IMREAD_UNCHANGED);
+            item.right = cv::imread(index.imagePath(pairs[i],false), cv::IMREAD_UNCHANGED);
+            if(item.left.empty() || item.right.empty())
+            {
+                errors++;
+                continue;
+            }
+            rectQueue.push(std::move(item));
+        }
+        rectQueue.producerDone();
+    };
+
+    auto rectify = [&]()
+    {
+        StereoItem item;
+        while(rectQueue.pop(item))
+        {
+            cv::Mat left_rect, right_rect;
+            cv::remap(item.left, left_rect, fmap_left_1, fmap_left_2, cv::INTER_LINEAR);
+            cv::remap(item.right, right_rect, fmap_right_1, fmap_right_2, cv::INTER_LINEAR);
+            item.left = left_rect;
+            item.right = right_rect;
+            encodeQueue.push(std::move(item));
+        }
+        encodeQueue.producerDone();
+    };
+
+    auto encode = [&]()
+    {
+        std::vector<int> png_params = {cv::IMWRITE_PNG_COMPRESSION, png_level};
+        StereoItem item;
+        while(encodeQueue.pop(item))
+        {
+            if( cv::imwrite(imagePath(out_dir,layout,true,item.seq,item.timestamp), item.left, png_params) &&
+                    cv::imwrite(imagePath(out_dir,layout,false,item.seq,item.timestamp), item.right, png_params) )
+                done++;
+            else
+                errors++;
+        }
+    };
+
+    sl_oc::tools::StopWatch sw;
+    std::vector<std::thread> pool;
+    for(int t=0; t<decode_threads; t++)
+        pool.emplace_back(decode);
+    for(int t=0; t<rectify_threads; t++)
+        pool.emplace_back(rectify);
+    for(int t=0; t<encode_threads; t++)
+        pool.emplace_back(encode);
+
+    // ----> Progress
+    while(done+errors<pairs.size())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        std::cout << "\r" << done << "/" << pairs.size() << " pairs" << std::flush;
+    }
+    std::cout << std::endl;
+    // <---- Progress
+
+    for(auto& th : pool)
+        th.join();
+    // <---- Pipeline
+
+    // ----> Timestamps
+    // Written in the order of the dataset, whatever the order of completion of the pipeline
+    if(layout==LAYOUT::EUROC)
+    {
+        for(int c=0; c<2; c++)
+        {
+            std::ofstream csv((fs::path(out_dir) / ("mav0/cam" + std::to_string(c) + "/data.csv")).string());
+            csv << "#timestamp [ns],filename" << std::endl;
+            for(size_t i=0; i<pairs.size(); i++)
+                csv << index.frame(pairs[i]).timestamp << "," << index.frame(pairs[i]).timestamp << ".png\n";
+        }
+    }
+    else
+    {
+        for(int c=0; c<2; c++)
+        {
+            std::ofstream txt((fs::path(out_dir) / ("image_0" + std::to_string(c)) / "timestamps.txt").string());
+            for(size_t i=0; i<pairs.size(); i++)
+            {
+                uint64_t ts = index.frame(pairs[i]).timestamp;
+                time_t sec = ts/1000000000ULL;
+                struct tm t;
+                gmtime_r(&sec, &t);
+                txt << std::put_time(&t, "%Y-%m-%d %H:%M:%S") << "." << std::setw(9) << std::setfill('0') << ts%1000000000ULL << "\n";
+            }
+        }
+    }
+    // <---- Timestamps
+
+    double elapsed = sw.toc();
+    double rec_duration = static_cast<double>(index.frame(pairs.back()).timestamp-index.frame(pairs.front()).timestamp)/1e9;
+    std::cout << "Converted " << done << " pairs in " << std::fixed << std::setprecision(2) << elapsed << " sec";
+    if(elapsed>0)
+        std::cout << " [" << std::setprecision(1) << done/elapsed << " pairs/sec, " << rec_duration/elapsed << "x real-time]";
+    std::cout << std::endl;
+
+    if(errors>0)
+    {
+        std::cerr << errors << " pairs could not be converted" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void usage(const char* name)
+{
+    std::cout << "Usage: " << name << " <recording_dir> <out_dir> [options]" << std::endl;
+    std::cout << "Convert a recording of raw images saved by `zed_open_capture_sync_save --raw` to a rectified dataset" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << " --euroc              EuRoC layout [default]" << std::endl;
+    std::cout << " --kitti              KITTI layout" << std::endl;
+    std::cout << " --calib <file>       calibration file of the camera" << std::endl;
+    std::cout << " --sn <serial>        serial number of the camera, to download the calibration file" << std::endl;
+    std::cout << " --png-level <0-9>    PNG compression level [default: 1]" << std::endl;
+    std::cout << " --decode <N>         number of decoding threads" << std::endl;
+    std::cout << " --rectify <N>        number of rectification threads" << std::endl;
+    std::cout << " --encode <N>         number of encoding threads" << std::endl;
+}
+
+std::string imagePath(const std::string& out_dir, LAYOUT layout, bool left, size_t seq, uint64_t ts)
+{
+    std::stringstream path;
+    path << out_dir << "/";
+    if(layout==LAYOUT::EUROC)
+        path << "mav0/cam" << (left?0:1) << "/data/" << ts << ".png";
+    else
+        path << "image_0" << (left?0:1) << "/data/" << std::setw(10) << std::setfill('0') << seq << ".png";
+    return path.str();
+}
+
+bool writeImuCsv(const sl_oc::tools::RecordingIndex& index, const std::string& out_dir, LAYOUT layout)
+{
+    if(layout==LAYOUT::KITTI)
+    {
+        // Same format of the recording
+        std::ofstream csv((fs::path(out_dir) / sl_oc::tools::REC_IMU_FILE).string());
+        csv << sl_oc::tools::REC_IMU_CSV_HEADER << std::endl;
+        for(size_t i=0; i<index.imuCount(); i++)
+            csv << index.imuLine(i) << "\n";
+        return static_cast<bool>(csv);
+    }
+
+    // EuRoC: angular velocity in rad/s first, then acceleration
+    std::ofstream csv((fs::path(out_dir) / "mav0/imu0/data.csv").string());
+    csv << "#timestamp [ns],w_RS_S_x [rad s^-1],w_RS_S_y [rad s^-1],w_RS_S_z [rad s^-1],"
+           "a_RS_S_x [m s^-2],a_RS_S_y [m s^-2],a_RS_S_z [m s^-2]" << std::endl;
+    csv << std::setprecision(9);
+
+    const double deg2rad = M_PI/180.0;
+    for(size_t i=0; i<index.imuCount(); i++)
+    {
+        std::string line = index.imuLine(i);
+        double v[6]; // aX aY aZ gX gY gZ
+        unsigned long long ts;
+        if(sscanf(line.c_str(), "%llu,%lf,%lf,%lf,%lf,%lf,%lf", &ts, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5])!=7)
+            continue;
+
+        csv << ts << "," << v[3]*deg2rad << "," << v[4]*deg2rad << "," << v[5]*deg2rad
+            << "," << v[0] << "," << v[1] << "," << v[2] << "\n";
+    }
+
+    if(!csv)
+    {
+        std::cerr << "Cannot write the IMU data" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void writeCalibration(const std::string& out_dir, LAYOUT layout, const cv::Mat& P1, const cv::Mat& P2, double baseline, cv::Size size)
+{
+    if(layout==LAYOUT::KITTI)
+    {
+        // Projection matrices of the rectified images, row major
+        std::ofstream calib((fs::path(out_dir) / "calib.txt").string());
+        calib << std::scientific << std::setprecision(12);
+        const cv::Mat* P[2] = {&P1, &P2};
+        for(int c=0; c<2; c++)
+        {
+            calib << "P" << c << ":";
+            for(int r=0; r<3; r++)
+                for(int col=0; col<4; col++)
+                    calib << " " << P[c]->at<double>(r,col);
+            calib << "\n";
+        }
+        return;
+    }
+
+    // EuRoC: one sensor.yaml per camera. The images are rectified, so there is no distortion
+    const cv::Mat* P[2] = {&P1, &P2};
+    for(int c=0; c<2; c++)
+    {
+        std::ofstream yaml((fs::path(out_dir) / ("mav0/cam" + std::to_string(c)) / "sensor.yaml").string());
+        yaml << "sensor_type: camera" << std::endl;
+        yaml << "comment: ZED " << (c==0?"left":"right") << " camera, rectified" << std::endl;
+        yaml << "T_BS:" << std::endl;
+        yaml << "  cols: 4" << std::endl;
+        yaml << "  rows: 4" << std::endl;
+        yaml << "  data: [1.0, 0.0, 0.0, " << (c==0?0.0:baseline/1000.0) << ", 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0]" << std::endl;
+        yaml << "resolution: [" << size.width << ", " << size.height << "]" << std::endl;
+        yaml << "camera_model: pinhole" << std::endl;
+        yaml << "intrinsics: [" << P[c]->at<double>(0,0) << ", " << P[c]->at<double>(1,1) << ", "
+             << P[c]->at<double>(0,2) << ", " << P[c]->at<double>(1,2) << "]" << std::endl;
+        yaml << "distortion_model: radial-tangential" << std::endl;
+        yaml << "distortion_coefficients: [0.0, 0.0, 0.0, 0.0]" << std::endl;
+    }
+}
@@ -0,0 +1,313 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ----> Includes
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+
+// OpenCV includes
+#include <opencv2/opencv.hpp>
+
+// Sample includes
+#include "calibration.hpp"
+#include "recording.hpp"
+#include "stopwatch.hpp"
+// <---- Includes
+
+// ----> Functions
+void usage(const char* name);
+int printInfo(const sl_oc::tools::RecordingIndex& index);
+int extract(const sl_oc::tools::RecordingIndex& index, int argc, char *argv[]);
+// <---- Functions
+
+// The main function
+int main(int argc, char *argv[])
+{
+    if(argc<3)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string cmd = argv[1];
+    std::string rec_dir = argv[2];
+
+    if(cmd!="index" && cmd!="info" && cmd!="extract")
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // ----> Open or build the index
+    bool force = (cmd=="index" && argc>3 && std::string(argv[3])=="--force");
+
+    sl_oc::tools::StopWatch sw;
+    sl_oc::tools::RecordingIndex index;
+    if( !index.open(rec_dir, force) )
+    {
+        std::cerr << "Cannot open the index of the recording " << rec_dir << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Index ready in " << std::fixed << std::setprecision(3) << sw.toc()*1000.0 << " msec: "
+              << index.frameCount() << " frames, " << index.imuCount() << " IMU samples" << std::endl;
+    // <---- Open or build the index
+
+    if(cmd=="index")
+        return EXIT_SUCCESS;
+    else if(cmd=="info")
+        return printInfo(index);
+    else
+        return extract(index, argc-3, argv+3);
+}
+
+void usage(const char* name)
+{
+    std::cout << "Usage: " << name << " <command> <recording_dir> [options]" << std::endl;
+    std::cout << "Commands:" << std::endl;
+    std::cout << " * index [--force]: build the index, or repair it if the recording has been modified" << std::endl;
+    std::cout << " * info: print the content of the recording" << std::endl;
+    std::cout << " * extract <out_dir> <t_start> <t_end> [options]: extract a time range" << std::endl;
+    std::cout << "   <t_start> <t_end> are in seconds from the first frame, or absolute nanoseconds with '--abs'" << std::endl;
+    std::cout << "   --abs                  the time range is expressed as absolute timestamps in nanoseconds" << std::endl;
+    std::cout << "   --no-frames            do not extract the images" << std::endl;
+    std::cout << "   --no-imu               do not extract the IMU samples" << std::endl;
+    std::cout << "   --rectify <calib_file> rectify the stereo pairs using the given calibration file" << std::endl;
+    std::cout << "   --threads <N>          number of extraction threads [default: number of cores]" << std::endl;
+}
+
+int printInfo(const sl_oc::tools::RecordingIndex& index)
+{
+    if(index.frameCount()>0)
+    {
+        uint64_t t0 = index.frame(0).timestamp;
+        uint64_t t1 = index.frame(index.frameCount()-1).timestamp;
+        size_t pairs=0;
+        for(size_t i=0; i<index.frameCount(); i++)
+            if(index.frame(i).flags==(sl_oc::tools::REC_FRAME_LEFT|sl_oc::tools::REC_FRAME_RIGHT))
+                pairs++;
+
+        std::cout << "Frames: " << index.frameCount() << " (" << pairs << " stereo pairs)" << std::endl;
+        std::cout << " * First: " << t0 << " nsec" << std::endl;
+        std::cout << " * Last: " << t1 << " nsec" << std::endl;
+        std::cout << " * Duration: " << std::fixed << std::setprecision(3) << static_cast<double>(t1-t0)/1e9 << " sec" << std::endl;
+        if(index.frameCount()>1)
+            std::cout << " * Mean frame rate: " << std::setprecision(2)
+                      << (index.frameCount()-1)*1e9/static_cast<double>(t1-t0) << " Hz" << std::endl;
+    }
+
+    if(index.imuCount()>0)
+    {
+        uint64_t t0 = index.imu(0).timestamp;
+        uint64_t t1 = index.imu(index.imuCount()-1).timestamp;
+        std::cout << "IMU samples: " << index.imuCount() << std::endl;
+        if(index.imuCount()>1)
+            std::cout << " * Mean rate: " << std::fixed << std::setprecision(2)
+                      << (index.imuCount()-1)*1e9/static_cast<double>(t1-t0) << " Hz" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int extract(const sl_oc::tools::RecordingIndex& index, int argc, char *argv[])
+{
+    namespace fs = std::filesystem;
+
+    if(argc<3)
+    {
+        std::cerr << "Missing parameters for the 'extract' command" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // ----> Parse the options
+    std::string out_dir = argv[0];
+    double start = std::stod(argv[1]);
+    double end = std::stod(argv[2]);
+
+    bool abs_time = false;
+    bool save_frames = true;
+    bool save_imu = true;
+    std::string calib_file;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(int i=3; i<argc; i++)
+    {
+        std::string opt = argv[i];
+        if(opt=="--abs")
+            abs_time = true;
+        else if(opt=="--no-frames")
+            save_frames = false;
+        else if(opt=="--no-imu")
+            save_imu = false;
+        else if(opt=="--rectify" && i+1<argc)
+            calib_file = argv[++i];
+        else if(opt=="--threads" && i+1<argc)
+            threads = std::max(1, std::stoi(argv[++i]));
+        else
+        {
+            std::cerr << "Unknown option: " << opt << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    // <---- Parse the options
+
+    // ----> Time range lookup
+    uint64_t t_start, t_end;
+    if(abs_time)
+    {
+        t_start = static_cast<uint64_t>(start);
+        t_end = static_cast<uint64_t>(end);
+    }
+    else
+    {
+        uint64_t t0 = index.frameCount()>0 ? index.frame(0).timestamp : (index.imuCount()>0 ? index.imu(0).timestamp : 0);
+        t_start = t0 + static_cast<uint64_t>(std::max(0.0,start)*1e9);
+        t_end = t0 + static_cast<uint64_t>(std::max(0.0,end)*1e9);
+    }
+
+    sl_oc::tools::StopWatch sw;
+    size_t f_first, f_last, i_first, i_last;
+    index.findFrames(t_start, t_end, f_first, f_last);
+    index.findImu(t_start, t_end, i_first, i_last);
+    std::cout << "Time range lookup in " << std::fixed << std::setprecision(3) << sw.toc()*1000.0 << " msec: "
+              << f_last-f_first << " frames, " << i_last-i_first << " IMU samples" << std::endl;
+    // <---- Time range lookup
+
+    fs::create_directories(out_dir);
+
+    // ----> IMU window
+    if(save_imu && i_last>i_first)
+    {
+        std::ofstream imu_out((fs::path(out_dir) / sl_oc::tools::REC_IMU_FILE).string(), std::ios::trunc);
+        imu_out << sl_oc::tools::REC_IMU_CSV_HEADER << std::endl;
+        for(size_t i=i_first; i<i_last; i++)
+            imu_out << index.imuLine(i) << "\n";
+    }
+    // <---- IMU window
+
+    if(!save_frames || f_last==f_first)
+        return EXIT_SUCCESS;
+
+    fs::create_directories(fs::path(out_dir) / sl_oc::tools::REC_LEFT_DIR);
+    fs::create_directories(fs::path(out_dir) / sl_oc::tools::REC_RIGHT_DIR);
+
+    // ----> Rectification maps
+    cv::Mat map_left_x, map_left_y;
+    cv::Mat map_right_x, map_right_y;
+    bool rectify = !calib_file.empty();
+    if(rectify)
+    {
+        // The size of the maps is given by the first image of the range
+        cv::Mat first;
+        for(size_t i=f_first; i<f_last && first.empty(); i++)
+            if(index.frame(i).flags & sl_oc::tools::REC_FRAME_LEFT)
+                first = cv::imread(index.imagePath(i,true), cv::IMREAD_UNCHANGED);
+
+        cv::Mat cameraMatrix_left, cameraMatrix_right;
+        if( first.empty() ||
+                !sl_oc::tools::initCalibration(calib_file, first.size(), map_left_x, map_left_y, map_right_x, map_right_y,
+                                               cameraMatrix_left, cameraMatrix_right) )
+        {
+            std::cerr << "Cannot initialize the rectification maps from " << calib_file << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    // <---- Rectification maps
+
+    // ----> Parallel extraction
+    // Each thread takes the next frame index from a shared counter: the images are independent files
+    std::atomic<size_t> next(f_first);
+    std::atomic<size_t> saved(0);
+    std::atomic<size_t> errors(0);
+
+    auto worker = [&]()
+    {
+        cv::Mat img, rect;
+        for(size_t i=next++; i<f_last; i=next++)
+        {
+            for(int s=0; s<2; s++)
+            {
+                bool left = (s==0);
+                if( !(index.frame(i).flags & (left?sl_oc::tools::REC_FRAME_LEFT:sl_oc::tools::REC_FRAME_RIGHT)) )
+                    continue;
+
+                std::string src = index.imagePath(i,left);
+                std::string dst = (fs::path(out_dir) / (left?sl_oc::tools::REC_LEFT_DIR:sl_oc::tools::REC_RIGHT_DIR) /
+                                   fs::path(src).filename()).string();
+
+                bool ok;
+                if(rectify)
+                {
+                    img = cv::imread(src, cv::IMREAD_UNCHANGED);
+                    ok = !img.empty();
+                    if(ok)
+                    {
+                        cv::remap(img, rect, left?map_left_x:map_right_x, left?map_left_y:map_right_y, cv::INTER_LINEAR);
+                        ok = cv::imwrite(dst, rect);
+                    }
+                }
+                else
+                {
+                    // Hard link when possible, the images are never modified
+                    std::error_code ec;
+                    fs::remove(dst, ec);
+                    fs::create_hard_link(src, dst, ec);
+                    if(ec)
+                        ok = fs::copy_file(src, dst, fs::copy_options::overwrite_existing, ec);
+                    else
+                        ok = true;
+                }
+
+                if(ok)
+                    saved++;
+                else
+                    errors++;
+            }
+        }
+    };
+
+    sw.tic();
+    std::vector<std::thread> pool;
+    for(int t=0; t<threads; t++)
+        pool.emplace_back(worker);
+    for(auto& th : pool)
+        th.join();
+
+    double elapsed = sw.toc();
+    std::cout << "Extracted " << saved << " images in " << std::fixed << std::setprecision(2) << elapsed << " sec using "
+              << threads << " threads";
+    if(elapsed>0)
+        std::cout << " [" << std::setprecision(1) << saved/elapsed << " images/sec]";
+    std::cout << std::endl;
+    // <---- Parallel extraction
+
+    if(errors>0)
+    {
+        std::cerr << errors << " images could not be extracted" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ----> Includes
+#include "videocapture.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+// <---- Includes
+
+#define LOG_SEP ","
+
+// ----> Functions
+void writeHeader(std::ofstream& out);
+void writeRecord(std::ofstream& out, const sl_oc::video::RegLogRecord& rec);
+// <---- Functions
+
+// The main function
+int main(int argc, char *argv[])
+{
+    if(argc<2 || argc>3)
+    {
+        std::cout << "Usage: " << argv[0] << " <log_file> [<out_prefix>]" << std::endl;
+        std::cout << "Convert a binary AEC/AGC register log to the CSV files <out_prefix>-LEFT.csv and <out_prefix>-RIGHT.csv" << std::endl;
+        std::cout << "The output prefix is the name of the log file without extension by default" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string log_file = argv[1];
+    std::string prefix = (argc==3)?argv[2]:log_file.substr(0, log_file.rfind('.'));
+
+    sl_oc::video::RegLogFileHeader header;
+    std::vector<sl_oc::video::RegLogRecord> records;
+    if(!sl_oc::video::RegisterLogger::readLog(log_file, header, records))
+    {
+        std::cerr << "'" << log_file << "' is not a valid register log" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Camera sn: " << header.serial_number << " - " << records.size() << " records" << std::endl;
+
+    std::ofstream out[2];
+    out[0].open(prefix+"-LEFT.csv");
+    out[1].open(prefix+"-RIGHT.csv");
+    for(int side=0; side<2; side++)
+    {
+        if(!out[side])
+        {
+            std::cerr << "Cannot create the output files '" << prefix << "-*.csv'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        writeHeader(out[side]);
+    }
+
+    size_t errors = 0;
+    for(const sl_oc::video::RegLogRecord& rec : records)
+    {
+        if(rec.side>1)
+            continue;
+        writeRecord(out[rec.side], rec);
+        errors += (rec.status!=0)?1:0;
+    }
+
+    if(errors>0)
+        std::cout << errors << " records with register reading errors" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+void writeHeader(std::ofstream& out)
+{
+    // Same columns as the CSV logs of the previous versions, followed by the reading information
+    out << "TIMESTAMP" << LOG_SEP;
+    out << "OV580-ISP_EN_HIGH" << LOG_SEP;
+    out << "OV580-yavg_low" << LOG_SEP;
+    out << "OV580-yavg_high" << LOG_SEP;
+    out << "OV580-interrupt_ctrl1";
+
+    for (int addr = 0x00; addr <= 0x22; ++addr)
+        out << LOG_SEP << "OV580-YAVG[0x" << std::hex << std::setfill('0') << std::setw(2) << addr << "]";
+
+    for (int addr = 0x3500; addr <= 0x3515; ++addr)
+        out << LOG_SEP << "OV4689-GAIN_EXP[0x" << std::hex << std::setfill('0') << std::setw(4) << addr << "]";
+
+    out << LOG_SEP << "FRAME_ID" << LOG_SEP << "READ_USEC" << LOG_SEP << "STATUS" << std::endl;
+}
+
+void writeRecord(std::ofstream& out, const sl_oc::video::RegLogRecord& rec)
+{
+    out << std::dec << rec.frame_ts;
+    for(int i=0; i<sl_oc::video::REG_LOG_REG_COUNT; i++)
+        out << LOG_SEP << "0x" << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(rec.values[i]);
+    out << std::dec << LOG_SEP << rec.frame_id << LOG_SEP << rec.read_usec << LOG_SEP << static_cast<int>(rec.status) << std::endl;
+}
@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ----> Includes
+#include "videocapture.hpp"
+#include "mockvideodevice.hpp"
+#include "sensorcapture.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <thread>
+// <---- Includes
+
+// ----> Functions
+void usage(const char* name);
+void printStats(const std::string& name, const sl_oc::StatsSummary& stats);
+std::string toJson(const sl_oc::TimingReport& report, int fps);
+// <---- Functions
+
+// The main function
+int main(int argc, char *argv[])
+{
+    // ----> Parse the options
+    sl_oc::video::VideoParams params;
+    params.res = sl_oc::video::RESOLUTION::HD720;
+    params.fps = sl_oc::video::FPS::FPS_60;
+
+    double duration = 10.0;
+    int dev_id = -1;
+    bool use_sensors = true;
+    bool mock = false;
+    float mock_jitter = 0.0f;
+    size_t window = sl_oc::TIMING_DEFAULT_WINDOW;
+    std::string json_file;
+    double max_jitter = 0.0;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::string opt = argv[i];
+        if(opt=="--res" && i+1<argc)
+        {
+            std::string res = argv[++i];
+            if(res=="HD2K") params.res = sl_oc::video::RESOLUTION::HD2K;
+            else if(res=="HD1080") params.res = sl_oc::video::RESOLUTION::HD1080;
+            else if(res=="HD720") params.res = sl_oc::video::RESOLUTION::HD720;
+            else if(res=="VGA") params.res = sl_oc::video::RESOLUTION::VGA;
+            else
+            {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if(opt=="--fps" && i+1<argc)
+            params.fps = static_cast<sl_oc::video::FPS>(std::stoi(argv[++i]));
+        else if(opt=="--duration" && i+1<argc)
+            duration = std::max(1.0, std::stod(argv[++i]));
+        else if(opt=="--dev" && i+1<argc)
+            dev_id = std::stoi(argv[++i]);
+        else if(opt=="--no-sensors")
+            use_sensors = false;
+        else if(opt=="--mock")
+            mock = true;
+        else if(opt=="--jitter" && i+1<argc)
+            mock_jitter = std::stof(argv[++i]);
+        else if(opt=="--window" && i+1<argc)
+            window = std::max(2, std::stoi(argv[++i]));
+        else if(opt=="--json" && i+1<argc)
+            json_file = argv[++i];
+        else if(opt=="--max-jitter" && i+1<argc)
+            max_jitter = std::stod(argv[++i]);
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    // <---- Parse the options
+
+    // ----> Open the camera
+    if(mock)
+    {
+        sl_oc::video::MockVideoParams mock_params;
+        mock_params.jitter_usec = mock_jitter;
+        params.device_io = std::make_shared<sl_oc::video::MockVideoDevice>(mock_params);
+        use_sensors = false;
+    }
+
+    sl_oc::video::VideoCapture cap(params);
+    if( !cap.initializeVideo(dev_id) )
+    {
+        std::cerr << "Cannot open camera video capture" << std::endl;
+        return EXIT_FAILURE;
+    }
+    int sn = cap.getSerialNumber();
+    std::cerr << "Connected to camera sn: " << sn << " [" << cap.getDeviceName() << "]" << std::endl;
+
+    // The IMU sync signals are matched with the frames only if the sensors are synchronized
+    sl_oc::sensors::SensorCapture sens;
+    if(use_sensors)
+    {
+        if( sens.initializeSensors(sn) )
+            cap.enableSensorSync(&sens);
+        else
+            std::cerr << "Sensors not available: the IMU sync offset is not measured" << std::endl;
+    }
+
+    cap.enableTimingAnalysis(window);
+    // <---- Open the camera
+
+    // ----> Analysis
+    int fps = static_cast<int>(params.fps);
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    };
+
+    double next_print = 1.0;
+    while( elapsed()<duration )
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        // Keep the frame queue flowing as a normal application
+        cap.getLastFrame(1);
+
+        if( elapsed()<next_print )
+            continue;
+        next_print += 1.0;
+
+        sl_oc::TimingReport report;
+        if( !cap.getTimingReport(report) )
+            continue;
+
+        std::cout << "[" << std::fixed << std::setprecision(0) << elapsed() << " s] frames: " << report.frames
+                  << " - late: " << report.late_frames << " - syncs: " << report.syncs << std::endl;
+        printStats("period", report.period);
+        printStats("jitter", report.jitter);
+        printStats("arrival skew", report.arrival_skew);
+        if(report.syncs>0)
+            printStats("sync offset", report.sync_offset);
+    }
+
+    sl_oc::TimingReport report;
+    cap.getTimingReport(report);
+    cap.disableTimingAnalysis();
+    // <---- Analysis
+
+    // ----> Results
+    if(!json_file.empty())
+    {
+        std::ofstream out(json_file);
+        out << toJson(report, fps);
+        if(!out)
+        {
+            std::cerr << "Cannot write '" << json_file << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cerr << "Results saved in '" << json_file << "'" << std::endl;
+    }
+
+    if(report.frames<2)
+    {
+        std::cerr << "Not enough frames received" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if(max_jitter>0.0)
+    {
+        double jitter = report.jitter.p99*1e-3;
+        if(jitter>max_jitter)
+        {
+            std::cerr << "FAILED: frame jitter p99 " << jitter << " usec > " << max_jitter << " usec" << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cerr << "PASSED: frame jitter p99 " << jitter << " usec <= " << max_jitter << " usec" << std::endl;
+    }
+    // <---- Results
+
+    return EXIT_SUCCESS;
+}
+
+void usage(const char* name)
+{
+    std::cout << "Usage: " << name << " [options]" << std::endl;
+    std::cout << "Timing analysis of the frames of a camera: frame period, jitter with respect to the nominal period," << std::endl;
+    std::cout << "delay of reception by the host and offset of the IMU sync signals. All the values are in usec." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "   --res <res>          HD2K, HD1080, HD720, VGA [default: HD720]" << std::endl;
+    std::cout << "   --fps <fps>          15, 30, 60, 100 [default: 60]" << std::endl;
+    std::cout << "   --duration <sec>     duration of the analysis [default: 10]" << std::endl;
+    std::cout << "   --dev <id>           video device id [default: first camera found]" << std::endl;
+    std::cout << "   --no-sensors         do not open the sensors, the IMU sync offset is not measured" << std::endl;
+    std::cout << "   --mock               use an emulated camera (no sensors)" << std::endl;
+    std::cout << "   --jitter <usec>      frame period jitter of the emulated camera [default: 0]" << std::endl;
+    std::cout << "   --window <N>         number of samples of the rolling statistics [default: "
+              << sl_oc::TIMING_DEFAULT_WINDOW << "]" << std::endl;
+    std::cout << "   --json <file>        save the final statistics in a JSON file" << std::endl;
+    std::cout << "   --max-jitter <usec>  fail if the 99th percentile of the jitter is higher" << std::endl;
+}
+
+void printStats(const std::string& name, const sl_oc::StatsSummary& stats)
+{
+    std::cout << std::fixed << std::setprecision(1)
+              << "  " << std::left << std::setw(14) << name << std::right
+              << " mean: " << std::setw(9) << stats.mean*1e-3
+              << " p50: " << std::setw(9) << stats.p50*1e-3
+              << " p99: " << std::setw(9) << stats.p99*1e-3
+              << " min: " << std::setw(9) << stats.min*1e-3
+              << " max: " << std::setw(9) << stats.max*1e-3 << std::endl;
+}
+
+std::string toJson(const sl_oc::TimingReport& report, int fps)
+{
+    auto stats = [](const sl_oc::StatsSummary& s) {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(3);
+        ss << "{\"count\": " << s.count << ", \"mean\": " << s.mean*1e-3 << ", \"p50\": " << s.p50*1e-3
+           << ", \"p99\": " << s.p99*1e-3 << ", \"min\": " << s.min*1e-3 << ", \"max\": " << s.max*1e-3 << "}";
+        return ss.str();
+    };
+
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << "{" << std::endl;
+    ss << "  \"unit\": \"usec\"," << std::endl;
+    ss << "  \"fps\": " << fps << "," << std::endl;
+    ss << "  \"frames\": " << report.frames << "," << std::endl;
+    ss << "  \"late_frames\": " << report.late_frames << "," << std::endl;
+    ss << "  \"syncs\": " << report.syncs << "," << std::endl;
+    ss << "  \"nominal_period\": " << report.nominal_period*1e-3 << "," << std::endl;
+    ss << "  \"period\": " << stats(report.period) << "," << std::endl;
+    ss << "  \"jitter\": " << stats(report.jitter) << "," << std::endl;
+    ss << "  \"arrival_skew\": " << stats(report.arrival_skew) << "," << std::endl;
+    ss << "  \"sync_offset\": " << stats(report.sync_offset) << std::endl;
+    ss << "}" << std::endl;
+    return ss.str();
+}
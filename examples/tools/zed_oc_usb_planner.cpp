@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ----> Includes
+#include "usbplanner.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+// <---- Includes
+
+// The main function
+int main(int argc, char *argv[])
+{
+    if(argc<2)
+    {
+        std::cout << "Usage: " << argv[0] << " <res> <fps> <video_device> [<video_device> ...] [--sysfs <root>]" << std::endl;
+        std::cout << " * res: HD2K, HD1080, HD720, VGA" << std::endl;
+        std::cout << " * fps: 15, 30, 60, 100" << std::endl;
+        std::cout << " * --sysfs: use a different sysfs tree (e.g. a mock tree for testing)" << std::endl;
+        std::cout << "Example: " << argv[0] << " HD720 60 /dev/video0 /dev/video2" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // ----> Parse the parameters
+    std::string sysfs_root = "/sys";
+    std::vector<std::string> args;
+    for(int i=1; i<argc; i++)
+    {
+        if(std::string(argv[i])=="--sysfs" && i+1<argc)
+            sysfs_root = argv[++i];
+        else
+            args.push_back(argv[i]);
+    }
+
+    if(args.size()<3)
+    {
+        std::cerr << "Missing parameters" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    sl_oc::video::RESOLUTION res;
+    if(args[0]=="HD2K") res = sl_oc::video::RESOLUTION::HD2K;
+    else if(args[0]=="HD1080") res = sl_oc::video::RESOLUTION::HD1080;
+    else if(args[0]=="HD720") res = sl_oc::video::RESOLUTION::HD720;
+    else if(args[0]=="VGA") res = sl_oc::video::RESOLUTION::VGA;
+    else
+    {
+        std::cerr << "Unknown resolution: " << args[0] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    sl_oc::video::FPS fps = static_cast<sl_oc::video::FPS>(std::stoi(args[1]));
+
+    std::vector<sl_oc::video::UsbCameraConfig> cams;
+    for(size_t i=2; i<args.size(); i++)
+    {
+        sl_oc::video::UsbCameraConfig cfg;
+        cfg.dev_name = args[i];
+        cfg.res = res;
+        cfg.fps = fps;
+        cams.push_back(cfg);
+    }
+    // <---- Parse the parameters
+
+    sl_oc::video::UsbBandwidthPlanner planner(sysfs_root);
+
+    // ----> USB topology
+    std::cout << "USB topology:" << std::endl;
+    for(const auto& cam : cams)
+    {
+        sl_oc::video::UsbDeviceInfo info;
+        if(!planner.getDeviceInfo(cam.dev_name, info))
+        {
+            std::cout << " * " << cam.dev_name << ": unknown USB topology" << std::endl;
+            continue;
+        }
+
+        std::cout << " * " << cam.dev_name << ": bus " << info.bus << ", port " << info.port_path << " @ "
+                  << info.speed_mbps << " Mbps - path:";
+        for(size_t l=0; l<info.links.size(); l++)
+            std::cout << " " << info.links[l] << " (" << info.link_speeds[l] << ")";
+        std::cout << std::endl;
+    }
+    // <---- USB topology
+
+    // ----> Bandwidth check
+    std::vector<sl_oc::video::UsbLinkLoad> loads;
+    bool feasible = planner.check(cams, loads);
+
+    std::cout << "Required bandwidth per camera: " << std::fixed << std::setprecision(0)
+              << sl_oc::video::UsbBandwidthPlanner::requiredBandwidth(res,fps) << " Mbps" << std::endl;
+    std::cout << "USB links load:" << std::endl;
+    for(const auto& load : loads)
+    {
+        std::cout << " * " << load.node << ": " << load.required_mbps << "/" << load.capacity_mbps << " Mbps"
+                  << (load.required_mbps>load.capacity_mbps?" [OVERLOADED]":"") << std::endl;
+    }
+    // <---- Bandwidth check
+
+    if(feasible)
+    {
+        std::cout << "The configuration is feasible" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // ----> Recommendation
+    std::cout << "The configuration is NOT feasible. ";
+    if(!planner.recommend(cams))
+    {
+        std::cout << "No feasible configuration found." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Recommended configuration:" << std::endl;
+    for(const auto& cam : cams)
+    {
+        const sl_oc::video::Resolution& r = sl_oc::video::cameraResolution[static_cast<int>(cam.res)];
+        std::cout << " * " << cam.dev_name << ": " << r.width << "x" << r.height << "@" << static_cast<int>(cam.fps) << "Hz" << std::endl;
+    }
+    // <---- Recommendation
+
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////
+////
+//// Copyright (c) 2021, STEREOLABS.
+////
+//// All rights reserved.
+////
+//// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+//// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+//// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+//// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+//// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+////
+/////////////////////////////////////////////////////////////////////////////
+
+//// ----> Includes
+#include "videocapture.hpp"
+#include "frameserver.hpp"
+#include "ocv_display.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include <opencv2/opencv.hpp>
+// <---- Includes
+
+// ----> Functions
+int runServer(std::string socket_path);
+int runClient(std::string socket_path, float max_fps);
+// <---- Functions
+
+// The main function
+int main(int argc, char *argv[])
+{
+    if(argc<2 || (std::string(argv[1])!="server" && std::string(argv[1])!="client"))
+    {
+        std::cout << "Usage: " << argv[0] << " <server|client> [socket_path] [max_fps]" << std::endl;
+        std::cout << " * server: open the camera and send the frames to the connected clients" << std::endl;
+        std::cout << " * client: receive the frames from the server, optionally limiting the frame rate" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string socket_path = (argc>2)?argv[2]:"";
+    float max_fps = (argc>3)?std::stof(argv[3]):0.0f;
+
+    if(std::string(argv[1])=="server")
+        return runServer(socket_path);
+    else
+        return runClient(socket_path, max_fps);
+}
+
+int runServer(std::string socket_path)
+{
+    sl_oc::video::VideoParams params;
+    params.res = sl_oc::video::RESOLUTION::HD720;
+    params.fps = sl_oc::video::FPS::FPS_60;
+    params.verbose = sl_oc::VERBOSITY::INFO;
+
+    // ----> Create Video Capture
+    sl_oc::video::VideoCapture cap(params);
+    if( !cap.initializeVideo() )
+    {
+        std::cerr << "Cannot open camera video capture" << std::endl;
+        std::cerr << "See verbosity level for more details." << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Connected to camera sn: " << cap.getSerialNumber() << "[" << cap.getDeviceName() << "]" << std::endl;
+    // <---- Create Video Capture
+
+    // ----> Start the frame server
+    sl_oc::video::FrameServerParams srvParams;
+    srvParams.verbose = sl_oc::VERBOSITY::INFO;
+    if( !cap.enableFrameServer(socket_path, srvParams) )
+    {
+        std::cerr << "Cannot start the frame server" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // <---- Start the frame server
+
+    std::cout << "Serving frames. Press 'q' on the stream window to quit" << std::endl;
+
+    while (1)
+    {
+        const sl_oc::video::Frame frame = cap.getLastFrame();
+
+        if(frame.data!=nullptr)
+        {
+            cv::Mat frameYUV = cv::Mat( frame.height, frame.width, CV_8UC2, frame.data );
+            cv::Mat frameBGR;
+            cv::cvtColor(frameYUV,frameBGR,cv::COLOR_YUV2BGR_YUYV);
+
+            sl_oc::tools::showImage( "Server", frameBGR, params.res  );
+        }
+
+        // ----> Keyboard handling
+        int key = cv::waitKey( 5 );
+        if(key=='q' || key=='Q') // Quit
+            break;
+        // <---- Keyboard handling
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int runClient(std::string socket_path, float max_fps)
+{
+    if(socket_path.empty())
+    {
+        std::cerr << "Please specify the path of the server socket (e.g. '/tmp/zed_oc_<serial_number>.sock')" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // ----> Connect to the server
+    sl_oc::video::FrameClient client(sl_oc::VERBOSITY::INFO);
+    if( !client.connect(socket_path, max_fps) )
+    {
+        std::cerr << "Cannot connect to the frame server. Is the server running?" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // <---- Connect to the server
+
+    uint64_t lastFrameTs = 0;
+
+    while (1)
+    {
+        sl_oc::video::ClientFrame frame;
+
+        if( client.getNextFrame(frame, 100) )
+        {
+            cv::Mat frameYUV = cv::Mat( frame.height, frame.width, CV_8UC2, const_cast<uint8_t*>(frame.data) );
+            cv::Mat frameBGR;
+            cv::cvtColor(frameYUV,frameBGR,cv::COLOR_YUV2BGR_YUYV);
+
+            std::stringstream info;
+            info << "Frame #" << frame.frame_id;
+            if(lastFrameTs!=0)
+                info << std::fixed << std::setprecision(1) << " - " << 1e9/static_cast<double>(frame.timestamp-lastFrameTs) << " Hz";
+            info << " - Dropped: " << frame.dropped;
+            lastFrameTs = frame.timestamp;
+
+            cv::putText( frameBGR, info.str(), cv::Point(20,40),cv::FONT_HERSHEY_SIMPLEX, 1.0,
+                         cv::Scalar(100,100,100), 2);
+            cv::imshow( "Client", frameBGR );
+        }
+
+        // ----> Keyboard handling
+        int key = cv::waitKey( 1 );
+        if(key=='q' || key=='Q') // Quit
+            break;
+        // <---- Keyboard handling
+    }
+
+    return EXIT_SUCCESS;
+}
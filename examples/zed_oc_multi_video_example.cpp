@@ -20,44 +20,49 @@
 
 //// ----> Includes
 #include "videocapture.hpp"
+#include "cameragroup.hpp"
+#include "framesync.hpp"
 #include "ocv_display.hpp"
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 
 #include <opencv2/opencv.hpp>
 // <---- Includes
 
-// #define TEST_FPS 1
-
 // The main function
 int main(int argc, char *argv[])
 {
-    // ----> Silence unused warning
-    (void)argc;
-    (void)argv;
-    // <---- Silence unused warning
-
     sl_oc::video::VideoParams params;
     params.res = sl_oc::video::RESOLUTION::HD720;
     params.fps = sl_oc::video::FPS::FPS_60;
 
-    // ----> Create Video Capture 0
-    sl_oc::video::VideoCapture cap_0(params);
-    if( !cap_0.initializeVideo(0) )
+    // ----> Create the Camera Group
+    // All the cameras are grabbed by a single thread, whatever their number
+    sl_oc::video::CameraGroup group(params);
+
+    if(argc>1)
     {
-        std::cerr << "Cannot open camera video capture" << std::endl;
-        std::cerr << "See verbosity level for more details." << std::endl;
+        // Open the devices given on the command line (e.g. `0 2 4` for `/dev/video0`, `/dev/video2`, `/dev/video4`)
+        for(int i=1; i<argc; i++)
+        {
+            if(group.addCamera(std::stoi(argv[i]))<0)
+            {
+                std::cerr << "Cannot open camera video capture /dev/video" << argv[i] << std::endl;
+                std::cerr << "See verbosity level for more details." << std::endl;
 
-        return EXIT_FAILURE;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    else
+    {
+        // Open all the available cameras
+        while(group.addCamera()>=0) {}
     }
 
-    std::cout << "Connected to camera sn: " << cap_0.getSerialNumber() << " [" << cap_0.getDeviceName() << "]" << std::endl;
-    // <---- Create Video Capture 0
-
-    // ----> Create Video Capture 1
-    sl_oc::video::VideoCapture cap_1(params);
-    if( !cap_1.initializeVideo(2) )
+    if(group.getCameraCount()==0)
     {
         std::cerr << "Cannot open camera video capture" << std::endl;
         std::cerr << "See verbosity level for more details." << std::endl;
@@ -65,86 +70,85 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    std::cout << "Connected to camera sn: " << cap_1.getSerialNumber() << " [" << cap_1.getDeviceName() << "]" << std::endl;
-    // <---- Create Video Capture 1
+    for(size_t i=0; i<group.getCameraCount(); i++)
+    {
+        sl_oc::video::VideoCapture* cap = group.getCamera(i);
+        std::cout << "Connected to camera sn: " << cap->getSerialNumber() << " [" << cap->getDeviceName() << "]" << std::endl;
+    }
+    // <---- Create the Camera Group
 
     // Set video parameters
     bool autoSettingEnable = true;
-    cap_0.setAutoWhiteBalance(autoSettingEnable);
-    cap_0.setAECAGC(autoSettingEnable);
+    for(size_t i=0; i<group.getCameraCount(); i++)
+    {
+        group.getCamera(i)->setAutoWhiteBalance(autoSettingEnable);
+        group.getCamera(i)->setAECAGC(autoSettingEnable);
+    }
 
-    cap_1.setAutoWhiteBalance(autoSettingEnable);
-    cap_1.setAECAGC(autoSettingEnable);
+    // ----> Frame synchronizer
+    // The frames of the cameras are matched by timestamp: the tolerance must be lower than half of the frame period
+    uint64_t frame_period = 1000000000ULL/static_cast<uint64_t>(params.fps);
+    sl_oc::video::FrameSynchronizer sync(group.getCameraCount(), frame_period/3);
+    sl_oc::video::FrameTuple tuple;
+    // <---- Frame synchronizer
 
-#ifdef TEST_FPS
-    // Timestamp to check FPS
-    double lastTime = static_cast<double>(getSteadyTimestamp())/1e9;
-    // Frame timestamp to check FPS
-    uint64_t lastFrameTs = 0;
-#endif
+    if(!group.start())
+    {
+        std::cerr << "Cannot start the camera group" << std::endl;
+        return EXIT_FAILURE;
+    }
 
     // Infinite video grabbing loop
     while (1)
     {
-        // Get last available frame
-        const sl_oc::video::Frame frame_0 = cap_0.getLastFrame();
-        const sl_oc::video::Frame frame_1 = cap_1.getLastFrame();
+        // Get the next frame of any camera
+        sl_oc::video::GroupFrame grpFrame;
 
-        // ----> If the frame is valid we can display it
-        if(frame_0.data!=nullptr && frame_1.data!=nullptr)
+        // ----> If a tuple of synchronized frames is available we can display it
+        if(group.getNextFrame(grpFrame) && sync.push(grpFrame.camera, grpFrame.frame, tuple))
         {
-#ifdef TEST_FPS
-            if(lastFrameTs!=0)
+            std::stringstream info;
+            info << "Skew: " << std::fixed << std::setprecision(2) << static_cast<double>(tuple.skew)/1e6 << " msec";
+
+            for(size_t c=0; c<tuple.frames.size(); c++)
             {
-                // ----> System time
-                double now = static_cast<double>(getSteadyTimestamp())/1e9;
-                double elapsed_sec = now - lastTime;
-                lastTime = now;
-                std::cout << "[System] Frame period: " << elapsed_sec << "sec - Freq: " << 1./elapsed_sec << " Hz" << std::endl;
-                // <---- System time
-
-                // ----> Frame time
-                double frame_dT = static_cast<double>(frame.timestamp-lastFrameTs)/1e9;
-                std::cout << "[Camera] Frame period: " << frame_dT << "sec - Freq: " << 1./frame_dT << " Hz" << std::endl;
-                // <---- Frame time
+                const sl_oc::video::Frame& frame = tuple.frames[c];
+
+                // ----> Conversion from YUV 4:2:2 to BGR for visualization
+                cv::Mat frameYUV = cv::Mat( frame.height, frame.width, CV_8UC2, frame.data );
+                cv::Mat frameBGR;
+                cv::cvtColor(frameYUV,frameBGR,cv::COLOR_YUV2BGR_YUYV);
+                // <---- Conversion from YUV 4:2:2 to BGR for visualization
+
+                // Show frame
+                sl_oc::tools::showImage( "Stream RGB #" + std::to_string(c), frameBGR, params.res, true, info.str() );
             }
-            lastFrameTs = frame.timestamp;
-#endif
-
-            // ----> Conversion from YUV 4:2:2 to BGR for visualization
-            cv::Mat frameYUV_0 = cv::Mat( frame_0.height, frame_0.width, CV_8UC2, frame_0.data );
-            cv::Mat frameBGR_0;
-            cv::Mat frameYUV_1 = cv::Mat( frame_1.height, frame_1.width, CV_8UC2, frame_1.data );
-            cv::Mat frameBGR_1;
-            cv::cvtColor(frameYUV_0,frameBGR_0,cv::COLOR_YUV2BGR_YUYV);
-            cv::cvtColor(frameYUV_1,frameBGR_1,cv::COLOR_YUV2BGR_YUYV);
-            // <---- Conversion from YUV 4:2:2 to BGR for visualization
-
-            // Show frame
-            sl_oc::tools::showImage( "Stream RGB #0", frameBGR_0, params.res  );
-            sl_oc::tools::showImage( "Stream RGB #1", frameBGR_1, params.res  );
         }
-        // <---- If the frame is valid we can display it
+        // <---- If a tuple of synchronized frames is available we can display it
 
         // ----> Keyboard handling
-        int key = cv::waitKey( 5 );
+        int key = cv::waitKey( 1 );
         if(key=='q' || key=='Q') // Quit
             break;
         if(key=='a' || key=='A')
         {
             autoSettingEnable = !autoSettingEnable;
-            cap_0.setAutoWhiteBalance(autoSettingEnable);
-            cap_0.setAECAGC(autoSettingEnable);
-
-            cap_1.setAutoWhiteBalance(autoSettingEnable);
-            cap_1.setAECAGC(autoSettingEnable);
+            for(size_t i=0; i<group.getCameraCount(); i++)
+            {
+                group.getCamera(i)->setAutoWhiteBalance(autoSettingEnable);
+                group.getCamera(i)->setAECAGC(autoSettingEnable);
+            }
 
             std::cout << "Auto GAIN/EXPOSURE and Auto White Balance: " << (autoSettingEnable?"ENABLED":"DISABLED") << std::endl;
         }
         // <---- Keyboard handling
     }
 
+    std::cout << "Synchronized tuples: " << sync.getTupleCount() << " - max skew: "
+              << static_cast<double>(sync.getMaxSkew())/1e6 << " msec" << std::endl;
+    for(size_t i=0; i<group.getCameraCount(); i++)
+        std::cout << "Camera #" << i << " - dropped frames: " << group.getDroppedCount(i)
+                  << " - unmatched frames: " << sync.getDroppedCount(i) << std::endl;
+
     return EXIT_SUCCESS;
 }
-
-
@@ -0,0 +1,170 @@
+////////////////////////////////////////////////////////////////////////////
+////
+//// Copyright (c) 2021, STEREOLABS.
+////
+//// All rights reserved.
+////
+//// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+//// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+//// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+//// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+//// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+//// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+//// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+////
+/////////////////////////////////////////////////////////////////////////////
+
+//// ----> Includes
+#include "videocapture.hpp"
+#include "shmframering.hpp"
+#include "ocv_display.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include <opencv2/opencv.hpp>
+// <---- Includes
+
+// ----> Functions
+int runPublisher(std::string name);
+int runSubscriber(std::string name);
+// <---- Functions
+
+// The main function
+int main(int argc, char *argv[])
+{
+    if(argc<2 || (std::string(argv[1])!="pub" && std::string(argv[1])!="sub"))
+    {
+        std::cout << "Usage: " << argv[0] << " <pub|sub> [shm_name]" << std::endl;
+        std::cout << " * pub: open the camera and publish the frames in the shared memory ring" << std::endl;
+        std::cout << " * sub: read the frames from the shared memory ring (run as many as you want)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string name = (argc>2)?argv[2]:"";
+
+    if(std::string(argv[1])=="pub")
+        return runPublisher(name);
+    else
+        return runSubscriber(name);
+}
+
+int runPublisher(std::string name)
+{
+    sl_oc::video::VideoParams params;
+    params.res = sl_oc::video::RESOLUTION::HD720;
+    params.fps = sl_oc::video::FPS::FPS_60;
+    params.verbose = sl_oc::VERBOSITY::INFO;
+
+    // ----> Create Video Capture
+    sl_oc::video::VideoCapture cap(params);
+    if( !cap.initializeVideo() )
+    {
+        std::cerr << "Cannot open camera video capture" << std::endl;
+        std::cerr << "See verbosity level for more details." << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Connected to camera sn: " << cap.getSerialNumber() << "[" << cap.getDeviceName() << "]" << std::endl;
+    // <---- Create Video Capture
+
+    // ----> Enable the publisher mode
+    if( !cap.enableShmPublisher(name) )
+    {
+        std::cerr << "Cannot create the shared memory ring" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // <---- Enable the publisher mode
+
+    std::cout << "Publishing frames. Press 'q' on the stream window to quit" << std::endl;
+
+    // Infinite video grabbing loop
+    while (1)
+    {
+        // Get last available frame
+        const sl_oc::video::Frame frame = cap.getLastFrame();
+
+        // ----> If the frame is valid we can display it
+        if(frame.data!=nullptr)
+        {
+            cv::Mat frameYUV = cv::Mat( frame.height, frame.width, CV_8UC2, frame.data );
+            cv::Mat frameBGR;
+            cv::cvtColor(frameYUV,frameBGR,cv::COLOR_YUV2BGR_YUYV);
+
+            sl_oc::tools::showImage( "Publisher", frameBGR, params.res  );
+        }
+        // <---- If the frame is valid we can display it
+
+        // ----> Keyboard handling
+        int key = cv::waitKey( 5 );
+        if(key=='q' || key=='Q') // Quit
+            break;
+        // <---- Keyboard handling
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int runSubscriber(std::string name)
+{
+    // ----> Map the shared memory ring
+    sl_oc::video::ShmFrameSubscriber sub(sl_oc::VERBOSITY::INFO);
+
+    if(name.empty())
+    {
+        std::cerr << "Please specify the name of the shared memory ring (e.g. '/zed_oc_<serial_number>')" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if( !sub.open(name) )
+    {
+        std::cerr << "Cannot open the shared memory ring. Is the publisher running?" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // <---- Map the shared memory ring
+
+    uint64_t lastFrameTs = 0;
+
+    while (1)
+    {
+        sl_oc::video::ShmFrame frame;
+
+        // ----> Process the next frame directly from the shared memory
+        if( sub.getNextFrame(frame, 100) )
+        {
+            cv::Mat frameYUV = cv::Mat( frame.height, frame.width, CV_8UC2, const_cast<uint8_t*>(frame.data) );
+            cv::Mat frameBGR;
+            cv::cvtColor(frameYUV,frameBGR,cv::COLOR_YUV2BGR_YUYV);
+
+            // The slot could have been overwritten by the publisher during the conversion
+            if( sub.isValid(frame) )
+            {
+                std::stringstream info;
+                info << "Frame #" << frame.frame_id;
+                if(lastFrameTs!=0)
+                    info << std::fixed << std::setprecision(1) << " - " << 1e9/static_cast<double>(frame.timestamp-lastFrameTs) << " Hz";
+                info << " - Dropped: " << sub.getDroppedCount();
+                lastFrameTs = frame.timestamp;
+
+                cv::putText( frameBGR, info.str(), cv::Point(20,40),cv::FONT_HERSHEY_SIMPLEX, 1.0,
+                             cv::Scalar(100,100,100), 2);
+                cv::imshow( "Subscriber", frameBGR );
+            }
+        }
+        // <---- Process the next frame directly from the shared memory
+
+        // ----> Keyboard handling
+        int key = cv::waitKey( 1 );
+        if(key=='q' || key=='Q') // Quit
+            break;
+        // <---- Keyboard handling
+    }
+
+    return EXIT_SUCCESS;
+}
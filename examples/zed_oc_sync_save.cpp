@@ -34,12 +34,13 @@
 // Sample includes
 #include "calibration.hpp"
 #include "ocv_display.hpp"
+#include "recording.hpp"
 // <---- Includes
 // <---- Includes
 
 // ----> Functions
 // Sensor acquisition runs at 400Hz, so it must be executed in a different thread
-void getSensorThreadFunc(sl_oc::sensors::SensorCapture* sensCap);
+void getSensorThreadFunc(sl_oc::sensors::SensorCapture* sensCap, std::string imu_file);
 // <---- Functions
 
 // ----> Global variables
@@ -56,11 +57,13 @@ uint64_t mcu_sync_ts=0;
 int main(int argc, char *argv[])
 {
     // Remove the unused warning silencing since we'll use argc/argv
-    if(argc != 2)
+    if(argc < 2 || argc > 3 || (argc==3 && std::string(argv[2])!="--raw"))
     {
-        std::cout << "Usage: " << argv[0] << " <output_directory>" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <output_directory> [--raw]" << std::endl;
+        std::cout << " * --raw: save the images without rectification, e.g. to be converted later with `zed_open_capture_rec_convert`" << std::endl;
         return EXIT_FAILURE;
     }
+    bool save_raw = (argc==3);
 
     // Create output directory and subdirectories if they don't exist
     std::string output_dir = argv[1];
@@ -126,7 +129,7 @@ int main(int argc, char *argv[])
 
     // Start the sensor capture thread. Note: since sensor data can be retrieved at 400Hz and video data frequency is
     // minor (max 100Hz), we use a separated thread for sensors.
-    std::thread sensThread(getSensorThreadFunc,&sensCap);
+    std::thread sensThread(getSensorThreadFunc,&sensCap,output_dir + "/" + sl_oc::tools::REC_IMU_FILE);
     // <---- Create Sensors Capture
 
     // ----> Enable video/sensors synchronization
@@ -217,8 +220,16 @@ int main(int argc, char *argv[])
             right_raw = frameBGR(cv::Rect(frameBGR.cols / 2, 0, frameBGR.cols / 2, frameBGR.rows));
             
             // ----> Apply rectification
-            cv::remap(left_raw, left_rect, map_left_x, map_left_y, cv::INTER_LINEAR );
-            cv::remap(right_raw, right_rect, map_right_x, map_right_y, cv::INTER_LINEAR );;
+            if(save_raw)
+            {
+                left_rect = left_raw;
+                right_rect = right_raw;
+            }
+            else
+            {
+                cv::remap(left_raw, left_rect, map_left_x, map_left_y, cv::INTER_LINEAR );
+                cv::remap(right_raw, right_rect, map_right_x, map_right_y, cv::INTER_LINEAR );
+            }
 
             // ----> Save rectified images
             std::stringstream left_filename, right_filename;
@@ -252,11 +263,17 @@ int main(int argc, char *argv[])
 }
 
 // Sensor acquisition runs at 400Hz, so it must be executed in a different thread
-void getSensorThreadFunc(sl_oc::sensors::SensorCapture* sensCap)
+void getSensorThreadFunc(sl_oc::sensors::SensorCapture* sensCap, std::string imu_file)
 {
     // Flag to stop the thread
     sensThreadStop = false;
 
+    // ----> IMU log, indexed by `zed_open_capture_rec_index`
+    std::ofstream imuLog(imu_file, std::ios::app);
+    if(imuLog.tellp()==0)
+        imuLog << sl_oc::tools::REC_IMU_CSV_HEADER << std::endl;
+    // <---- IMU log
+
     // Previous IMU timestamp to calculate frequency
     uint64_t last_imu_ts = 0;
 
@@ -283,6 +300,12 @@ void getSensorThreadFunc(sl_oc::sensors::SensorCapture* sensCap)
             gyro << std::fixed << std::showpos << std::setprecision(4) << " * Gyro: " << imuData.gX << " " << imuData.gY << " " << imuData.gZ << " [deg/s]";
             // <---- Data info to be displayed
 
+            // Each sample is written on a single line starting with the timestamp
+            imuLog << imuData.timestamp << std::setprecision(6) << std::noshowpos
+                   << "," << imuData.aX << "," << imuData.aY << "," << imuData.aZ
+                   << "," << imuData.gX << "," << imuData.gY << "," << imuData.gZ
+                   << "," << imuData.temp << "," << (imuData.sync?1:0) << "\n";
+
             // Mutex to not overwrite data while diplaying them
             imuMutex.lock();
 
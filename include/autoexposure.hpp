@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef AUTOEXPOSURE_HPP
+#define AUTOEXPOSURE_HPP
+
+#include "defines.hpp"
+#include "framestats.hpp"
+
+#include <vector>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief The host auto exposure configuration parameters
+ */
+struct SL_OC_EXPORT AutoExposureParams
+{
+    /*!
+     * \brief Default constructor setting the default parameter values
+     */
+    AutoExposureParams() {
+        target_luma = 110.0f;
+        tolerance = 4.0f;
+        max_saturation = 1.0f;
+        speed = 0.6f;
+        settle_frames = 2;
+        max_exposure = 100.0f;
+        max_gain = 100;
+    }
+
+    std::vector<float> roi_weights; //!< Weight of each metering ROI (see \ref FrameStatsParams::rois). Empty for equal weights
+    float target_luma;      //!< Target weighted mean luma [0,255]
+    float tolerance;        //!< Dead band around the target, in luma levels
+    float max_saturation;   //!< Maximum percentage of saturated pixels. The exposure is reduced above this value
+    float speed;            //!< Convergence speed (0,1]: fraction of the correction applied at each update, in log scale. `1` to correct in a single step
+    int settle_frames;      //!< Number of frames ignored after each change, the time for the sensors to apply it
+    float max_exposure;     //!< Maximum exposure [0,100], to limit the motion blur
+    int max_gain;           //!< Maximum gain [0,100], to limit the noise
+};
+
+/*!
+ * \brief Status of the host auto exposure
+ */
+struct SL_OC_EXPORT AutoExposureStatus
+{
+    float luma = 0.0f;          //!< Last measured weighted luma
+    float saturation = 0.0f;    //!< Last measured weighted saturation percentage
+    float exposure = 0.0f;      //!< Current exposure [0,100]
+    int gain = 0;               //!< Current gain [0,100]
+    bool converged = false;     //!< Indicates if the last measured luma is inside the dead band
+    uint64_t updates = 0;       //!< Number of exposure/gain changes
+    uint64_t overruns = 0;      //!< Number of changes applied later than one frame period after the frame reception
+    double latency_usec = 0.0;  //!< Delay between the reception of the last metered frame and the end of its change
+};
+
+/*!
+ * \brief The AutoExposureController class computes the exposure and the gain that bring the metered luma of the
+ *        frames to a target value.
+ *
+ * The luma is the weighted mean of the luma of the metering regions of both eyes (see \ref FrameStats). The
+ * controller works on the total exposure (exposure time x linear gain) in log scale, so that the convergence
+ * speed does not depend on the scene brightness, and splits it by giving priority to the exposure time to
+ * keep the noise low.
+ *
+ * \note It is normally used by \ref VideoCapture::enableHostAutoExposure
+ */
+class SL_OC_EXPORT AutoExposureController
+{
+public:
+    /*!
+     * \brief Set the controller parameters
+     * \param params the controller parameters (see \ref AutoExposureParams)
+     * \param roi_count number of metering regions
+     * \param gain_table linear gain for each gain value in [0,100]
+     * \param min_exposure minimum exposure [0,100] accepted by the sensors
+     * \return false if the parameters are not valid
+     */
+    bool configure(const AutoExposureParams& params, size_t roi_count, const std::vector<double>& gain_table,
+                   float min_exposure);
+
+    /*!
+     * \brief Set the current exposure and gain, e.g. read from the sensors
+     * \param exposure current exposure [0,100]
+     * \param gain current gain [0,100]
+     */
+    void setState(float exposure, int gain);
+
+    /*!
+     * \brief Meter a frame and compute the new exposure and gain
+     * \param stats the luma statistics of the frame
+     * \param exposure the returned exposure [0,100]
+     * \param gain the returned gain [0,100]
+     * \return true if the exposure or the gain changed and must be applied
+     */
+    bool update(const FrameStats& stats, float& exposure, int& gain);
+
+    /*!
+     * \brief Get the status of the controller
+     * \return the controller status. The latency fields are not filled
+     */
+    AutoExposureStatus getStatus() const;
+
+    /*!
+     * \brief Get the number of frames to be ignored after each change
+     * \return the value of \ref AutoExposureParams::settle_frames
+     */
+    inline int getSettleFrames() const {return mParams.settle_frames;}
+
+private:
+    AutoExposureParams mParams;     //!< Controller parameters
+    std::vector<float> mWeights;    //!< Normalized weights of the metering regions
+    std::vector<double> mGainTable; //!< Linear gain for each gain value
+    float mMinExposure=0.0f;        //!< Minimum exposure
+
+    float mExposure=0.0f;           //!< Current exposure
+    int mGain=0;                    //!< Current gain
+    float mLuma=0.0f;               //!< Last measured luma
+    float mSaturation=0.0f;         //!< Last measured saturation
+    bool mConverged=false;          //!< Indicates if the last measured luma is inside the dead band
+    uint64_t mUpdates=0;            //!< Number of changes
+};
+
+}
+
+}
+
+#endif
+
+#endif // AUTOEXPOSURE_HPP
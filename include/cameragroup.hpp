@@ -0,0 +1,184 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef CAMERAGROUP_HPP
+#define CAMERAGROUP_HPP
+
+#include "videocapture.hpp"
+#include "usbplanner.hpp"
+
+#include <deque>
+#include <condition_variable>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief A frame delivered by a \ref CameraGroup
+ *
+ * \note `frame.data` points to a buffer of the group: it is valid until the next call of
+ * \ref CameraGroup::getNextFrame
+ */
+struct SL_OC_EXPORT GroupFrame
+{
+    int camera = -1;            //!< Index of the camera in the group
+    int serial_number = -1;     //!< Serial number of the camera
+    Frame frame;                //!< The frame
+};
+
+/*!
+ * \brief The CameraGroup class grabs the frames of several cameras using a single reactor thread and delivers
+ *        them through a single queue, whatever the number of cameras
+ *
+ * The file descriptors of all the devices are serviced by an `epoll` reactor. Each camera has a small pool of frame
+ * buffers: if the consumer is slower than the cameras, the oldest queued frame of the camera is dropped and its
+ * buffer reused, so a camera never waits for the consumer.
+ *
+ * The cameras can be controlled using \ref getCamera, but their frames must only be retrieved with \ref getNextFrame.
+ */
+class SL_OC_EXPORT CameraGroup
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the initialization parameters used for all the cameras (see \ref VideoParams)
+     * \param buffers_per_camera number of frame buffers for each camera (minimum 2)
+     */
+    CameraGroup( VideoParams params = VideoParams(), uint8_t buffers_per_camera=3 );
+
+    /*!
+     * \brief The class destructor. All the cameras are closed
+     */
+    virtual ~CameraGroup();
+
+    /*!
+     * \brief Open a camera and add it to the group
+     * \param devId Id of the camera (see `/dev/video*`). Use `-1` to open the first available camera not
+     *        already in the group
+     * \return the index of the camera in the group, `-1` if the camera cannot be opened
+     *
+     * \note Cameras can only be added before calling \ref start
+     *
+     * \note If the USB bandwidth check is enabled (default), a camera is not opened when the USB links it shares with
+     * the cameras already in the group cannot carry its stream (see \ref UsbBandwidthPlanner)
+     */
+    int addCamera( int devId=-1 );
+
+    /*!
+     * \brief Enable or disable the USB bandwidth verification performed by \ref addCamera
+     * \param enable true to verify the bandwidth before opening each camera
+     * \param sysfs_root root of the sysfs tree describing the USB topology
+     */
+    void enableUsbBandwidthCheck( bool enable, std::string sysfs_root="/sys" );
+
+    /*!
+     * \brief Start the reactor thread grabbing the frames of all the cameras
+     * \return true if the reactor has been correctly started
+     */
+    bool start();
+
+    /*!
+     * \brief Stop the reactor thread. The cameras stay open
+     */
+    void stop();
+
+    /*!
+     * \brief Get the next frame grabbed by any camera of the group, in order of arrival
+     * \param frame the returned frame
+     * \param timeout_msec waiting timeout in milliseconds
+     * \return true if a new frame has been received before the timeout
+     */
+    bool getNextFrame( GroupFrame& frame, uint64_t timeout_msec=100 );
+
+    /*!
+     * \brief Get the number of cameras in the group
+     * \return the number of cameras
+     */
+    inline size_t getCameraCount(){return mCameras.size();}
+
+    /*!
+     * \brief Get a camera of the group, to change its settings
+     * \param idx index of the camera
+     * \return the camera, `nullptr` if the index is not valid
+     *
+     * \note Do not call \ref VideoCapture::getLastFrame on the returned object
+     */
+    VideoCapture* getCamera( size_t idx );
+
+    /*!
+     * \brief Get the number of frames of a camera dropped because the consumer was too slow
+     * \param idx index of the camera
+     * \return the number of dropped frames
+     */
+    uint64_t getDroppedCount( size_t idx );
+
+private:
+    void reactorThreadFunc();           //!< The reactor thread function
+    bool grabCamera( size_t cam );      //!< Grab a ready frame of a camera into a free buffer
+    int acquireBuffer( size_t cam );    //!< Get a free buffer of a camera, dropping its oldest queued frame if needed
+    bool checkUsbBandwidth( int devId );//!< Verify that the camera `devId` can be added to the USB configuration of the group
+
+    /*!
+     * \brief Queued frame, identified by camera and buffer
+     */
+    struct QueueItem
+    {
+        int cam;                        //!< Index of the camera
+        int buf;                        //!< Index of the buffer of the camera
+    };
+
+private:
+    VideoParams mParams;                //!< Parameters used for all the cameras
+    uint8_t mBufPerCam;                 //!< Number of buffers of each camera
+
+    std::vector<VideoCapture*> mCameras;            //!< The cameras of the group
+    std::vector<std::vector<Frame>> mBuffers;       //!< Frame buffers of each camera
+    std::vector<std::vector<int>> mFreeBuffers;     //!< Free buffers of each camera
+    std::vector<uint64_t> mDropped;                 //!< Dropped frames of each camera
+
+    bool mUsbCheck=true;                //!< Indicates if the USB bandwidth is verified before opening a camera
+    UsbBandwidthPlanner mUsbPlanner;    //!< USB bandwidth planner
+    std::vector<UsbCameraConfig> mUsbConfigs;       //!< USB configuration of the opened cameras
+
+    std::mutex mQueueMutex;             //!< Mutex for safe access to the queue and to the free buffers
+    std::condition_variable mQueueCond; //!< Signals new frames in the queue
+    std::deque<QueueItem> mQueue;       //!< Frames waiting for the consumer
+    QueueItem mHeld = {-1,-1};          //!< Frame returned by the last call of getNextFrame
+
+    int mEpollFd=-1;                    //!< The reactor
+    int mEventFd=-1;                    //!< Used to wake up the reactor when stopping
+    bool mStopReactor=true;             //!< Indicates if the reactor thread must be stopped
+    std::thread mReactorThread;         //!< The reactor thread
+};
+
+}
+
+}
+
+#endif
+
+/** \example zed_oc_multi_video_example.cpp
+ * Example of how to use the CameraGroup class to grab the frames of several cameras with a single thread.
+ */
+
+#endif // CAMERAGROUP_HPP
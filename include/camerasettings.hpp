@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef CAMERASETTINGS_HPP
+#define CAMERASETTINGS_HPP
+
+#include "defines.hpp"
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief Region of interest of the automatic Exposure and Gain control of a sensor, in pixels of the single image
+ */
+struct SL_OC_EXPORT AecAgcRoi
+{
+    uint16_t x = 0;     //!< Top left X coordinate
+    uint16_t y = 0;     //!< Top left Y coordinate
+    uint16_t w = 0;     //!< Width. `0` if the ROI is not part of the settings
+    uint16_t h = 0;     //!< Height
+
+    inline bool operator==(const AecAgcRoi& o) const {return x==o.x && y==o.y && w==o.w && h==o.h;}
+    inline bool operator!=(const AecAgcRoi& o) const {return !(*this==o);}
+};
+
+/*!
+ * \brief Snapshot of the camera controls, see \ref VideoCapture::captureSettings and \ref VideoCapture::applySettings
+ *
+ * A negative value (or a ROI with null width) means that the control is not part of the settings and is left
+ * unchanged when the settings are applied.
+ */
+struct SL_OC_EXPORT CameraSettings
+{
+    int serial_number = -1;         //!< Serial number of the camera. `-1` if the settings are not bound to a camera
+
+    int brightness = -1;            //!< Brightness [0,8]
+    int contrast = -1;              //!< Contrast [0,8]
+    int hue = -1;                   //!< Hue [0,11]
+    int saturation = -1;            //!< Saturation [0,8]
+    int sharpness = -1;             //!< Sharpness [0,8]
+    int gamma = -1;                 //!< Gamma preset [1,9]
+
+    int auto_white_balance = -1;    //!< Automatic White Balance: `1` active, `0` manual
+    int white_balance = -1;         //!< White Balance [2800,6500], used only if the automatic White Balance is not active
+
+    int aec_agc = -1;               //!< Automatic Exposure and Gain control: `1` active, `0` manual
+    AecAgcRoi roi[2];               //!< ROI of the automatic Exposure and Gain control of the left and of the right sensor
+    int gain[2] = {-1,-1};          //!< Gain [0,100] of the left and of the right sensor, used only in manual mode
+    int exposure[2] = {-1,-1};      //!< Exposure [0,100] of the left and of the right sensor, used only in manual mode
+
+    /*!
+     * \brief Write the settings in a text file, one `key=value` line for each control
+     * \param filename name of the file. It is replaced atomically
+     * \return true if the file has been correctly written
+     */
+    bool save(const std::string& filename) const;
+
+    /*!
+     * \brief Read the settings from a file written by \ref save. The controls missing in the file are not set
+     * \param filename name of the file
+     * \return true if the file has been correctly read
+     */
+    bool load(const std::string& filename);
+
+    /*!
+     * \brief Get the default name of the settings file of a camera
+     * \param serial_number serial number of the camera
+     * \return the file name `SN<serial_number>_settings.conf`
+     */
+    static std::string getDefaultFilename(int serial_number);
+};
+
+}
+
+}
+
+#endif
+
+#endif // CAMERASETTINGS_HPP
@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef CLOCKSYNC_HPP
+#define CLOCKSYNC_HPP
+
+#include "defines.hpp"
+
+#include <mutex>
+#include <map>
+#include <memory>
+
+namespace sl_oc {
+
+static const double CLOCK_SYNC_TIME_CONST = 30e9;       //!< Time constant [nsec] of the exponential forgetting of the old samples
+static const uint32_t CLOCK_SYNC_MIN_SAMPLES = 32;      //!< Minimum number of samples before the model can be used
+static const double CLOCK_SYNC_MIN_SPAN = 1e9;          //!< Minimum device time span [nsec] before the model can be used
+static const double CLOCK_SYNC_REJECT_SIGMA = 3.0;      //!< Late samples farther than `n*sigma` from the model are rejected
+static const double CLOCK_SYNC_MAX_SKEW = 1e-3;         //!< Maximum acceptable skew. The model is reset beyond this value
+static const int64_t CLOCK_SYNC_RESET_THRES = 1000000000LL; //!< Error [nsec] considered as a discontinuity of the device clock
+
+/*!
+ * \brief Status of the model of a device clock
+ */
+struct SL_OC_EXPORT ClockSyncStatus
+{
+    std::string name;           //!< Name of the device clock
+    bool ready = false;         //!< Indicates if the model can be used to convert the timestamps
+    uint64_t samples = 0;       //!< Number of samples used by the model
+    uint64_t rejected = 0;      //!< Number of samples rejected because received too late
+    uint64_t resets = 0;        //!< Number of resets caused by discontinuities of the device clock
+    double skew_ppm = 0.0;      //!< Rate difference between the device clock and the host clock in parts per million
+    int64_t offset = 0;         //!< Offset between host and device clock at the last sample [nsec]
+    double error = 0.0;         //!< Estimated error bound of the conversion (3 sigma of the residuals) [nsec]
+};
+
+/*!
+ * \brief The ClockSync class maps the clocks of several devices to the host monotonic clock.
+ *
+ * For each registered device clock, the pairs (device timestamp, host monotonic reception time) are fitted online
+ * with a linear model `host = offset + (1+skew)*device`, using a weighted least squares with an exponential
+ * forgetting of the old samples (\ref CLOCK_SYNC_TIME_CONST), so the slow drift of the device oscillators is followed.
+ * The reception delay is always positive: samples received later than \ref CLOCK_SYNC_REJECT_SIGMA times the residual
+ * deviation are not used. A jump of the device clock (e.g. after a reconnection) resets the model.
+ *
+ * All the devices of the process share the same reference, so the timestamps of all the cameras and sensor
+ * MCUs can be compared directly with an error bounded by the \ref ClockSyncStatus::error of each model.
+ *
+ * \note The constant part of the transport latency cannot be observed and is included in the offset
+ */
+class SL_OC_EXPORT ClockSync
+{
+public:
+    /*!
+     * \brief Get the instance shared in the process
+     * \return the shared clock service
+     */
+    static ClockSync& getInstance();
+
+    /*!
+     * \brief Register a new device clock
+     * \param name name of the device clock, used for the status report
+     * \return the identifier of the clock
+     */
+    int registerClock(const std::string& name);
+
+    /*!
+     * \brief Remove a device clock
+     * \param id the identifier returned by \ref registerClock
+     */
+    void unregisterClock(int id);
+
+    /*!
+     * \brief Add a timestamp pair to the model of a device clock
+     * \param id the identifier returned by \ref registerClock
+     * \param device_ts device timestamp in nanoseconds
+     * \param host_ts host monotonic time of the reception of the data in nanoseconds
+     * \return false if the sample has been rejected
+     */
+    bool addSample(int id, uint64_t device_ts, uint64_t host_ts);
+
+    /*!
+     * \brief Convert a device timestamp to the host monotonic clock
+     * \param id the identifier returned by \ref registerClock
+     * \param device_ts device timestamp in nanoseconds
+     * \param host_ts the returned host monotonic timestamp in nanoseconds
+     * \return false if the model of the clock is not yet ready
+     */
+    bool toHost(int id, uint64_t device_ts, uint64_t& host_ts);
+
+    /*!
+     * \brief Get the status of the model of a device clock
+     * \param id the identifier returned by \ref registerClock
+     * \param status the returned status
+     * \return false if the identifier is not valid
+     */
+    bool getStatus(int id, ClockSyncStatus& status);
+
+    /*!
+     * \brief Get the identifiers of all the registered clocks
+     * \return the identifiers of the registered clocks
+     */
+    std::vector<int> getClockIds();
+
+private:
+    struct Model;
+
+    ClockSync() = default;
+    ~ClockSync();
+    ClockSync(const ClockSync&) = delete;
+    ClockSync& operator=(const ClockSync&) = delete;
+
+private:
+    std::mutex mMutex;                              //!< Mutex for safe access to the models
+    std::map<int,std::unique_ptr<Model>> mModels;   //!< Models of the registered clocks
+    int mNextId=0;                                  //!< Identifier of the next registered clock
+};
+
+}
+
+#endif // CLOCKSYNC_HPP
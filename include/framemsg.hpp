@@ -0,0 +1,370 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FRAMEMSG_HPP
+#define FRAMEMSG_HPP
+
+#include "defines.hpp"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace sl_oc {
+
+static const uint32_t FRAME_MSG_MAGIC = 0x4D434F5A;     //!< "ZOCM" marker at the beginning of each message
+static const uint16_t FRAME_MSG_VERSION = 1;            //!< Version of the message layout
+static const uint32_t FRAME_MSG_ALIGNMENT = 64;         //!< Alignment of the header, of each section and of the message size
+
+/*!
+ * \brief Flags describing the content of a message
+ */
+enum FRAME_MSG_FLAGS {
+    FRAME_MSG_HAS_FRAME = 0x01,     //!< The message contains a frame
+    FRAME_MSG_HAS_IMU = 0x02        //!< The message contains at least one IMU sample
+};
+
+/*!
+ * \brief Header placed at the beginning of each message.
+ *
+ * A message is a single flat block of memory, readable in place with no parsing:
+ *
+ * | Section | Offset | Size |
+ * |---------|--------|------|
+ * | \ref FrameMsgHeader | 0 | `header_size` |
+ * | Frame data | `frame_offset` | `frame_size` |
+ * | \ref FrameMsgImu array | `imu_offset` | `imu_count*imu_stride` |
+ *
+ * All the offsets and `total_size` are multiples of \ref FRAME_MSG_ALIGNMENT, so messages can be concatenated
+ * in a file or in a ring and each section can be accessed directly with SIMD loads.
+ *
+ * \note Values are stored in the host byte order (little endian on all the supported platforms).
+ * New fields can only be added at the end of the structures, increasing \ref FRAME_MSG_VERSION: readers use
+ * `header_size` and `imu_stride` to skip the fields they do not know.
+ */
+struct alignas(64) FrameMsgHeader
+{
+    uint32_t magic;         //!< Must be equal to \ref FRAME_MSG_MAGIC
+    uint16_t version;       //!< Version of the layout used to write the message
+    uint16_t header_size;   //!< Size of this header in bytes
+    uint32_t total_size;    //!< Size of the whole message in bytes, including the padding
+    uint32_t flags;         //!< Content of the message, see \ref FRAME_MSG_FLAGS
+    uint64_t frame_id;      //!< Increasing index of frames
+    uint64_t timestamp;     //!< Frame timestamp in nanoseconds
+    uint16_t width;         //!< Frame width
+    uint16_t height;        //!< Frame height
+    uint8_t channels;       //!< Number of channels per pixel
+    uint8_t reserved0;      //!< Reserved, must be zero
+    uint16_t reserved1;     //!< Reserved, must be zero
+    int32_t serial_number;  //!< Serial number of the camera
+    uint32_t frame_offset;  //!< Offset of the frame data from the beginning of the message
+    uint32_t frame_size;    //!< Size of the frame data in bytes
+    uint32_t imu_offset;    //!< Offset of the first IMU sample from the beginning of the message
+    uint32_t imu_count;     //!< Number of IMU samples
+    uint32_t imu_stride;    //!< Size in bytes of each IMU sample
+};
+
+static_assert(sizeof(FrameMsgHeader)==FRAME_MSG_ALIGNMENT, "FrameMsgHeader must fill exactly one alignment block");
+
+/*!
+ * \brief An IMU sample stored in a message. Usually the samples received since the previous frame
+ */
+struct FrameMsgImu
+{
+    uint64_t timestamp;     //!< Timestamp in nanoseconds
+    float aX;               //!< Acceleration along X axis in m/s²
+    float aY;               //!< Acceleration along Y axis in m/s²
+    float aZ;               //!< Acceleration along Z axis in m/s²
+    float gX;               //!< Angular velocity around X axis in °/s
+    float gY;               //!< Angular velocity around Y axis in °/s
+    float gZ;               //!< Angular velocity around Z axis in °/s
+    float temp;             //!< Sensor temperature in °C
+    uint8_t valid;          //!< Validity of the data, same values of `sensors::data::Imu::ImuStatus`
+    uint8_t sync;           //!< Indicates if the data are synchronized with a video frame
+    uint16_t reserved;      //!< Reserved, must be zero
+};
+
+static_assert(sizeof(FrameMsgImu)==40, "FrameMsgImu layout must not depend on the compiler");
+
+/*!
+ * \brief Round a size up to the message alignment
+ * \param size the size to be aligned
+ * \return the aligned size
+ */
+inline size_t frameMsgAlign(size_t size) {return (size+FRAME_MSG_ALIGNMENT-1) & ~static_cast<size_t>(FRAME_MSG_ALIGNMENT-1);}
+
+/*!
+ * \brief Get the size of the buffer required to store a message
+ * \param frame_size size of the frame data in bytes
+ * \param imu_count maximum number of IMU samples
+ * \return the size of the message in bytes
+ */
+inline size_t frameMsgSize(size_t frame_size, size_t imu_count)
+{
+    return sizeof(FrameMsgHeader) + frameMsgAlign(frame_size) + frameMsgAlign(imu_count*sizeof(FrameMsgImu));
+}
+
+/*!
+ * \brief The FrameMsgBuilder class writes a message directly into a buffer allocated by the caller.
+ *
+ * No memory is allocated: the buffer can be a slot of a shared memory ring, a `memfd` buffer, a memory mapped
+ * file or a simple preallocated array. The frame must be written before the IMU samples.
+ *
+ * \code
+ * std::vector<uint8_t> buf(sl_oc::frameMsgSize(frame_size,max_imu)); // once
+ * sl_oc::FrameMsgBuilder builder(buf.data(), buf.size());
+ * builder.begin(frame.frame_id, frame.timestamp, frame.width, frame.height, frame.channels, sn);
+ * builder.setFrame(frame.data, frame_size);
+ * builder.addImu(sample);
+ * size_t msg_size = builder.finish();
+ * \endcode
+ */
+class FrameMsgBuilder
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param buffer destination buffer. Must be aligned to 8 bytes at least, \ref FRAME_MSG_ALIGNMENT to access the
+     *        sections with aligned SIMD loads
+     * \param capacity size of the destination buffer in bytes
+     */
+    FrameMsgBuilder(void* buffer, size_t capacity)
+    {
+        mBuffer = static_cast<uint8_t*>(buffer);
+        mCapacity = capacity;
+    }
+
+    /*!
+     * \brief Start a new message, erasing the previous content of the buffer header
+     * \param frame_id frame index
+     * \param timestamp frame timestamp in nanoseconds
+     * \param width frame width
+     * \param height frame height
+     * \param channels number of channels per pixel
+     * \param serial_number serial number of the camera
+     * \return false if the buffer is too small to store the header
+     */
+    bool begin(uint64_t frame_id, uint64_t timestamp, uint16_t width, uint16_t height, uint8_t channels, int serial_number=-1)
+    {
+        if(mBuffer==nullptr || mCapacity<sizeof(FrameMsgHeader))
+        {
+            mHeader = nullptr;
+            return false;
+        }
+
+        mHeader = reinterpret_cast<FrameMsgHeader*>(mBuffer);
+        memset(mHeader, 0, sizeof(FrameMsgHeader));
+        mHeader->magic = FRAME_MSG_MAGIC;
+        mHeader->version = FRAME_MSG_VERSION;
+        mHeader->header_size = sizeof(FrameMsgHeader);
+        mHeader->frame_id = frame_id;
+        mHeader->timestamp = timestamp;
+        mHeader->width = width;
+        mHeader->height = height;
+        mHeader->channels = channels;
+        mHeader->serial_number = serial_number;
+        mHeader->frame_offset = sizeof(FrameMsgHeader);
+        mHeader->imu_offset = sizeof(FrameMsgHeader);
+        mHeader->imu_stride = sizeof(FrameMsgImu);
+
+        return true;
+    }
+
+    /*!
+     * \brief Reserve the space for the frame data, so that it can be written in place (e.g. by the grab copy)
+     * \param size size of the frame data in bytes
+     * \return the address where the frame data must be written, `nullptr` if the buffer is too small or if
+     *         IMU samples have already been added
+     */
+    uint8_t* reserveFrame(size_t size)
+    {
+        if(mHeader==nullptr || mHeader->imu_count>0 ||
+                sizeof(FrameMsgHeader)+frameMsgAlign(size) > mCapacity)
+            return nullptr;
+
+        mHeader->flags |= FRAME_MSG_HAS_FRAME;
+        mHeader->frame_size = static_cast<uint32_t>(size);
+        mHeader->imu_offset = static_cast<uint32_t>(sizeof(FrameMsgHeader)+frameMsgAlign(size));
+
+        return mBuffer+mHeader->frame_offset;
+    }
+
+    /*!
+     * \brief Copy the frame data in the message
+     * \param data frame data
+     * \param size size of the frame data in bytes
+     * \return false if the buffer is too small or if IMU samples have already been added
+     */
+    bool setFrame(const uint8_t* data, size_t size)
+    {
+        uint8_t* dst = reserveFrame(size);
+        if(dst==nullptr)
+            return false;
+
+        memcpy(dst, data, size);
+        return true;
+    }
+
+    /*!
+     * \brief Append an IMU sample to the message
+     * \param imu the IMU sample
+     * \return false if the buffer is too small
+     */
+    bool addImu(const FrameMsgImu& imu)
+    {
+        if(mHeader==nullptr)
+            return false;
+
+        size_t offset = mHeader->imu_offset + mHeader->imu_count*sizeof(FrameMsgImu);
+        if(offset+sizeof(FrameMsgImu) > mCapacity)
+            return false;
+
+        memcpy(mBuffer+offset, &imu, sizeof(FrameMsgImu));
+        mHeader->imu_count++;
+        mHeader->flags |= FRAME_MSG_HAS_IMU;
+
+        return true;
+    }
+
+    /*!
+     * \brief Complete the message. The padding is zeroed so that no uninitialized memory is sent or saved
+     * \return the size of the message in bytes, `0` if no message has been started
+     */
+    size_t finish()
+    {
+        if(mHeader==nullptr)
+            return 0;
+
+        size_t frame_end = mHeader->frame_offset + mHeader->frame_size;
+        size_t imu_end = mHeader->imu_offset + mHeader->imu_count*sizeof(FrameMsgImu);
+        size_t total = frameMsgAlign(imu_end);
+        if(total>mCapacity) // only if the capacity is not aligned
+            total = mCapacity;
+
+        memset(mBuffer+frame_end, 0, mHeader->imu_offset-frame_end);
+        memset(mBuffer+imu_end, 0, total-imu_end);
+
+        mHeader->total_size = static_cast<uint32_t>(total);
+        mHeader = nullptr;
+
+        return total;
+    }
+
+private:
+    uint8_t* mBuffer=nullptr;           //!< Destination buffer
+    size_t mCapacity=0;                 //!< Size of the destination buffer
+    FrameMsgHeader* mHeader=nullptr;    //!< Header of the message being built
+};
+
+/*!
+ * \brief The FrameMsgView class gives access in place to a message received from any source
+ *
+ * The message is validated once by \ref parse, then the accessors only return pointers inside the buffer.
+ */
+class FrameMsgView
+{
+public:
+    /*!
+     * \brief Validate a message
+     * \param data address of the message
+     * \param size number of bytes available at `data`
+     * \return true if the message is valid and completely contained in the available bytes, with aligned and
+     *         not overlapping sections
+     */
+    bool parse(const void* data, size_t size)
+    {
+        mHeader = nullptr;
+
+        const FrameMsgHeader* hdr = static_cast<const FrameMsgHeader*>(data);
+        if(data==nullptr || size<sizeof(FrameMsgHeader) ||
+                hdr->magic!=FRAME_MSG_MAGIC || hdr->version<1 ||
+                hdr->header_size<sizeof(FrameMsgHeader) || hdr->total_size>size)
+            return false;
+
+        // The sections are read in place: they must be aligned, after the header and must not overlap
+        if(hdr->frame_offset<hdr->header_size || hdr->frame_offset%FRAME_MSG_ALIGNMENT!=0 ||
+                hdr->imu_offset<hdr->header_size || hdr->imu_offset%FRAME_MSG_ALIGNMENT!=0 ||
+                hdr->imu_stride<sizeof(FrameMsgImu) || hdr->imu_stride%alignof(FrameMsgImu)!=0)
+            return false;
+
+        if(static_cast<uint64_t>(hdr->frame_offset)+hdr->frame_size > hdr->total_size ||
+                hdr->imu_offset + static_cast<uint64_t>(hdr->imu_count)*hdr->imu_stride > hdr->total_size)
+            return false;
+
+        if(hdr->frame_size>0 && hdr->imu_count>0 &&
+                hdr->imu_offset < static_cast<uint64_t>(hdr->frame_offset)+hdr->frame_size &&
+                hdr->frame_offset < hdr->imu_offset + static_cast<uint64_t>(hdr->imu_count)*hdr->imu_stride)
+            return false;
+
+        mHeader = hdr;
+        return true;
+    }
+
+    /*!
+     * \brief Indicates if the last parsed message is valid
+     * \return true if a valid message is available
+     */
+    inline bool isValid() const {return mHeader!=nullptr;}
+
+    /*!
+     * \brief Get the header of the message
+     * \return the message header, `nullptr` if not valid
+     */
+    inline const FrameMsgHeader* header() const {return mHeader;}
+
+    /*!
+     * \brief Get the size of the message, to reach the following message in a sequence
+     * \return the size of the message in bytes
+     */
+    inline size_t size() const {return mHeader?mHeader->total_size:0;}
+
+    /*!
+     * \brief Get the frame data
+     * \return the address of the frame data, `nullptr` if the message does not contain a frame
+     */
+    inline const uint8_t* frameData() const
+    {
+        return (mHeader && (mHeader->flags&FRAME_MSG_HAS_FRAME))?
+                    reinterpret_cast<const uint8_t*>(mHeader)+mHeader->frame_offset:nullptr;
+    }
+
+    /*!
+     * \brief Get the number of IMU samples
+     * \return the number of IMU samples
+     */
+    inline size_t imuCount() const {return mHeader?mHeader->imu_count:0;}
+
+    /*!
+     * \brief Get an IMU sample
+     * \param idx index of the sample, lower than \ref imuCount
+     * \return the IMU sample
+     */
+    inline const FrameMsgImu& imu(size_t idx) const
+    {
+        return *reinterpret_cast<const FrameMsgImu*>(reinterpret_cast<const uint8_t*>(mHeader) +
+                                                     mHeader->imu_offset + idx*mHeader->imu_stride);
+    }
+
+private:
+    const FrameMsgHeader* mHeader=nullptr;  //!< Header of the last valid message
+};
+
+}
+
+#endif // FRAMEMSG_HPP
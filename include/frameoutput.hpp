@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FRAMEOUTPUT_HPP
+#define FRAMEOUTPUT_HPP
+
+#include "defines.hpp"
+
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+struct Frame;
+
+/*!
+ * \brief Pixel format of the frames produced for a consumer
+ */
+enum class OUTPUT_FORMAT {
+    YUYV,       //!< YUV 4:2:2, as the camera frames
+    GRAY,       //!< Luma only, one channel
+    BGR         //!< 8 bit BGR, three channels (BT.601)
+};
+
+/*!
+ * \brief Description of the frames produced for a consumer (see \ref VideoCapture::addOutput)
+ */
+struct SL_OC_EXPORT OutputParams
+{
+    /*!
+     * \brief Default constructor setting the default parameter values
+     */
+    OutputParams() {
+        crop_x = 0.0f;
+        crop_y = 0.0f;
+        crop_width = 1.0f;
+        crop_height = 1.0f;
+        decimation = 1;
+        format = OUTPUT_FORMAT::YUYV;
+        max_fps = 0.0f;
+    }
+
+    float crop_x;           //!< Left border of the crop rectangle, normalized on the frame width [0,1]
+    float crop_y;           //!< Top border of the crop rectangle, normalized on the frame height [0,1]
+    float crop_width;       //!< Width of the crop rectangle, normalized on the frame width [0,1]
+    float crop_height;      //!< Height of the crop rectangle, normalized on the frame height [0,1]
+    int decimation;         //!< Box filter decimation factor: `1`, `2` or `4`
+    OUTPUT_FORMAT format;   //!< Pixel format
+    float max_fps;          //!< Maximum rate of the produced frames. `0` for no limit
+};
+
+/*!
+ * \brief A frame produced for a consumer
+ *
+ * \note The content is valid until the next call of \ref FrameOutput::getFrame
+ */
+struct SL_OC_EXPORT OutputFrame
+{
+    uint64_t frame_id = 0;          //!< Index of the source frame, see \ref Frame::frame_id
+    uint64_t timestamp = 0;         //!< Timestamp of the source frame in nanoseconds, see \ref Frame::timestamp
+    const uint8_t* data = nullptr;  //!< Frame data
+    uint16_t width = 0;             //!< Frame width
+    uint16_t height = 0;            //!< Frame height
+    uint8_t channels = 0;           //!< Number of channels per pixel
+};
+
+/*!
+ * \brief The FrameOutput class crops, decimates and converts the camera frames for a single consumer.
+ *
+ * The rows of the crop rectangle are summed by groups of `decimation` rows with SSE2 or NEON instructions, then the
+ * sums are reduced horizontally and converted to the output format, so each source pixel is read once.
+ * The frames are exchanged through three buffers: the producer never waits for the consumer and the consumer always
+ * gets the last produced frame.
+ *
+ * \note It is normally used by \ref VideoCapture::addOutput
+ */
+class SL_OC_EXPORT FrameOutput
+{
+public:
+    /*!
+     * \brief Compute the output size and allocate the buffers
+     * \param params the output description (see \ref OutputParams)
+     * \param width width of the source frames
+     * \param height height of the source frames
+     * \return false if the parameters are not valid or the crop rectangle is empty
+     */
+    bool configure(const OutputParams& params, int width, int height);
+
+    /*!
+     * \brief Produce the output of a new source frame, if the rate limit allows it
+     * \param src YUV 4:2:2 source frame, of the size set with \ref configure
+     * \return true if a new frame has been produced
+     */
+    bool process(const Frame& src);
+
+    /*!
+     * \brief Wait for a frame more recent than the last returned one
+     * \param frame the returned frame
+     * \param timeout_msec waiting timeout in milliseconds
+     * \return true if a new frame has been received before the timeout
+     */
+    bool getFrame(OutputFrame& frame, uint64_t timeout_msec=100);
+
+    /*!
+     * \brief Get the size of the produced frames
+     * \param width the frame width
+     * \param height the frame height
+     * \param channels the number of channels per pixel
+     */
+    inline void getSize(int& width, int& height, int& channels){width=mOutWidth;height=mOutHeight;channels=mChannels;}
+
+    /*!
+     * \brief Get the description of the output
+     * \return the output parameters
+     */
+    inline OutputParams getParams(){return mParams;}
+
+private:
+    struct Buffer
+    {
+        std::vector<uint8_t> data;  //!< Frame data
+        uint64_t frame_id = 0;      //!< Index of the source frame
+        uint64_t timestamp = 0;     //!< Timestamp of the source frame
+    };
+
+    static void sumRows(const uint8_t* src, size_t stride, int rows, size_t bytes, uint16_t* sums); //!< Vertical sums of `rows` rows
+    void reduceRow(const uint16_t* sums, uint8_t* dst); //!< Horizontal reduction and conversion of a row of sums
+
+private:
+    OutputParams mParams;           //!< Output description
+
+    int mSrcWidth = 0;              //!< Width of the source frames
+    int mSrcHeight = 0;             //!< Height of the source frames
+    int mX0 = 0;                    //!< Left border of the crop rectangle in pixels, even
+    int mY0 = 0;                    //!< Top border of the crop rectangle in pixels
+    int mOutWidth = 0;              //!< Width of the produced frames
+    int mOutHeight = 0;             //!< Height of the produced frames
+    int mChannels = 0;              //!< Channels of the produced frames
+    int mShift = 0;                 //!< log2 of the number of source pixels of an output pixel
+
+    std::vector<uint16_t> mSums;    //!< Vertical sums of the current output row
+    uint64_t mLastTs = 0;           //!< Monotonic timestamp of the last produced frame
+
+    Buffer mBuffers[3];             //!< Buffers being written, ready and being read
+    int mWriteIdx = 0;              //!< Buffer written by the producer
+    int mReadyIdx = 1;              //!< Last produced buffer
+    int mReadIdx = 2;               //!< Buffer returned to the consumer
+    bool mNewFrame = false;         //!< Indicates if the ready buffer has not been returned yet
+    std::mutex mMutex;              //!< Mutex for safe exchange of the buffers
+    std::condition_variable mCond;  //!< Signals a new frame to the consumer
+};
+
+}
+
+}
+
+#endif
+
+#endif // FRAMEOUTPUT_HPP
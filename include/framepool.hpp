@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FRAMEPOOL_HPP
+#define FRAMEPOOL_HPP
+
+#include "defines.hpp"
+
+#include <mutex>
+#include <map>
+#include <deque>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+static const size_t FRAME_POOL_ALIGNMENT = 64;                      //!< Minimum alignment of the pooled buffers, for SIMD loads
+static const size_t FRAME_POOL_HUGE_PAGE = 2*1024*1024;             //!< Size of the huge pages
+static const size_t FRAME_POOL_DEFAULT_CACHE = 64*1024*1024;        //!< Default maximum size of the released buffers kept for reuse
+
+/*!
+ * \brief Allocation counters of the \ref FramePool
+ */
+struct SL_OC_EXPORT FramePoolStats
+{
+    uint64_t allocations = 0;   //!< Buffers mapped from the system
+    uint64_t reuses = 0;        //!< Buffers served from the released ones
+    uint64_t huge_pages = 0;    //!< Buffers mapped on reserved huge pages (`MAP_HUGETLB`)
+    size_t used_bytes = 0;      //!< Size of the buffers in use
+    size_t cached_bytes = 0;    //!< Size of the released buffers kept for reuse
+};
+
+/*!
+ * \brief The FramePool class provides the frame buffers of all the cameras of the process.
+ *
+ * The buffers are mapped with `mmap`, so they are always page aligned (at least \ref FRAME_POOL_ALIGNMENT), and
+ * released buffers are kept for reuse: closing and opening a camera again with the same configuration does not
+ * map new memory.
+ *
+ * Huge pages are requested with `MAP_HUGETLB` if pages are reserved in the system, else with transparent huge
+ * pages. If a NUMA node is requested the buffer is bound to it with `mbind`, else its pages are placed on the node
+ * of the thread that writes them first, i.e. the grabbing thread.
+ */
+class SL_OC_EXPORT FramePool
+{
+public:
+    /*!
+     * \brief Get the instance shared in the process
+     * \return the shared frame pool
+     */
+    static FramePool& getInstance();
+
+    /*!
+     * \brief Get a buffer, reusing a released one with the same properties if available
+     * \param size minimum size of the buffer in bytes
+     * \param huge_pages map the buffer on huge pages
+     * \param numa_node NUMA node of the buffer pages. `-1` for the node of the first writing thread
+     * \return the buffer, `nullptr` if the memory cannot be mapped
+     */
+    uint8_t* acquire(size_t size, bool huge_pages=false, int numa_node=-1);
+
+    /*!
+     * \brief Give back a buffer returned by \ref acquire. It is kept for reuse while the cache size allows it
+     * \param data the buffer. `nullptr` is ignored
+     */
+    void release(uint8_t* data);
+
+    /*!
+     * \brief Set the maximum size of the released buffers kept for reuse. The oldest are unmapped first
+     * \param bytes the cache size in bytes. `0` to unmap the buffers as soon as they are released
+     */
+    void setMaxCachedBytes(size_t bytes);
+
+    /*!
+     * \brief Unmap all the released buffers
+     */
+    void trim();
+
+    /*!
+     * \brief Get the allocation counters
+     * \return the allocation counters
+     */
+    FramePoolStats getStats();
+
+private:
+    struct Block
+    {
+        uint8_t* data = nullptr;    //!< Mapped address
+        size_t map_size = 0;        //!< Mapped size
+        bool huge_pages = false;    //!< Requested with huge pages
+        int numa_node = -1;         //!< Requested NUMA node
+        bool hugetlb = false;       //!< Mapped on reserved huge pages
+    };
+
+    FramePool() = default;
+    ~FramePool();
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    bool map(Block& block);         //!< Map the memory of a block
+    void evict();                   //!< Unmap the oldest released blocks beyond the cache size. Must be called locked
+
+private:
+    std::mutex mMutex;                          //!< Mutex for safe access to the blocks
+    std::map<uint8_t*,Block> mUsed;             //!< Blocks in use, by address
+    std::deque<Block> mFree;                    //!< Released blocks, from the oldest
+    size_t mMaxCached=FRAME_POOL_DEFAULT_CACHE; //!< Maximum size of the released blocks
+    FramePoolStats mStats;                      //!< Allocation counters
+};
+
+}
+
+}
+
+#endif
+
+#endif // FRAMEPOOL_HPP
@@ -0,0 +1,311 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FRAMESERVER_HPP
+#define FRAMESERVER_HPP
+
+#include "defines.hpp"
+#include "framemsg.hpp"
+
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <deque>
+#include <map>
+#include <atomic>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+static const uint32_t FRAME_SRV_MAGIC = 0x53434F5A;   //!< "ZOCS" marker at the beginning of each message
+static const uint32_t FRAME_SRV_VERSION = 3;          //!< Version of the socket protocol
+
+/*!
+ * \brief Message sent by the server with each frame. The frame buffer is attached as a sealed `memfd` file
+ *        descriptor using `SCM_RIGHTS`: it contains a \ref FrameMsgHeader message with the frame data
+ */
+struct FrameSrvMsg
+{
+    uint32_t magic;         //!< Must be equal to \ref FRAME_SRV_MAGIC
+    uint32_t version;       //!< Must be equal to \ref FRAME_SRV_VERSION
+    uint64_t frame_id;      //!< Increasing index of frames
+    uint64_t timestamp;     //!< Timestamp in nanoseconds
+    uint32_t data_size;     //!< Size of the message stored in the frame buffer in bytes
+    uint16_t width;         //!< Frame width
+    uint16_t height;        //!< Frame height
+    uint8_t channels;       //!< Number of channels per pixel
+    uint64_t dropped;       //!< Number of frames dropped for this client since the connection
+};
+
+/*!
+ * \brief Request sent by a client just after the connection to configure its stream
+ */
+struct FrameSrvRequest
+{
+    uint32_t magic;         //!< Must be equal to \ref FRAME_SRV_MAGIC
+    uint32_t version;       //!< Must be equal to \ref FRAME_SRV_VERSION
+    float max_fps;          //!< Maximum frame rate to be sent to the client. `0` for no limit
+    uint32_t queue_depth;   //!< Maximum number of frames waiting to be sent. The oldest frame is dropped when full
+};
+
+/*!
+ * \brief Acknowledge sent by a client for the received frames, so that the server limits the frames in flight
+ */
+struct FrameSrvAck
+{
+    uint32_t magic;         //!< Must be equal to \ref FRAME_SRV_MAGIC
+    uint32_t version;       //!< Must be equal to \ref FRAME_SRV_VERSION
+    uint32_t count;         //!< Number of frames received since the previous acknowledge
+};
+
+/*!
+ * \brief The frame server configuration parameters
+ */
+struct FrameServerParams
+{
+    /*!
+     * \brief Default constructor setting the default parameter values
+     */
+    FrameServerParams() {
+        max_clients = 16;
+        default_max_fps = 0.0f;
+        default_queue_depth = 2;
+        buffer_pool_size = 3;
+        verbose = sl_oc::VERBOSITY::ERROR;
+    }
+
+    int max_clients;            //!< Maximum number of connected clients
+    float default_max_fps;      //!< Frame rate limit for the clients that do not request one. `0` for no limit
+    /*!
+     * \brief Queue depth for the clients that do not request one.
+     *
+     * The queue depth of a client also limits its frames sent but not yet acknowledged, held by the socket.
+     * A client pins at most `2*queue_depth+1` frame buffers: the frames waiting to be sent, the frames in
+     * flight and the frame it is reading
+     */
+    uint32_t default_queue_depth;
+    uint32_t buffer_pool_size;  //!< Number of `memfd` buffers prepared in advance for the grabbing thread
+    int verbose;                //!< Verbose mode
+};
+
+/*!
+ * \brief The FrameServer class sends the frames to the local clients connected to a Unix domain socket.
+ *
+ * Each frame is copied once into a `memfd` buffer, prepared in advance by the server thread, that is then
+ * sealed and passed to all the clients as a read-only file descriptor. The buffer contains a \ref FrameMsgHeader
+ * message, so the clients can save or forward it as-is and read it back with \ref FrameMsgView.
+ * The grabbing thread only copies the frame and, when the server thread is idle, wakes it up with a non-blocking
+ * `eventfd` write: all the other syscalls (buffer creation, sealing, sending) are done by the server thread.
+ * The server thread never blocks on a client: when a client does not read fast enough the frames are queued
+ * and the oldest is dropped when its queue is full, so a slow client cannot stall the capture or the other clients.
+ * The frames in the socket are limited too: the client acknowledges each received frame and no more than its
+ * queue depth are sent ahead, so a client that does not read cannot pin more buffers
+ * (see \ref FrameServerParams::default_queue_depth).
+ *
+ * \note DMA-BUF export of the V4L2 buffers is not used: the UVC buffers are re-queued to the driver as soon as
+ * the frame is copied, so their content cannot be shared with clients that keep them for longer.
+ *
+ * \note It is normally used by \ref VideoCapture::enableFrameServer
+ */
+class SL_OC_EXPORT FrameServer
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the server parameters (see \ref FrameServerParams)
+     */
+    FrameServer( FrameServerParams params = FrameServerParams() );
+
+    /*!
+     * \brief The class destructor
+     */
+    virtual ~FrameServer();
+
+    /*!
+     * \brief Create the listening socket and start the server thread
+     * \param socket_path path of the Unix domain socket
+     * \param width frame width
+     * \param height frame height
+     * \param channels number of channels per pixel
+     * \param serial_number serial number of the camera, stored in the messages
+     * \return true if the server is correctly started
+     */
+    bool start(std::string socket_path, uint16_t width, uint16_t height, uint8_t channels, int serial_number=-1);
+
+    /*!
+     * \brief Stop the server thread and disconnect all the clients
+     */
+    void stop();
+
+    /*!
+     * \brief Copy a new frame in a prepared buffer and notify the server thread. This function never blocks
+     *        and performs at most one non-blocking `eventfd` write
+     * \param data frame data
+     * \param size size of the frame data in bytes
+     * \param frame_id frame index
+     * \param timestamp frame timestamp in nanoseconds
+     * \return false if no buffer was available and the frame has been dropped
+     */
+    bool pushFrame(const uint8_t* data, size_t size, uint64_t frame_id, uint64_t timestamp);
+
+    /*!
+     * \brief Get the number of connected clients
+     * \return the number of connected clients
+     */
+    size_t getClientCount();
+
+    /*!
+     * \brief Get the number of frames dropped because the server thread had no buffer ready
+     * \return the number of frames not published
+     */
+    inline uint64_t getDroppedCount(){return mDropped;}
+
+    /*!
+     * \brief Get the path of the Unix domain socket
+     * \return the path of the socket
+     */
+    inline std::string getSocketPath(){return mSocketPath;}
+
+    /*!
+     * \brief Get the server parameters
+     * \return the server parameters
+     */
+    inline FrameServerParams getParams(){return mParams;}
+
+private:
+    struct Buffer;
+    struct Client;
+
+    void serverThreadFunc();            //!< The server thread function
+    bool prepareBuffers();              //!< Fill the pool of `memfd` buffers ready for the grabbing thread
+    void acceptClient();                //!< Accept a new client connection
+    bool readClientRequest(Client& client); //!< Read the stream configuration or an acknowledge sent by a client. False if disconnected
+    void dispatchReadyFrames();         //!< Seal the new frames and queue them to the clients
+    bool flushClient(Client& client);   //!< Send the queued frames to a client, without blocking
+    void removeClient(int fd);          //!< Close a client connection
+    void updateClientEvents(Client& client, bool wait_out); //!< Enable/disable the write notifications of a client
+
+private:
+    FrameServerParams mParams;          //!< Server parameters
+
+    std::string mSocketPath;            //!< Path of the Unix domain socket
+    int mListenFd=-1;                   //!< Listening socket
+    int mEpollFd=-1;                    //!< Reactor of the server thread
+    int mEventFd=-1;                    //!< Used by the grabbing thread to wake up the server thread
+
+    uint16_t mWidth=0;                  //!< Frame width
+    uint16_t mHeight=0;                 //!< Frame height
+    uint8_t mChannels=0;                //!< Number of channels per pixel
+    size_t mDataSize=0;                 //!< Frame size in bytes
+    int mSerialNumber=-1;               //!< Serial number of the camera
+
+    std::mutex mBufMutex;               //!< Mutex for safe access to the buffer queues
+    std::deque<std::shared_ptr<Buffer>> mFreeBuffers;   //!< Mapped buffers ready to be filled by the grabbing thread
+    std::deque<std::shared_ptr<Buffer>> mReadyBuffers;  //!< Filled buffers waiting for the server thread
+
+    std::mutex mClientMutex;            //!< Mutex for safe access to the client list
+    std::map<int,std::shared_ptr<Client>> mClients;     //!< Connected clients, by socket
+
+    std::atomic<uint64_t> mDropped{0};  //!< Frames dropped because no buffer was ready
+
+    bool mStopServer=true;              //!< Indicates if the server thread must be stopped
+    std::thread mServerThread;          //!< The server thread
+};
+
+/*!
+ * \brief A frame received from a \ref FrameServer, mapped read-only in the memory of the client
+ *
+ * \note The content is valid until the next call of \ref FrameClient::getNextFrame
+ */
+struct SL_OC_EXPORT ClientFrame
+{
+    uint64_t frame_id = 0;          //!< Increasing index of frames
+    uint64_t timestamp = 0;         //!< Timestamp in nanoseconds
+    const uint8_t* data = nullptr;  //!< Frame data in YUV 4:2:2 format
+    uint16_t width = 0;             //!< Frame width
+    uint16_t height = 0;            //!< Frame height
+    uint8_t channels = 0;           //!< Number of channels per pixel
+    uint64_t dropped = 0;           //!< Number of frames dropped by the server for this client
+    const FrameMsgHeader* msg = nullptr; //!< The whole received message (`msg->total_size` bytes), to save or forward it as-is
+};
+
+/*!
+ * \brief The FrameClient class connects to a \ref FrameServer and receives the frames as file descriptors
+ */
+class SL_OC_EXPORT FrameClient
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param verbose_lvl enable useful information to debug the class behaviours while running
+     */
+    FrameClient( int verbose_lvl=sl_oc::VERBOSITY::ERROR );
+
+    /*!
+     * \brief The class destructor
+     */
+    virtual ~FrameClient();
+
+    /*!
+     * \brief Connect to a frame server
+     * \param socket_path path of the Unix domain socket of the server
+     * \param max_fps maximum frame rate requested to the server. `0` for no limit
+     * \param queue_depth maximum number of frames queued by the server for this client. `0` for the server default
+     * \return true if the connection is correctly established
+     */
+    bool connect(std::string socket_path, float max_fps=0.0f, uint32_t queue_depth=0);
+
+    /*!
+     * \brief Close the connection and release the last received frame
+     */
+    void disconnect();
+
+    /*!
+     * \brief Wait for the next frame sent by the server
+     * \param frame the returned frame
+     * \param timeout_msec waiting timeout in milliseconds
+     * \return true if a new frame has been received before the timeout
+     */
+    bool getNextFrame(ClientFrame& frame, uint64_t timeout_msec=100);
+
+private:
+    void releaseFrame();                //!< Unmap the last received frame
+    void sendAck();                     //!< Acknowledge the received frames to the server, without blocking
+
+private:
+    int mVerbose=0;                     //!< Verbose status
+    int mSocket=-1;                     //!< Connected socket
+
+    uint32_t mUnacked=0;                //!< Frames received but not yet acknowledged to the server
+
+    void* mMapAddr=nullptr;             //!< Mapping of the last received frame
+    size_t mMapSize=0;                  //!< Size of the mapping of the last received frame
+};
+
+}
+
+}
+
+#endif
+
+#endif // FRAMESERVER_HPP
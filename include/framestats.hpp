@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FRAMESTATS_HPP
+#define FRAMESTATS_HPP
+
+#include "defines.hpp"
+#include "tonecurve.hpp"
+
+#include <vector>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+static const int FRAME_STATS_HIST_BINS = 64;    //!< Number of bins of the luma histograms (4 luma levels per bin)
+static const int FRAME_STATS_MAX_ROIS = 8;      //!< Maximum number of ROIs for each eye
+
+/*!
+ * \brief Region of interest of an eye image, in normalized coordinates [0,1] so that it does not depend on the
+ *        resolution. The same region is used for the left and the right images.
+ */
+struct SL_OC_EXPORT StatsRoi
+{
+    float x = 0.0f;         //!< Left border
+    float y = 0.0f;         //!< Top border
+    float width = 1.0f;     //!< Width
+    float height = 1.0f;    //!< Height
+};
+
+/*!
+ * \brief Luma statistics of a region of interest
+ */
+struct SL_OC_EXPORT LumaStats
+{
+    uint32_t histogram[FRAME_STATS_HIST_BINS];  //!< Histogram of the luma values
+    uint32_t pixels = 0;                        //!< Number of pixels of the region
+    float mean = 0.0f;                          //!< Mean luma value [0,255]
+    float saturation = 0.0f;                    //!< Percentage of pixels with luma not lower than \ref FrameStatsParams::saturation_level
+};
+
+/*!
+ * \brief Luma statistics of a frame, for each eye and each region of interest
+ */
+struct SL_OC_EXPORT FrameStats
+{
+    bool valid = false;                         //!< Indicates if the statistics have been computed for the frame
+    uint8_t roi_count = 0;                      //!< Number of regions of interest
+    LumaStats left[FRAME_STATS_MAX_ROIS];       //!< Statistics of the left image, for each region of interest
+    LumaStats right[FRAME_STATS_MAX_ROIS];      //!< Statistics of the right image, for each region of interest
+};
+
+/*!
+ * \brief The frame statistics configuration parameters
+ */
+struct SL_OC_EXPORT FrameStatsParams
+{
+    /*!
+     * \brief Default constructor setting the default parameter values
+     */
+    FrameStatsParams() {
+        saturation_level = 250;
+    }
+
+    std::vector<StatsRoi> rois;     //!< Regions of interest (max \ref FRAME_STATS_MAX_ROIS). Empty for the whole image
+    uint8_t saturation_level;       //!< Luma level considered as saturated
+};
+
+/*!
+ * \brief The FrameStatsCalculator class copies YUV 4:2:2 side-by-side frames and computes the luma statistics of
+ *        the regions of interest of each eye in the same pass.
+ *
+ * The frame is copied row by row and the statistics of a row are computed just after its copy, while it is still
+ * in the L1 cache, so the frame is read only once from the memory. Sum and saturation count use SSE2 or NEON
+ * instructions when available.
+ *
+ * \note It is normally used by \ref VideoCapture::enableFrameStats
+ */
+class SL_OC_EXPORT FrameStatsCalculator
+{
+public:
+    /*!
+     * \brief Set the regions of interest and the frame size
+     * \param params the statistics parameters (see \ref FrameStatsParams)
+     * \param width width of the side-by-side frame
+     * \param height height of the frame
+     * \param eye `-1` to copy the side-by-side frames, `0` or `1` to copy only the left or the right half of each
+     *        row into a half width frame. The statistics of the image not copied have no pixels
+     * \return false if the parameters are not valid
+     */
+    bool configure(const FrameStatsParams& params, int width, int height, int eye=-1);
+
+    /*!
+     * \brief Copy a frame and compute its statistics
+     * \param dst destination buffer
+     * \param src YUV 4:2:2 side-by-side frame
+     * \param size size of the frame data in bytes
+     * \param stats the returned statistics
+     * \param curve tone curve applied to each row after the computation of its statistics, if not null
+     */
+    void copyFrame(uint8_t* dst, const uint8_t* src, size_t size, FrameStats& stats,
+                   const ToneCurve* curve=nullptr);
+
+private:
+    struct Rect
+    {
+        int x0, y0, x1, y1;         //!< Pixel borders in the eye image, `x` even
+    };
+
+    struct Accum
+    {
+        uint32_t hist[4][FRAME_STATS_HIST_BINS]; //!< Partial histograms, interleaved to avoid dependencies
+        uint64_t sum;               //!< Sum of the luma values
+        uint32_t saturated;         //!< Number of saturated pixels
+    };
+
+    static void accumulate(const uint8_t* yuyv, int pixels, uint8_t sat_level, Accum& acc); //!< Luma statistics of a row segment
+    static void finalize(Accum& acc, uint32_t pixels, LumaStats& stats); //!< Merge the partial histograms and compute the mean
+
+private:
+    int mWidth = 0;                 //!< Width of the side-by-side frame
+    int mHeight = 0;                //!< Height of the frame
+    int mEye = -1;                  //!< Image copied, `-1` for both
+    uint8_t mSatLevel = 250;        //!< Luma level considered as saturated
+    std::vector<Rect> mRects;       //!< Regions of interest in pixels
+    std::vector<Accum> mAccums;     //!< Accumulators of the left (even) and right (odd) images, for each region
+};
+
+}
+
+}
+
+#endif
+
+#endif // FRAMESTATS_HPP
@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FRAMESYNC_HPP
+#define FRAMESYNC_HPP
+
+#include "videocapture.hpp"
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief A set of frames, one for each camera, with the closest timestamps
+ *
+ * \note The frame data belong to the \ref FrameSynchronizer and are valid until the next tuple is emitted
+ */
+struct SL_OC_EXPORT FrameTuple
+{
+    std::vector<Frame> frames;      //!< The frames, indexed by camera
+    uint64_t timestamp = 0;         //!< Timestamp of the most recent frame of the tuple [nsec]
+    uint64_t skew = 0;              //!< Difference between the most recent and the oldest frame of the tuple [nsec]
+};
+
+/*!
+ * \brief The FrameSynchronizer class matches the frames of several unsynchronized cameras by timestamp
+ *
+ * Each camera has a short history of frames. When a frame arrives, the closest frame of every other camera is
+ * searched in its history: if all the frames of the tuple are within the tolerance, the tuple is emitted. Each
+ * arrival scans the history of every camera once: its cost is proportional to the number of cameras times the
+ * (constant) history size. The frames older than the matched ones can no longer be part
+ * of a tuple and are dropped, as the frames pushed out of a full history.
+ *
+ * \note The tolerance should be lower than half of the frame period, so that each frame has at most one
+ * candidate in the history of the other cameras
+ */
+class SL_OC_EXPORT FrameSynchronizer
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param camera_count number of cameras
+     * \param tolerance_nsec maximum difference between the timestamps of the frames of a tuple [nsec]
+     * \param history number of frames stored for each camera
+     */
+    FrameSynchronizer( size_t camera_count, uint64_t tolerance_nsec, size_t history=4 );
+
+    /*!
+     * \brief The class destructor
+     */
+    virtual ~FrameSynchronizer();
+
+    /*!
+     * \brief Add a new frame. The frame data are copied
+     * \param camera index of the camera
+     * \param frame the new frame
+     * \param tuple the matched tuple, if any
+     * \return true if a new tuple has been emitted
+     */
+    bool push( size_t camera, const Frame& frame, FrameTuple& tuple );
+
+    /*!
+     * \brief Remove all the frames waiting for a match. The counters are not reset
+     */
+    void clear();
+
+    /*!
+     * \brief Get the number of frames of a camera dropped without being part of a tuple
+     * \param camera index of the camera
+     * \return the number of dropped frames
+     */
+    uint64_t getDroppedCount( size_t camera );
+
+    /*!
+     * \brief Get the number of emitted tuples
+     * \return the number of emitted tuples
+     */
+    inline uint64_t getTupleCount(){return mTupleCount;}
+
+    /*!
+     * \brief Get the maximum skew of the emitted tuples
+     * \return the maximum skew [nsec]
+     */
+    inline uint64_t getMaxSkew(){return mMaxSkew;}
+
+private:
+    /*!
+     * \brief A frame waiting for a match
+     */
+    struct Slot
+    {
+        Frame frame;                //!< The frame, with its own copy of the data
+        size_t size = 0;            //!< Size of the allocated data
+        bool valid = false;         //!< Indicates if the slot contains a frame
+    };
+
+    static void copyFrame( Slot& slot, const Frame& frame ); //!< Copy a frame in a slot, reallocating if needed
+
+private:
+    size_t mCamCount;               //!< Number of cameras
+    uint64_t mTolerance;            //!< Maximum skew of a tuple [nsec]
+    size_t mHistory;                //!< Number of slots of each camera
+
+    std::vector<std::vector<Slot>> mSlots;  //!< History of each camera
+    std::vector<Slot> mOut;         //!< Frames of the last emitted tuple
+    std::vector<int> mMatch;        //!< Temporary matched slot of each camera
+
+    std::vector<uint64_t> mDropped; //!< Dropped frames of each camera
+    uint64_t mTupleCount=0;         //!< Number of emitted tuples
+    uint64_t mMaxSkew=0;            //!< Maximum skew of the emitted tuples [nsec]
+};
+
+}
+
+}
+
+#endif
+
+#endif // FRAMESYNC_HPP
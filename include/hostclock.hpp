@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef HOSTCLOCK_HPP
+#define HOSTCLOCK_HPP
+
+#include "defines.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <time.h>
+
+namespace sl_oc {
+
+/*!
+ * \brief Clock used for the `timestamp` field of the frames and of the sensor data
+ */
+enum class CLOCK_SOURCE {
+    WALL,       //!< System wall clock (`CLOCK_REALTIME`). It follows the corrections of the time sync services
+    MONOTONIC   //!< Monotonic clock (`CLOCK_MONOTONIC`). It never jumps, but it is not related to the date
+};
+
+static const int64_t HOST_CLOCK_STEP_THRES = 1000000;       //!< Offset change [nsec] considered as a step of the wall clock
+static const uint64_t HOST_CLOCK_UPDATE_PERIOD = 10000000;  //!< Minimum time [nsec] between two offset estimations
+static const int HOST_CLOCK_FILTER_SHIFT = 3;               //!< Exponential filter weight of a new offset sample: 1/2^n
+
+/*!
+ * \brief Get the current value of `CLOCK_MONOTONIC`, the clock used by V4L2 to stamp the buffers
+ * \return the current monotonic clock in nanoseconds
+ */
+inline uint64_t getMonotonicTimestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec)*1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/*!
+ * \brief The HostClock class continuously estimates the offset between the monotonic clock and the wall clock
+ *        of the host, to convert the timestamps from a clock domain to the other.
+ *
+ * The offset is sampled reading the wall clock between two readings of the monotonic clock and it is smoothed
+ * with an exponential filter, so the conversion follows the slow slewing applied by NTP without adding the
+ * sampling noise. A change larger than \ref HOST_CLOCK_STEP_THRES is considered as a step of the wall clock and
+ * applied immediately.
+ *
+ * A single instance is shared by all the \ref video::VideoCapture and \ref sensors::SensorCapture objects of the
+ * process, so all the timestamps are converted with the same mapping.
+ */
+class SL_OC_EXPORT HostClock
+{
+public:
+    /*!
+     * \brief Get the instance shared in the process
+     * \return the shared clock mapping
+     */
+    static HostClock& getInstance()
+    {
+        static HostClock instance;
+        return instance;
+    }
+
+    /*!
+     * \brief Sample the two clocks and update the estimated offset. The call is ignored if the last update is more
+     *        recent than \ref HOST_CLOCK_UPDATE_PERIOD or if another thread is updating the estimation.
+     */
+    void update()
+    {
+        uint64_t now = getMonotonicTimestamp();
+        if( mInitialized && now-mLastUpdate.load(std::memory_order_relaxed) < HOST_CLOCK_UPDATE_PERIOD )
+            return;
+
+        std::unique_lock<std::mutex> lock(mUpdateMutex, std::try_to_lock);
+        if( !lock.owns_lock() )
+            return;
+
+        // Keep the sample with the shortest reading interval, the least affected by preemption
+        int64_t offset = 0;
+        uint64_t best_gap = UINT64_MAX;
+        for( int i=0; i<3; i++ )
+        {
+            struct timespec m0, w, m1;
+            clock_gettime(CLOCK_MONOTONIC, &m0);
+            clock_gettime(CLOCK_REALTIME, &w);
+            clock_gettime(CLOCK_MONOTONIC, &m1);
+
+            int64_t mono0 = static_cast<int64_t>(m0.tv_sec)*1000000000LL + m0.tv_nsec;
+            int64_t mono1 = static_cast<int64_t>(m1.tv_sec)*1000000000LL + m1.tv_nsec;
+            int64_t wall = static_cast<int64_t>(w.tv_sec)*1000000000LL + w.tv_nsec;
+
+            uint64_t gap = static_cast<uint64_t>(mono1-mono0);
+            if( gap < best_gap )
+            {
+                best_gap = gap;
+                offset = wall - (mono0 + (mono1-mono0)/2);
+            }
+        }
+
+        int64_t current = mOffset.load(std::memory_order_relaxed);
+        int64_t diff = offset - current;
+        if( !mInitialized || diff > HOST_CLOCK_STEP_THRES || diff < -HOST_CLOCK_STEP_THRES )
+        {
+            mOffset.store(offset, std::memory_order_relaxed);
+            mInitialized = true;
+        }
+        else
+        {
+            mOffset.store(current + diff/(1<<HOST_CLOCK_FILTER_SHIFT), std::memory_order_relaxed);
+        }
+
+        mLastUpdate.store(now, std::memory_order_relaxed);
+    }
+
+    /*!
+     * \brief Get the estimated offset between the wall clock and the monotonic clock
+     * \return the offset to be added to a monotonic timestamp to obtain a wall timestamp [nsec]
+     */
+    inline int64_t getWallOffset(){return mOffset.load(std::memory_order_relaxed);}
+
+    /*!
+     * \brief Convert a monotonic timestamp to the wall clock domain
+     * \param mono_ts monotonic timestamp in nanoseconds
+     * \return the wall timestamp in nanoseconds
+     */
+    inline uint64_t toWall(uint64_t mono_ts)
+    {
+        return static_cast<uint64_t>(static_cast<int64_t>(mono_ts) + getWallOffset());
+    }
+
+    /*!
+     * \brief Convert a wall timestamp to the monotonic clock domain
+     * \param wall_ts wall timestamp in nanoseconds
+     * \return the monotonic timestamp in nanoseconds
+     */
+    inline uint64_t toMonotonic(uint64_t wall_ts)
+    {
+        return static_cast<uint64_t>(static_cast<int64_t>(wall_ts) - getWallOffset());
+    }
+
+    /*!
+     * \brief Get the timestamp of a monotonic time point in the requested clock domain
+     * \param mono_ts monotonic timestamp in nanoseconds
+     * \param source the requested clock
+     * \return the timestamp in nanoseconds
+     */
+    inline uint64_t convert(uint64_t mono_ts, CLOCK_SOURCE source)
+    {
+        return (source==CLOCK_SOURCE::MONOTONIC)?mono_ts:toWall(mono_ts);
+    }
+
+private:
+    HostClock() {update();}
+
+    HostClock(const HostClock&) = delete;
+    HostClock& operator=(const HostClock&) = delete;
+
+private:
+    std::atomic<int64_t> mOffset{0};        //!< Estimated offset between wall clock and monotonic clock [nsec]
+    std::atomic<uint64_t> mLastUpdate{0};   //!< Monotonic timestamp of the last estimation [nsec]
+    std::atomic<bool> mInitialized{false};  //!< Indicates if the offset has been estimated at least once
+    std::mutex mUpdateMutex;                //!< Serializes the estimations
+};
+
+}
+
+#endif // HOSTCLOCK_HPP
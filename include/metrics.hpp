@@ -0,0 +1,329 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "defines.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <condition_variable>
+
+namespace sl_oc {
+
+static const uint32_t METRICS_SHM_MAGIC = 0x50434F5A;   //!< "ZOCP" marker at the beginning of the shared memory page
+static const uint32_t METRICS_SHM_VERSION = 1;          //!< Version of the shared memory layout
+static const size_t METRICS_SHM_NAME_SIZE = 120;        //!< Maximum size of a sample name, labels included
+
+/*!
+ * \brief Type of a metric, as defined by the Prometheus exposition format
+ */
+enum class METRIC_TYPE {
+    COUNTER,    //!< Monotonically increasing value
+    GAUGE,      //!< Value that can go up and down
+    HISTOGRAM   //!< Distribution of the observed values in cumulative buckets
+};
+
+/*!
+ * \brief A monotonically increasing counter. Updates are lock-free
+ */
+class SL_OC_EXPORT MetricCounter
+{
+public:
+    /*!
+     * \brief Increment the counter
+     * \param n the increment
+     */
+    inline void inc(uint64_t n=1){mValue.fetch_add(n, std::memory_order_relaxed);}
+
+    /*!
+     * \brief Get the current value
+     * \return the value of the counter
+     */
+    inline uint64_t get() const {return mValue.load(std::memory_order_relaxed);}
+
+private:
+    std::atomic<uint64_t> mValue{0};    //!< Counter value
+};
+
+/*!
+ * \brief A floating point value that can go up and down. Updates are lock-free
+ */
+class SL_OC_EXPORT MetricGauge
+{
+public:
+    /*!
+     * \brief Set the gauge value
+     * \param value the new value
+     */
+    inline void set(double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        mBits.store(bits, std::memory_order_relaxed);
+    }
+
+    /*!
+     * \brief Get the current value
+     * \return the value of the gauge
+     */
+    inline double get() const
+    {
+        uint64_t bits = mBits.load(std::memory_order_relaxed);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+private:
+    std::atomic<uint64_t> mBits{0};     //!< Bit pattern of the `double` value
+};
+
+/*!
+ * \brief A histogram with fixed bucket bounds. Updates are lock-free
+ */
+class SL_OC_EXPORT MetricHistogram
+{
+public:
+    /*!
+     * \brief Constructor
+     * \param bounds upper bounds of the buckets, in increasing order. A `+Inf` bucket is always added
+     */
+    MetricHistogram(const std::vector<double>& bounds);
+
+    /*!
+     * \brief Add a value to the distribution
+     * \param value the observed value
+     */
+    void observe(double value);
+
+    /*!
+     * \brief Get the bucket upper bounds
+     * \return the upper bounds, without the `+Inf` bucket
+     */
+    inline const std::vector<double>& getBounds() const {return mBounds;}
+
+    /*!
+     * \brief Get the number of values observed in a bucket (not cumulative)
+     * \param idx index of the bucket. `getBounds().size()` is the `+Inf` bucket
+     * \return the number of values
+     */
+    inline uint64_t getBucketCount(size_t idx) const {return mBuckets[idx].load(std::memory_order_relaxed);}
+
+    /*!
+     * \brief Get the number of observed values
+     * \return the number of values
+     */
+    inline uint64_t getCount() const {return mCount.load(std::memory_order_relaxed);}
+
+    /*!
+     * \brief Get the sum of the observed values
+     * \return the sum of the values
+     */
+    double getSum() const;
+
+private:
+    std::vector<double> mBounds;                        //!< Bucket upper bounds
+    std::unique_ptr<std::atomic<uint64_t>[]> mBuckets;  //!< Values in each bucket, `+Inf` included
+    std::atomic<uint64_t> mCount{0};                    //!< Number of observed values
+    std::atomic<uint64_t> mSumBits{0};                  //!< Bit pattern of the `double` sum of the values
+};
+
+/*!
+ * \brief Header placed at the beginning of the shared memory page written by \ref MetricsExporter
+ *
+ * The `seq` counter works as a sequence lock: it is odd while the exporter is writing the page.
+ */
+struct alignas(64) MetricsShmHeader
+{
+    uint32_t magic;                     //!< Must be equal to \ref METRICS_SHM_MAGIC
+    uint32_t version;                   //!< Must be equal to \ref METRICS_SHM_VERSION
+    uint32_t capacity;                  //!< Maximum number of samples in the page
+    uint32_t count;                     //!< Number of valid samples
+    std::atomic<uint64_t> seq;          //!< Sequence counter of the page
+    uint64_t timestamp;                 //!< Wall time of the last update in nanoseconds
+};
+
+/*!
+ * \brief A sample of the shared memory page, e.g. `zed_oc_frames_total{serial="12345"}` and its value
+ */
+struct MetricsShmSample
+{
+    char name[METRICS_SHM_NAME_SIZE];   //!< Sample name with labels, in Prometheus format. Null terminated
+    double value;                       //!< Sample value
+};
+
+/*!
+ * \brief The MetricsRegistry class holds all the metrics of the process.
+ *
+ * The metrics are created once, normally while a device is opened, and then updated without locks through the
+ * returned pointers. A metric is never destroyed: requesting again the same name and labels (e.g. after a
+ * reconnection) returns the existing object.
+ */
+class SL_OC_EXPORT MetricsRegistry
+{
+public:
+    /*!
+     * \brief Get the instance shared in the process
+     * \return the shared registry
+     */
+    static MetricsRegistry& getInstance();
+
+    /*!
+     * \brief Get or create a counter
+     * \param name metric name (e.g. `zed_oc_frames_total`)
+     * \param help description of the metric
+     * \param labels labels in Prometheus format (e.g. `serial="12345"`), can be empty
+     * \return the counter, valid for the whole life of the process
+     */
+    MetricCounter* counter(const std::string& name, const std::string& help, const std::string& labels="");
+
+    /*!
+     * \brief Get or create a gauge
+     * \param name metric name
+     * \param help description of the metric
+     * \param labels labels in Prometheus format, can be empty
+     * \return the gauge, valid for the whole life of the process
+     */
+    MetricGauge* gauge(const std::string& name, const std::string& help, const std::string& labels="");
+
+    /*!
+     * \brief Get or create a histogram
+     * \param name metric name
+     * \param help description of the metric
+     * \param bounds bucket upper bounds, in increasing order. Ignored if the histogram already exists
+     * \param labels labels in Prometheus format, can be empty
+     * \return the histogram, valid for the whole life of the process
+     */
+    MetricHistogram* histogram(const std::string& name, const std::string& help, const std::vector<double>& bounds,
+                               const std::string& labels="");
+
+    /*!
+     * \brief Format all the metrics in the Prometheus text exposition format
+     * \return the formatted metrics
+     */
+    std::string toPrometheus();
+
+    /*!
+     * \brief Get all the samples as (name with labels, value) pairs, histograms expanded as in the Prometheus format
+     * \param samples the returned samples
+     */
+    void getSamples(std::vector<std::pair<std::string,double>>& samples);
+
+private:
+    struct Family;
+    struct Metric;
+
+    MetricsRegistry() = default;
+    ~MetricsRegistry();
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    Metric* find(const std::string& name, const std::string& help, METRIC_TYPE type, const std::string& labels,
+                 const std::vector<double>* bounds); //!< Get or create a metric
+
+private:
+    std::mutex mMutex;                              //!< Mutex for safe access to the metric list
+    std::vector<std::unique_ptr<Family>> mFamilies; //!< Metrics grouped by name, in creation order
+};
+
+/*!
+ * \brief The metrics exporter configuration parameters
+ */
+struct MetricsExportParams
+{
+    /*!
+     * \brief Default constructor setting the default parameter values
+     */
+    MetricsExportParams() {
+        period_msec = 1000;
+        shm_capacity = 1024;
+        verbose = sl_oc::VERBOSITY::ERROR;
+    }
+
+    std::string text_file;      //!< Prometheus text file, e.g. for the `node_exporter` textfile collector. Empty to disable
+    std::string shm_name;       //!< Name of the shared memory page (e.g. `/zed_oc_metrics`). Empty to disable
+    uint32_t period_msec;       //!< Export period in milliseconds
+    uint32_t shm_capacity;      //!< Maximum number of samples in the shared memory page
+    int verbose;                //!< Verbose mode
+};
+
+/*!
+ * \brief The MetricsExporter class periodically writes the content of the \ref MetricsRegistry to a Prometheus
+ *        text file and/or to a shared memory page, from its own thread.
+ *
+ * The text file is written to a temporary file and then renamed, so a scraper never reads a partial file.
+ */
+class SL_OC_EXPORT MetricsExporter
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the exporter parameters (see \ref MetricsExportParams)
+     */
+    MetricsExporter( MetricsExportParams params = MetricsExportParams() );
+
+    /*!
+     * \brief The class destructor. The exporter thread is stopped and the shared memory page unlinked
+     */
+    virtual ~MetricsExporter();
+
+    /*!
+     * \brief Create the shared memory page and start the exporter thread
+     * \return true if the exporter is correctly started
+     */
+    bool start();
+
+    /*!
+     * \brief Stop the exporter thread and unlink the shared memory page
+     */
+    void stop();
+
+    /*!
+     * \brief Export the metrics immediately
+     * \return true if all the enabled outputs have been correctly written
+     */
+    bool exportNow();
+
+private:
+    void exportThreadFunc();            //!< The exporter thread function
+    bool writeTextFile();               //!< Write the Prometheus text file
+    void writeShm();                    //!< Update the shared memory page
+
+private:
+    MetricsExportParams mParams;        //!< Exporter parameters
+
+    uint8_t* mShmBase=nullptr;          //!< Address of the mapped shared memory page
+    size_t mShmSize=0;                  //!< Size of the mapped shared memory page
+    std::string mShmName;               //!< Name of the shared memory page
+
+    std::mutex mExportMutex;            //!< Serializes the exports
+    std::mutex mStopMutex;              //!< Mutex for the stop condition
+    std::condition_variable mStopCond;  //!< Wakes up the exporter thread when stopping
+    bool mStop=true;                    //!< Indicates if the exporter thread must be stopped
+    std::thread mThread;                //!< The exporter thread
+};
+
+}
+
+#endif // METRICS_HPP
@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef MOCKVIDEODEVICE_HPP
+#define MOCKVIDEODEVICE_HPP
+
+#include "videodevice.hpp"
+#include "videocapture_def.hpp"
+
+#include <mutex>
+#include <map>
+#include <vector>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief The mock camera configuration parameters
+ */
+struct MockVideoParams
+{
+    /*!
+     * \brief Default constructor setting the default parameter values
+     */
+    MockVideoParams() {
+        first_dev_id = 0;
+        device_count = 1;
+        model = SL_DEVICE::ZED_2i;
+        serial_number = 10000000;
+        fps_override = 0.0f;
+        jitter_usec = 0.0f;
+        incomplete_ratio = 0.0f;
+        disparity = 32;
+        verbose = sl_oc::VERBOSITY::ERROR;
+    }
+
+    int first_dev_id;       //!< Id of the first emulated device (i.e. `/dev/video<first_dev_id>`)
+    int device_count;       //!< Number of emulated devices, with consecutive ids
+    SL_DEVICE model;        //!< Emulated camera model
+    int serial_number;      //!< Serial number of the first device. The following devices use consecutive values
+    float fps_override;     //!< Frame rate of the generated stream. `0` to use the frame rate requested by the capture
+    float jitter_usec;      //!< Standard deviation of the frame period jitter in microseconds
+    float incomplete_ratio; //!< Ratio [0,1] of frames delivered incomplete, as with USB transfer errors
+    int disparity;          //!< Horizontal shift in pixels of the right image with respect to the left image
+    int verbose;            //!< Verbose mode
+};
+
+/*!
+ * \brief The MockVideoDevice class emulates the V4L2 devices of Stereolabs cameras with no hardware.
+ *
+ * It generates side-by-side YUV 4:2:2 frames with a synthetic pattern at the requested (or forced) rate, with
+ * optional period jitter and incomplete frames, and emulates the standard UVC controls and the extension unit
+ * commands used by \ref VideoCapture (serial number, LED GPIO, ISP and sensor registers).
+ * When the automatic exposure is disabled the brightness of the frames follows the emulated exposure and gain.
+ *
+ * The returned file descriptors are `eventfd` counters readable when a frame is ready, so they can be used with
+ * `select` and `epoll` exactly like the real devices.
+ *
+ * \code
+ * std::shared_ptr<MockVideoDevice> mock = std::make_shared<MockVideoDevice>();
+ * VideoParams params;
+ * params.device_io = mock;
+ * VideoCapture cap(params);
+ * cap.initializeVideo(0);
+ * \endcode
+ */
+class SL_OC_EXPORT MockVideoDevice : public VideoDeviceIO
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the mock parameters (see \ref MockVideoParams)
+     */
+    MockVideoDevice( MockVideoParams params = MockVideoParams() );
+
+    /*!
+     * \brief The class destructor. The devices still opened are closed
+     */
+    virtual ~MockVideoDevice();
+
+    bool readModalias(const std::string& dev_name, std::string& modalias) override;
+    int stat(const char* path, struct ::stat* st) override;
+    int open(const char* path, int flags) override;
+    int close(int fd) override;
+    int ioctl(int fd, unsigned long request, void* arg) override;
+    void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) override;
+    int munmap(void* addr, size_t length) override;
+
+    /*!
+     * \brief Get the number of frames generated by an opened device
+     * \param fd the file descriptor returned by \ref open
+     * \return the number of generated frames, including the frames dropped because no buffer was queued
+     */
+    uint64_t getGeneratedCount(int fd);
+
+    /*!
+     * \brief Get the number of frames dropped by an opened device because the capture did not queue a buffer in time
+     * \param fd the file descriptor returned by \ref open
+     * \return the number of dropped frames
+     */
+    uint64_t getDroppedCount(int fd);
+
+private:
+    struct Device;
+    struct Stream;
+
+    int getDeviceIndex(const char* path);                       //!< Index of the emulated device, -1 if not emulated
+    std::shared_ptr<Stream> getStream(int fd);                  //!< Opened stream of a file descriptor
+    int vendorControl(Device& dev, uint8_t query, uint8_t* data, uint16_t size); //!< Emulate an extension unit query
+    void stopStreaming(Stream& s);                              //!< Stop the generator and drop the filled buffers
+    void generatorThreadFunc(Stream* s);                        //!< Frame generator of a streaming device
+    void renderFrame(Stream& s, uint8_t* dst, uint64_t seq, double luma_gain); //!< Draw a synthetic frame
+
+private:
+    MockVideoParams mParams;            //!< Mock parameters
+
+    std::vector<std::shared_ptr<Device>> mDevices;  //!< State of the emulated devices (controls and registers)
+
+    std::mutex mStreamMutex;            //!< Mutex for safe access to the opened streams
+    std::map<int,std::shared_ptr<Stream>> mStreams; //!< Opened streams, by file descriptor
+};
+
+}
+
+}
+
+#endif
+
+#endif // MOCKVIDEODEVICE_HPP
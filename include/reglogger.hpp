@@ -0,0 +1,203 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef REGLOGGER_HPP
+#define REGLOGGER_HPP
+
+#include "defines.hpp"
+
+#include <stdio.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <string>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+static const uint32_t REG_LOG_MAGIC = 0x4C434F5A;   //!< "ZOCL" marker at the beginning of the log files
+static const uint16_t REG_LOG_VERSION = 1;          //!< Version of the log file layout
+static const int REG_LOG_REG_COUNT = 61;            //!< Number of registers logged for each sensor
+static const size_t REG_LOG_QUEUE_SIZE = 64;        //!< Maximum number of pending requests and records
+
+/*!
+ * \brief Header placed at the beginning of a register log file
+ */
+struct RegLogFileHeader
+{
+    uint32_t magic;         //!< Must be equal to \ref REG_LOG_MAGIC
+    uint16_t version;       //!< Version of the layout used to write the file
+    uint16_t header_size;   //!< Size of this header in bytes
+    uint32_t record_size;   //!< Size of each \ref RegLogRecord in bytes
+    uint16_t reg_count;     //!< Number of registers of each record
+    uint16_t reserved;      //!< Reserved, must be zero
+    int32_t serial_number;  //!< Serial number of the camera
+    uint32_t reserved1;     //!< Reserved, must be zero
+    uint64_t start_ts;      //!< Wall clock time of the beginning of the log [nsec]
+};
+
+static_assert(sizeof(RegLogFileHeader)==32, "RegLogFileHeader layout must not depend on the compiler");
+
+/*!
+ * \brief Registers of a sensor read for a frame.
+ *
+ * The registers are, in this order:
+ * - OV580 ISP `0x80181002`, `0x80181031`, `0x80181032`, `0x80181033` (`0x801818xx` for the right sensor)
+ * - OV580 YAVG `0x801810C0` to `0x801810E2` (`0x801818C0` to `0x801818E2` for the right sensor)
+ * - OV4689 gain and exposure `0x3500` to `0x3515`
+ *
+ * \note Values are stored in the host byte order (little endian on all the supported platforms)
+ */
+struct RegLogRecord
+{
+    uint64_t frame_id;      //!< Index of the frame that triggered the reading
+    uint64_t frame_ts;      //!< Timestamp of the frame that triggered the reading [nsec]
+    uint64_t read_ts;       //!< Monotonic time of the end of the reading [nsec]
+    uint32_t read_usec;     //!< Duration of the reading [usec]
+    uint8_t side;           //!< Sensor: 0 for left, 1 for right
+    uint8_t status;         //!< 0 if all the registers have been correctly read
+    uint16_t reserved;      //!< Reserved, must be zero
+    uint8_t values[REG_LOG_REG_COUNT]; //!< Register values
+    uint8_t padding[3];     //!< Padding, must be zero
+};
+
+static_assert(sizeof(RegLogRecord)==96, "RegLogRecord layout must not depend on the compiler");
+
+/*!
+ * \brief The RegisterLogger class logs camera registers without blocking the grabbing thread.
+ *
+ * The grabbing thread only enqueues a reading request. A control worker thread reads the registers with the
+ * provided function and a writer thread saves the fixed size binary records to the file. When a queue is full
+ * the new request is dropped and counted.
+ *
+ * \note It is normally used by \ref VideoCapture::enableAecAgcSensLogging
+ */
+class SL_OC_EXPORT RegisterLogger
+{
+public:
+    /*!
+     * \brief Function reading the registers of a sensor
+     * \param side the sensor: 0 for left, 1 for right
+     * \param values the returned \ref REG_LOG_REG_COUNT register values
+     * \return 0 if all the registers have been correctly read
+     */
+    typedef std::function<int(int side, uint8_t* values)> ReadFunc;
+
+    /*!
+     * \brief The default constructor
+     * \param verbose_lvl enable useful information to debug the class behaviours while running
+     */
+    RegisterLogger( int verbose_lvl=sl_oc::VERBOSITY::ERROR );
+
+    /*!
+     * \brief The class destructor. The pending requests are processed before closing the file
+     */
+    virtual ~RegisterLogger();
+
+    /*!
+     * \brief Create the log file and start the worker threads
+     * \param filename the log file
+     * \param serial_number serial number of the camera
+     * \param read_func the function reading the registers
+     * \return true if the file has been correctly created
+     */
+    bool start(const std::string& filename, int serial_number, ReadFunc read_func);
+
+    /*!
+     * \brief Process the pending requests, stop the worker threads and close the file
+     */
+    void stop();
+
+    /*!
+     * \brief Enqueue a request to read the registers of both sensors. This function never blocks.
+     * \param frame_id index of the frame
+     * \param frame_ts timestamp of the frame [nsec]
+     * \return false if the request has been dropped
+     */
+    bool request(uint64_t frame_id, uint64_t frame_ts);
+
+    /*!
+     * \brief Get the number of records written to the file
+     * \return the number of written records
+     */
+    inline uint64_t getRecordCount(){return mRecords;}
+
+    /*!
+     * \brief Get the number of requests dropped because the queues were full
+     * \return the number of dropped requests
+     */
+    inline uint64_t getDroppedCount(){return mDropped;}
+
+    /*!
+     * \brief Read a register log file
+     * \param filename the log file
+     * \param header the returned file header
+     * \param records the returned records
+     * \return false if the file cannot be read or is not valid
+     */
+    static bool readLog(const std::string& filename, RegLogFileHeader& header, std::vector<RegLogRecord>& records);
+
+private:
+    void controlThreadFunc();           //!< Reads the registers for each request
+    void writerThreadFunc();            //!< Writes the records to the file
+
+private:
+    struct Request
+    {
+        uint64_t frame_id;
+        uint64_t frame_ts;
+    };
+
+    int mVerbose=0;                     //!< Verbose status
+    ReadFunc mReadFunc;                 //!< Function reading the registers
+    FILE* mFile=nullptr;                //!< Log file
+
+    std::mutex mReqMutex;               //!< Mutex for safe access to the request queue
+    std::condition_variable mReqCond;   //!< Signals a new request to the control thread
+    std::deque<Request> mRequests;      //!< Pending requests
+
+    std::mutex mRecMutex;               //!< Mutex for safe access to the record queue
+    std::condition_variable mRecCond;   //!< Signals new records to the writer thread
+    std::vector<RegLogRecord> mPending; //!< Records waiting to be written
+
+    bool mStopControl=true;             //!< Indicates if the control thread must be stopped
+    bool mStopWriter=true;              //!< Indicates if the writer thread must be stopped
+    std::thread mControlThread;         //!< The control thread
+    std::thread mWriterThread;          //!< The writer thread
+
+    std::atomic<uint64_t> mRecords{0};  //!< Written records
+    std::atomic<uint64_t> mDropped{0};  //!< Dropped requests
+};
+
+}
+
+}
+
+#endif
+
+#endif // REGLOGGER_HPP
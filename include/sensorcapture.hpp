@@ -22,6 +22,8 @@
 #define SENSORCAPTURE_HPP
 
 #include "defines.hpp"
+#include "hostclock.hpp"
+#include "metrics.hpp"
 
 #include <thread>
 #include <vector>
@@ -58,7 +60,9 @@ struct SL_OC_EXPORT Imu
     } ImuStatus;
 
     ImuStatus valid = NOT_PRESENT;     //!< Indicates if IMU data are valid
-    uint64_t timestamp = 0; //!< Timestamp in nanoseconds
+    uint64_t timestamp = 0; //!< Timestamp in nanoseconds, in the clock domain selected by \ref SensorCapture::setClockSource
+    uint64_t timestamp_mono = 0; //!< Timestamp in nanoseconds in the `CLOCK_MONOTONIC` domain
+    uint64_t timestamp_wall = 0; //!< Timestamp in nanoseconds in the wall clock domain
     float aX;               //!< Acceleration along X axis in m/s²
     float aY;               //!< Acceleration along Y axis in m/s²
     float aZ;               //!< Acceleration along Z axis in m/s²
@@ -82,7 +86,9 @@ struct SL_OC_EXPORT Magnetometer
     } MagStatus;
 
     MagStatus valid = NOT_PRESENT;     //!< Indicates if Magnetometer data are valid
-    uint64_t timestamp = 0; //!< Timestamp in nanoseconds
+    uint64_t timestamp = 0; //!< Timestamp in nanoseconds, in the clock domain selected by \ref SensorCapture::setClockSource
+    uint64_t timestamp_mono = 0; //!< Timestamp in nanoseconds in the `CLOCK_MONOTONIC` domain
+    uint64_t timestamp_wall = 0; //!< Timestamp in nanoseconds in the wall clock domain
     float mX;               //!< Acceleration along X axis in uT
     float mY;               //!< Acceleration along Y axis in uT
     float mZ;               //!< Acceleration along Z axis in uT
@@ -101,7 +107,9 @@ struct SL_OC_EXPORT Environment
     } EnvStatus;
 
     EnvStatus valid = NOT_PRESENT;     //!< Indicates if Environmental data are valid
-    uint64_t timestamp = 0; //!< Timestamp in nanoseconds
+    uint64_t timestamp = 0; //!< Timestamp in nanoseconds, in the clock domain selected by \ref SensorCapture::setClockSource
+    uint64_t timestamp_mono = 0; //!< Timestamp in nanoseconds in the `CLOCK_MONOTONIC` domain
+    uint64_t timestamp_wall = 0; //!< Timestamp in nanoseconds in the wall clock domain
     float temp;             //!< Sensor temperature in °C
     float press;            //!< Atmospheric pressure in hPa
     float humid;            //!< Humidity in %rH
@@ -119,7 +127,9 @@ struct SL_OC_EXPORT Temperature
     } TempStatus;
 
     TempStatus valid = NOT_PRESENT;     //!< Indicates if camera temperature data are valid
-    uint64_t timestamp = 0; //!< Timestamp in nanoseconds
+    uint64_t timestamp = 0; //!< Timestamp in nanoseconds, in the clock domain selected by \ref SensorCapture::setClockSource
+    uint64_t timestamp_mono = 0; //!< Timestamp in nanoseconds in the `CLOCK_MONOTONIC` domain
+    uint64_t timestamp_wall = 0; //!< Timestamp in nanoseconds in the wall clock domain
     float temp_left;        //!< Temperature of the left CMOS camera sensor
     float temp_right;       //!< Temperature of the right CMOS camera sensor
 };
@@ -213,6 +223,16 @@ public:
      */
     static bool resetSensorModule(int serial_number=0);
 
+    /*!
+     * \brief Set the clock used for the `timestamp` field of the sensor data. The data always contain both the
+     *        monotonic and the wall timestamps.
+     * \param source the clock source. The default is \ref CLOCK_SOURCE::WALL
+     *
+     * \note The source is set to the one of the \ref video::VideoCapture object when the synchronization is enabled
+     * with \ref video::VideoCapture::enableSensorSync
+     */
+    inline void setClockSource(CLOCK_SOURCE source){mClockSource=source;}
+
     /*!
      * \brief Perform a reset of the video module without resetting the sensor module. To be called in case the Video
      * module stops to work correctly.
@@ -224,6 +244,19 @@ public:
      */
     static bool resetVideoModule(int serial_number=0);
 
+    /*!
+     * \brief Decode a raw sensor data packet and update the last received data, as done by the grabbing thread for
+     *        each packet received from the MCU
+     * \param buf the packet, starting with the HID report ID (see \ref usb::RawData)
+     * \param size size of the packet in bytes
+     * \param rx_ts monotonic host timestamp of the reception of the packet [nsec]
+     * \return false if the packet is not a valid sensor data packet
+     *
+     * \note Normally used only by the grabbing thread. It allows replaying recorded packets and benchmarking the
+     * decoding with synthetic data when no device is connected
+     */
+    bool processRawData(const uint8_t* buf, int size, uint64_t rx_ts);
+
 #ifdef VIDEO_MOD_AVAILABLE
     void updateTimestampOffset(uint64_t frame_ts);                                 //!< Called by  VideoCapture to update timestamp offset
     inline void setStartTimestamp(uint64_t start_ts){mStartSysTs=start_ts;}        //!< Called by  VideoCapture to sync timestamps reference point
@@ -236,6 +269,7 @@ private:
     void grabThreadFunc();              //!< The sensor data grabbing thread function
 
     bool startCapture();                //!< Start data capture thread
+    void initMetrics();                 //!< Create the metrics of the connected device in the \ref MetricsRegistry
 
     bool open(uint16_t pid, int serial_number); //!< Open the USB connection
     void close();                       //!< Close the USB connection
@@ -280,8 +314,11 @@ private:
     std::mutex mEnvMutex;               //!< Mutex for safe access to ENV data buffer
     std::mutex mCamTempMutex;           //!< Mutex for safe access to CAM_TEMP data buffer
 
-    uint64_t mStartSysTs=0;             //!< Initial System Timestamp, to calculate differences [nsec]
+    uint64_t mStartSysTs=0;             //!< Initial monotonic System Timestamp, to calculate differences [nsec]
+    CLOCK_SOURCE mClockSource=CLOCK_SOURCE::WALL; //!< Clock used for the `timestamp` field of the data
+    int mClockId=-1;                    //!< Identifier of the MCU clock in \ref ClockSync
     uint64_t mLastMcuTs=0;              //!< MCU Timestamp of the previous data, to calculate relative timestamps [nsec]
+    uint64_t mRelMcuTs=0;               //!< MCU time elapsed since the first data, corrected by the drift scaling [nsec]
 
     bool mFirstImuData=true;            //!< Used to initialize the sensor timestamp start point
 
@@ -297,6 +334,15 @@ private:
     int64_t mSyncOffset=0;              //!< Timestamp offset respect to synchronized camera
     // <---- Timestamp synchronization
 
+    // ----> Metrics
+    MetricCounter* mMetImu=nullptr;         //!< Received IMU samples
+    MetricCounter* mMetHidErr=nullptr;      //!< Failed or invalid HID reads
+    MetricGauge* mMetImuRate=nullptr;       //!< Measured IMU rate
+    MetricGauge* mMetSyncOffset=nullptr;    //!< Offset of the timestamps respect to the synchronized camera
+    MetricGauge* mMetTsScaling=nullptr;     //!< MCU timestamp drift scaling factor
+    double mImuRateAvg=0.0;                 //!< Smoothed IMU rate
+    // <---- Metrics
+
 #ifdef VIDEO_MOD_AVAILABLE
     video::VideoCapture* mVideoPtr=nullptr;    //!< Pointer to the synchronized SensorCapture object
     uint64_t mSyncTs=0;                 //!< Timestamp of the latest received HW sync signal
@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef SHMFRAMERING_HPP
+#define SHMFRAMERING_HPP
+
+#include "defines.hpp"
+
+#include <atomic>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+static const uint32_t SHM_RING_MAGIC = 0x52434F5A;  //!< "ZOCR" marker at the beginning of each ring
+static const uint32_t SHM_RING_VERSION = 2;         //!< Version of the shared memory layout
+static const uint8_t SHM_RING_DEFAULT_SLOTS = 4;    //!< Default number of frame slots in the ring
+
+static_assert(ATOMIC_LLONG_LOCK_FREE==2, "64 bit atomics must be lock free to be shared between processes");
+
+/*!
+ * \brief Header placed at the beginning of the shared memory segment
+ *
+ * \note The layout is shared between processes: fields must never be reordered without increasing
+ * \ref SHM_RING_VERSION
+ */
+struct alignas(64) ShmRingHeader
+{
+    uint32_t magic;                     //!< Must be equal to \ref SHM_RING_MAGIC
+    uint32_t version;                   //!< Must be equal to \ref SHM_RING_VERSION
+    uint32_t slot_count;                //!< Number of frame slots
+    uint32_t slot_stride;               //!< Size in bytes of each slot, including its header
+    uint32_t data_size;                 //!< Size in bytes of the frame data stored in each slot
+    uint16_t width;                     //!< Frame width
+    uint16_t height;                    //!< Frame height
+    uint8_t channels;                   //!< Number of channels per pixel
+    int32_t serial_number;              //!< Serial number of the publishing camera
+    int32_t owner_pid;                  //!< Process identifier of the publisher, to detect the segments left by a crash
+    std::atomic<uint64_t> write_count;  //!< Number of frames published since the ring has been created
+};
+
+/*!
+ * \brief Header placed at the beginning of each frame slot
+ *
+ * The `seq` counter works as a sequence lock: it is odd while the publisher is writing the slot and equal
+ * to `2*n` when the slot contains the n-th published frame.
+ */
+struct alignas(64) ShmSlotHeader
+{
+    std::atomic<uint64_t> seq;          //!< Sequence counter of the slot
+    uint64_t frame_id;                  //!< Frame index, see \ref Frame::frame_id
+    uint64_t timestamp;                 //!< Frame timestamp in nanoseconds
+};
+
+/*!
+ * \brief A frame stored in the shared memory ring, accessed without copy
+ *
+ * \note `data` points to the shared memory: the content is valid only while \ref ShmFrameSubscriber::isValid
+ * returns true, i.e. until the publisher wraps around the ring and overwrites the slot
+ */
+struct SL_OC_EXPORT ShmFrame
+{
+    uint64_t seq = 0;                   //!< Publishing index of the frame (1 for the first frame of the ring)
+    uint64_t frame_id = 0;              //!< Increasing index of frames
+    uint64_t timestamp = 0;             //!< Timestamp in nanoseconds
+    const uint8_t* data = nullptr;      //!< Frame data in YUV 4:2:2 format
+    uint16_t width = 0;                 //!< Frame width
+    uint16_t height = 0;                //!< Frame height
+    uint8_t channels = 0;               //!< Number of channels per pixel
+};
+
+/*!
+ * \brief The ShmFramePublisher class creates a POSIX shared memory ring and writes the frames into it
+ *
+ * \note It is normally used by \ref VideoCapture::enableShmPublisher
+ */
+class SL_OC_EXPORT ShmFramePublisher
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param verbose_lvl enable useful information to debug the class behaviours while running
+     */
+    ShmFramePublisher( int verbose_lvl=sl_oc::VERBOSITY::ERROR );
+
+    /*!
+     * \brief The class destructor. The shared memory segment is unlinked
+     */
+    virtual ~ShmFramePublisher();
+
+    /*!
+     * \brief Create the shared memory ring
+     *
+     * An existing segment with the same name is replaced only if its publisher process is no longer running:
+     * a ring in use by another publisher and its subscribers is never taken over.
+     * \param name name of the shared memory segment (e.g. `/zed_oc_12345678`)
+     * \param width frame width
+     * \param height frame height
+     * \param channels number of channels per pixel
+     * \param serial_number serial number of the publishing camera
+     * \param slot_count number of frame slots in the ring
+     * \return true if the ring has been correctly created
+     */
+    bool create(std::string name, uint16_t width, uint16_t height, uint8_t channels, int serial_number,
+                uint8_t slot_count=SHM_RING_DEFAULT_SLOTS);
+
+    /*!
+     * \brief Unmap and unlink the shared memory ring
+     */
+    void destroy();
+
+    /*!
+     * \brief Write a new frame in the next slot of the ring
+     * \param data frame data
+     * \param size size of the frame data in bytes. It is truncated to the slot size
+     * \param frame_id frame index
+     * \param timestamp frame timestamp in nanoseconds
+     */
+    void publish(const uint8_t* data, size_t size, uint64_t frame_id, uint64_t timestamp);
+
+    /*!
+     * \brief Get the name of the shared memory segment
+     * \return the name of the shared memory segment
+     */
+    inline std::string getName(){return mName;}
+
+    /*!
+     * \brief Get the number of frame slots of the ring
+     * \return the number of frame slots, 0 if not created
+     */
+    inline uint8_t getSlotCount(){return mHeader?static_cast<uint8_t>(mHeader->slot_count):0;}
+
+private:
+    int mVerbose=0;                     //!< Verbose status
+
+    std::string mName;                  //!< Name of the shared memory segment
+    uint8_t* mBase=nullptr;             //!< Address of the mapped segment
+    size_t mMapSize=0;                  //!< Size of the mapped segment
+    ShmRingHeader* mHeader=nullptr;     //!< Ring header
+};
+
+/*!
+ * \brief The ShmFrameSubscriber class maps read-only a shared memory ring created by a \ref ShmFramePublisher
+ *
+ * Any number of subscribers can access the same ring at the same time with no copy and no broker.
+ */
+class SL_OC_EXPORT ShmFrameSubscriber
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param verbose_lvl enable useful information to debug the class behaviours while running
+     */
+    ShmFrameSubscriber( int verbose_lvl=sl_oc::VERBOSITY::ERROR );
+
+    /*!
+     * \brief The class destructor
+     */
+    virtual ~ShmFrameSubscriber();
+
+    /*!
+     * \brief Map an existing shared memory ring
+     * \param name name of the shared memory segment
+     * \return true if the ring has been correctly mapped
+     */
+    bool open(std::string name);
+
+    /*!
+     * \brief Unmap the shared memory ring
+     */
+    void close();
+
+    /*!
+     * \brief Get the last frame published in the ring
+     * \param frame the returned frame
+     * \return true if a valid frame is available
+     */
+    bool getLatestFrame(ShmFrame& frame);
+
+    /*!
+     * \brief Get the frame following the last frame returned by this subscriber
+     * \param frame the returned frame
+     * \param timeout_msec waiting timeout in milliseconds
+     * \return true if a new valid frame has been received before the timeout
+     *
+     * \note if the subscriber is slower than the publisher, the oldest frame still available in the ring is
+     * returned and the skipped frames are counted in \ref getDroppedCount
+     */
+    bool getNextFrame(ShmFrame& frame, uint64_t timeout_msec=100);
+
+    /*!
+     * \brief Check that the slot of a frame has not been overwritten by the publisher in the meanwhile
+     * \param frame the frame to be verified
+     * \return true if the frame data are still valid
+     *
+     * \note call this function after processing the frame data to be sure that they were consistent
+     */
+    bool isValid(const ShmFrame& frame) const;
+
+    /*!
+     * \brief Get the number of frames skipped by \ref getNextFrame because the subscriber was too slow
+     * \return the number of skipped frames
+     */
+    inline uint64_t getDroppedCount(){return mDropped;}
+
+    /*!
+     * \brief Get the serial number of the publishing camera
+     * \return the serial number of the publishing camera, -1 if not mapped
+     */
+    inline int getSerialNumber(){return mHeader?mHeader->serial_number:-1;}
+
+private:
+    bool readSlot(uint64_t seq, ShmFrame& frame);   //!< Fill `frame` with the content of the slot of the `seq`-th frame
+
+private:
+    int mVerbose=0;                     //!< Verbose status
+
+    const uint8_t* mBase=nullptr;       //!< Address of the mapped segment
+    size_t mMapSize=0;                  //!< Size of the mapped segment
+    const ShmRingHeader* mHeader=nullptr; //!< Ring header
+
+    uint64_t mLastSeq=0;                //!< Publishing index of the last frame returned by \ref getNextFrame
+    uint64_t mDropped=0;                //!< Number of frames skipped by \ref getNextFrame
+};
+
+}
+
+}
+
+#endif
+
+/** \example zed_oc_shm_example.cpp
+ * Example of how to publish the frames of a VideoCapture object into a shared memory ring and how to read them
+ * from another process using the ShmFrameSubscriber class.
+ */
+
+#endif // SHMFRAMERING_HPP
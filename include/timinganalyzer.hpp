@@ -0,0 +1,208 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef TIMINGANALYZER_HPP
+#define TIMINGANALYZER_HPP
+
+#include "defines.hpp"
+
+#include <mutex>
+#include <deque>
+#include <vector>
+
+namespace sl_oc {
+
+static const size_t TIMING_DEFAULT_WINDOW = 1000;       //!< Default number of samples of the rolling statistics
+static const int TIMING_SUB_BINS_BITS = 5;              //!< Each power of two is divided in `2^n` bins: bin width below 1/32 of the value
+static const size_t TIMING_SYNC_HISTORY = 8;            //!< Number of frames and sync signals kept to match them
+static const double TIMING_LATE_FACTOR = 1.5;           //!< A frame period longer than `n` nominal periods reveals a lost frame
+
+/*!
+ * \brief Summary of a rolling statistic. All the values are in nanoseconds
+ */
+struct SL_OC_EXPORT StatsSummary
+{
+    uint64_t count = 0;     //!< Number of samples in the window
+    double mean = 0.0;      //!< Mean value
+    double p50 = 0.0;       //!< Median value
+    double p99 = 0.0;       //!< 99th percentile
+    double min = 0.0;       //!< Minimum value
+    double max = 0.0;       //!< Maximum value
+};
+
+/*!
+ * \brief The RollingStats class computes the statistics of the last N samples of a signed value with O(1) updates.
+ *
+ * The mean is updated with a running sum, the extrema with monotonic queues and the percentiles with a histogram
+ * with logarithmic bins (as HDR histograms), updated when a sample enters or leaves the window.
+ * The percentiles are interpolated inside the bins, whose width is below `2^-TIMING_SUB_BINS_BITS` times their value.
+ *
+ * \note The class is not thread safe
+ */
+class SL_OC_EXPORT RollingStats
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param window number of samples of the rolling window
+     */
+    RollingStats( size_t window=TIMING_DEFAULT_WINDOW );
+
+    /*!
+     * \brief Add a new sample, removing the oldest one if the window is full
+     * \param value the new sample
+     */
+    void add(int64_t value);
+
+    /*!
+     * \brief Remove all the samples
+     * \param window new size of the window. `0` to keep the current size
+     */
+    void reset(size_t window=0);
+
+    /*!
+     * \brief Get a percentile of the samples in the window
+     * \param p the percentile in the range [0,1]
+     * \return the value of the percentile, `0` if the window is empty
+     */
+    double getPercentile(double p) const;
+
+    /*!
+     * \brief Get the statistics of the samples in the window
+     * \return the summary of the statistics
+     */
+    StatsSummary getSummary() const;
+
+    /*!
+     * \brief Get the number of samples in the window
+     * \return the number of samples in the window
+     */
+    inline size_t getCount() const {return mCount;}
+
+    /*!
+     * \brief Get the mean of the samples in the window, in constant time
+     * \return the mean value, `0` if the window is empty
+     */
+    inline double getMean() const {return mCount?static_cast<double>(mSum)/mCount:0.0;}
+
+private:
+    static size_t binIndex(int64_t value);  //!< Index of the histogram bin of a value
+    static void binBounds(size_t idx, double& lo, double& hi); //!< Smallest and largest values of a histogram bin
+
+private:
+    size_t mWindow;                         //!< Size of the window
+    std::vector<int64_t> mValues;           //!< Circular buffer of the samples in the window
+    std::vector<uint32_t> mBins;            //!< Histogram of the samples in the window
+    size_t mCount=0;                        //!< Number of samples in the window
+    uint64_t mTotal=0;                      //!< Number of samples added since the last reset
+    int64_t mSum=0;                         //!< Sum of the samples in the window
+
+    std::deque<std::pair<uint64_t,int64_t>> mMaxQueue; //!< Decreasing candidates for the maximum (sample index, value)
+    std::deque<std::pair<uint64_t,int64_t>> mMinQueue; //!< Increasing candidates for the minimum (sample index, value)
+};
+
+/*!
+ * \brief Timing statistics of a video stream. All the values are in nanoseconds
+ */
+struct SL_OC_EXPORT TimingReport
+{
+    uint64_t frames = 0;            //!< Frames analyzed since the last reset
+    uint64_t late_frames = 0;       //!< Frame periods longer than \ref TIMING_LATE_FACTOR nominal periods
+    uint64_t syncs = 0;             //!< IMU sync signals matched with a frame since the last reset
+    double nominal_period = 0.0;    //!< Nominal frame period used for the jitter
+
+    StatsSummary period;            //!< Time between consecutive frame timestamps
+    StatsSummary jitter;            //!< Difference between the frame period and the nominal period
+    StatsSummary arrival_skew;      //!< Delay between the frame timestamp and its reception by the host
+    StatsSummary sync_offset;       //!< Difference between the IMU sync signal timestamp and the matching frame timestamp
+};
+
+/*!
+ * \brief The TimingAnalyzer class tracks the timing quality of a video stream: frame period, jitter, delay of the
+ *        frames on the USB link and offset of the IMU synchronization, with rolling statistics.
+ *
+ * It is thread safe: the frames and the IMU sync signals can be added by different threads.
+ *
+ * \note It is normally used by \ref video::VideoCapture::enableTimingAnalysis
+ */
+class SL_OC_EXPORT TimingAnalyzer
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param window number of samples of the rolling statistics
+     */
+    TimingAnalyzer( size_t window=TIMING_DEFAULT_WINDOW );
+
+    /*!
+     * \brief Set the nominal frame period, reference of the jitter
+     * \param period_nsec the nominal period [nsec]. `0` to use the mean measured period
+     */
+    void setNominalPeriod(uint64_t period_nsec);
+
+    /*!
+     * \brief Add a new frame
+     * \param ts monotonic timestamp of the frame [nsec]
+     * \param rx_ts monotonic time of the reception of the frame by the host [nsec]. `0` if not available
+     */
+    void addFrame(uint64_t ts, uint64_t rx_ts=0);
+
+    /*!
+     * \brief Add the timestamp of an IMU sample flagged with the frame sync signal
+     * \param ts monotonic timestamp of the IMU sample [nsec], in the time base of the frames
+     */
+    void addImuSync(uint64_t ts);
+
+    /*!
+     * \brief Get the current statistics
+     * \return the timing report
+     */
+    TimingReport getReport();
+
+    /*!
+     * \brief Remove all the samples
+     * \param window new size of the rolling windows. `0` to keep the current size
+     */
+    void reset(size_t window=0);
+
+private:
+    void matchSync(uint64_t frame_ts, uint64_t sync_ts);   //!< Add a sync offset sample if the two timestamps match
+
+private:
+    std::mutex mMutex;                      //!< Mutex for safe access from the video and sensor threads
+
+    RollingStats mPeriod;                   //!< Frame period
+    RollingStats mJitter;                   //!< Frame period error
+    RollingStats mSkew;                     //!< Frame arrival delay
+    RollingStats mSyncOffset;               //!< IMU sync signal offset
+
+    uint64_t mNominalPeriod=0;              //!< Nominal frame period. `0` to use the mean measured period
+    uint64_t mLastTs=0;                     //!< Timestamp of the last frame
+    uint64_t mFrames=0;                     //!< Frames analyzed
+    uint64_t mLateFrames=0;                 //!< Late frames
+    uint64_t mSyncs=0;                      //!< Matched IMU sync signals
+
+    std::deque<uint64_t> mRecentFrames;     //!< Timestamps of the last frames, to match the sync signals
+    std::deque<uint64_t> mPendingSyncs;     //!< Sync signals received before their frame
+};
+
+}
+
+#endif // TIMINGANALYZER_HPP
@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef TONECURVE_HPP
+#define TONECURVE_HPP
+
+#include "defines.hpp"
+
+#include <vector>
+#include <utility>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+static const int TONE_CURVE_SIZE = 256;     //!< Number of entries of a tone curve, one for each luma level
+
+/*!
+ * \brief A tone curve applied by the host to the luma channel of the frames, as a look-up table
+ *
+ * \note The chroma bytes are not modified: the curve is applied to the Y channel only.
+ */
+struct SL_OC_EXPORT ToneCurve
+{
+    /*!
+     * \brief Default constructor setting the identity curve
+     */
+    ToneCurve();
+
+    /*!
+     * \brief Create a gamma curve `out = 255*(in/255)^(1/gamma)`
+     * \param gamma gamma value. Values greater than 1 brighten the dark tones
+     * \return the tone curve
+     */
+    static ToneCurve gamma(float gamma);
+
+    /*!
+     * \brief Create a piecewise linear curve
+     * \param points the control points (input, output), sorted by increasing input. The curve is constant before
+     *        the first point and after the last one
+     * \return the tone curve, the identity curve if `points` is empty
+     */
+    static ToneCurve fromPoints(const std::vector<std::pair<uint8_t,uint8_t>>& points);
+
+    /*!
+     * \brief Apply the curve in place to the luma of a YUV 4:2:2 buffer
+     * \param yuyv the buffer
+     * \param pixels number of pixels
+     */
+    void apply(uint8_t* yuyv, size_t pixels) const;
+
+    /*!
+     * \brief Copy a YUV 4:2:2 buffer applying the curve to the luma. The buffer is processed by blocks that are
+     *        mapped just after their copy, while they are still in the cache
+     * \param dst destination buffer
+     * \param src source buffer
+     * \param size size of the buffer in bytes
+     */
+    void copy(uint8_t* dst, const uint8_t* src, size_t size) const;
+
+    uint8_t lut[TONE_CURVE_SIZE];   //!< The output luma value of each input luma value
+};
+
+}
+
+}
+
+#endif
+
+#endif // TONECURVE_HPP
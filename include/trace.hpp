@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include "defines.hpp"
+#include "hostclock.hpp"
+
+#include <atomic>
+
+namespace sl_oc {
+
+static const size_t TRACE_DEFAULT_BUFFER_SIZE = 16384;  //!< Default number of events kept for each thread
+
+/*!
+ * \brief A completed trace event
+ */
+struct TraceEvent
+{
+    const char* name;       //!< Event name. Must be a string literal, only the pointer is stored
+    uint64_t start;         //!< Start time, monotonic clock [nsec]
+    uint64_t dur;           //!< Duration [nsec]
+};
+
+/*!
+ * \brief The Tracer class collects the scoped trace events of all the threads of the process.
+ *
+ * Each thread writes its events in its own ring buffer, allocated at its first event, with no lock and no
+ * allocation; when a ring is full the oldest events are overwritten. The ring of an exited thread is kept until the
+ * trace is saved, then it is freed or reused by a new thread. The rings are read only when the trace is saved,
+ * in the Chrome trace JSON format (`chrome://tracing`, https://ui.perfetto.dev) or in the Perfetto protobuf format.
+ *
+ * The library instrumentation uses the \ref TRACE_SCOPE macro, that compiles out unless the library is built with
+ * the `TRACE_EVENTS` CMake option. The events are recorded only while the tracer is enabled with \ref enable.
+ */
+class SL_OC_EXPORT Tracer
+{
+public:
+    /*!
+     * \brief Start or stop the recording of the events
+     * \param enable true to record the events
+     */
+    static void enable(bool enable);
+
+    /*!
+     * \brief Check if the events are recorded
+     * \return true if the recording is enabled
+     */
+    static inline bool isEnabled() {return sEnabled.load(std::memory_order_relaxed);}
+
+    /*!
+     * \brief Set the number of events kept for each thread. Applied only to the threads that have not yet
+     *        recorded an event
+     * \param events number of events, rounded up to a power of 2
+     */
+    static void setBufferSize(size_t events);
+
+    /*!
+     * \brief Set the name of the calling thread, shown in the trace viewers
+     * \param name the thread name
+     */
+    static void setThreadName(const std::string& name);
+
+    /*!
+     * \brief Record a completed event in the ring of the calling thread
+     * \param name event name. Must be a string literal
+     * \param start start time, monotonic clock [nsec]
+     * \param end end time, monotonic clock [nsec]
+     */
+    static void record(const char* name, uint64_t start, uint64_t end);
+
+    /*!
+     * \brief Save the recorded events in the Chrome trace JSON format
+     * \param filename the output file
+     * \return true if the file has been correctly written
+     */
+    static bool saveChromeTrace(const std::string& filename);
+
+    /*!
+     * \brief Save the recorded events in the Perfetto protobuf trace format
+     * \param filename the output file
+     * \return true if the file has been correctly written
+     */
+    static bool savePerfettoTrace(const std::string& filename);
+
+    /*!
+     * \brief Discard all the recorded events
+     */
+    static void clear();
+
+private:
+    static std::atomic<bool> sEnabled;  //!< Indicates if the events are recorded
+};
+
+/*!
+ * \brief Records an event covering the lifetime of the object, if the \ref Tracer is enabled at its creation
+ */
+class TraceScope
+{
+public:
+    /*!
+     * \brief Start the event
+     * \param name event name. Must be a string literal
+     */
+    explicit TraceScope(const char* name) : mName(name), mStart(Tracer::isEnabled()?getMonotonicTimestamp():0) {}
+
+    /*!
+     * \brief Complete the event
+     */
+    ~TraceScope() {if(mStart) Tracer::record(mName, mStart, getMonotonicTimestamp());}
+
+    /*!
+     * \brief Do not record the event, e.g. when a polling call returned no data
+     */
+    inline void discard() {mStart=0;}
+
+private:
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    const char* mName;      //!< Event name
+    uint64_t mStart;        //!< Start time, `0` if not recording
+};
+
+}
+
+#define SL_OC_TRACE_CAT_(a,b) a##b
+#define SL_OC_TRACE_CAT(a,b) SL_OC_TRACE_CAT_(a,b)
+
+#ifdef TRACE_AVAILABLE
+//! Record an event from this point to the end of the enclosing scope
+#define TRACE_SCOPE(name) sl_oc::TraceScope SL_OC_TRACE_CAT(sl_oc_trace_,__LINE__)(name)
+//! Same as \ref TRACE_SCOPE, with a named scope object that can be discarded with \ref TRACE_DISCARD
+#define TRACE_SCOPE_ID(id,name) sl_oc::TraceScope id(name)
+//! Do not record the event of a scope created with \ref TRACE_SCOPE_ID
+#define TRACE_DISCARD(id) id.discard()
+//! Set the name of the calling thread in the trace
+#define TRACE_THREAD_NAME(name) sl_oc::Tracer::setThreadName(name)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_SCOPE_ID(id,name)
+#define TRACE_DISCARD(id)
+#define TRACE_THREAD_NAME(name)
+#endif
+
+#endif // TRACE_HPP
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef USBPLANNER_HPP
+#define USBPLANNER_HPP
+
+#include "defines.hpp"
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+#include "videocapture_def.hpp"
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief USB topology of a video device, read from sysfs
+ */
+struct SL_OC_EXPORT UsbDeviceInfo
+{
+    std::string dev_name;           //!< Video device (e.g. `/dev/video0`)
+    std::string sysfs_path;         //!< sysfs folder of the USB device
+    int bus = -1;                   //!< USB bus number
+    std::string port_path;          //!< USB port chain (e.g. `2-1.3`)
+    int speed_mbps = 0;             //!< Negotiated link speed of the device [Mbps]
+    std::vector<std::string> links; //!< USB nodes from the device to its root hub (e.g. `2-1.3`, `2-1`, `usb2`)
+    std::vector<int> link_speeds;   //!< Link speed of each node in `links` [Mbps]
+};
+
+/*!
+ * \brief A camera configuration to be verified by the \ref UsbBandwidthPlanner
+ */
+struct SL_OC_EXPORT UsbCameraConfig
+{
+    std::string dev_name;           //!< Video device (e.g. `/dev/video0`)
+    RESOLUTION res = RESOLUTION::HD720; //!< Requested resolution
+    FPS fps = FPS::FPS_30;          //!< Requested frame rate
+};
+
+/*!
+ * \brief The load of a USB link shared by one or more cameras
+ */
+struct SL_OC_EXPORT UsbLinkLoad
+{
+    std::string node;               //!< USB node (device, hub or root hub)
+    int speed_mbps = 0;             //!< Nominal link speed [Mbps]
+    double capacity_mbps = 0.0;     //!< Bandwidth usable for video streaming [Mbps]. `0` if the link speed is unknown
+    double required_mbps = 0.0;     //!< Bandwidth required by the cameras using the link [Mbps]
+    std::vector<std::string> devices; //!< Video devices using the link
+};
+
+/*!
+ * \brief The UsbBandwidthPlanner class verifies that a set of cameras can stream at the same time with the requested
+ *        resolutions and frame rates, given the USB topology.
+ *
+ * Each camera requires a fixed bandwidth for its uncompressed YUV 4:2:2 side-by-side stream. All the links on the
+ * path from the camera to its root hub (the camera link itself, the external hubs and the root hub) must carry the
+ * sum of the streams of the cameras behind them. Only a fraction of the nominal link speed is usable, because of
+ * the encoding and of the protocol overhead (see \ref setUsableFraction).
+ *
+ * The topology is read from `<sysfs_root>/class/video4linux`, so a mock sysfs tree can be used for testing: it only
+ * needs the `device` symlinks of the video nodes, pointing to USB interface folders whose parents contain the
+ * `speed`, `busnum` and `devpath` files.
+ */
+class SL_OC_EXPORT UsbBandwidthPlanner
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param sysfs_root root of the sysfs tree
+     * \param verbose_lvl enable useful information to debug the class behaviours while running
+     */
+    UsbBandwidthPlanner( std::string sysfs_root="/sys", int verbose_lvl=sl_oc::VERBOSITY::ERROR );
+
+    /*!
+     * \brief Read the USB topology of a video device
+     * \param dev_name the video device (e.g. `/dev/video0`)
+     * \param info the returned information
+     * \return true if the device is a USB device with a known topology
+     */
+    bool getDeviceInfo( std::string dev_name, UsbDeviceInfo& info );
+
+    /*!
+     * \brief Get the bandwidth required by a camera stream
+     * \param res the resolution
+     * \param fps the frame rate
+     * \return the required bandwidth [Mbps]
+     */
+    static double requiredBandwidth( RESOLUTION res, FPS fps );
+
+    /*!
+     * \brief Verify that a set of cameras can stream at the same time
+     * \param cams the camera configurations
+     * \param loads the load of each USB link used by the cameras
+     * \return true if no link is overloaded. Cameras with unknown topology and links with unknown speed (sysfs
+     *         `speed` not numeric) are not considered
+     */
+    bool check( const std::vector<UsbCameraConfig>& cams, std::vector<UsbLinkLoad>& loads );
+
+    /*!
+     * \brief Lower the frame rates, then the resolutions, of the cameras on the overloaded links until the
+     *        configuration is feasible. The most demanding camera of the most overloaded link is lowered first
+     * \param cams the camera configurations, modified in place
+     * \return true if a feasible configuration has been found
+     */
+    bool recommend( std::vector<UsbCameraConfig>& cams );
+
+    /*!
+     * \brief Set the fraction of the nominal link speed usable for video streaming
+     * \param fraction the usable fraction, in (0,1]. Default: 0.6
+     */
+    inline void setUsableFraction( double fraction ){mUsableFraction=(fraction>0.0 && fraction<=1.0)?fraction:mUsableFraction;}
+
+private:
+    std::string readSysfs( const std::string& path );   //!< Read the first line of a sysfs file
+    static bool lowerConfig( UsbCameraConfig& cam );    //!< Lower the frame rate or the resolution of one step
+
+private:
+    std::string mSysfsRoot;         //!< Root of the sysfs tree
+    int mVerbose;                   //!< Verbose status
+    double mUsableFraction=0.6;     //!< Fraction of the link speed usable for video streaming
+};
+
+}
+
+}
+
+#endif
+
+#endif // USBPLANNER_HPP
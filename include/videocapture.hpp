@@ -24,14 +24,28 @@
 #include "defines.hpp"
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>      // std::ofstream
 #include <iomanip>
+#include <map>
+#include <memory>
 
 #define LOG_SEP ","
 
 #ifdef VIDEO_MOD_AVAILABLE
 
 #include "videocapture_def.hpp"
+#include "shmframering.hpp"
+#include "frameserver.hpp"
+#include "metrics.hpp"
+#include "timinganalyzer.hpp"
+#include "framestats.hpp"
+#include "autoexposure.hpp"
+#include "reglogger.hpp"
+#include "camerasettings.hpp"
+#include "frameoutput.hpp"
+#include "framepool.hpp"
 
 namespace sl_oc {
 
@@ -45,17 +59,38 @@ class SensorCapture;
 
 namespace video {
 
+class CameraGroup;
+
+/*!
+ * \brief Exposure and gain of the sensors, read asynchronously (see \ref VideoCapture::enableExposureSampler)
+ */
+struct SL_OC_EXPORT ExposureSample
+{
+    bool valid = false;             //!< Indicates if the sample is available
+    int exposure[2] = {0,0};        //!< Exposure [0,100] of the left and of the right sensor
+    int gain[2] = {0,0};            //!< Gain [0,100] of the left and of the right sensor
+    int exposure_raw[2] = {0,0};    //!< Raw exposure register value of the left and of the right sensor
+    int gain_raw[2] = {0,0};        //!< Raw gain register value of the left and of the right sensor
+    uint64_t frame_id = 0;          //!< Index of the last frame grabbed when the registers have been read
+    uint64_t timestamp_mono = 0;    //!< Monotonic time of the end of the register reading [nsec]
+};
+
 /*!
  * \brief The Frame struct containing the acquired video frames
  */
 struct SL_OC_EXPORT Frame
 {
     uint64_t frame_id = 0;          //!< Increasing index of frames
-    uint64_t timestamp = 0;         //!< Timestamp in nanoseconds
+    uint64_t timestamp = 0;         //!< Timestamp in nanoseconds, in the clock domain selected by \ref VideoParams::clock_source
+    uint64_t timestamp_mono = 0;    //!< Timestamp in nanoseconds in the `CLOCK_MONOTONIC` domain
+    uint64_t timestamp_wall = 0;    //!< Timestamp in nanoseconds in the wall clock domain
     uint8_t* data = nullptr;        //!< Frame data in YUV 4:2:2 format
     uint16_t width = 0;             //!< Frame width
     uint16_t height = 0;            //!< Frame height
     uint8_t channels = 0;           //!< Number of channels per pixel
+    FrameStats stats;               //!< Luma statistics, computed only if enabled with \ref VideoCapture::enableFrameStats
+    ExposureSample exposure;        //!< Last exposure and gain sample, only if enabled with \ref VideoCapture::enableExposureSampler
+    uint32_t tone_curve = 0;        //!< Identifier of the tone curve applied to the luma (see \ref VideoCapture::setToneCurve), `0` if none
 };
 
 /*!
@@ -65,6 +100,8 @@ class SL_OC_EXPORT VideoCapture
 {
     ZED_OC_VERSION_ATTRIBUTE;
 
+    friend class CameraGroup;
+
 public:
     /*!
      * \brief The default constructor
@@ -97,12 +134,46 @@ public:
      */
     const Frame& getLastFrame(uint64_t timeout_msec=100);
 
+    /*!
+     * \brief Copy the last received driver buffer again, as done by the grabbing thread for each frame
+     *
+     * The copy uses the current options: luma statistics, tone curve and captured image
+     * (see \ref VideoParams::capture_mode). The destination is a frame buffer of the \ref FramePool, the last frame
+     * is not modified. Used to measure the cost of the frame copy.
+     *
+     * \return the duration of the copy [nsec], 0 if no frame has been received yet
+     *
+     * \note The grabbing thread is blocked during the copy
+     * \note Not available for the cameras grabbed by a \ref CameraGroup
+     */
+    uint64_t measureFrameCopy();
+
     /*!
      * \brief Get the size of the camera frame
-     * \param width the frame width
+     * \param width the frame width. Half the width of the stream if a single image is captured
+     *        (see \ref VideoParams::capture_mode)
      * \param height the frame height
      */
-    inline void getFrameSize( int& width, int& height ){width=mWidth;height=mHeight;}
+    inline void getFrameSize( int& width, int& height ){width=mFrameWidth;height=mHeight;}
+
+    /*!
+     * \brief Change the resolution and the frame rate of the opened camera without closing it
+     *
+     * The streaming is stopped and the new format is negotiated on the opened device: the driver buffers and the
+     * frame buffer are allocated again only if the frame size changes. The camera controls are not reset and the
+     * AEC/AGC ROIs are scaled to the new frame size. The frame statistics, the host auto exposure, the exposure
+     * sampler and the timing analysis are updated for the new configuration.
+     *
+     * \param res the new resolution. Unsupported combinations are corrected as in \ref initializeVideo
+     * \param fps the new frame rate
+     * \return true if the new configuration is active. If the new format is refused by the device the previous one
+     *         is restored and false is returned
+     *
+     * \note If the frame size changes, the data of the frames returned before the call are no longer valid and the
+     *       frame publishers are created again: their subscribers and clients must reconnect
+     * \note Not available for the cameras grabbed by a \ref CameraGroup
+     */
+    bool reconfigure(RESOLUTION res, FPS fps);
 
     // ----> Led Control
     /*!
@@ -332,6 +403,34 @@ public:
      * \return the current Exposure value
      */
     int getExposure(CAM_SENS_POS cam);
+
+    /*!
+     * \brief Read the current value of all the camera controls
+     * \param settings the returned settings, bound to the serial number of the camera
+     * \return true if all the controls have been correctly read
+     */
+    bool captureSettings(CameraSettings& settings);
+
+    /*!
+     * \brief Apply a snapshot of the camera controls in a single ordered transaction
+     *
+     * The settings are compared with the current state of the camera and only the controls that differ are written:
+     * image controls first, then Gamma, White Balance, AEC/AGC ROIs and finally the AEC/AGC mode with the manual
+     * Gain and Exposure. The automatic modes are disabled before writing the manual values and enabled only after
+     * the ROIs, so the camera never runs with a partial configuration.
+     *
+     * If a write fails, no other control is written and the controls already written are restored, in reverse order,
+     * to the values read before the transaction. An invalid AEC/AGC ROI is ignored before writing.
+     *
+     * \param settings the settings to be applied. The controls with a negative value are left unchanged
+     * \return the number of controls written, `-1` if the camera is not initialized or its state cannot be read,
+     *         `-2` if the settings are bound to another camera, `-3` if a write failed and the previous state has
+     *         been restored, `-4` if a write failed and the previous state could not be fully restored
+     *
+     * \note Gain and Exposure are not written while the host auto exposure is enabled
+     *       (see \ref enableHostAutoExposure)
+     */
+    int applySettings(const CameraSettings& settings);
     // <---- Camera Settings control
 
     /*!
@@ -357,12 +456,175 @@ public:
      */
     inline int getDeviceId(){return mDevId;}
 
+    /*!
+     * \brief Enable the publisher mode: each grabbed frame is also written into a POSIX shared memory ring that
+     *        can be read by other processes using a \ref ShmFrameSubscriber object
+     * \param name name of the shared memory segment. If empty `/zed_oc_<serial_number>` is used
+     * \param slot_count number of frame slots in the ring
+     * \return true if the shared memory ring has been correctly created
+     *
+     * \note The camera must be initialized before calling this function
+     */
+    bool enableShmPublisher(std::string name="", uint8_t slot_count=SHM_RING_DEFAULT_SLOTS);
+
+    /*!
+     * \brief Disable the publisher mode and remove the shared memory ring
+     */
+    void disableShmPublisher();
+
+    /*!
+     * \brief Start a \ref FrameServer that sends each grabbed frame to the local clients connected to a Unix
+     *        domain socket (see \ref FrameClient)
+     * \param socket_path path of the socket. If empty `/tmp/zed_oc_<serial_number>.sock` is used
+     * \param params the server parameters (see \ref FrameServerParams)
+     * \return true if the server has been correctly started
+     *
+     * \note The camera must be initialized before calling this function
+     */
+    bool enableFrameServer(std::string socket_path="", FrameServerParams params=FrameServerParams());
+
+    /*!
+     * \brief Stop the frame server and disconnect all its clients
+     */
+    void disableFrameServer();
+
+    /*!
+     * \brief Add a consumer of cropped, decimated or converted frames. The output frames are produced by the
+     *        grabbing thread from each grabbed frame, only for the registered consumers
+     * \param params the output description (see \ref OutputParams). The crop rectangle is normalized on the
+     *        captured frame, so it is kept when the resolution is changed with \ref reconfigure
+     * \return the identifier of the output, -1 if the camera is not initialized or the parameters are not valid
+     */
+    int addOutput(const OutputParams& params);
+
+    /*!
+     * \brief Remove a consumer added with \ref addOutput
+     * \param id the identifier of the output
+     */
+    void removeOutput(int id);
+
+    /*!
+     * \brief Wait for a new frame of an output added with \ref addOutput
+     * \param id the identifier of the output
+     * \param frame the returned frame, valid until the next call of this function for the same output
+     * \param timeout_msec waiting timeout in milliseconds
+     * \return true if a new frame has been received before the timeout
+     *
+     * \note Only one thread must read each output. The output frames are invalidated by \ref reconfigure
+     */
+    bool getOutputFrame(int id, OutputFrame& frame, uint64_t timeout_msec=100);
+
+    /*!
+     * \brief Start the analysis of the timing of the grabbed frames: frame period, jitter, delay of reception
+     *        and offset of the IMU sync signals, if a SensorCapture object is synchronized
+     * \param window number of samples of the rolling statistics
+     * \return true if the analysis has been correctly started
+     *
+     * \note The camera must be initialized before calling this function. The analysis restarts from scratch
+     */
+    bool enableTimingAnalysis(size_t window=TIMING_DEFAULT_WINDOW);
+
+    /*!
+     * \brief Stop the analysis of the timing of the grabbed frames
+     */
+    inline void disableTimingAnalysis(){mTimingEnabled=false;}
+
+    /*!
+     * \brief Enable the computation of the luma statistics of each frame (histogram, mean and saturation of the
+     *        regions of interest of each eye), in the same pass as the copy of the frame from the driver buffer.
+     *        The statistics are returned in \ref Frame::stats
+     * \param params the statistics parameters (see \ref FrameStatsParams)
+     * \return false if the camera is not initialized or if the parameters are not valid
+     */
+    bool enableFrameStats(const FrameStatsParams& params=FrameStatsParams());
+
+    /*!
+     * \brief Disable the computation of the luma statistics
+     */
+    void disableFrameStats();
+
+    /*!
+     * \brief Apply a tone curve to the luma of the frames, in the same pass as the copy of the frame from the
+     *        driver buffer. The curve can be changed at each frame with no communication with the camera
+     * \param curve the tone curve (see \ref ToneCurve)
+     * \return the identifier of the curve, returned in \ref Frame::tone_curve for the frames it is applied to
+     *
+     * \note The luma statistics (see \ref enableFrameStats) are computed before the curve is applied
+     */
+    uint32_t setToneCurve(const ToneCurve& curve);
+
+    /*!
+     * \brief Stop applying the tone curve to the frames
+     */
+    inline void disableToneCurve(){mToneCurveId=0;}
+
+    /*!
+     * \brief Start the host auto exposure: a side thread meters the luma statistics of each frame and drives the
+     *        exposure and the gain of both sensors, replacing the firmware AEC/AGC
+     * \param params the controller parameters (see \ref AutoExposureParams)
+     * \param metering the metering regions, weighted by \ref AutoExposureParams::roi_weights. They replace the
+     *        configuration of the frame statistics (see \ref enableFrameStats)
+     * \return false if the camera is not initialized or if the parameters are not valid
+     *
+     * \note Do not call \ref setExposure, \ref setGain or \ref setAECAGC while the host auto exposure is enabled
+     */
+    bool enableHostAutoExposure(const AutoExposureParams& params=AutoExposureParams(),
+                                const FrameStatsParams& metering=FrameStatsParams());
+
+    /*!
+     * \brief Stop the host auto exposure. The current exposure and gain are kept and the frame statistics are
+     *        still computed
+     */
+    void disableHostAutoExposure();
+
+    /*!
+     * \brief Get the status of the host auto exposure
+     * \param status the returned status (see \ref AutoExposureStatus)
+     * \return false if the host auto exposure is not enabled
+     */
+    bool getHostAutoExposureStatus(AutoExposureStatus& status);
+
+    /*!
+     * \brief Start a side thread that reads the exposure and the gain of both sensors at a fixed rate. The last
+     *        sample is attached to each grabbed frame in \ref Frame::exposure
+     * \param rate_hz sampling rate, limited to 50 Hz: the register readings must leave room on the extension unit
+     *        for the camera controls. The effective rate is also limited by the duration of the USB control transfers
+     * \return false if the camera is not initialized or if the rate is not positive
+     *
+     * \note The sample attached to a frame can be older than the frame: use \ref ExposureSample::frame_id to
+     * know which frames have been grabbed before the reading
+     */
+    bool enableExposureSampler(float rate_hz=10.0f);
+
+    /*!
+     * \brief Stop the exposure and gain sampling thread
+     */
+    void disableExposureSampler();
+
+    /*!
+     * \brief Get the last exposure and gain sample
+     * \param sample the returned sample
+     * \return false if no sample is available
+     */
+    bool getLastExposureSample(ExposureSample& sample);
+
+    /*!
+     * \brief Get the current timing statistics
+     * \param report the returned statistics (see \ref TimingReport)
+     * \return false if the timing analysis is not enabled
+     */
+    bool getTimingReport(TimingReport& report);
+
 #ifdef SENSOR_LOG_AVAILABLE
     /*!
      * \brief Start logging to file of AEG/AGC camera registers
      * \param enable set to true to enable logging
      * \param frame_skip number of frames to skip when logging to file
      * \return true if log file can be correctly created/closed
+     *
+     * \note The registers are read and saved by the threads of a \ref RegisterLogger: the grabbing thread only
+     * enqueues a request, so that the logging does not perturb the frame timing. The binary log file can be
+     * converted to CSV with the `zed_open_capture_reg_log_dump` tool
      */
     bool enableAecAgcSensLogging(bool enable, int frame_skip=10);
 
@@ -395,12 +657,25 @@ public:
      *        be synchronized to the last Sensor Data
      */
     inline void setReadyToSync(){ mSensReadyToSync=true; }
+
+    /*!
+     * \brief Called by SensorCapture when an IMU sample is flagged with the frame sync signal
+     * \param ts monotonic timestamp of the IMU sample [nsec]
+     */
+    inline void addImuSyncTimestamp(uint64_t ts){ if(mTimingEnabled) mTiming.addImuSync(ts); }
 #endif
 
         bool resetAGCAECregisters();
 
 private:
     void grabThreadFunc();  //!< The frame grabbing thread function
+    bool grabFrame(Frame* dst=nullptr); //!< Dequeue and process one frame, if ready. `dst` receives the data instead of the last frame
+    void copyFrameData(Frame& frame); //!< Copy the current UVC buffer, computing the luma statistics and applying the tone curve if enabled
+    void initMetrics();     //!< Create the metrics of the opened camera in the \ref MetricsRegistry
+    void aeThreadFunc();    //!< The host auto exposure thread function
+    void expSamplerThreadFunc(); //!< The exposure and gain sampling thread function
+    void publishExposureSample(const ExposureSample& sample); //!< Write \ref mExpSample under the sequence lock
+    void notifyAutoExposure(const FrameStats& stats, uint64_t frame_id, uint64_t rx_ts); //!< Pass the statistics of a new frame to the auto exposure thread
 
     // ----> Low level functions
     int ll_VendorControl(uint8_t *buf, int len, int readMode, bool safe = false, bool force=false);
@@ -428,7 +703,7 @@ private:
     // <---- Low level functions
 
     // ----> Mid level functions
-    void setCameraControlSettings(int ctrl_id, int ctrl_val);
+    int setCameraControlSettings(int ctrl_id, int ctrl_val); // Write a UVC control, returns 0 if success
     void resetCameraControlSettings(int ctrl_id);
     int getCameraControlSettings(int ctrl_id);
 
@@ -436,11 +711,34 @@ private:
 
     int calcRawGainValue(int gain); // Convert "user gain" to "ISP gain"
     int calcGainValue(int rawGain); // Convert "ISP Gain" to "User gain"
+    int calcRawExposureValue(int exposure); // Convert "user exposure" to "ISP exposure"
+    /*!
+     * \brief Sensor state read with the settings, restored exactly if \ref applySettings fails
+     */
+    struct RawSettings
+    {
+        int aec_agc[2] = {0,0};     //!< AEC/AGC mode of each sensor, they can differ
+        int gain[2] = {0,0};        //!< Raw gain register value of each sensor
+        int exposure[2] = {0,0};    //!< Raw exposure register value of each sensor
+    };
+
+    bool readSettings(CameraSettings& settings, RawSettings* raw=nullptr); // Read all the camera controls, see \ref captureSettings
+    bool checkROIforAECAGC(CAM_SENS_POS side, uint16_t x, uint16_t y, uint16_t w, uint16_t h); // Check a ROI before writing it
+    int setRawExposure(int sensorId, int rawExp); // Write the "ISP exposure", returns 0 if success
+    int setRawGain(int sensorId, int rawGain); // Write the "ISP gain", returns 0 if success
+    int getRawExposure(int sensorId); // Read the "ISP exposure", negative if an error occurred
+    int getRawGain(int sensorId); // Read the "ISP gain", negative if an error occurred
     // <---- Mid level functions
 
     // ----> Connection control functions
     bool openCamera( uint8_t devId );                           //!< Open camera
     bool startCapture();                                        //!< Start video capture thread
+    bool startStreaming();                                      //!< Queue all the UVC buffers and start the streaming
+    bool setFormat();                                           //!< Set the frame size and rate on the opened device
+    bool allocateBuffers();                                     //!< Request and map the UVC buffers
+    bool allocateFrame();                                       //!< Get the buffer of \ref mLastFrame from the \ref FramePool
+    void releaseBuffers();                                      //!< Unmap and release the UVC buffers
+    int getCapturedEye();                                       //!< Image copied in the frames: `-1` both, `0` left, `1` right
     void reset();                                               //!< Reset camera connection
     inline void stopCapture(){mStopCapture=true;}               //!< Stop video capture thread
     int input_set_framerate(int fps);                           //!< Set UVC framerate
@@ -471,8 +769,7 @@ private:
     }
 
 #ifdef SENSOR_LOG_AVAILABLE
-    void saveLogDataLeft();
-    void saveLogDataRight();
+    int readLogRegisters(int side, uint8_t* values); //!< Read the AEC/AGC registers of a sensor, see \ref RegLogRecord
 #endif
 
 private:
@@ -481,17 +778,23 @@ private:
     bool mInitialized=false;            //!< Inficates if the camera has been initialized
     bool mStopCapture=true;             //!< Indicates if the grabbing thread must be stopped
     bool mGrabRunning=false;            //!< Indicates if the grabbing thread is running
+    bool mExternalGrab=false;           //!< Indicates that the frames are grabbed by a CameraGroup instead of the grabbing thread
 
     VideoParams mParams;                //!< Grabbing parameters
 
     int mDevId = 0;                     //!< ID of the camera device
+    int mSerialNumber = -1;             //!< Serial number of the opened camera
     std::string mDevName;               //!< The file descriptor path name (e.g. /dev/video0)
     int mFileDesc=-1;                   //!< The file descriptor handler
+    std::shared_ptr<VideoDeviceIO> mIO; //!< Access layer of the device (V4L2 or emulated)
 
     std::mutex mBufMutex;               //!< Mutex for safe access to data buffer
-    std::mutex mComMutex;               //!< Mutex for safe access to UVC communication
+    std::mutex mComMutex;               //!< Mutex for safe access to the streaming buffer queue (VIDIOC_DQBUF/VIDIOC_QBUF)
+    std::mutex mXuMutex;                //!< Serializes the extension unit commands, never taken by the grabbing thread
+    std::mutex mSettingsMutex;          //!< Serializes \ref captureSettings and \ref applySettings
 
-    int mWidth = 0;                     //!< Frame width
+    int mWidth = 0;                     //!< Stream width, both images
+    int mFrameWidth = 0;                //!< Width of the returned frames: half of \ref mWidth if a single image is captured
     int mHeight = 0;                    //!< Frame height
     int mChannels = 0;                  //!< Frame channels
     int mFps=0;                         //!< Frames per seconds
@@ -503,8 +806,10 @@ private:
     uint8_t mCurrentIndex = 0;          //!< The index of the currect UVC buffer
     struct UVCBuffer *mBuffers = nullptr;  //!< UVC buffers
 
-    uint64_t mStartTs=0;                //!< Initial System Timestamp, to calculate differences [nsec]
+    uint64_t mStartTs=0;                //!< Initial monotonic System Timestamp, to calculate differences [nsec]
     uint64_t mInitTs=0;                 //!< Initial Device Timestamp, to calculate differences [usec]
+    bool mMonoBufTs=false;              //!< Indicates if the driver stamps the buffers with `CLOCK_MONOTONIC`
+    int mClockId=-1;                    //!< Identifier of the device clock in \ref ClockSync, if not stamped by the driver
 
     int mGainSegMax=0;                  //!< Maximum value of the raw gain to be used for conversion
     int mExpoureRawMax;                 //!< Maximum value of the raw exposure to be used for conversion
@@ -513,14 +818,75 @@ private:
 
     bool mFirstFrame=true;              //!< Used to initialize the timestamp start point
 
+    // ----> Metrics
+    MetricCounter* mMetFrames=nullptr;      //!< Grabbed frames
+    MetricCounter* mMetDropped=nullptr;     //!< Frames lost by the driver or incomplete
+    MetricGauge* mMetFps=nullptr;           //!< Measured frame rate
+    MetricHistogram* mMetLatency=nullptr;   //!< Delay between the capture and the dequeue of the frames
+    uint32_t mLastSequence=0;               //!< V4L2 sequence number of the last frame, to count the lost frames
+    uint64_t mLastFrameTs=0;                //!< Monotonic timestamp of the last frame, to measure the frame rate
+    double mFpsAvg=0.0;                     //!< Smoothed frame rate
+    // <---- Metrics
+
+    FrameStatsCalculator mStatsCalc;        //!< Copy of the frames with luma statistics
+    bool mStatsEnabled=false;               //!< Indicates if the luma statistics are computed. Protected by `mBufMutex`
+    FrameStatsParams mStatsParams;          //!< Parameters of the luma statistics, to configure them again for a new frame size
+
+    // ----> Tone curve
+    std::mutex mToneMutex;                  //!< Mutex for safe access to the last requested curve
+    ToneCurve mToneCurve;                   //!< Last curve set by \ref setToneCurve
+    std::atomic<uint32_t> mToneCurveId{0};  //!< Identifier of the last requested curve, `0` if disabled
+    uint32_t mToneCurveCount=0;             //!< Number of curves set, to assign the identifiers
+    ToneCurve mToneActive;                  //!< Curve applied by the grabbing thread
+    uint32_t mToneActiveId=0;               //!< Identifier of the curve applied by the grabbing thread
+    // <---- Tone curve
+
+    // ----> Exposure sampling
+    std::atomic<bool> mExpSamplerEnabled{false}; //!< Indicates if the exposure sampling is enabled
+    bool mExpStop=false;                    //!< Indicates if the sampling thread must be stopped
+    uint64_t mExpPeriodUsec=0;              //!< Sampling period
+    std::thread mExpThread;                 //!< The sampling thread
+    std::mutex mExpMutex;                   //!< Mutex for the stop signal of the sampling thread
+    std::condition_variable mExpCond;       //!< Wakes up the sampling thread to stop it
+    std::atomic<uint32_t> mExpSeq{0};       //!< Sequence lock of \ref mExpSample: odd while it is written
+    ExposureSample mExpSample;              //!< Last sample, read without lock by the grabbing thread
+    std::atomic<uint64_t> mGrabbedFrameId{0}; //!< Index of the last grabbed frame
+    // <---- Exposure sampling
+
+    // ----> Host auto exposure
+    AutoExposureController mAeCtrl;         //!< Exposure and gain computation
+    std::atomic<bool> mAeEnabled{false};    //!< Indicates if the host auto exposure is enabled
+    bool mAeStop=false;                     //!< Indicates if the auto exposure thread must be stopped
+    std::thread mAeThread;                  //!< The auto exposure thread
+    std::mutex mAeMutex;                    //!< Mutex for safe access to the data shared with the auto exposure thread
+    std::condition_variable mAeCond;        //!< Signals a new frame to the auto exposure thread
+    bool mAeNewStats=false;                 //!< Indicates if the statistics of a new frame are available
+    FrameStats mAeStats;                    //!< Statistics of the last frame
+    uint64_t mAeFrameId=0;                  //!< Index of the last frame
+    uint64_t mAeRxTs=0;                     //!< Monotonic reception time of the last frame
+    AutoExposureStatus mAeStatus;           //!< Status of the auto exposure
+    AutoExposureParams mAeParams;           //!< Parameters of the auto exposure, to restart it after a new configuration
+    FrameStatsParams mAeMetering;           //!< Metering regions of the auto exposure
+    // <---- Host auto exposure
+
+    TimingAnalyzer mTiming;                 //!< Frame timing statistics
+    std::atomic<bool> mTimingEnabled{false}; //!< Indicates if the timing analysis is enabled
+
+    ShmFramePublisher* mShmPub=nullptr; //!< Shared memory ring publisher, if enabled
+    FrameServer* mFrameSrv=nullptr;     //!< Unix socket frame server, if enabled
+    std::mutex mPubMutex;               //!< Mutex for safe access to the frame publishers
+
+    std::map<int,std::shared_ptr<FrameOutput>> mOutputs; //!< Consumers of cropped/decimated frames, by identifier
+    int mNextOutputId=0;                //!< Identifier of the next added output
+    std::mutex mOutMutex;               //!< Mutex for safe access to the outputs
+
 #ifdef SENSOR_LOG_AVAILABLE
     // ----> Registers logging
-    bool mLogEnable=false;
-    std::string mLogFilenameLeft;
-    std::string mLogFilenameRight;
-    std::ofstream mLogFileLeft;
-    std::ofstream mLogFileRight;
-    int mLogFrameSkip=10;
+    bool mLogEnable=false;              //!< Indicates if the registers are logged. Protected by `mBufMutex`
+    std::string mLogFilename;           //!< Name of the binary log file
+    RegisterLogger* mRegLogger=nullptr; //!< Asynchronous register logger, if enabled
+    int mLogFrameSkip=10;               //!< Number of frames between two register readings
+    int mLogFrameCount=0;               //!< Frames since the last register reading
     // <---- Registers logging
 #endif
 
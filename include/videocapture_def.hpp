@@ -26,11 +26,16 @@
 #endif
 
 #include "defines.hpp"
+#include "hostclock.hpp"
+
+#include <memory>
 
 namespace sl_oc {
 
 namespace video {
 
+class VideoDeviceIO;
+
 /*!
  * \brief Camera models
  */
@@ -75,6 +80,15 @@ enum class CAM_SENS_POS {
     LAST = 3
 };
 
+/*!
+ * \brief Images copied from the side-by-side stream of the camera
+ */
+enum class CAPTURE_MODE {
+    STEREO,     //!< Left and right images, side by side
+    LEFT,       //!< Left image only: the frames are half the width of the stream
+    RIGHT       //!< Right image only: the frames are half the width of the stream
+};
+
 /*!
  * \brief The camera configuration parameters
  */
@@ -87,11 +101,21 @@ typedef struct VideoParams
         res = RESOLUTION::HD2K;
         fps = FPS::FPS_15;
         verbose= sl_oc::VERBOSITY::ERROR;
+        clock_source = CLOCK_SOURCE::WALL;
+        capture_mode = CAPTURE_MODE::STEREO;
+        device_io = nullptr;
+        frame_huge_pages = false;
+        frame_numa_node = -1;
     }
 
     RESOLUTION res; //!< Camera resolution
     FPS fps;        //!< Frames per second
     int verbose;   //!< Verbose mode
+    CLOCK_SOURCE clock_source; //!< Clock used for \ref Frame::timestamp
+    CAPTURE_MODE capture_mode; //!< Images copied in the frames. The camera always streams both images
+    std::shared_ptr<VideoDeviceIO> device_io; //!< Device access layer. `nullptr` for the V4L2 devices (see \ref MockVideoDevice)
+    bool frame_huge_pages;  //!< Allocate the frame buffers on huge pages (see \ref FramePool)
+    int frame_numa_node;    //!< NUMA node of the frame buffers. `-1` for the node of the grabbing thread
 } VideoParams;
 
 /*!
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef VIDEODEVICE_HPP
+#define VIDEODEVICE_HPP
+
+#include "defines.hpp"
+
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief The VideoDeviceIO class is the interface of all the system calls used by \ref VideoCapture to access
+ *        the V4L2 devices. The functions have the same semantic of the corresponding system calls, `errno` included.
+ *
+ * The file descriptors returned by \ref open must be pollable (`select`/`epoll`): they are readable when a
+ * frame can be dequeued.
+ *
+ * \note The default implementation is \ref V4L2DeviceIO. \ref MockVideoDevice emulates the cameras with no hardware.
+ */
+class SL_OC_EXPORT VideoDeviceIO
+{
+public:
+    /*!
+     * \brief The class destructor
+     */
+    virtual ~VideoDeviceIO() = default;
+
+    /*!
+     * \brief Read the USB `modalias` of a device (e.g. `usb:v2B03pF582...`), used to identify the camera model
+     * \param dev_name the device name (e.g. `/dev/video0`)
+     * \param modalias the returned modalias
+     * \return true if the modalias is available
+     */
+    virtual bool readModalias(const std::string& dev_name, std::string& modalias) = 0;
+
+    virtual int stat(const char* path, struct ::stat* st) = 0;                             //!< See `stat(2)`
+    virtual int open(const char* path, int flags) = 0;                                      //!< See `open(2)`
+    virtual int close(int fd) = 0;                                                          //!< See `close(2)`
+    virtual int ioctl(int fd, unsigned long request, void* arg) = 0;                        //!< See `ioctl(2)`
+    virtual void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) = 0; //!< See `mmap(2)`
+    virtual int munmap(void* addr, size_t length) = 0;                                      //!< See `munmap(2)`
+};
+
+/*!
+ * \brief The V4L2DeviceIO class forwards the calls of \ref VideoDeviceIO to the kernel
+ */
+class SL_OC_EXPORT V4L2DeviceIO : public VideoDeviceIO
+{
+public:
+    /*!
+     * \brief Get the instance shared by all the \ref VideoCapture objects that do not use a custom device layer
+     * \return the shared instance
+     */
+    static std::shared_ptr<VideoDeviceIO> getInstance();
+
+    bool readModalias(const std::string& dev_name, std::string& modalias) override;
+    int stat(const char* path, struct ::stat* st) override;
+    int open(const char* path, int flags) override;
+    int close(int fd) override;
+    int ioctl(int fd, unsigned long request, void* arg) override;
+    void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) override;
+    int munmap(void* addr, size_t length) override;
+};
+
+}
+
+}
+
+#endif
+
+#endif // VIDEODEVICE_HPP
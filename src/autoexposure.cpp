@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "autoexposure.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace sl_oc {
+
+namespace video {
+
+bool AutoExposureController::configure(const AutoExposureParams& params, size_t roi_count,
+                                       const std::vector<double>& gain_table, float min_exposure)
+{
+    if(roi_count==0 || gain_table.empty() || params.speed<=0.0f || params.speed>1.0f ||
+            params.target_luma<=0.0f || params.target_luma>=255.0f || params.max_exposure<=min_exposure)
+        return false;
+
+    if(!params.roi_weights.empty() && params.roi_weights.size()!=roi_count)
+        return false;
+
+    // ----> Normalized weights
+    std::vector<float> weights = params.roi_weights;
+    if(weights.empty())
+        weights.assign(roi_count, 1.0f);
+
+    float sum = 0.0f;
+    for(float w : weights)
+    {
+        if(w<0.0f)
+            return false;
+        sum += w;
+    }
+    if(sum<=0.0f)
+        return false;
+
+    for(float& w : weights)
+        w /= sum;
+    // <---- Normalized weights
+
+    mParams = params;
+    mParams.max_gain = std::max(0, std::min(params.max_gain, static_cast<int>(gain_table.size())-1));
+    mWeights = weights;
+    mGainTable = gain_table;
+    mMinExposure = min_exposure;
+    mConverged = false;
+    mUpdates = 0;
+
+    return true;
+}
+
+void AutoExposureController::setState(float exposure, int gain)
+{
+    mExposure = std::max(mMinExposure, std::min(mParams.max_exposure, exposure));
+    mGain = std::max(0, std::min(mParams.max_gain, gain));
+}
+
+bool AutoExposureController::update(const FrameStats& stats, float& exposure, int& gain)
+{
+    if(!stats.valid || stats.roi_count!=mWeights.size())
+        return false;
+
+    // ----> Metering
+    float luma = 0.0f;
+    float saturation = 0.0f;
+    for(size_t r=0; r<mWeights.size(); r++)
+    {
+        // A single image is measured when only one is captured
+        int eyes = (stats.left[r].pixels>0?1:0) + (stats.right[r].pixels>0?1:0);
+        if(eyes==0)
+            continue;
+
+        luma += mWeights[r]*(stats.left[r].mean+stats.right[r].mean)/eyes;
+        saturation += mWeights[r]*(stats.left[r].saturation+stats.right[r].saturation)/eyes;
+    }
+    mLuma = luma;
+    mSaturation = saturation;
+    // <---- Metering
+
+    // ----> Correction of the total exposure
+    bool too_saturated = saturation>mParams.max_saturation;
+    mConverged = !too_saturated && std::fabs(luma-mParams.target_luma)<=mParams.tolerance;
+    if(mConverged)
+        return false;
+
+    double ratio = mParams.target_luma/std::max(1.0f, luma);
+    if(too_saturated)
+    {
+        // The mean is not reliable when the highlights are clipped: the exposure is reduced anyway
+        ratio = std::min(ratio, std::max(0.5, static_cast<double>(mParams.max_saturation/saturation)));
+    }
+
+    double total = mExposure*mGainTable[mGain]*std::pow(ratio, static_cast<double>(mParams.speed));
+    // <---- Correction of the total exposure
+
+    // ----> Split between exposure and gain: the exposure time first, to keep the noise low
+    float new_exp = static_cast<float>(total/mGainTable[0]);
+    int new_gain = 0;
+    if(new_exp>mParams.max_exposure)
+    {
+        double needed = total/mParams.max_exposure;
+        while(new_gain<mParams.max_gain && mGainTable[new_gain]<needed)
+            new_gain++;
+        new_exp = static_cast<float>(total/mGainTable[new_gain]);
+    }
+    new_exp = std::max(mMinExposure, std::min(mParams.max_exposure, new_exp));
+    // <---- Split between exposure and gain
+
+    if(new_gain==mGain && std::fabs(new_exp-mExposure)<0.01f)
+        return false;
+
+    mExposure = new_exp;
+    mGain = new_gain;
+    mUpdates++;
+
+    exposure = mExposure;
+    gain = mGain;
+    return true;
+}
+
+AutoExposureStatus AutoExposureController::getStatus() const
+{
+    AutoExposureStatus status;
+    status.luma = mLuma;
+    status.saturation = mSaturation;
+    status.exposure = mExposure;
+    status.gain = mGain;
+    status.converged = mConverged;
+    status.updates = mUpdates;
+    return status;
+}
+
+}
+
+}
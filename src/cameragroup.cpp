@@ -0,0 +1,389 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "cameragroup.hpp"
+#include "trace.hpp"
+
+#include <errno.h>            // for errno
+#include <unistd.h>           // for close, write
+#include <sys/epoll.h>        // for epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h>      // for eventfd
+
+#define GROUP_MAX_EVENTS 16
+#define GROUP_STOP_EVENT 0xFFFFFFFF
+
+namespace sl_oc {
+
+namespace video {
+
+CameraGroup::CameraGroup( VideoParams params, uint8_t buffers_per_camera )
+{
+    mParams = params;
+    mUsbPlanner = UsbBandwidthPlanner("/sys", mParams.verbose);
+    // One buffer can be held by the consumer, at least another one must be available for the reactor
+    mBufPerCam = std::max<uint8_t>(2,buffers_per_camera);
+}
+
+CameraGroup::~CameraGroup()
+{
+    stop();
+
+    for( auto cam : mCameras )
+        delete cam;
+    mCameras.clear();
+
+    for( auto& bufs : mBuffers )
+        for( auto& frm : bufs )
+            FramePool::getInstance().release(frm.data);
+    mBuffers.clear();
+}
+
+int CameraGroup::addCamera( int devId )
+{
+    if( !mStopReactor )
+    {
+        ERROR_OUT(mParams.verbose,"Cameras cannot be added while the group is running");
+        return -1;
+    }
+
+    VideoCapture* cap = new VideoCapture(mParams);
+    cap->mExternalGrab = true;
+
+    bool opened = false;
+    if( devId==-1 )
+    {
+        // Try all the devices not already in the group (max allowed by v4l: 64)
+        for( int id=0; id<64 && !opened; id++ )
+        {
+            bool used = false;
+            for( auto cam : mCameras )
+                used |= (cam->mDevId==id);
+
+            if( !used && checkUsbBandwidth(id) )
+                opened = cap->initializeVideo(id);
+        }
+    }
+    else if( checkUsbBandwidth(devId) )
+    {
+        opened = cap->initializeVideo(devId);
+    }
+
+    if( !opened )
+    {
+        delete cap;
+        ERROR_OUT(mParams.verbose,"Cannot open a camera for the group");
+        return -1;
+    }
+
+    // ----> Frame buffers
+    int w,h;
+    cap->getFrameSize(w,h);
+    size_t size = static_cast<size_t>(w)*h*cap->mChannels;
+
+    std::vector<Frame> bufs(mBufPerCam);
+    std::vector<int> free_bufs;
+    for( int b=0; b<mBufPerCam; b++ )
+    {
+        bufs[b].data = FramePool::getInstance().acquire(size, mParams.frame_huge_pages, mParams.frame_numa_node);
+        if( !bufs[b].data )
+        {
+            for( auto& frm : bufs )
+                FramePool::getInstance().release(frm.data);
+            delete cap;
+            ERROR_OUT(mParams.verbose,"Cannot allocate the frame buffers of the camera");
+            return -1;
+        }
+        free_bufs.push_back(b);
+    }
+    // <---- Frame buffers
+
+    UsbCameraConfig usb_cfg;
+    usb_cfg.dev_name = cap->mDevName;
+    usb_cfg.res = mParams.res;
+    usb_cfg.fps = mParams.fps;
+    mUsbConfigs.push_back(usb_cfg);
+
+    mCameras.push_back(cap);
+    mBuffers.push_back(bufs);
+    mFreeBuffers.push_back(free_bufs);
+    mDropped.push_back(0);
+
+    if(mParams.verbose)
+    {
+        std::string msg = std::string("Camera #") + std::to_string(mCameras.size()-1) + " added: '" + cap->mDevName +
+                "' [SN: " + std::to_string(cap->mSerialNumber) + "]";
+        INFO_OUT(mParams.verbose,msg);
+    }
+
+    return static_cast<int>(mCameras.size())-1;
+}
+
+void CameraGroup::enableUsbBandwidthCheck( bool enable, std::string sysfs_root )
+{
+    mUsbCheck = enable;
+    mUsbPlanner = UsbBandwidthPlanner(sysfs_root, mParams.verbose);
+}
+
+bool CameraGroup::checkUsbBandwidth( int devId )
+{
+    if( !mUsbCheck )
+        return true;
+
+    std::vector<UsbCameraConfig> cams = mUsbConfigs;
+    UsbCameraConfig cfg;
+    cfg.dev_name = std::string("/dev/video") + std::to_string(devId);
+    cfg.res = mParams.res;
+    cfg.fps = mParams.fps;
+
+    // Devices with unknown topology (e.g. not USB) are not verified
+    UsbDeviceInfo info;
+    if( !mUsbPlanner.getDeviceInfo(cfg.dev_name, info) )
+        return true;
+
+    cams.push_back(cfg);
+
+    std::vector<UsbLinkLoad> loads;
+    if( mUsbPlanner.check(cams, loads) )
+        return true;
+
+    if(mParams.verbose)
+    {
+        std::string msg = std::string("Not enough USB bandwidth to open '") + cfg.dev_name + "' with the group parameters";
+        ERROR_OUT(mParams.verbose,msg);
+
+        if( mUsbPlanner.recommend(cams) )
+        {
+            INFO_OUT(mParams.verbose,"The configuration above would be feasible");
+        }
+    }
+
+    return false;
+}
+
+bool CameraGroup::start()
+{
+    if( !mStopReactor )
+        return true;
+
+    if( mCameras.empty() )
+    {
+        ERROR_OUT(mParams.verbose,"No camera in the group");
+        return false;
+    }
+
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    mEventFd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if( mEpollFd==-1 || mEventFd==-1 )
+    {
+        ERROR_OUT(mParams.verbose,"Cannot create the group reactor");
+        stop();
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = GROUP_STOP_EVENT;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mEventFd, &ev);
+
+    for( size_t i=0; i<mCameras.size(); i++ )
+    {
+        ev.events = EPOLLIN;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        if( epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mCameras[i]->mFileDesc, &ev)==-1 )
+        {
+            std::string msg = std::string("Cannot add the camera #") + std::to_string(i) + " to the reactor: " + strerror(errno);
+            ERROR_OUT(mParams.verbose,msg);
+            stop();
+            return false;
+        }
+    }
+
+    mStopReactor = false;
+    mReactorThread = std::thread( &CameraGroup::reactorThreadFunc, this );
+
+    return true;
+}
+
+void CameraGroup::stop()
+{
+    mStopReactor = true;
+
+    if( mEventFd!=-1 )
+    {
+        uint64_t val = 1;
+        if( write(mEventFd, &val, sizeof(val))!=sizeof(val) )
+        {
+            WARNING_OUT(mParams.verbose,"Cannot wake up the group reactor");
+        }
+    }
+
+    if( mReactorThread.joinable() )
+    {
+        mReactorThread.join();
+    }
+
+    if( mEpollFd!=-1 )
+    {
+        close(mEpollFd);
+        mEpollFd = -1;
+    }
+    if( mEventFd!=-1 )
+    {
+        close(mEventFd);
+        mEventFd = -1;
+    }
+
+    // ----> Release the queued frames
+    const std::lock_guard<std::mutex> lock(mQueueMutex);
+    for( const auto& item : mQueue )
+        mFreeBuffers[item.cam].push_back(item.buf);
+    mQueue.clear();
+    if( mHeld.cam!=-1 )
+        mFreeBuffers[mHeld.cam].push_back(mHeld.buf);
+    mHeld = {-1,-1};
+    // <---- Release the queued frames
+}
+
+void CameraGroup::reactorThreadFunc()
+{
+    struct epoll_event events[GROUP_MAX_EVENTS];
+
+    TRACE_THREAD_NAME("zed_oc camera group");
+
+    while( !mStopReactor )
+    {
+        int n = epoll_wait(mEpollFd, events, GROUP_MAX_EVENTS, 100);
+
+        for( int i=0; i<n; i++ )
+        {
+            uint32_t cam = events[i].data.u32;
+            if( cam==GROUP_STOP_EVENT )
+                continue;
+
+            if( events[i].events & (EPOLLERR|EPOLLHUP) )
+            {
+                // The device is not streaming anymore (e.g. disconnected): stop polling it
+                std::string msg = std::string("Camera #") + std::to_string(cam) + " not available";
+                WARNING_OUT(mParams.verbose,msg);
+                epoll_ctl(mEpollFd, EPOLL_CTL_DEL, mCameras[cam]->mFileDesc, nullptr);
+                continue;
+            }
+
+            // Process all the buffers ready for this camera
+            while( !mStopReactor && grabCamera(cam) ) {}
+        }
+    }
+}
+
+int CameraGroup::acquireBuffer( size_t cam )
+{
+    const std::lock_guard<std::mutex> lock(mQueueMutex);
+
+    if( !mFreeBuffers[cam].empty() )
+    {
+        int buf = mFreeBuffers[cam].back();
+        mFreeBuffers[cam].pop_back();
+        return buf;
+    }
+
+    // The consumer is too slow: drop the oldest queued frame of this camera
+    for( auto it=mQueue.begin(); it!=mQueue.end(); ++it )
+    {
+        if( it->cam==static_cast<int>(cam) )
+        {
+            int buf = it->buf;
+            mQueue.erase(it);
+            mDropped[cam]++;
+            return buf;
+        }
+    }
+
+    return -1;
+}
+
+bool CameraGroup::grabCamera( size_t cam )
+{
+    int buf = acquireBuffer(cam);
+    if( buf==-1 )
+    {
+        return false;
+    }
+
+    bool ok = mCameras[cam]->grabFrame(&mBuffers[cam][buf]);
+
+    const std::lock_guard<std::mutex> lock(mQueueMutex);
+    if( ok )
+    {
+        mQueue.push_back({static_cast<int>(cam),buf});
+        mQueueCond.notify_one();
+    }
+    else
+    {
+        mFreeBuffers[cam].push_back(buf);
+    }
+
+    return ok;
+}
+
+bool CameraGroup::getNextFrame( GroupFrame& frame, uint64_t timeout_msec )
+{
+    std::unique_lock<std::mutex> lock(mQueueMutex);
+
+    // The previous frame is not used anymore by the consumer
+    if( mHeld.cam!=-1 )
+    {
+        mFreeBuffers[mHeld.cam].push_back(mHeld.buf);
+        mHeld = {-1,-1};
+    }
+
+    if( !mQueueCond.wait_for(lock, std::chrono::milliseconds(timeout_msec), [this]{return !mQueue.empty();}) )
+    {
+        return false;
+    }
+
+    mHeld = mQueue.front();
+    mQueue.pop_front();
+
+    frame.camera = mHeld.cam;
+    frame.serial_number = mCameras[mHeld.cam]->mSerialNumber;
+    frame.frame = mBuffers[mHeld.cam][mHeld.buf];
+
+    return true;
+}
+
+VideoCapture* CameraGroup::getCamera( size_t idx )
+{
+    if( idx>=mCameras.size() )
+        return nullptr;
+    return mCameras[idx];
+}
+
+uint64_t CameraGroup::getDroppedCount( size_t idx )
+{
+    const std::lock_guard<std::mutex> lock(mQueueMutex);
+    if( idx>=mDropped.size() )
+        return 0;
+    return mDropped[idx];
+}
+
+}
+
+}
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "camerasettings.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+namespace sl_oc {
+
+namespace video {
+
+static const char* SIDE_NAME[2] = {"left","right"};
+
+bool CameraSettings::save(const std::string& filename) const
+{
+    std::string tmp = filename + ".tmp";
+
+    std::ofstream file(tmp, std::ios::trunc);
+    if(!file.is_open())
+        return false;
+
+    file << "# ZED Open Capture camera settings" << std::endl;
+    file << "serial_number=" << serial_number << std::endl;
+
+    // Only the controls part of the settings are written
+    auto writeValue = [&file](const std::string& key, int value) {
+        if(value>=0)
+            file << key << "=" << value << std::endl;
+    };
+
+    writeValue("brightness", brightness);
+    writeValue("contrast", contrast);
+    writeValue("hue", hue);
+    writeValue("saturation", saturation);
+    writeValue("sharpness", sharpness);
+    writeValue("gamma", gamma);
+    writeValue("auto_white_balance", auto_white_balance);
+    writeValue("white_balance", white_balance);
+    writeValue("aec_agc", aec_agc);
+
+    for(int s=0; s<2; s++)
+    {
+        if(roi[s].w>0)
+            file << "roi_" << SIDE_NAME[s] << "=" << roi[s].x << "," << roi[s].y << ","
+                 << roi[s].w << "," << roi[s].h << std::endl;
+        writeValue(std::string("gain_")+SIDE_NAME[s], gain[s]);
+        writeValue(std::string("exposure_")+SIDE_NAME[s], exposure[s]);
+    }
+
+    file.close();
+
+    if(file.fail() || rename(tmp.c_str(), filename.c_str())!=0)
+    {
+        remove(tmp.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool CameraSettings::load(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if(!file.is_open())
+        return false;
+
+    CameraSettings loaded;
+
+    std::string line;
+    while(std::getline(file, line))
+    {
+        if(line.empty() || line[0]=='#')
+            continue;
+
+        size_t sep = line.find('=');
+        if(sep==std::string::npos)
+            return false;
+
+        std::string key = line.substr(0,sep);
+        std::string value = line.substr(sep+1);
+
+        if(key.compare(0,4,"roi_")==0)
+        {
+            unsigned int x,y,w,h;
+            if(sscanf(value.c_str(), "%u,%u,%u,%u", &x, &y, &w, &h)!=4)
+                return false;
+
+            for(int s=0; s<2; s++)
+            {
+                if(key.compare(4,std::string::npos,SIDE_NAME[s])==0)
+                {
+                    loaded.roi[s].x = static_cast<uint16_t>(x);
+                    loaded.roi[s].y = static_cast<uint16_t>(y);
+                    loaded.roi[s].w = static_cast<uint16_t>(w);
+                    loaded.roi[s].h = static_cast<uint16_t>(h);
+                }
+            }
+            continue;
+        }
+
+        std::istringstream iss(value);
+        int val;
+        if(!(iss >> val))
+            return false;
+
+        if(key=="serial_number") loaded.serial_number = val;
+        else if(key=="brightness") loaded.brightness = val;
+        else if(key=="contrast") loaded.contrast = val;
+        else if(key=="hue") loaded.hue = val;
+        else if(key=="saturation") loaded.saturation = val;
+        else if(key=="sharpness") loaded.sharpness = val;
+        else if(key=="gamma") loaded.gamma = val;
+        else if(key=="auto_white_balance") loaded.auto_white_balance = val;
+        else if(key=="white_balance") loaded.white_balance = val;
+        else if(key=="aec_agc") loaded.aec_agc = val;
+        else if(key=="gain_left") loaded.gain[0] = val;
+        else if(key=="gain_right") loaded.gain[1] = val;
+        else if(key=="exposure_left") loaded.exposure[0] = val;
+        else if(key=="exposure_right") loaded.exposure[1] = val;
+        // Unknown keys are ignored, for compatibility with the files written by newer versions
+    }
+
+    *this = loaded;
+    return true;
+}
+
+std::string CameraSettings::getDefaultFilename(int serial_number)
+{
+    return std::string("SN") + std::to_string(serial_number) + "_settings.conf";
+}
+
+}
+
+}
@@ -0,0 +1,259 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "clocksync.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace sl_oc {
+
+static const uint64_t CLOCK_SYNC_REBASE_PERIOD = 1000000000ULL; //!< Device time [nsec] after which the reference pair is moved
+static const double CLOCK_SYNC_MIN_REJECT = 50000.0;            //!< Minimum delay [nsec] to reject a late sample
+
+/*!
+ * \brief Linear model of a device clock.
+ *
+ * To keep the precision of the sums, the samples are expressed relative to a reference pair moved forward
+ * periodically: `x = device-dev_ref` and `y = (host-host_ref)-x`, so only the offset and the skew are fitted.
+ */
+struct ClockSync::Model
+{
+    std::string name;
+    bool init=false;
+    uint64_t dev_ref=0, host_ref=0;     // Reference pair
+    uint64_t last_dev=0;                // Last accepted device timestamp
+
+    // Weighted sums
+    double w=0.0, sx=0.0, sy=0.0, sxx=0.0, sxy=0.0;
+    double res_var=0.0;                 // Weighted variance of the residuals
+
+    // Fitted model: y = a + s*x
+    double a=0.0, s=0.0;
+    bool ready=false;
+    uint64_t count=0;                   // Samples since the last reset
+    double span=0.0;                    // Device time covered since the last reset
+
+    uint64_t samples=0, rejected=0, resets=0;
+
+    void reset(uint64_t device_ts, uint64_t host_ts)
+    {
+        dev_ref = device_ts;
+        host_ref = host_ts;
+        last_dev = device_ts;
+        w = sx = sy = sxx = sxy = 0.0;
+        res_var = 0.0;
+        a = s = 0.0;
+        ready = false;
+        count = 0;
+        span = 0.0;
+        init = true;
+    }
+
+    // Move the reference forward by `d` device nanoseconds. `y` does not change
+    void rebase(uint64_t d)
+    {
+        double dd = static_cast<double>(d);
+        sxx += -2.0*dd*sx + dd*dd*w;
+        sxy -= dd*sy;
+        sx -= dd*w;
+        a += s*dd;
+        dev_ref += d;
+        host_ref += d;
+    }
+
+    inline double predict(double x) const {return a + s*x;}
+
+    bool add(uint64_t device_ts, uint64_t host_ts)
+    {
+        if( !init || device_ts<last_dev )
+        {
+            if(init) resets++;
+            reset(device_ts, host_ts);
+        }
+
+        if( device_ts-dev_ref > CLOCK_SYNC_REBASE_PERIOD )
+            rebase(device_ts-dev_ref);
+
+        double x = static_cast<double>(static_cast<int64_t>(device_ts-dev_ref));
+        double y = static_cast<double>(static_cast<int64_t>(host_ts-host_ref)) - x;
+
+        // ----> Outliers
+        if( count>0 )
+        {
+            double r = y - predict(x);
+            if( std::fabs(r) > static_cast<double>(CLOCK_SYNC_RESET_THRES) )
+            {
+                // Discontinuity of the device clock
+                resets++;
+                reset(device_ts, host_ts);
+                x = 0.0;
+                y = 0.0;
+            }
+            else if( ready && r > std::max(CLOCK_SYNC_REJECT_SIGMA*std::sqrt(res_var),CLOCK_SYNC_MIN_REJECT) )
+            {
+                // Sample received late
+                rejected++;
+                return false;
+            }
+            else
+            {
+                res_var += (r*r-res_var)/std::min<double>(count,CLOCK_SYNC_MIN_SAMPLES);
+            }
+        }
+        // <---- Outliers
+
+        // ----> Exponential forgetting, in device time
+        double dt = static_cast<double>(device_ts-last_dev);
+        double f = std::exp(-dt/CLOCK_SYNC_TIME_CONST);
+        w *= f; sx *= f; sy *= f; sxx *= f; sxy *= f;
+        // <---- Exponential forgetting, in device time
+
+        w += 1.0;
+        sx += x;
+        sy += y;
+        sxx += x*x;
+        sxy += x*y;
+
+        span += dt;
+        last_dev = device_ts;
+        count++;
+        samples++;
+
+        // ----> Fit
+        double det = w*sxx - sx*sx;
+        if( det > 0.0 && count>=2 )
+        {
+            s = (w*sxy - sx*sy)/det;
+            a = (sy - s*sx)/w;
+        }
+        else
+        {
+            s = 0.0;
+            a = sy/w;
+        }
+
+        if( std::fabs(s) > CLOCK_SYNC_MAX_SKEW )
+        {
+            // Not a drift: keep the offset only until enough samples are collected
+            s = 0.0;
+            a = sy/w;
+            ready = false;
+        }
+        else
+        {
+            ready = count>=CLOCK_SYNC_MIN_SAMPLES && span>=CLOCK_SYNC_MIN_SPAN;
+        }
+        // <---- Fit
+
+        return true;
+    }
+
+    uint64_t toHost(uint64_t device_ts) const
+    {
+        double x = static_cast<double>(static_cast<int64_t>(device_ts-dev_ref));
+        int64_t corr = static_cast<int64_t>(std::llround(predict(x)));
+        return host_ref + (device_ts-dev_ref) + static_cast<uint64_t>(corr);
+    }
+};
+
+ClockSync::~ClockSync()
+{
+}
+
+ClockSync& ClockSync::getInstance()
+{
+    static ClockSync instance;
+    return instance;
+}
+
+int ClockSync::registerClock(const std::string& name)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    int id = mNextId++;
+    mModels[id].reset(new Model);
+    mModels[id]->name = name;
+
+    return id;
+}
+
+void ClockSync::unregisterClock(int id)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    mModels.erase(id);
+}
+
+bool ClockSync::addSample(int id, uint64_t device_ts, uint64_t host_ts)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mModels.find(id);
+    if( it==mModels.end() )
+        return false;
+
+    return it->second->add(device_ts, host_ts);
+}
+
+bool ClockSync::toHost(int id, uint64_t device_ts, uint64_t& host_ts)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mModels.find(id);
+    if( it==mModels.end() || !it->second->ready )
+        return false;
+
+    host_ts = it->second->toHost(device_ts);
+    return true;
+}
+
+bool ClockSync::getStatus(int id, ClockSyncStatus& status)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mModels.find(id);
+    if( it==mModels.end() )
+        return false;
+
+    const Model& m = *it->second;
+    status.name = m.name;
+    status.ready = m.ready;
+    status.samples = m.samples;
+    status.rejected = m.rejected;
+    status.resets = m.resets;
+    status.skew_ppm = m.s*1e6;
+    status.offset = m.init?static_cast<int64_t>(m.toHost(m.last_dev)-m.last_dev):0;
+    status.error = CLOCK_SYNC_REJECT_SIGMA*std::sqrt(m.res_var);
+
+    return true;
+}
+
+std::vector<int> ClockSync::getClockIds()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    std::vector<int> ids;
+    for( auto& m : mModels )
+        ids.push_back(m.first);
+
+    return ids;
+}
+
+}
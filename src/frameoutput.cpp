@@ -0,0 +1,291 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "frameoutput.hpp"
+#include "videocapture.hpp"
+
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sl_oc {
+
+namespace video {
+
+static inline uint8_t clampPixel(int val)
+{
+    return static_cast<uint8_t>(val<0?0:(val>255?255:val));
+}
+
+bool FrameOutput::configure(const OutputParams& params, int width, int height)
+{
+    if(width<4 || height<1)
+        return false;
+    if(params.decimation!=1 && params.decimation!=2 && params.decimation!=4)
+        return false;
+
+    int channels;
+    switch(params.format)
+    {
+    case OUTPUT_FORMAT::YUYV: channels = 2; break;
+    case OUTPUT_FORMAT::GRAY: channels = 1; break;
+    case OUTPUT_FORMAT::BGR: channels = 3; break;
+    default: return false;
+    }
+
+    float x0 = std::max(0.0f, params.crop_x);
+    float y0 = std::max(0.0f, params.crop_y);
+    float x1 = std::min(1.0f, params.crop_x+params.crop_width);
+    float y1 = std::min(1.0f, params.crop_y+params.crop_height);
+
+    const int dec = params.decimation;
+
+    // The chroma is shared by the two pixels of a YUYV macro pixel: the left border must be even and each output
+    // macro pixel must cover an integer number of source macro pixels
+    int px0 = static_cast<int>(std::floor(x0*width)) & ~1;
+    int px1 = std::min(width, static_cast<int>(std::ceil(x1*width)));
+    int py0 = static_cast<int>(std::floor(y0*height));
+    int py1 = std::min(height, static_cast<int>(std::ceil(y1*height)));
+
+    int out_w = ((px1-px0)/(2*dec))*2;
+    int out_h = (py1-py0)/dec;
+    if(out_w<=0 || out_h<=0)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mParams = params;
+    mSrcWidth = width;
+    mSrcHeight = height;
+    mX0 = px0;
+    mY0 = py0;
+    mOutWidth = out_w;
+    mOutHeight = out_h;
+    mChannels = channels;
+    mShift = (dec==1)?0:((dec==2)?2:4);
+    mSums.resize(out_w*dec*2);
+    mLastTs = 0;
+
+    for(Buffer& buf : mBuffers)
+    {
+        buf.data.assign(static_cast<size_t>(out_w)*out_h*channels, 0);
+        buf.frame_id = 0;
+        buf.timestamp = 0;
+    }
+    mNewFrame = false;
+
+    return true;
+}
+
+void FrameOutput::sumRows(const uint8_t* src, size_t stride, int rows, size_t bytes, uint16_t* sums)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for(; i+16<=bytes; i+=16)
+    {
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        for(int r=0; r<rows; r++)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+r*stride+i));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums+i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums+i+8), hi);
+    }
+#elif defined(__ARM_NEON)
+    for(; i+16<=bytes; i+=16)
+    {
+        uint16x8_t lo = vdupq_n_u16(0);
+        uint16x8_t hi = vdupq_n_u16(0);
+        for(int r=0; r<rows; r++)
+        {
+            uint8x16_t v = vld1q_u8(src+r*stride+i);
+            lo = vaddw_u8(lo, vget_low_u8(v));
+            hi = vaddw_u8(hi, vget_high_u8(v));
+        }
+        vst1q_u16(sums+i, lo);
+        vst1q_u16(sums+i+8, hi);
+    }
+#endif
+
+    for(; i<bytes; i++)
+    {
+        uint16_t acc = 0;
+        for(int r=0; r<rows; r++)
+            acc += src[r*stride+i];
+        sums[i] = acc;
+    }
+}
+
+void FrameOutput::reduceRow(const uint16_t* sums, uint8_t* dst)
+{
+    // `sums` contains the vertical sums of the YUYV bytes of `decimation*mOutWidth` source pixels:
+    // even indexes are luma, odd indexes are alternatively U and V
+    const int dec = mParams.decimation;
+    const int shift = mShift;
+    const int round = (1<<shift)>>1;
+
+    for(int m=0; m<mOutWidth/2; m++)
+    {
+        // Each output macro pixel covers `dec` source macro pixels
+        const uint16_t* s = sums + m*4*dec;
+
+        int y[2] = {0,0};
+        int u = 0, v = 0;
+        for(int k=0; k<dec; k++)
+        {
+            const uint16_t* mp = s + 4*k;
+            y[(2*k)/dec] += mp[0];
+            y[(2*k+1)/dec] += mp[2];
+            u += mp[1];
+            v += mp[3];
+        }
+
+        y[0] = (y[0]+round)>>shift;
+        y[1] = (y[1]+round)>>shift;
+        u = (u+round)>>shift;
+        v = (v+round)>>shift;
+
+        switch(mParams.format)
+        {
+        case OUTPUT_FORMAT::YUYV:
+            dst[0] = static_cast<uint8_t>(y[0]);
+            dst[1] = static_cast<uint8_t>(u);
+            dst[2] = static_cast<uint8_t>(y[1]);
+            dst[3] = static_cast<uint8_t>(v);
+            dst += 4;
+            break;
+        case OUTPUT_FORMAT::GRAY:
+            dst[0] = static_cast<uint8_t>(y[0]);
+            dst[1] = static_cast<uint8_t>(y[1]);
+            dst += 2;
+            break;
+        case OUTPUT_FORMAT::BGR:
+        {
+            // BT.601, limited range
+            const int d = u-128;
+            const int e = v-128;
+            const int cb = 516*d;
+            const int cg = -100*d - 208*e;
+            const int cr = 409*e;
+            for(int p=0; p<2; p++)
+            {
+                const int c = 298*(y[p]-16) + 128;
+                dst[0] = clampPixel((c+cb)>>8);
+                dst[1] = clampPixel((c+cg)>>8);
+                dst[2] = clampPixel((c+cr)>>8);
+                dst += 3;
+            }
+            break;
+        }
+        }
+    }
+}
+
+bool FrameOutput::process(const Frame& src)
+{
+    if(mOutWidth==0 || !src.data || src.width!=mSrcWidth || src.height!=mSrcHeight)
+        return false;
+
+    if(mParams.max_fps>0.0f && mLastTs!=0)
+    {
+        // 10% of tolerance so that the jitter of the source does not halve the rate when it is close to the limit
+        const uint64_t min_period = static_cast<uint64_t>(0.9e9/mParams.max_fps);
+        if(src.timestamp_mono-mLastTs < min_period)
+            return false;
+    }
+    mLastTs = src.timestamp_mono;
+
+    Buffer& buf = mBuffers[mWriteIdx];
+
+    const int dec = mParams.decimation;
+    const size_t stride = static_cast<size_t>(mSrcWidth)*2;
+    const size_t row_bytes = static_cast<size_t>(mOutWidth)*dec*2;
+    const size_t out_stride = static_cast<size_t>(mOutWidth)*mChannels;
+    const uint8_t* in = src.data + mY0*stride + mX0*2;
+    uint8_t* out = buf.data.data();
+
+    for(int r=0; r<mOutHeight; r++)
+    {
+        if(dec==1 && mParams.format==OUTPUT_FORMAT::YUYV)
+            memcpy(out, in, row_bytes);
+        else if(dec==1 && mParams.format==OUTPUT_FORMAT::GRAY)
+        {
+            for(int x=0; x<mOutWidth; x++)
+                out[x] = in[2*x];
+        }
+        else
+        {
+            sumRows(in, stride, dec, row_bytes, mSums.data());
+            reduceRow(mSums.data(), out);
+        }
+
+        in += dec*stride;
+        out += out_stride;
+    }
+
+    buf.frame_id = src.frame_id;
+    buf.timestamp = src.timestamp;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::swap(mWriteIdx, mReadyIdx);
+        mNewFrame = true;
+    }
+    mCond.notify_all();
+
+    return true;
+}
+
+bool FrameOutput::getFrame(OutputFrame& frame, uint64_t timeout_msec)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if(!mCond.wait_for(lock, std::chrono::milliseconds(timeout_msec), [this]{return mNewFrame;}))
+        return false;
+
+    std::swap(mReadIdx, mReadyIdx);
+    mNewFrame = false;
+
+    const Buffer& buf = mBuffers[mReadIdx];
+    frame.frame_id = buf.frame_id;
+    frame.timestamp = buf.timestamp;
+    frame.data = buf.data.data();
+    frame.width = static_cast<uint16_t>(mOutWidth);
+    frame.height = static_cast<uint16_t>(mOutHeight);
+    frame.channels = static_cast<uint8_t>(mChannels);
+
+    return true;
+}
+
+}
+
+}
@@ -0,0 +1,188 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "framepool.hpp"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <iterator>
+
+namespace sl_oc {
+
+namespace video {
+
+static const int FRAME_POOL_MPOL_PREFERRED = 1;     // MPOL_PREFERRED of <numaif.h>, not required to build
+static const int FRAME_POOL_MAX_NODES = 1024;       // Size of the NUMA node mask
+
+FramePool& FramePool::getInstance()
+{
+    static FramePool instance;
+    return instance;
+}
+
+FramePool::~FramePool()
+{
+    trim();
+
+    // Buffers still used at exit are not unmapped: they can be accessed by the destructors of static objects
+}
+
+bool FramePool::map(Block& block)
+{
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void* addr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if(block.huge_pages)
+    {
+        // Fails if no huge page is reserved (`vm.nr_hugepages`)
+        addr = mmap(nullptr, block.map_size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+        block.hugetlb = (addr!=MAP_FAILED);
+    }
+#endif
+
+    if(addr==MAP_FAILED)
+    {
+        addr = mmap(nullptr, block.map_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if(addr==MAP_FAILED)
+            return false;
+
+#ifdef MADV_HUGEPAGE
+        if(block.huge_pages)
+            madvise(addr, block.map_size, MADV_HUGEPAGE);
+#endif
+    }
+
+#ifdef SYS_mbind
+    if(block.numa_node>=0 && block.numa_node<FRAME_POOL_MAX_NODES)
+    {
+        // The pages are not touched yet: they are allocated on the node at the first write.
+        // The call fails harmlessly if the kernel has no NUMA support
+        const int bits = 8*sizeof(unsigned long);
+        unsigned long mask[FRAME_POOL_MAX_NODES/bits] = {0};
+        mask[block.numa_node/bits] = 1UL << (block.numa_node%bits);
+        syscall(SYS_mbind, addr, block.map_size, FRAME_POOL_MPOL_PREFERRED, mask, FRAME_POOL_MAX_NODES+1, 0);
+    }
+#endif
+
+    block.data = static_cast<uint8_t*>(addr);
+    return true;
+}
+
+uint8_t* FramePool::acquire(size_t size, bool huge_pages, int numa_node)
+{
+    if(size==0)
+        return nullptr;
+
+    const size_t page = huge_pages?FRAME_POOL_HUGE_PAGE:static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    Block block;
+    block.map_size = ((size+page-1)/page)*page;
+    block.huge_pages = huge_pages;
+    block.numa_node = numa_node;
+
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    // The most recently released buffers are the most likely to be still in the caches
+    for(auto it=mFree.rbegin(); it!=mFree.rend(); ++it)
+    {
+        if(it->map_size==block.map_size && it->huge_pages==huge_pages && it->numa_node==numa_node)
+        {
+            block = *it;
+            mFree.erase(std::next(it).base());
+            mStats.cached_bytes -= block.map_size;
+            mStats.reuses++;
+
+            mUsed[block.data] = block;
+            mStats.used_bytes += block.map_size;
+            return block.data;
+        }
+    }
+
+    if(!map(block))
+        return nullptr;
+
+    mStats.allocations++;
+    if(block.hugetlb)
+        mStats.huge_pages++;
+
+    mUsed[block.data] = block;
+    mStats.used_bytes += block.map_size;
+    return block.data;
+}
+
+void FramePool::release(uint8_t* data)
+{
+    if(!data)
+        return;
+
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mUsed.find(data);
+    if(it==mUsed.end())
+        return;
+
+    Block block = it->second;
+    mUsed.erase(it);
+    mStats.used_bytes -= block.map_size;
+
+    mFree.push_back(block);
+    mStats.cached_bytes += block.map_size;
+    evict();
+}
+
+void FramePool::evict()
+{
+    while(!mFree.empty() && mStats.cached_bytes>mMaxCached)
+    {
+        const Block& block = mFree.front();
+        munmap(block.data, block.map_size);
+        mStats.cached_bytes -= block.map_size;
+        mFree.pop_front();
+    }
+}
+
+void FramePool::setMaxCachedBytes(size_t bytes)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    mMaxCached = bytes;
+    evict();
+}
+
+void FramePool::trim()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    for(const Block& block : mFree)
+        munmap(block.data, block.map_size);
+    mFree.clear();
+    mStats.cached_bytes = 0;
+}
+
+FramePoolStats FramePool::getStats()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+}
+
+}
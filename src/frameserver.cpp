@@ -0,0 +1,770 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "frameserver.hpp"
+
+#include <errno.h>            // for errno
+#include <fcntl.h>            // for fcntl, F_ADD_SEALS
+#include <unistd.h>           // for close, ftruncate
+#include <poll.h>             // for poll
+#include <sys/mman.h>         // for memfd_create, mmap, munmap
+#include <sys/socket.h>       // for socket, sendmsg, recvmsg, SCM_RIGHTS
+#include <sys/un.h>           // for sockaddr_un
+#include <sys/epoll.h>        // for epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h>      // for eventfd
+
+#include <algorithm>          // for min
+
+#define SRV_MAX_EVENTS 32
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief A `memfd` frame buffer. The descriptor is closed when the last client queue releases it
+ */
+struct FrameServer::Buffer
+{
+    int fd = -1;                    //!< The memfd descriptor
+    uint8_t* addr = nullptr;        //!< Writable mapping, valid until the buffer is sealed
+    size_t size = 0;                //!< Size of the buffer
+    FrameSrvMsg msg;                //!< Frame information sent with the descriptor
+
+    ~Buffer()
+    {
+        if(addr)
+            munmap(addr, size);
+        if(fd!=-1)
+            ::close(fd);
+    }
+};
+
+/*!
+ * \brief State of a connected client
+ */
+struct FrameServer::Client
+{
+    int fd = -1;                    //!< Connected socket
+    uint64_t min_period = 0;        //!< Minimum time between two frames [nsec]
+    uint64_t last_ts = 0;           //!< Timestamp of the last frame queued
+    uint32_t queue_depth = 2;       //!< Maximum number of queued frames and of frames in flight
+    uint32_t in_flight = 0;         //!< Frames sent but not yet acknowledged by the client
+    uint64_t dropped = 0;           //!< Number of frames dropped for this client
+    bool wait_out = false;          //!< Indicates if the socket is full and we wait for EPOLLOUT
+    std::deque<std::shared_ptr<Buffer>> queue;  //!< Frames waiting to be sent
+};
+
+static inline uint64_t fpsToPeriod(float fps)
+{
+    if(fps<=0.0f)
+        return 0;
+    return static_cast<uint64_t>(1e9/fps);
+}
+
+// ----> FrameServer
+FrameServer::FrameServer(FrameServerParams params)
+{
+    mParams = params;
+}
+
+FrameServer::~FrameServer()
+{
+    stop();
+}
+
+bool FrameServer::start(std::string socket_path, uint16_t width, uint16_t height, uint8_t channels, int serial_number)
+{
+    stop();
+
+    mSocketPath = socket_path;
+    mWidth = width;
+    mHeight = height;
+    mChannels = channels;
+    mDataSize = static_cast<size_t>(width)*height*channels;
+    mSerialNumber = serial_number;
+
+    // ----> Listening socket
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(mSocketPath.size()>=sizeof(addr.sun_path))
+    {
+        ERROR_OUT(mParams.verbose,std::string("Socket path too long: '") + mSocketPath + "'");
+        return false;
+    }
+    strncpy(addr.sun_path, mSocketPath.c_str(), sizeof(addr.sun_path)-1);
+
+    // SOCK_SEQPACKET preserves the message boundaries, so each message carries exactly one frame
+    mListenFd = socket(AF_UNIX, SOCK_SEQPACKET|SOCK_NONBLOCK|SOCK_CLOEXEC, 0);
+    if(mListenFd==-1)
+    {
+        std::string msg = std::string("Cannot create the socket: [")
+                + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+        ERROR_OUT(mParams.verbose,msg);
+        return false;
+    }
+
+    unlink(mSocketPath.c_str()); // Remove a stale socket left by a crashed server
+
+    if(bind(mListenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr))==-1 ||
+            listen(mListenFd, mParams.max_clients)==-1)
+    {
+        std::string msg = std::string("Cannot listen on '") + mSocketPath + "': ["
+                + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+        ERROR_OUT(mParams.verbose,msg);
+        stop();
+        return false;
+    }
+    // <---- Listening socket
+
+    // ----> Reactor
+    mEventFd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if(mEventFd==-1 || mEpollFd==-1)
+    {
+        ERROR_OUT(mParams.verbose,"Cannot create the server reactor");
+        stop();
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = mListenFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mListenFd, &ev);
+    ev.data.fd = mEventFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mEventFd, &ev);
+    // <---- Reactor
+
+    if(!prepareBuffers())
+    {
+        stop();
+        return false;
+    }
+
+    mStopServer = false;
+    mServerThread = std::thread( &FrameServer::serverThreadFunc,this );
+
+    if(mParams.verbose)
+    {
+        std::string msg = std::string("Frame server listening on '") + mSocketPath + "'";
+        INFO_OUT(mParams.verbose,msg);
+    }
+
+    return true;
+}
+
+void FrameServer::stop()
+{
+    mStopServer = true;
+
+    if(mEventFd!=-1)
+    {
+        uint64_t one = 1;
+        ssize_t ret = write(mEventFd, &one, sizeof(one)); // Wake up the server thread
+        (void)ret;
+    }
+
+    if( mServerThread.joinable() )
+    {
+        mServerThread.join();
+    }
+
+    mClientMutex.lock();
+    for(auto& it : mClients)
+        ::close(it.first);
+    mClients.clear();
+    mClientMutex.unlock();
+
+    mBufMutex.lock();
+    mFreeBuffers.clear();
+    mReadyBuffers.clear();
+    mBufMutex.unlock();
+
+    if(mListenFd!=-1)
+    {
+        ::close(mListenFd);
+        mListenFd=-1;
+        unlink(mSocketPath.c_str());
+    }
+    if(mEpollFd!=-1)
+    {
+        ::close(mEpollFd);
+        mEpollFd=-1;
+    }
+    if(mEventFd!=-1)
+    {
+        ::close(mEventFd);
+        mEventFd=-1;
+    }
+}
+
+bool FrameServer::prepareBuffers()
+{
+    mBufMutex.lock();
+    size_t missing = mParams.buffer_pool_size>mFreeBuffers.size()?mParams.buffer_pool_size-mFreeBuffers.size():0;
+    mBufMutex.unlock();
+
+    // The buffers are created out of the lock, the grabbing thread is never blocked by the syscalls
+    for(size_t i=0; i<missing; i++)
+    {
+        std::shared_ptr<Buffer> buf = std::make_shared<Buffer>();
+
+        const size_t buf_size = frameMsgSize(mDataSize, 0);
+
+        buf->fd = memfd_create("zed_oc_frame", MFD_CLOEXEC|MFD_ALLOW_SEALING);
+        if(buf->fd==-1 || ftruncate(buf->fd, buf_size)==-1)
+        {
+            std::string msg = std::string("Cannot create a frame buffer: [")
+                    + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+            ERROR_OUT(mParams.verbose,msg);
+            return false;
+        }
+
+        void* addr = mmap(nullptr, buf_size, PROT_READ|PROT_WRITE, MAP_SHARED, buf->fd, 0);
+        if(addr==MAP_FAILED)
+        {
+            ERROR_OUT(mParams.verbose,"Cannot map a frame buffer");
+            return false;
+        }
+        buf->addr = static_cast<uint8_t*>(addr);
+        buf->size = buf_size;
+
+        const std::lock_guard<std::mutex> lock(mBufMutex);
+        mFreeBuffers.push_back(buf);
+    }
+
+    return true;
+}
+
+bool FrameServer::pushFrame(const uint8_t* data, size_t size, uint64_t frame_id, uint64_t timestamp)
+{
+    std::shared_ptr<Buffer> buf;
+
+    mBufMutex.lock();
+    if(mFreeBuffers.empty())
+    {
+        mDropped++;
+        mBufMutex.unlock();
+        return false;
+    }
+    buf = mFreeBuffers.front();
+    mFreeBuffers.pop_front();
+    mBufMutex.unlock();
+
+    size_t copy_size = size<mDataSize?size:mDataSize;
+
+    FrameMsgBuilder builder(buf->addr, buf->size);
+    builder.begin(frame_id, timestamp, mWidth, mHeight, mChannels, mSerialNumber);
+    builder.setFrame(data, copy_size);
+    size_t msg_size = builder.finish();
+
+    buf->msg.magic = FRAME_SRV_MAGIC;
+    buf->msg.version = FRAME_SRV_VERSION;
+    buf->msg.frame_id = frame_id;
+    buf->msg.timestamp = timestamp;
+    buf->msg.data_size = static_cast<uint32_t>(msg_size);
+    buf->msg.width = mWidth;
+    buf->msg.height = mHeight;
+    buf->msg.channels = mChannels;
+
+    mBufMutex.lock();
+    bool wake = mReadyBuffers.empty();
+    mReadyBuffers.push_back(buf);
+    mBufMutex.unlock();
+
+    // The server thread reads the event before taking the ready frames: it needs to be woken up only when the
+    // queue was empty. The write is not blocking: the eventfd counter cannot overflow
+    if(wake)
+    {
+        uint64_t one = 1;
+        ssize_t ret = write(mEventFd, &one, sizeof(one));
+        (void)ret;
+    }
+
+    return true;
+}
+
+size_t FrameServer::getClientCount()
+{
+    const std::lock_guard<std::mutex> lock(mClientMutex);
+    return mClients.size();
+}
+
+void FrameServer::serverThreadFunc()
+{
+    struct epoll_event events[SRV_MAX_EVENTS];
+
+    while(!mStopServer)
+    {
+        int n = epoll_wait(mEpollFd, events, SRV_MAX_EVENTS, 500);
+
+        for(int i=0; i<n && !mStopServer; i++)
+        {
+            int fd = events[i].data.fd;
+
+            if(fd==mListenFd)
+            {
+                acceptClient();
+            }
+            else if(fd==mEventFd)
+            {
+                uint64_t val;
+                ssize_t ret = read(mEventFd, &val, sizeof(val));
+                (void)ret;
+
+                dispatchReadyFrames();
+                prepareBuffers();
+            }
+            else
+            {
+                std::shared_ptr<Client> client;
+                mClientMutex.lock();
+                auto it = mClients.find(fd);
+                if(it!=mClients.end())
+                    client = it->second;
+                mClientMutex.unlock();
+
+                if(!client)
+                    continue;
+
+                if(events[i].events & (EPOLLHUP|EPOLLERR))
+                {
+                    removeClient(fd);
+                    continue;
+                }
+
+                if((events[i].events & EPOLLIN) && !readClientRequest(*client))
+                {
+                    removeClient(fd);
+                    continue;
+                }
+
+                if(events[i].events & EPOLLOUT)
+                {
+                    if(!flushClient(*client))
+                        removeClient(fd);
+                }
+            }
+        }
+    }
+}
+
+void FrameServer::acceptClient()
+{
+    int fd = accept4(mListenFd, nullptr, nullptr, SOCK_NONBLOCK|SOCK_CLOEXEC);
+    if(fd==-1)
+        return;
+
+    const std::lock_guard<std::mutex> lock(mClientMutex);
+
+    if(static_cast<int>(mClients.size())>=mParams.max_clients)
+    {
+        WARNING_OUT(mParams.verbose,"Maximum number of clients reached. Connection refused");
+        ::close(fd);
+        return;
+    }
+
+    std::shared_ptr<Client> client = std::make_shared<Client>();
+    client->fd = fd;
+    client->min_period = fpsToPeriod(mParams.default_max_fps);
+    client->queue_depth = mParams.default_queue_depth;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev);
+
+    mClients[fd] = client;
+
+    if(mParams.verbose)
+    {
+        std::string msg = std::string("New client connected. Clients: ") + std::to_string(mClients.size());
+        INFO_OUT(mParams.verbose,msg);
+    }
+}
+
+bool FrameServer::readClientRequest(Client& client)
+{
+    union
+    {
+        FrameSrvRequest req;
+        FrameSrvAck ack;
+    } in;
+    ssize_t len = recv(client.fd, &in, sizeof(in), MSG_DONTWAIT);
+
+    if(len==0)
+        return false; // Orderly shutdown of the client
+
+    // The messages are told apart by their size: SOCK_SEQPACKET preserves the boundaries
+    if(len==sizeof(FrameSrvAck) && in.ack.magic==FRAME_SRV_MAGIC && in.ack.version==FRAME_SRV_VERSION)
+    {
+        client.in_flight -= std::min(client.in_flight, in.ack.count);
+
+        // Room for the queued frames
+        if(!client.wait_out)
+            return flushClient(client);
+        return true;
+    }
+
+    if(len!=sizeof(FrameSrvRequest) || in.req.magic!=FRAME_SRV_MAGIC || in.req.version!=FRAME_SRV_VERSION)
+        return true;
+
+    client.min_period = fpsToPeriod(in.req.max_fps);
+    if(in.req.queue_depth>0)
+        client.queue_depth = in.req.queue_depth;
+
+    return true;
+}
+
+void FrameServer::dispatchReadyFrames()
+{
+    std::deque<std::shared_ptr<Buffer>> ready;
+
+    mBufMutex.lock();
+    ready.swap(mReadyBuffers);
+    mBufMutex.unlock();
+
+    for(auto& buf : ready)
+    {
+        // ----> Make the buffer immutable before sharing it
+        munmap(buf->addr, buf->size);
+        buf->addr = nullptr;
+        if(fcntl(buf->fd, F_ADD_SEALS, F_SEAL_SHRINK|F_SEAL_GROW|F_SEAL_WRITE|F_SEAL_SEAL)==-1)
+        {
+            WARNING_OUT(mParams.verbose,"Cannot seal the frame buffer");
+        }
+        // <---- Make the buffer immutable before sharing it
+
+        const std::lock_guard<std::mutex> lock(mClientMutex);
+        for(auto& it : mClients)
+        {
+            Client& client = *(it.second);
+
+            // ----> Rate limiting
+            // 10% of tolerance to absorb the jitter of the frame timestamps
+            if(client.last_ts!=0 && client.min_period!=0 &&
+                    buf->msg.timestamp-client.last_ts < client.min_period-client.min_period/10)
+            {
+                continue;
+            }
+            client.last_ts = buf->msg.timestamp;
+            // <---- Rate limiting
+
+            // ----> Drop oldest
+            client.queue.push_back(buf);
+            while(client.queue.size()>client.queue_depth)
+            {
+                client.queue.pop_front();
+                client.dropped++;
+            }
+            // <---- Drop oldest
+        }
+    }
+
+    // ----> Send the frames
+    std::vector<int> failed;
+
+    mClientMutex.lock();
+    for(auto& it : mClients)
+    {
+        if(!it.second->wait_out && !flushClient(*(it.second)))
+            failed.push_back(it.first);
+    }
+    mClientMutex.unlock();
+
+    for(int fd : failed)
+        removeClient(fd);
+    // <---- Send the frames
+}
+
+bool FrameServer::flushClient(Client& client)
+{
+    // The frames in flight are limited too: the socket would otherwise hold hundreds of them for a client that
+    // does not read, each one pinning a frame buffer
+    while(!client.queue.empty() && client.in_flight<client.queue_depth)
+    {
+        std::shared_ptr<Buffer>& buf = client.queue.front();
+
+        FrameSrvMsg msg = buf->msg;
+        msg.dropped = client.dropped;
+
+        struct iovec iov;
+        iov.iov_base = &msg;
+        iov.iov_len = sizeof(msg);
+
+        char ctrl[CMSG_SPACE(sizeof(int))];
+        memset(ctrl, 0, sizeof(ctrl));
+
+        struct msghdr mh;
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_iov = &iov;
+        mh.msg_iovlen = 1;
+        mh.msg_control = ctrl;
+        mh.msg_controllen = sizeof(ctrl);
+
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&mh);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &buf->fd, sizeof(int));
+
+        ssize_t ret = sendmsg(client.fd, &mh, MSG_DONTWAIT|MSG_NOSIGNAL);
+        if(ret==-1)
+        {
+            if(errno==EAGAIN || errno==EWOULDBLOCK)
+            {
+                // The client is slow: wait for room in the socket, new frames will replace the oldest queued
+                updateClientEvents(client, true);
+                return true;
+            }
+
+            return false;
+        }
+
+        client.queue.pop_front();
+        client.in_flight++;
+    }
+
+    updateClientEvents(client, false);
+    return true;
+}
+
+void FrameServer::updateClientEvents(Client& client, bool wait_out)
+{
+    if(client.wait_out==wait_out)
+        return;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | (wait_out?EPOLLOUT:0);
+    ev.data.fd = client.fd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_MOD, client.fd, &ev);
+
+    client.wait_out = wait_out;
+}
+
+void FrameServer::removeClient(int fd)
+{
+    const std::lock_guard<std::mutex> lock(mClientMutex);
+
+    auto it = mClients.find(fd);
+    if(it==mClients.end())
+        return;
+
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    mClients.erase(it);
+
+    if(mParams.verbose)
+    {
+        std::string msg = std::string("Client disconnected. Clients: ") + std::to_string(mClients.size());
+        INFO_OUT(mParams.verbose,msg);
+    }
+}
+// <---- FrameServer
+
+// ----> FrameClient
+FrameClient::FrameClient(int verbose_lvl)
+{
+    mVerbose = verbose_lvl;
+}
+
+FrameClient::~FrameClient()
+{
+    disconnect();
+}
+
+bool FrameClient::connect(std::string socket_path, float max_fps, uint32_t queue_depth)
+{
+    disconnect();
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(socket_path.size()>=sizeof(addr.sun_path))
+    {
+        ERROR_OUT(mVerbose,std::string("Socket path too long: '") + socket_path + "'");
+        return false;
+    }
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path)-1);
+
+    mSocket = socket(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC, 0);
+    if(mSocket==-1 || ::connect(mSocket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr))==-1)
+    {
+        if(mVerbose)
+        {
+            std::string msg = std::string("Cannot connect to '") + socket_path + "': ["
+                    + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+            ERROR_OUT(mVerbose,msg);
+        }
+        disconnect();
+        return false;
+    }
+
+    FrameSrvRequest req;
+    req.magic = FRAME_SRV_MAGIC;
+    req.version = FRAME_SRV_VERSION;
+    req.max_fps = max_fps;
+    req.queue_depth = queue_depth;
+    if(send(mSocket, &req, sizeof(req), MSG_NOSIGNAL)!=sizeof(req))
+    {
+        ERROR_OUT(mVerbose,"Cannot send the stream request to the server");
+        disconnect();
+        return false;
+    }
+
+    mUnacked = 0;
+
+    return true;
+}
+
+void FrameClient::sendAck()
+{
+    if(mSocket==-1 || mUnacked==0)
+        return;
+
+    FrameSrvAck ack;
+    ack.magic = FRAME_SRV_MAGIC;
+    ack.version = FRAME_SRV_VERSION;
+    ack.count = mUnacked;
+
+    // Retried at the next call if the socket is full: the server stops sending when all its frames are in flight
+    if(send(mSocket, &ack, sizeof(ack), MSG_DONTWAIT|MSG_NOSIGNAL)==sizeof(ack))
+        mUnacked = 0;
+}
+
+void FrameClient::disconnect()
+{
+    releaseFrame();
+
+    if(mSocket!=-1)
+    {
+        ::close(mSocket);
+        mSocket=-1;
+    }
+}
+
+void FrameClient::releaseFrame()
+{
+    if(mMapAddr)
+    {
+        munmap(mMapAddr, mMapSize);
+        mMapAddr = nullptr;
+        mMapSize = 0;
+    }
+}
+
+bool FrameClient::getNextFrame(ClientFrame& frame, uint64_t timeout_msec)
+{
+    if(mSocket==-1)
+        return false;
+
+    sendAck();
+
+    struct pollfd pfd;
+    pfd.fd = mSocket;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if(poll(&pfd, 1, static_cast<int>(timeout_msec))<=0)
+        return false;
+
+    FrameSrvMsg msg;
+    struct iovec iov;
+    iov.iov_base = &msg;
+    iov.iov_len = sizeof(msg);
+
+    char ctrl[CMSG_SPACE(sizeof(int))];
+    memset(ctrl, 0, sizeof(ctrl));
+
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = ctrl;
+    mh.msg_controllen = sizeof(ctrl);
+
+    ssize_t len = recvmsg(mSocket, &mh, MSG_CMSG_CLOEXEC);
+    if(len<=0)
+    {
+        if(len==0)
+        {
+            WARNING_OUT(mVerbose,"Connection closed by the server");
+            disconnect();
+        }
+        return false;
+    }
+
+    // The message is out of the socket: the server can send the next one
+    mUnacked++;
+    sendAck();
+
+    int fd = -1;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&mh);
+    if(cmsg && cmsg->cmsg_level==SOL_SOCKET && cmsg->cmsg_type==SCM_RIGHTS)
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+
+    if(fd==-1)
+        return false;
+
+    if(len!=sizeof(msg) || msg.magic!=FRAME_SRV_MAGIC || msg.version!=FRAME_SRV_VERSION)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    releaseFrame();
+
+    void* addr = mmap(nullptr, msg.data_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the buffer alive
+
+    if(addr==MAP_FAILED)
+        return false;
+
+    mMapAddr = addr;
+    mMapSize = msg.data_size;
+
+    FrameMsgView view;
+    if(!view.parse(addr, msg.data_size) || view.frameData()==nullptr)
+    {
+        WARNING_OUT(mVerbose,"Invalid frame message received");
+        releaseFrame();
+        return false;
+    }
+
+    const FrameMsgHeader* hdr = view.header();
+    frame.frame_id = hdr->frame_id;
+    frame.timestamp = hdr->timestamp;
+    frame.data = view.frameData();
+    frame.width = hdr->width;
+    frame.height = hdr->height;
+    frame.channels = hdr->channels;
+    frame.dropped = msg.dropped;
+    frame.msg = hdr;
+
+    return true;
+}
+// <---- FrameClient
+
+}
+
+}
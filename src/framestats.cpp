@@ -0,0 +1,229 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "framestats.hpp"
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sl_oc {
+
+namespace video {
+
+static const int HIST_SHIFT = 2;    // Luma bits discarded to get the histogram bin
+static_assert((256>>HIST_SHIFT)==FRAME_STATS_HIST_BINS, "The histogram bins must cover the luma range");
+
+bool FrameStatsCalculator::configure(const FrameStatsParams& params, int width, int height, int eye)
+{
+    if(params.rois.size()>static_cast<size_t>(FRAME_STATS_MAX_ROIS) || width<4 || height<1 || eye<-1 || eye>1)
+        return false;
+
+    std::vector<StatsRoi> rois = params.rois;
+    if(rois.empty())
+        rois.push_back(StatsRoi());
+
+    const int eye_w = width/2;
+
+    std::vector<Rect> rects;
+    for(const StatsRoi& roi : rois)
+    {
+        float x0 = std::max(0.0f, roi.x);
+        float y0 = std::max(0.0f, roi.y);
+        float x1 = std::min(1.0f, roi.x+roi.width);
+        float y1 = std::min(1.0f, roi.y+roi.height);
+
+        // The luma values are read by YUYV macro pixel: the horizontal borders must be even
+        Rect r;
+        r.x0 = static_cast<int>(std::floor(x0*eye_w)) & ~1;
+        r.x1 = static_cast<int>(std::ceil(x1*eye_w)) & ~1;
+        r.y0 = static_cast<int>(std::floor(y0*height));
+        r.y1 = static_cast<int>(std::ceil(y1*height));
+        if(r.x1<=r.x0 || r.y1<=r.y0)
+            return false;
+
+        rects.push_back(r);
+    }
+
+    mWidth = width;
+    mHeight = height;
+    mEye = eye;
+    mSatLevel = params.saturation_level;
+    mRects = rects;
+    mAccums.resize(2*mRects.size());
+
+    return true;
+}
+
+void FrameStatsCalculator::copyFrame(uint8_t* dst, const uint8_t* src, size_t size, FrameStats& stats,
+                                     const ToneCurve* curve)
+{
+    const size_t row_bytes = static_cast<size_t>(mWidth)*2;
+    if(mRects.empty() || size<row_bytes*mHeight)
+    {
+        // Not configured for this frame: a single image cannot be extracted from it
+        if(curve && mEye<0)
+            curve->copy(dst, src, size);
+        else if(mEye<0)
+            memcpy(dst, src, size);
+        stats.valid = false;
+        return;
+    }
+
+    for(Accum& acc : mAccums)
+        memset(&acc, 0, sizeof(Accum));
+
+    // Single image: only its half of each row is copied
+    const int eye_w = mWidth/2;
+    const size_t dst_row_bytes = (mEye<0)?row_bytes:row_bytes/2;
+    const size_t src_offset = (mEye==1)?dst_row_bytes:0;
+    const int dst_width = (mEye<0)?mWidth:eye_w;
+
+    for(int row=0; row<mHeight; row++)
+    {
+        uint8_t* line = dst + row*dst_row_bytes;
+        memcpy(line, src + row*row_bytes + src_offset, dst_row_bytes);
+
+        // The row has just been copied: it is read again from the cache
+        for(size_t r=0; r<mRects.size(); r++)
+        {
+            const Rect& rect = mRects[r];
+            if(row<rect.y0 || row>=rect.y1)
+                continue;
+
+            if(mEye<0)
+            {
+                accumulate(line + rect.x0*2, rect.x1-rect.x0, mSatLevel, mAccums[2*r]);
+                accumulate(line + (eye_w+rect.x0)*2, rect.x1-rect.x0, mSatLevel, mAccums[2*r+1]);
+            }
+            else
+                accumulate(line + rect.x0*2, rect.x1-rect.x0, mSatLevel, mAccums[2*r+mEye]);
+        }
+
+        // The statistics describe the sensor output: the curve is applied after them
+        if(curve)
+            curve->apply(line, dst_width);
+    }
+
+    size_t copied = row_bytes*mHeight;
+    if(mEye<0 && size>copied)
+    {
+        if(curve)
+            curve->copy(dst+copied, src+copied, size-copied);
+        else
+            memcpy(dst+copied, src+copied, size-copied);
+    }
+
+    for(size_t r=0; r<mRects.size(); r++)
+    {
+        const Rect& rect = mRects[r];
+        uint32_t pixels = static_cast<uint32_t>((rect.x1-rect.x0)*(rect.y1-rect.y0));
+        finalize(mAccums[2*r], (mEye!=1)?pixels:0, stats.left[r]);
+        finalize(mAccums[2*r+1], (mEye!=0)?pixels:0, stats.right[r]);
+    }
+    stats.roi_count = static_cast<uint8_t>(mRects.size());
+    stats.valid = true;
+}
+
+void FrameStatsCalculator::accumulate(const uint8_t* yuyv, int pixels, uint8_t sat_level, Accum& acc)
+{
+    int i = 0;
+
+    // ----> Sum and saturation count
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i y_mask = _mm_set1_epi16(0x00FF);
+    const __m128i y_one = _mm_set1_epi16(0x0001);
+    const __m128i sat = _mm_set1_epi8(static_cast<char>(sat_level));
+    __m128i sum = zero;
+    __m128i saturated = zero;
+    for(; i+8<=pixels; i+=8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(yuyv+2*i));
+
+        // Y0 U Y1 V ... -> the chroma bytes are zeroed and the luma bytes summed in two 64 bit lanes
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_and_si128(v, y_mask), zero));
+
+        // Unsigned comparison v>=sat, counting 1 for each luma byte
+        __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(v, sat), v);
+        saturated = _mm_add_epi64(saturated, _mm_sad_epu8(_mm_and_si128(ge, y_one), zero));
+    }
+    // A row segment cannot overflow the 32 low bits of the lanes
+    acc.sum += static_cast<uint64_t>(_mm_cvtsi128_si32(sum)) +
+            static_cast<uint64_t>(_mm_cvtsi128_si32(_mm_srli_si128(sum, 8)));
+    acc.saturated += _mm_cvtsi128_si32(saturated) + _mm_cvtsi128_si32(_mm_srli_si128(saturated, 8));
+#elif defined(__ARM_NEON)
+    const uint8x16_t sat = vdupq_n_u8(sat_level);
+    uint32x4_t sum = vdupq_n_u32(0);
+    uint32x4_t saturated = vdupq_n_u32(0);
+    for(; i+16<=pixels; i+=16)
+    {
+        // Y0 U Y1 V ... -> val[0] contains the luma bytes
+        uint8x16x2_t v = vld2q_u8(yuyv+2*i);
+        sum = vpadalq_u16(sum, vpaddlq_u8(v.val[0]));
+        saturated = vpadalq_u16(saturated, vpaddlq_u8(vshrq_n_u8(vcgeq_u8(v.val[0], sat), 7)));
+    }
+    acc.sum += static_cast<uint64_t>(vgetq_lane_u32(sum,0)) + vgetq_lane_u32(sum,1) +
+            vgetq_lane_u32(sum,2) + vgetq_lane_u32(sum,3);
+    acc.saturated += vgetq_lane_u32(saturated,0) + vgetq_lane_u32(saturated,1) +
+            vgetq_lane_u32(saturated,2) + vgetq_lane_u32(saturated,3);
+#endif
+    for(int j=i; j<pixels; j++)
+    {
+        uint8_t y = yuyv[2*j];
+        acc.sum += y;
+        acc.saturated += (y>=sat_level)?1:0;
+    }
+    // <---- Sum and saturation count
+
+    // ----> Histogram
+    // Four partial histograms, so that consecutive equal values do not wait for the previous increment
+    int j = 0;
+    for(; j+4<=pixels; j+=4)
+    {
+        acc.hist[0][yuyv[2*j]>>HIST_SHIFT]++;
+        acc.hist[1][yuyv[2*j+2]>>HIST_SHIFT]++;
+        acc.hist[2][yuyv[2*j+4]>>HIST_SHIFT]++;
+        acc.hist[3][yuyv[2*j+6]>>HIST_SHIFT]++;
+    }
+    for(; j<pixels; j++)
+        acc.hist[0][yuyv[2*j]>>HIST_SHIFT]++;
+    // <---- Histogram
+}
+
+void FrameStatsCalculator::finalize(Accum& acc, uint32_t pixels, LumaStats& stats)
+{
+    for(int b=0; b<FRAME_STATS_HIST_BINS; b++)
+        stats.histogram[b] = acc.hist[0][b] + acc.hist[1][b] + acc.hist[2][b] + acc.hist[3][b];
+
+    stats.pixels = pixels;
+    stats.mean = pixels?static_cast<float>(static_cast<double>(acc.sum)/pixels):0.0f;
+    stats.saturation = pixels?100.0f*acc.saturated/pixels:0.0f;
+}
+
+}
+
+}
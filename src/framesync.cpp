@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "framesync.hpp"
+
+namespace sl_oc {
+
+namespace video {
+
+FrameSynchronizer::FrameSynchronizer( size_t camera_count, uint64_t tolerance_nsec, size_t history )
+{
+    mCamCount = camera_count;
+    mTolerance = tolerance_nsec;
+    mHistory = std::max<size_t>(1,history);
+
+    mSlots.resize(mCamCount, std::vector<Slot>(mHistory));
+    mOut.resize(mCamCount);
+    mMatch.resize(mCamCount, -1);
+    mDropped.resize(mCamCount, 0);
+}
+
+FrameSynchronizer::~FrameSynchronizer()
+{
+    for( auto& slots : mSlots )
+        for( auto& slot : slots )
+            delete [] slot.frame.data;
+
+    for( auto& slot : mOut )
+        delete [] slot.frame.data;
+}
+
+void FrameSynchronizer::copyFrame( Slot& slot, const Frame& frame )
+{
+    size_t size = static_cast<size_t>(frame.width)*frame.height*frame.channels;
+    if( size>slot.size )
+    {
+        delete [] slot.frame.data;
+        slot.frame.data = new uint8_t[size];
+        slot.size = size;
+    }
+
+    uint8_t* data = slot.frame.data;
+    slot.frame = frame;
+    slot.frame.data = data;
+    memcpy(data, frame.data, size);
+    slot.valid = true;
+}
+
+bool FrameSynchronizer::push( size_t camera, const Frame& frame, FrameTuple& tuple )
+{
+    if( camera>=mCamCount || frame.data==nullptr )
+        return false;
+
+    // ----> Store the new frame
+    // in a free slot, or in place of the oldest frame
+    std::vector<Slot>& slots = mSlots[camera];
+    size_t dst = 0;
+    for( size_t s=0; s<mHistory; s++ )
+    {
+        if( !slots[s].valid )
+        {
+            dst = s;
+            break;
+        }
+        if( slots[s].frame.timestamp < slots[dst].frame.timestamp )
+            dst = s;
+    }
+
+    if( slots[dst].valid )
+        mDropped[camera]++;
+
+    copyFrame(slots[dst], frame);
+    // <---- Store the new frame
+
+    // ----> Search the frames of the other cameras
+    // The closest frame of each camera, in a single pass over the histories. With a tolerance lower than half of
+    // the frame period each camera has at most one candidate in `[ts-mTolerance,ts+mTolerance]`
+    const uint64_t ts = frame.timestamp;
+    uint64_t ts_min = ts;
+    uint64_t ts_max = ts;
+    for( size_t c=0; c<mCamCount; c++ )
+    {
+        if( c==camera )
+        {
+            mMatch[c] = static_cast<int>(dst);
+            continue;
+        }
+
+        int best = -1;
+        uint64_t best_diff = 0;
+        for( size_t s=0; s<mHistory; s++ )
+        {
+            const Slot& slot = mSlots[c][s];
+            if( !slot.valid )
+                continue;
+
+            uint64_t diff = (slot.frame.timestamp>ts) ? (slot.frame.timestamp-ts) : (ts-slot.frame.timestamp);
+            if( diff<=mTolerance && (best==-1 || diff<best_diff) )
+            {
+                best = static_cast<int>(s);
+                best_diff = diff;
+            }
+        }
+
+        if( best==-1 )
+            return false;
+
+        mMatch[c] = best;
+        ts_min = std::min(ts_min, mSlots[c][best].frame.timestamp);
+        ts_max = std::max(ts_max, mSlots[c][best].frame.timestamp);
+    }
+
+    // All the frames of a tuple must be within `mTolerance`, not only each one from the new frame
+    if( ts_max-ts_min > mTolerance )
+        return false;
+    // <---- Search the frames of the other cameras
+
+    // ----> Emit the tuple
+    tuple.frames.resize(mCamCount);
+    for( size_t c=0; c<mCamCount; c++ )
+    {
+        Slot& matched = mSlots[c][mMatch[c]];
+
+        // The older frames can no longer be matched
+        for( size_t s=0; s<mHistory; s++ )
+        {
+            Slot& slot = mSlots[c][s];
+            if( slot.valid && static_cast<int>(s)!=mMatch[c] && slot.frame.timestamp<matched.frame.timestamp )
+            {
+                slot.valid = false;
+                mDropped[c]++;
+            }
+        }
+
+        // The matched frame is moved to the output, with no copy
+        std::swap(mOut[c], matched);
+        matched.valid = false;
+        mOut[c].valid = false;
+
+        tuple.frames[c] = mOut[c].frame;
+    }
+
+    tuple.timestamp = ts_max;
+    tuple.skew = ts_max-ts_min;
+
+    mTupleCount++;
+    mMaxSkew = std::max(mMaxSkew, tuple.skew);
+    // <---- Emit the tuple
+
+    return true;
+}
+
+void FrameSynchronizer::clear()
+{
+    for( auto& slots : mSlots )
+        for( auto& slot : slots )
+            slot.valid = false;
+}
+
+uint64_t FrameSynchronizer::getDroppedCount( size_t camera )
+{
+    if( camera>=mCamCount )
+        return 0;
+    return mDropped[camera];
+}
+
+}
+
+}
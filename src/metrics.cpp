@@ -0,0 +1,448 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "metrics.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <fstream>
+
+#include <errno.h>            // for errno
+#include <fcntl.h>            // for O_CREAT, O_RDWR
+#include <unistd.h>           // for close, ftruncate
+#include <sys/mman.h>         // for shm_open, shm_unlink, mmap, munmap
+
+#include <new>                // for placement new
+
+namespace sl_oc {
+
+static inline std::string formatValue(double value)
+{
+    if(std::isinf(value))
+        return value>0?"+Inf":"-Inf";
+    if(std::isnan(value))
+        return "NaN";
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.10g", value);
+    return buf;
+}
+
+static inline std::string sampleName(const std::string& name, const std::string& labels, const std::string& extra="")
+{
+    if(labels.empty() && extra.empty())
+        return name;
+
+    std::string lbl = labels;
+    if(!extra.empty())
+        lbl += (lbl.empty()?"":",") + extra;
+
+    return name + "{" + lbl + "}";
+}
+
+// ----> MetricHistogram
+MetricHistogram::MetricHistogram(const std::vector<double>& bounds)
+    : mBounds(bounds)
+{
+    mBuckets.reset(new std::atomic<uint64_t>[mBounds.size()+1]);
+    for(size_t i=0; i<=mBounds.size(); i++)
+        mBuckets[i].store(0, std::memory_order_relaxed);
+}
+
+void MetricHistogram::observe(double value)
+{
+    size_t idx = 0;
+    while(idx<mBounds.size() && value>mBounds[idx])
+        idx++;
+
+    mBuckets[idx].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t old_bits = mSumBits.load(std::memory_order_relaxed);
+    uint64_t new_bits;
+    do
+    {
+        double sum;
+        memcpy(&sum, &old_bits, sizeof(sum));
+        sum += value;
+        memcpy(&new_bits, &sum, sizeof(new_bits));
+    } while(!mSumBits.compare_exchange_weak(old_bits, new_bits, std::memory_order_relaxed));
+}
+
+double MetricHistogram::getSum() const
+{
+    uint64_t bits = mSumBits.load(std::memory_order_relaxed);
+    double sum;
+    memcpy(&sum, &bits, sizeof(sum));
+    return sum;
+}
+// <---- MetricHistogram
+
+// ----> MetricsRegistry
+struct MetricsRegistry::Metric
+{
+    std::string labels;
+    std::unique_ptr<MetricCounter> counter;
+    std::unique_ptr<MetricGauge> gauge;
+    std::unique_ptr<MetricHistogram> histogram;
+};
+
+struct MetricsRegistry::Family
+{
+    std::string name;
+    std::string help;
+    METRIC_TYPE type;
+    std::vector<std::unique_ptr<Metric>> metrics;
+};
+
+MetricsRegistry::~MetricsRegistry()
+{
+}
+
+MetricsRegistry& MetricsRegistry::getInstance()
+{
+    static MetricsRegistry instance;
+    return instance;
+}
+
+MetricsRegistry::Metric* MetricsRegistry::find(const std::string& name, const std::string& help, METRIC_TYPE type,
+                                               const std::string& labels, const std::vector<double>* bounds)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    Family* family = nullptr;
+    for(auto& f : mFamilies)
+    {
+        if(f->name==name)
+        {
+            family = f.get();
+            break;
+        }
+    }
+
+    if(!family)
+    {
+        mFamilies.emplace_back(new Family);
+        family = mFamilies.back().get();
+        family->name = name;
+        family->help = help;
+        family->type = type;
+    }
+    else if(family->type!=type)
+    {
+        // The same name cannot be used for different metric types
+        return nullptr;
+    }
+
+    for(auto& m : family->metrics)
+    {
+        if(m->labels==labels)
+            return m.get();
+    }
+
+    Metric* m = new Metric;
+    m->labels = labels;
+    switch(type)
+    {
+    case METRIC_TYPE::COUNTER:
+        m->counter.reset(new MetricCounter);
+        break;
+    case METRIC_TYPE::GAUGE:
+        m->gauge.reset(new MetricGauge);
+        break;
+    case METRIC_TYPE::HISTOGRAM:
+        m->histogram.reset(new MetricHistogram(*bounds));
+        break;
+    }
+    family->metrics.emplace_back(m);
+
+    return m;
+}
+
+MetricCounter* MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels)
+{
+    Metric* m = find(name, help, METRIC_TYPE::COUNTER, labels, nullptr);
+    return m?m->counter.get():nullptr;
+}
+
+MetricGauge* MetricsRegistry::gauge(const std::string& name, const std::string& help, const std::string& labels)
+{
+    Metric* m = find(name, help, METRIC_TYPE::GAUGE, labels, nullptr);
+    return m?m->gauge.get():nullptr;
+}
+
+MetricHistogram* MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                            const std::vector<double>& bounds, const std::string& labels)
+{
+    Metric* m = find(name, help, METRIC_TYPE::HISTOGRAM, labels, &bounds);
+    return m?m->histogram.get():nullptr;
+}
+
+std::string MetricsRegistry::toPrometheus()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    std::stringstream ss;
+    for(auto& f : mFamilies)
+    {
+        static const char* type_names[] = {"counter","gauge","histogram"};
+
+        ss << "# HELP " << f->name << " " << f->help << "\n";
+        ss << "# TYPE " << f->name << " " << type_names[static_cast<int>(f->type)] << "\n";
+
+        for(auto& m : f->metrics)
+        {
+            switch(f->type)
+            {
+            case METRIC_TYPE::COUNTER:
+                ss << sampleName(f->name, m->labels) << " " << m->counter->get() << "\n";
+                break;
+            case METRIC_TYPE::GAUGE:
+                ss << sampleName(f->name, m->labels) << " " << formatValue(m->gauge->get()) << "\n";
+                break;
+            case METRIC_TYPE::HISTOGRAM:
+            {
+                const MetricHistogram& h = *m->histogram;
+                uint64_t cumul = 0;
+                for(size_t i=0; i<=h.getBounds().size(); i++)
+                {
+                    cumul += h.getBucketCount(i);
+                    double le = (i<h.getBounds().size())?h.getBounds()[i]:INFINITY;
+                    ss << sampleName(f->name+"_bucket", m->labels, "le=\""+formatValue(le)+"\"") << " " << cumul << "\n";
+                }
+                ss << sampleName(f->name+"_sum", m->labels) << " " << formatValue(h.getSum()) << "\n";
+                ss << sampleName(f->name+"_count", m->labels) << " " << h.getCount() << "\n";
+            }
+                break;
+            }
+        }
+    }
+
+    return ss.str();
+}
+
+void MetricsRegistry::getSamples(std::vector<std::pair<std::string,double>>& samples)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    samples.clear();
+    for(auto& f : mFamilies)
+    {
+        for(auto& m : f->metrics)
+        {
+            switch(f->type)
+            {
+            case METRIC_TYPE::COUNTER:
+                samples.emplace_back(sampleName(f->name, m->labels), static_cast<double>(m->counter->get()));
+                break;
+            case METRIC_TYPE::GAUGE:
+                samples.emplace_back(sampleName(f->name, m->labels), m->gauge->get());
+                break;
+            case METRIC_TYPE::HISTOGRAM:
+            {
+                const MetricHistogram& h = *m->histogram;
+                uint64_t cumul = 0;
+                for(size_t i=0; i<=h.getBounds().size(); i++)
+                {
+                    cumul += h.getBucketCount(i);
+                    double le = (i<h.getBounds().size())?h.getBounds()[i]:INFINITY;
+                    samples.emplace_back(sampleName(f->name+"_bucket", m->labels, "le=\""+formatValue(le)+"\""),
+                                         static_cast<double>(cumul));
+                }
+                samples.emplace_back(sampleName(f->name+"_sum", m->labels), h.getSum());
+                samples.emplace_back(sampleName(f->name+"_count", m->labels), static_cast<double>(h.getCount()));
+            }
+                break;
+            }
+        }
+    }
+}
+// <---- MetricsRegistry
+
+// ----> MetricsExporter
+MetricsExporter::MetricsExporter(MetricsExportParams params)
+{
+    mParams = params;
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::start()
+{
+    stop();
+
+    if(!mParams.shm_name.empty())
+    {
+        mShmName = mParams.shm_name;
+        if(mShmName[0]!='/')
+            mShmName = "/" + mShmName;
+
+        mShmSize = sizeof(MetricsShmHeader) + static_cast<size_t>(mParams.shm_capacity)*sizeof(MetricsShmSample);
+
+        int fd = shm_open(mShmName.c_str(), O_CREAT|O_RDWR, 0644);
+        if(fd==-1 || ftruncate(fd, mShmSize)!=0)
+        {
+            std::string msg = std::string("Cannot create the shared memory page '") + mShmName + "': ["
+                    + std::to_string(errno) + "] " + std::string(strerror(errno));
+            ERROR_OUT(mParams.verbose,msg);
+            if(fd!=-1)
+                ::close(fd);
+            mShmName.clear();
+            return false;
+        }
+
+        void* addr = mmap(nullptr, mShmSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(addr==MAP_FAILED)
+        {
+            std::string msg = std::string("Cannot map the shared memory page '") + mShmName + "': ["
+                    + std::to_string(errno) + "] " + std::string(strerror(errno));
+            ERROR_OUT(mParams.verbose,msg);
+            shm_unlink(mShmName.c_str());
+            mShmName.clear();
+            return false;
+        }
+
+        mShmBase = static_cast<uint8_t*>(addr);
+        MetricsShmHeader* hdr = new (mShmBase) MetricsShmHeader;
+        hdr->magic = METRICS_SHM_MAGIC;
+        hdr->version = METRICS_SHM_VERSION;
+        hdr->capacity = mParams.shm_capacity;
+        hdr->count = 0;
+        hdr->seq.store(0, std::memory_order_release);
+        hdr->timestamp = 0;
+    }
+
+    mStop = false;
+    mThread = std::thread(&MetricsExporter::exportThreadFunc, this);
+
+    return true;
+}
+
+void MetricsExporter::stop()
+{
+    {
+        const std::lock_guard<std::mutex> lock(mStopMutex);
+        mStop = true;
+    }
+    mStopCond.notify_all();
+
+    if(mThread.joinable())
+        mThread.join();
+
+    if(mShmBase)
+    {
+        munmap(mShmBase, mShmSize);
+        shm_unlink(mShmName.c_str());
+        mShmBase = nullptr;
+        mShmSize = 0;
+        mShmName.clear();
+    }
+}
+
+void MetricsExporter::exportThreadFunc()
+{
+    std::unique_lock<std::mutex> lock(mStopMutex);
+    while(!mStop)
+    {
+        lock.unlock();
+        exportNow();
+        lock.lock();
+
+        mStopCond.wait_for(lock, std::chrono::milliseconds(mParams.period_msec), [this]{return mStop;});
+    }
+
+    // Last values
+    lock.unlock();
+    exportNow();
+}
+
+bool MetricsExporter::exportNow()
+{
+    const std::lock_guard<std::mutex> lock(mExportMutex);
+
+    bool ok = true;
+    if(!mParams.text_file.empty())
+        ok = writeTextFile();
+    if(mShmBase)
+        writeShm();
+
+    return ok;
+}
+
+bool MetricsExporter::writeTextFile()
+{
+    std::string tmp = mParams.text_file + ".tmp";
+
+    std::ofstream file(tmp, std::ios::trunc);
+    if(!file.is_open())
+    {
+        std::string msg = std::string("Cannot write '") + tmp + "'";
+        ERROR_OUT(mParams.verbose,msg);
+        return false;
+    }
+
+    file << MetricsRegistry::getInstance().toPrometheus();
+    file.close();
+
+    if(file.fail() || rename(tmp.c_str(), mParams.text_file.c_str())!=0)
+    {
+        std::string msg = std::string("Cannot write '") + mParams.text_file + "'";
+        ERROR_OUT(mParams.verbose,msg);
+        return false;
+    }
+
+    return true;
+}
+
+void MetricsExporter::writeShm()
+{
+    std::vector<std::pair<std::string,double>> samples;
+    MetricsRegistry::getInstance().getSamples(samples);
+
+    MetricsShmHeader* hdr = reinterpret_cast<MetricsShmHeader*>(mShmBase);
+    MetricsShmSample* data = reinterpret_cast<MetricsShmSample*>(mShmBase+sizeof(MetricsShmHeader));
+
+    size_t count = std::min<size_t>(samples.size(), hdr->capacity);
+
+    // ----> Sequence lock
+    uint64_t seq = hdr->seq.load(std::memory_order_relaxed);
+    hdr->seq.store(seq+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for(size_t i=0; i<count; i++)
+    {
+        strncpy(data[i].name, samples[i].first.c_str(), METRICS_SHM_NAME_SIZE-1);
+        data[i].name[METRICS_SHM_NAME_SIZE-1] = '\0';
+        data[i].value = samples[i].second;
+    }
+    hdr->count = static_cast<uint32_t>(count);
+    hdr->timestamp = getWallTimestamp();
+
+    hdr->seq.store(seq+2, std::memory_order_release);
+    // <---- Sequence lock
+}
+// <---- MetricsExporter
+
+}
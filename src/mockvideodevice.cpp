@@ -0,0 +1,892 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "mockvideodevice.hpp"
+#include "hostclock.hpp"
+
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <random>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+#include <errno.h>            // for errno, EAGAIN, EINVAL, ENOENT, ENOTTY
+#include <fcntl.h>            // for O_NONBLOCK
+#include <time.h>             // for clock_nanosleep
+#include <unistd.h>           // for read, write, close
+#include <sys/eventfd.h>      // for eventfd
+#include <sys/mman.h>         // for MAP_FAILED
+#include <sys/sysmacros.h>    // for makedev
+#include <linux/usb/video.h>  // for UVC_GET_CUR, UVC_SET_CUR, UVC_GET_LEN
+#include <linux/uvcvideo.h>   // for uvc_xu_control_query, UVCIOC_CTRL_QUERY
+#include <linux/videodev2.h>  // for v4l2_buffer, v4l2_format, VIDIOC_*
+
+// ----> Emulated camera
+#define MOCK_XU_UNIT_ID         0x04
+#define MOCK_XU_SELECTOR        0x02
+#define MOCK_XU_LEN             384     // USB3 extension unit payload
+#define MOCK_XU_DATA_OFFSET     17      // First byte of the data returned by the extension unit commands
+
+#define MOCK_XU_GPIO_DIR        0x10
+#define MOCK_XU_GPIO_SET        0x12
+#define MOCK_XU_GPIO_GET        0x13
+#define MOCK_XU_FLASH_READ      0xA1
+#define MOCK_XU_SYS_REG         0xA2
+#define MOCK_XU_SENS_REG_LEFT   0xA3
+#define MOCK_XU_SENS_REG_RIGHT  0xA5
+#define MOCK_XU_TASK_SET        0x50
+
+#define MOCK_UNIQUE_ID_START    0x18000
+#define MOCK_ISP_CTRL_LEFT      0x80181033
+#define MOCK_ISP_CTRL_RIGHT     0x80181833
+#define MOCK_AEG_AGC_MASK       0x02
+
+#define MOCK_ADDR_EXP_H         0x3500
+#define MOCK_ADDR_EXP_M         0x3501
+#define MOCK_ADDR_EXP_L         0x3502
+#define MOCK_ADDR_GAIN_M        0x3508
+#define MOCK_ADDR_GAIN_L        0x3509
+
+#define MOCK_EXP_RAW_DEFAULT    500     // Raw exposure giving the nominal brightness of the pattern
+#define MOCK_GAIN_RAW_UNIT      512     // Raw gain doubling the brightness
+
+#define MOCK_MAX_BUFFERS        32
+#define MOCK_BAR_WIDTH          16      // Width of the moving bar in pixels
+// <---- Emulated camera
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief A standard UVC control exposed by the emulated devices
+ */
+struct MockControl
+{
+    uint32_t id;
+    const char* name;
+    int32_t min;
+    int32_t max;
+    int32_t step;
+    int32_t def;
+};
+
+static const MockControl mockControls[] = {
+    {V4L2_CID_BRIGHTNESS, "Brightness", 0, 8, 1, 4},
+    {V4L2_CID_CONTRAST, "Contrast", 0, 8, 1, 4},
+    {V4L2_CID_SATURATION, "Saturation", 0, 8, 1, 4},
+    {V4L2_CID_HUE, "Hue", 0, 11, 1, 0},
+    {V4L2_CID_AUTO_WHITE_BALANCE, "White Balance Temperature, Auto", 0, 1, 1, 1},
+    {V4L2_CID_GAMMA, "Gamma", 1, 9, 1, 8},
+    {V4L2_CID_GAIN, "Gain", 0, 100, 1, 0},
+    {V4L2_CID_WHITE_BALANCE_TEMPERATURE, "White Balance Temperature", 2800, 6500, 100, 4600},
+    {V4L2_CID_SHARPNESS, "Sharpness", 0, 8, 1, 4}
+};
+
+static const MockControl* findControl(uint32_t id)
+{
+    for(const MockControl& ctrl : mockControls)
+    {
+        if(ctrl.id==id)
+            return &ctrl;
+    }
+    return nullptr;
+}
+
+static inline int setErrno(int err)
+{
+    errno = err;
+    return -1;
+}
+
+struct MockVideoDevice::Device
+{
+    int dev_id = 0;                         //!< Device id (i.e. `/dev/video<dev_id>`)
+    int serial_number = 0;                  //!< Serial number stored in the emulated flash
+
+    std::mutex mutex;                       //!< Mutex for safe access to the device state
+    std::map<uint32_t,int32_t> controls;    //!< Values of the standard controls
+    std::map<uint32_t,uint8_t> sys_regs;    //!< ISP registers
+    std::map<uint32_t,uint8_t> sens_regs[2];//!< Left and right sensor registers
+    uint8_t gpio[8] = {0};                  //!< GPIO values (e.g. the status LED)
+    uint8_t xu_resp[MOCK_XU_LEN] = {0};     //!< Response of the last extension unit command
+};
+
+struct MockVideoDevice::Stream
+{
+    int fd = -1;                            //!< `eventfd` returned as file descriptor
+    std::shared_ptr<Device> dev;            //!< Opened device
+
+    std::mutex mutex;                       //!< Mutex for safe access to the buffer queues
+    uint32_t width = 0;                     //!< Frame width in pixels (both images)
+    uint32_t height = 0;                    //!< Frame height in pixels
+    float fps = 15.0f;                      //!< Frame rate requested with `VIDIOC_S_PARM`
+    size_t buf_size = 0;                    //!< Size of each buffer in bytes
+    size_t buf_stride = 0;                  //!< Distance between the `mmap` offsets of two buffers
+    std::vector<std::unique_ptr<uint8_t[]>> buffers; //!< Emulated driver buffers
+    std::deque<uint32_t> queued;            //!< Buffers queued by the application, waiting to be filled
+    std::deque<struct v4l2_buffer> ready;   //!< Filled buffers waiting to be dequeued
+    std::vector<uint8_t> pattern;           //!< Static part of the synthetic frame
+
+    std::atomic<bool> stop{true};           //!< Indicates if the generator thread must be stopped
+    std::thread generator;                  //!< The generator thread
+    std::atomic<uint64_t> generated{0};     //!< Generated frames
+    std::atomic<uint64_t> dropped{0};       //!< Frames dropped because no buffer was queued
+};
+
+MockVideoDevice::MockVideoDevice( MockVideoParams params )
+{
+    mParams = params;
+
+    for(int i=0; i<mParams.device_count; i++)
+    {
+        std::shared_ptr<Device> dev = std::make_shared<Device>();
+        dev->dev_id = mParams.first_dev_id + i;
+        dev->serial_number = mParams.serial_number + i;
+
+        for(const MockControl& ctrl : mockControls)
+            dev->controls[ctrl.id] = ctrl.def;
+
+        dev->sys_regs[MOCK_ISP_CTRL_LEFT] = MOCK_AEG_AGC_MASK;
+        dev->sys_regs[MOCK_ISP_CTRL_RIGHT] = MOCK_AEG_AGC_MASK;
+
+        for(int side=0; side<2; side++)
+        {
+            dev->sens_regs[side][MOCK_ADDR_EXP_H] = (MOCK_EXP_RAW_DEFAULT >> 12) & 0xff;
+            dev->sens_regs[side][MOCK_ADDR_EXP_M] = (MOCK_EXP_RAW_DEFAULT >> 4) & 0xff;
+            dev->sens_regs[side][MOCK_ADDR_EXP_L] = (MOCK_EXP_RAW_DEFAULT << 4) & 0xf0;
+        }
+
+        mDevices.push_back(dev);
+    }
+}
+
+MockVideoDevice::~MockVideoDevice()
+{
+    std::vector<int> fds;
+    {
+        const std::lock_guard<std::mutex> lock(mStreamMutex);
+        for(auto& it : mStreams)
+            fds.push_back(it.first);
+    }
+
+    for(int fd : fds)
+        close(fd);
+}
+
+int MockVideoDevice::getDeviceIndex(const char* path)
+{
+    std::string name = path?path:"";
+    const std::string prefix = "/dev/video";
+
+    if(name.compare(0, prefix.size(), prefix)!=0 || name.size()==prefix.size())
+        return -1;
+
+    int id = 0;
+    for(size_t i=prefix.size(); i<name.size(); i++)
+    {
+        if(name[i]<'0' || name[i]>'9')
+            return -1;
+        id = id*10 + (name[i]-'0');
+    }
+
+    int idx = id - mParams.first_dev_id;
+    if(idx<0 || idx>=static_cast<int>(mDevices.size()))
+        return -1;
+
+    return idx;
+}
+
+std::shared_ptr<MockVideoDevice::Stream> MockVideoDevice::getStream(int fd)
+{
+    const std::lock_guard<std::mutex> lock(mStreamMutex);
+    auto it = mStreams.find(fd);
+    if(it==mStreams.end())
+        return nullptr;
+    return it->second;
+}
+
+bool MockVideoDevice::readModalias(const std::string& dev_name, std::string& modalias)
+{
+    if(getDeviceIndex(dev_name.c_str())<0)
+        return false;
+
+    uint16_t pid = 0;
+    switch(mParams.model)
+    {
+    case SL_DEVICE::ZED: pid = SL_USB_PROD_ZED_REVA; break;
+    case SL_DEVICE::ZED_M: pid = SL_USB_PROD_ZED_M_REVA; break;
+    case SL_DEVICE::ZED_CBS: pid = SL_USB_PROD_ZED_REVB; break;
+    case SL_DEVICE::ZED_M_CBS: pid = SL_USB_PROD_ZED_M_REVB; break;
+    case SL_DEVICE::ZED_2: pid = SL_USB_PROD_ZED_2_REVB; break;
+    case SL_DEVICE::ZED_2i: pid = SL_USB_PROD_ZED_2i; break;
+    default: return false;
+    }
+
+    std::ostringstream ss;
+    ss << "usb:v" << std::uppercase << std::hex << std::setfill('0') << std::setw(4) << SL_USB_VENDOR
+       << "p" << std::setw(4) << pid << "d0100dcEFdsc02dp01ic0Eisc01ip00in00";
+    modalias = ss.str();
+
+    return true;
+}
+
+int MockVideoDevice::stat(const char* path, struct ::stat* st)
+{
+    int idx = getDeviceIndex(path);
+    if(idx<0)
+        return setErrno(ENOENT);
+
+    memset(st, 0, sizeof(struct ::stat));
+    st->st_mode = S_IFCHR | 0660;
+    st->st_rdev = makedev(81, static_cast<unsigned int>(mDevices[idx]->dev_id));
+
+    return 0;
+}
+
+int MockVideoDevice::open(const char* path, int flags)
+{
+    int idx = getDeviceIndex(path);
+    if(idx<0)
+        return setErrno(ENOENT);
+
+    // The eventfd counts the filled buffers: it is readable when a frame can be dequeued
+    int efd_flags = EFD_SEMAPHORE | EFD_CLOEXEC;
+    if(flags & O_NONBLOCK)
+        efd_flags |= EFD_NONBLOCK;
+
+    int fd = eventfd(0, efd_flags);
+    if(fd<0)
+        return -1;
+
+    std::shared_ptr<Stream> s = std::make_shared<Stream>();
+    s->fd = fd;
+    s->dev = mDevices[idx];
+
+    const std::lock_guard<std::mutex> lock(mStreamMutex);
+    mStreams[fd] = s;
+
+    if(mParams.verbose)
+    {
+        std::string msg = std::string("Opened the emulated device '") + path + "' [SN: " +
+                std::to_string(s->dev->serial_number) + "]";
+        INFO_OUT(mParams.verbose,msg);
+    }
+
+    return fd;
+}
+
+int MockVideoDevice::close(int fd)
+{
+    std::shared_ptr<Stream> s;
+    {
+        const std::lock_guard<std::mutex> lock(mStreamMutex);
+        auto it = mStreams.find(fd);
+        if(it==mStreams.end())
+            return setErrno(EBADF);
+        s = it->second;
+        mStreams.erase(it);
+    }
+
+    stopStreaming(*s);
+
+    return ::close(fd);
+}
+
+void* MockVideoDevice::mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset)
+{
+    (void)addr;
+    (void)prot;
+    (void)flags;
+
+    std::shared_ptr<Stream> s = getStream(fd);
+    if(!s)
+    {
+        errno = EBADF;
+        return MAP_FAILED;
+    }
+
+    const std::lock_guard<std::mutex> lock(s->mutex);
+    size_t idx = s->buf_stride?(static_cast<size_t>(offset)/s->buf_stride):0;
+    if(idx>=s->buffers.size() || length>s->buf_size)
+    {
+        errno = EINVAL;
+        return MAP_FAILED;
+    }
+
+    return s->buffers[idx].get();
+}
+
+int MockVideoDevice::munmap(void* addr, size_t length)
+{
+    (void)addr;
+    (void)length;
+
+    // The buffers are owned by the streams and released by `VIDIOC_REQBUFS` or `close`
+    return 0;
+}
+
+uint64_t MockVideoDevice::getGeneratedCount(int fd)
+{
+    std::shared_ptr<Stream> s = getStream(fd);
+    return s?s->generated.load():0;
+}
+
+uint64_t MockVideoDevice::getDroppedCount(int fd)
+{
+    std::shared_ptr<Stream> s = getStream(fd);
+    return s?s->dropped.load():0;
+}
+
+int MockVideoDevice::ioctl(int fd, unsigned long request, void* arg)
+{
+    std::shared_ptr<Stream> s = getStream(fd);
+    if(!s)
+        return setErrno(EBADF);
+
+    if(!arg)
+        return setErrno(EFAULT);
+
+    switch(request)
+    {
+    case VIDIOC_QUERYCAP:
+    {
+        struct v4l2_capability* cap = static_cast<struct v4l2_capability*>(arg);
+        memset(cap, 0, sizeof(struct v4l2_capability));
+        strncpy(reinterpret_cast<char*>(cap->driver), "uvcvideo", sizeof(cap->driver)-1);
+        strncpy(reinterpret_cast<char*>(cap->card), "ZED mock", sizeof(cap->card)-1);
+        snprintf(reinterpret_cast<char*>(cap->bus_info), sizeof(cap->bus_info), "mock:%d", s->dev->dev_id);
+        cap->capabilities = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING | V4L2_CAP_DEVICE_CAPS;
+        cap->device_caps = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+        return 0;
+    }
+
+    case VIDIOC_CROPCAP:
+    {
+        struct v4l2_cropcap* cropcap = static_cast<struct v4l2_cropcap*>(arg);
+        const std::lock_guard<std::mutex> lock(s->mutex);
+        cropcap->bounds.width = cropcap->defrect.width = s->width;
+        cropcap->bounds.height = cropcap->defrect.height = s->height;
+        cropcap->pixelaspect.numerator = cropcap->pixelaspect.denominator = 1;
+        return 0;
+    }
+
+    case VIDIOC_S_FMT:
+    case VIDIOC_G_FMT:
+    {
+        struct v4l2_format* fmt = static_cast<struct v4l2_format*>(arg);
+        if(fmt->type!=V4L2_BUF_TYPE_VIDEO_CAPTURE)
+            return setErrno(EINVAL);
+
+        const std::lock_guard<std::mutex> lock(s->mutex);
+        if(request==VIDIOC_S_FMT)
+        {
+            if(!s->stop || !s->buffers.empty())
+                return setErrno(EBUSY);
+
+            // The closest available side-by-side resolution is selected, as the UVC driver does
+            size_t best = 0;
+            uint64_t best_diff = UINT64_MAX;
+            for(size_t i=0; i<cameraResolution.size(); i++)
+            {
+                int64_t dw = static_cast<int64_t>(cameraResolution[i].width*2) - fmt->fmt.pix.width;
+                int64_t dh = static_cast<int64_t>(cameraResolution[i].height) - fmt->fmt.pix.height;
+                uint64_t diff = static_cast<uint64_t>(std::llabs(dw) + std::llabs(dh));
+                if(diff<best_diff)
+                {
+                    best_diff = diff;
+                    best = i;
+                }
+            }
+
+            s->width = static_cast<uint32_t>(cameraResolution[best].width*2);
+            s->height = static_cast<uint32_t>(cameraResolution[best].height);
+            s->buf_size = s->width * s->height * 2;
+            s->pattern.clear();
+        }
+
+        fmt->fmt.pix.width = s->width;
+        fmt->fmt.pix.height = s->height;
+        fmt->fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+        fmt->fmt.pix.field = V4L2_FIELD_NONE;
+        fmt->fmt.pix.bytesperline = s->width * 2;
+        fmt->fmt.pix.sizeimage = static_cast<uint32_t>(s->buf_size);
+        fmt->fmt.pix.colorspace = V4L2_COLORSPACE_SRGB;
+        return 0;
+    }
+
+    case VIDIOC_S_PARM:
+    case VIDIOC_G_PARM:
+    {
+        struct v4l2_streamparm* parm = static_cast<struct v4l2_streamparm*>(arg);
+        if(parm->type!=V4L2_BUF_TYPE_VIDEO_CAPTURE)
+            return setErrno(EINVAL);
+
+        const std::lock_guard<std::mutex> lock(s->mutex);
+        if(request==VIDIOC_S_PARM)
+        {
+            struct v4l2_fract& tpf = parm->parm.capture.timeperframe;
+            if(tpf.numerator==0 || tpf.denominator==0)
+                return setErrno(EINVAL);
+            s->fps = static_cast<float>(tpf.denominator)/tpf.numerator;
+        }
+
+        parm->parm.capture.capability = V4L2_CAP_TIMEPERFRAME;
+        parm->parm.capture.timeperframe.numerator = 1;
+        parm->parm.capture.timeperframe.denominator = static_cast<uint32_t>(std::round(s->fps));
+        return 0;
+    }
+
+    case VIDIOC_REQBUFS:
+    {
+        struct v4l2_requestbuffers* req = static_cast<struct v4l2_requestbuffers*>(arg);
+        if(req->type!=V4L2_BUF_TYPE_VIDEO_CAPTURE || req->memory!=V4L2_MEMORY_MMAP)
+            return setErrno(EINVAL);
+
+        const std::lock_guard<std::mutex> lock(s->mutex);
+        if(!s->stop)
+            return setErrno(EBUSY);
+        if(s->buf_size==0)
+            return setErrno(EINVAL);
+
+        uint32_t count = std::min<uint32_t>(req->count, MOCK_MAX_BUFFERS);
+        s->buffers.clear();
+        s->queued.clear();
+        s->ready.clear();
+
+        // `mmap` offsets are page aligned as in the real driver
+        long page = sysconf(_SC_PAGESIZE);
+        s->buf_stride = ((s->buf_size + page - 1) / page) * page;
+        for(uint32_t i=0; i<count; i++)
+        {
+            s->buffers.emplace_back(new uint8_t[s->buf_size]);
+            memset(s->buffers.back().get(), 0, s->buf_size);
+        }
+
+        req->count = count;
+        return 0;
+    }
+
+    case VIDIOC_QUERYBUF:
+    case VIDIOC_QBUF:
+    {
+        struct v4l2_buffer* buf = static_cast<struct v4l2_buffer*>(arg);
+        const std::lock_guard<std::mutex> lock(s->mutex);
+        if(buf->type!=V4L2_BUF_TYPE_VIDEO_CAPTURE || buf->index>=s->buffers.size())
+            return setErrno(EINVAL);
+
+        if(request==VIDIOC_QBUF)
+        {
+            for(uint32_t idx : s->queued)
+            {
+                if(idx==buf->index)
+                    return setErrno(EINVAL);
+            }
+            s->queued.push_back(buf->index);
+        }
+
+        buf->length = static_cast<uint32_t>(s->buf_size);
+        buf->m.offset = static_cast<uint32_t>(buf->index * s->buf_stride);
+        buf->flags = V4L2_BUF_FLAG_MAPPED | V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+        if(request==VIDIOC_QBUF)
+            buf->flags |= V4L2_BUF_FLAG_QUEUED;
+        return 0;
+    }
+
+    case VIDIOC_DQBUF:
+    {
+        struct v4l2_buffer* buf = static_cast<struct v4l2_buffer*>(arg);
+        if(buf->type!=V4L2_BUF_TYPE_VIDEO_CAPTURE)
+            return setErrno(EINVAL);
+
+        // Blocks in blocking mode, EAGAIN in non blocking mode
+        uint64_t val = 0;
+        if(::read(fd, &val, sizeof(val))!=sizeof(val))
+            return -1;
+
+        const std::lock_guard<std::mutex> lock(s->mutex);
+        if(s->ready.empty())
+            return setErrno(EAGAIN);
+
+        *buf = s->ready.front();
+        s->ready.pop_front();
+        return 0;
+    }
+
+    case VIDIOC_G_PRIORITY:
+    {
+        *static_cast<uint32_t*>(arg) = V4L2_PRIORITY_DEFAULT;
+        return 0;
+    }
+
+    case VIDIOC_STREAMON:
+    {
+        const std::lock_guard<std::mutex> lock(s->mutex);
+        if(s->buffers.empty())
+            return setErrno(EINVAL);
+
+        if(s->stop)
+        {
+            s->stop = false;
+            s->generator = std::thread(&MockVideoDevice::generatorThreadFunc, this, s.get());
+        }
+        return 0;
+    }
+
+    case VIDIOC_STREAMOFF:
+    {
+        stopStreaming(*s);
+        return 0;
+    }
+
+    case VIDIOC_QUERYCTRL:
+    {
+        struct v4l2_queryctrl* qctrl = static_cast<struct v4l2_queryctrl*>(arg);
+        const MockControl* ctrl = findControl(qctrl->id);
+        if(!ctrl)
+            return setErrno(EINVAL);
+
+        memset(qctrl, 0, sizeof(struct v4l2_queryctrl));
+        qctrl->id = ctrl->id;
+        qctrl->type = (ctrl->max==1)?V4L2_CTRL_TYPE_BOOLEAN:V4L2_CTRL_TYPE_INTEGER;
+        strncpy(reinterpret_cast<char*>(qctrl->name), ctrl->name, sizeof(qctrl->name)-1);
+        qctrl->minimum = ctrl->min;
+        qctrl->maximum = ctrl->max;
+        qctrl->step = ctrl->step;
+        qctrl->default_value = ctrl->def;
+        return 0;
+    }
+
+    case VIDIOC_G_CTRL:
+    case VIDIOC_S_CTRL:
+    {
+        struct v4l2_control* control = static_cast<struct v4l2_control*>(arg);
+        const MockControl* ctrl = findControl(control->id);
+        if(!ctrl)
+            return setErrno(EINVAL);
+
+        const std::lock_guard<std::mutex> lock(s->dev->mutex);
+        if(request==VIDIOC_S_CTRL)
+        {
+            if(control->value<ctrl->min || control->value>ctrl->max)
+                return setErrno(ERANGE);
+            s->dev->controls[ctrl->id] = control->value;
+        }
+
+        control->value = s->dev->controls[ctrl->id];
+        return 0;
+    }
+
+    case UVCIOC_CTRL_QUERY:
+    {
+        struct uvc_xu_control_query* xu = static_cast<struct uvc_xu_control_query*>(arg);
+        if(xu->unit!=MOCK_XU_UNIT_ID || xu->selector!=MOCK_XU_SELECTOR)
+            return setErrno(ENOENT);
+
+        return vendorControl(*s->dev, xu->query, xu->data, xu->size);
+    }
+
+    default:
+        return setErrno(ENOTTY);
+    }
+}
+
+int MockVideoDevice::vendorControl(Device& dev, uint8_t query, uint8_t* data, uint16_t size)
+{
+    if(!data)
+        return setErrno(EFAULT);
+
+    const std::lock_guard<std::mutex> lock(dev.mutex);
+
+    switch(query)
+    {
+    case UVC_GET_LEN:
+        if(size<2)
+            return setErrno(ENOBUFS);
+        data[0] = MOCK_XU_LEN & 0xff;
+        data[1] = (MOCK_XU_LEN >> 8) & 0xff;
+        return 0;
+
+    case UVC_GET_CUR:
+        if(size!=MOCK_XU_LEN)
+            return setErrno(ENOBUFS);
+        memcpy(data, dev.xu_resp, MOCK_XU_LEN);
+        return 0;
+
+    case UVC_SET_CUR:
+        break;
+
+    default:
+        return setErrno(EBADRQC);
+    }
+
+    if(size!=MOCK_XU_LEN)
+        return setErrno(ENOBUFS);
+
+    // The command is executed immediately, the response is returned by the following UVC_GET_CUR
+    memcpy(dev.xu_resp, data, MOCK_XU_LEN);
+    uint8_t* resp = &dev.xu_resp[MOCK_XU_DATA_OFFSET];
+
+    bool set = (data[0]==MOCK_XU_TASK_SET);
+    uint32_t address = (static_cast<uint32_t>(data[5])<<24) | (static_cast<uint32_t>(data[6])<<16) |
+            (static_cast<uint32_t>(data[7])<<8) | data[8];
+
+    switch(data[1])
+    {
+    case MOCK_XU_GPIO_DIR:
+        break;
+
+    case MOCK_XU_GPIO_SET:
+        dev.gpio[data[2] & 0x07] = data[3];
+        break;
+
+    case MOCK_XU_GPIO_GET:
+        *resp = dev.gpio[data[2] & 0x07];
+        break;
+
+    case MOCK_XU_SYS_REG:
+        if(set)
+            dev.sys_regs[address] = data[16];
+        else
+            *resp = dev.sys_regs[address];
+        break;
+
+    case MOCK_XU_SENS_REG_LEFT:
+    case MOCK_XU_SENS_REG_RIGHT:
+    {
+        int side = (data[1]==MOCK_XU_SENS_REG_LEFT)?0:1;
+        if(set)
+            dev.sens_regs[side][address] = data[16];
+        else
+            *resp = dev.sens_regs[side][address];
+        break;
+    }
+
+    case MOCK_XU_FLASH_READ:
+    {
+        int len = (data[11]<<8) | data[12];
+        len = std::min(len, MOCK_XU_LEN-MOCK_XU_DATA_OFFSET);
+        memset(resp, 0, len);
+
+        // The serial number is stored as "OV" followed by its decimal digits read as a hexadecimal value
+        if(address==MOCK_UNIQUE_ID_START && len>=6)
+        {
+            uint32_t sn_hex = static_cast<uint32_t>(std::stoul(std::to_string(dev.serial_number), nullptr, 16));
+            resp[0] = 'O';
+            resp[1] = 'V';
+            resp[2] = (sn_hex >> 24) & 0xff;
+            resp[3] = (sn_hex >> 16) & 0xff;
+            resp[4] = (sn_hex >> 8) & 0xff;
+            resp[5] = sn_hex & 0xff;
+        }
+        break;
+    }
+
+    default:
+        return setErrno(EINVAL);
+    }
+
+    return 0;
+}
+
+void MockVideoDevice::stopStreaming(Stream& s)
+{
+    s.stop = true;
+    if(s.generator.joinable())
+        s.generator.join();
+
+    size_t pending = 0;
+    {
+        const std::lock_guard<std::mutex> lock(s.mutex);
+        pending = s.ready.size();
+        s.ready.clear();
+        s.queued.clear();
+    }
+
+    // Consume the notifications of the dropped buffers
+    uint64_t val = 0;
+    for(size_t i=0; i<pending; i++)
+    {
+        if(::read(s.fd, &val, sizeof(val))!=sizeof(val))
+            break;
+    }
+}
+
+void MockVideoDevice::renderFrame(Stream& s, uint8_t* dst, uint64_t seq, double luma_gain)
+{
+    const uint32_t half = s.width/2;
+    const size_t stride = s.width*2;
+
+    // ----> Static pattern: gradient with a checkerboard texture, the right image is shifted by the disparity
+    if(s.pattern.size()!=s.buf_size)
+    {
+        s.pattern.resize(s.buf_size);
+        for(uint32_t y=0; y<s.height; y++)
+        {
+            uint8_t* row = &s.pattern[y*stride];
+            for(uint32_t x=0; x<s.width; x++)
+            {
+                int sx = (x<half)?static_cast<int>(x):static_cast<int>(x-half)+mParams.disparity;
+                int luma = 40 + (sx*120)/half + (y*40)/s.height + ((((sx>>4)^(y>>4))&1)?30:0);
+                row[x*2] = static_cast<uint8_t>(std::min(luma,235));
+                row[x*2+1] = 128;
+            }
+        }
+    }
+    // <---- Static pattern
+
+    if(luma_gain==1.0)
+    {
+        memcpy(dst, s.pattern.data(), s.buf_size);
+    }
+    else
+    {
+        uint8_t lut[256];
+        for(int i=0; i<256; i++)
+            lut[i] = static_cast<uint8_t>(std::min(255.0, i*luma_gain));
+
+        const uint8_t* src = s.pattern.data();
+        for(size_t i=0; i<s.buf_size; i+=2)
+        {
+            dst[i] = lut[src[i]];
+            dst[i+1] = src[i+1];
+        }
+    }
+
+    // ----> Moving bar, at the same scene position in both images
+    int bar_x = static_cast<int>((seq*4)%half);
+    for(uint32_t y=0; y<s.height; y++)
+    {
+        uint8_t* row = &dst[y*stride];
+        for(int bx=bar_x; bx<bar_x+MOCK_BAR_WIDTH; bx++)
+        {
+            if(bx<static_cast<int>(half))
+                row[bx*2] = 235;
+            int rx = bx-mParams.disparity;
+            if(rx>=0 && rx<static_cast<int>(half))
+                row[(half+rx)*2] = 235;
+        }
+    }
+    // <---- Moving bar
+}
+
+void MockVideoDevice::generatorThreadFunc(Stream* s)
+{
+    std::mt19937 rng(static_cast<uint32_t>(s->dev->serial_number));
+    std::normal_distribution<double> jitter(0.0, std::max(0.0f,mParams.jitter_usec)*1000.0);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+    float fps = (mParams.fps_override>0.0f)?mParams.fps_override:s->fps;
+    uint64_t period = static_cast<uint64_t>(NSEC_PER_SEC/fps);
+
+    uint64_t start = getMonotonicTimestamp();
+    uint64_t last_ts = start;
+
+    for(uint64_t seq=0; !s->stop; seq++)
+    {
+        // ----> Wait for the capture time of the frame
+        int64_t ts = static_cast<int64_t>(start + (seq+1)*period);
+        if(mParams.jitter_usec>0.0f)
+            ts += static_cast<int64_t>(jitter(rng));
+        if(ts<=static_cast<int64_t>(last_ts))
+            ts = last_ts+1;
+        last_ts = static_cast<uint64_t>(ts);
+
+        struct timespec wake;
+        wake.tv_sec = static_cast<time_t>(last_ts/NSEC_PER_SEC);
+        wake.tv_nsec = static_cast<long>(last_ts%NSEC_PER_SEC);
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr)==EINTR) {}
+        // <---- Wait for the capture time of the frame
+
+        if(s->stop)
+            break;
+
+        s->generated++;
+
+        // ----> Brightness emulation of the manual exposure and gain
+        double luma_gain = 1.0;
+        {
+            Device& dev = *s->dev;
+            const std::lock_guard<std::mutex> lock(dev.mutex);
+            if((dev.sys_regs[MOCK_ISP_CTRL_LEFT] & MOCK_AEG_AGC_MASK)==0)
+            {
+                std::map<uint32_t,uint8_t>& regs = dev.sens_regs[0];
+                int exp_raw = (regs[MOCK_ADDR_EXP_H]<<12) + (regs[MOCK_ADDR_EXP_M]<<4) + (regs[MOCK_ADDR_EXP_L]>>4);
+                int gain_raw = (regs[MOCK_ADDR_GAIN_M]<<8) + regs[MOCK_ADDR_GAIN_L];
+                luma_gain = (static_cast<double>(exp_raw)/MOCK_EXP_RAW_DEFAULT) * (1.0 + static_cast<double>(gain_raw)/MOCK_GAIN_RAW_UNIT);
+            }
+        }
+        // <---- Brightness emulation of the manual exposure and gain
+
+        uint32_t idx = 0;
+        {
+            const std::lock_guard<std::mutex> lock(s->mutex);
+            if(s->queued.empty())
+            {
+                // The application did not give back a buffer in time
+                s->dropped++;
+                continue;
+            }
+            idx = s->queued.front();
+            s->queued.pop_front();
+        }
+
+        // The buffer belongs to the "driver" until it is dequeued: no lock required to fill it
+        renderFrame(*s, s->buffers[idx].get(), seq, luma_gain);
+
+        struct v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = idx;
+        buf.length = static_cast<uint32_t>(s->buf_size);
+        buf.m.offset = static_cast<uint32_t>(idx * s->buf_stride);
+        buf.bytesused = buf.length;
+        if(mParams.incomplete_ratio>0.0f && uniform(rng)<mParams.incomplete_ratio)
+            buf.bytesused = buf.length/2;
+        buf.sequence = static_cast<uint32_t>(seq);
+        buf.field = V4L2_FIELD_NONE;
+        buf.flags = V4L2_BUF_FLAG_MAPPED | V4L2_BUF_FLAG_DONE |
+                V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC | V4L2_BUF_FLAG_TSTAMP_SRC_SOE;
+        buf.timestamp.tv_sec = static_cast<time_t>(last_ts/NSEC_PER_SEC);
+        buf.timestamp.tv_usec = static_cast<suseconds_t>((last_ts%NSEC_PER_SEC)/1000);
+
+        {
+            const std::lock_guard<std::mutex> lock(s->mutex);
+            s->ready.push_back(buf);
+        }
+
+        uint64_t one = 1;
+        if(::write(s->fd, &one, sizeof(one))!=sizeof(one))
+        {
+            if(mParams.verbose)
+            {
+                std::string msg = std::string("Frame notification failed: ") + std::string(strerror(errno));
+                ERROR_OUT(mParams.verbose,msg);
+            }
+        }
+    }
+}
+
+}
+
+}
@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "reglogger.hpp"
+#include "hostclock.hpp"
+
+#include <cstring>
+
+namespace sl_oc {
+
+namespace video {
+
+RegisterLogger::RegisterLogger(int verbose_lvl)
+{
+    mVerbose = verbose_lvl;
+}
+
+RegisterLogger::~RegisterLogger()
+{
+    stop();
+}
+
+bool RegisterLogger::start(const std::string& filename, int serial_number, ReadFunc read_func)
+{
+    stop();
+
+    mFile = fopen(filename.c_str(), "wb");
+    if(!mFile)
+    {
+        ERROR_OUT(mVerbose, std::string("Cannot create the log file '") + filename + std::string("'"));
+        return false;
+    }
+
+    // The records are small: a large buffer reduces the number of writes
+    setvbuf(mFile, nullptr, _IOFBF, 64*1024);
+
+    RegLogFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = REG_LOG_MAGIC;
+    header.version = REG_LOG_VERSION;
+    header.header_size = sizeof(RegLogFileHeader);
+    header.record_size = sizeof(RegLogRecord);
+    header.reg_count = REG_LOG_REG_COUNT;
+    header.serial_number = serial_number;
+    header.start_ts = getWallTimestamp();
+    if(fwrite(&header, sizeof(header), 1, mFile)!=1)
+    {
+        fclose(mFile);
+        mFile = nullptr;
+        return false;
+    }
+
+    mReadFunc = read_func;
+    mRecords = 0;
+    mDropped = 0;
+    mRequests.clear();
+    mPending.clear();
+
+    mStopControl = false;
+    mStopWriter = false;
+    mWriterThread = std::thread(&RegisterLogger::writerThreadFunc, this);
+    mControlThread = std::thread(&RegisterLogger::controlThreadFunc, this);
+
+    return true;
+}
+
+void RegisterLogger::stop()
+{
+    // The control thread is stopped first, so that its last records are written
+    {
+        const std::lock_guard<std::mutex> lock(mReqMutex);
+        mStopControl = true;
+    }
+    mReqCond.notify_one();
+    if(mControlThread.joinable())
+        mControlThread.join();
+
+    {
+        const std::lock_guard<std::mutex> lock(mRecMutex);
+        mStopWriter = true;
+    }
+    mRecCond.notify_one();
+    if(mWriterThread.joinable())
+        mWriterThread.join();
+
+    if(mFile)
+    {
+        fclose(mFile);
+        mFile = nullptr;
+    }
+}
+
+bool RegisterLogger::request(uint64_t frame_id, uint64_t frame_ts)
+{
+    {
+        const std::lock_guard<std::mutex> lock(mReqMutex);
+        if(mStopControl || mRequests.size()>=REG_LOG_QUEUE_SIZE)
+        {
+            mDropped++;
+            return false;
+        }
+        mRequests.push_back({frame_id, frame_ts});
+    }
+    mReqCond.notify_one();
+
+    return true;
+}
+
+void RegisterLogger::controlThreadFunc()
+{
+    while(1)
+    {
+        Request req;
+        {
+            std::unique_lock<std::mutex> lock(mReqMutex);
+            mReqCond.wait(lock, [this]{return !mRequests.empty() || mStopControl;});
+
+            // The pending requests are processed before stopping
+            if(mRequests.empty())
+                break;
+            req = mRequests.front();
+            mRequests.pop_front();
+        }
+
+        // ----> Register reading
+        RegLogRecord rec[2];
+        for(int side=0; side<2; side++)
+        {
+            memset(&rec[side], 0, sizeof(RegLogRecord));
+            rec[side].frame_id = req.frame_id;
+            rec[side].frame_ts = req.frame_ts;
+            rec[side].side = static_cast<uint8_t>(side);
+
+            uint64_t start = getMonotonicTimestamp();
+            rec[side].status = (mReadFunc(side, rec[side].values)==0)?0:1;
+            rec[side].read_ts = getMonotonicTimestamp();
+            rec[side].read_usec = static_cast<uint32_t>((rec[side].read_ts-start)/1000);
+        }
+        // <---- Register reading
+
+        {
+            const std::lock_guard<std::mutex> lock(mRecMutex);
+            if(mPending.size()+2>REG_LOG_QUEUE_SIZE)
+            {
+                mDropped++;
+                continue;
+            }
+            mPending.push_back(rec[0]);
+            mPending.push_back(rec[1]);
+        }
+        mRecCond.notify_one();
+    }
+}
+
+void RegisterLogger::writerThreadFunc()
+{
+    std::vector<RegLogRecord> records;
+    while(1)
+    {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(mRecMutex);
+            mRecCond.wait(lock, [this]{return !mPending.empty() || mStopWriter;});
+            records.swap(mPending);
+            stop = mStopWriter;
+        }
+
+        if(!records.empty())
+        {
+            size_t written = fwrite(records.data(), sizeof(RegLogRecord), records.size(), mFile);
+            mRecords += written;
+            if(written!=records.size())
+                ERROR_OUT(mVerbose, "Cannot write the log file");
+
+            // Each batch is flushed: a crash loses at most the records of the last batch
+            fflush(mFile);
+            records.clear();
+        }
+
+        if(stop)
+            break;
+    }
+}
+
+bool RegisterLogger::readLog(const std::string& filename, RegLogFileHeader& header, std::vector<RegLogRecord>& records)
+{
+    records.clear();
+
+    FILE* file = fopen(filename.c_str(), "rb");
+    if(!file)
+        return false;
+
+    bool ok = (fread(&header, sizeof(header), 1, file)==1) && header.magic==REG_LOG_MAGIC &&
+            header.header_size>=sizeof(RegLogFileHeader) && header.record_size>=sizeof(RegLogRecord) &&
+            header.reg_count==REG_LOG_REG_COUNT;
+
+    // The fields added by newer versions are skipped
+    if(ok)
+        ok = fseek(file, header.header_size, SEEK_SET)==0;
+
+    std::vector<uint8_t> buf(ok?header.record_size:0);
+    while(ok && fread(buf.data(), buf.size(), 1, file)==1)
+    {
+        RegLogRecord rec;
+        memcpy(&rec, buf.data(), sizeof(rec));
+        records.push_back(rec);
+    }
+
+    fclose(file);
+    return ok;
+}
+
+}
+
+}
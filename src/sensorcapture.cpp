@@ -19,6 +19,8 @@
 ///////////////////////////////////////////////////////////////////////////
 
 #include "sensorcapture.hpp"
+#include "clocksync.hpp"
+#include "trace.hpp"
 
 #ifdef VIDEO_MOD_AVAILABLE
 
@@ -183,11 +185,30 @@ bool SensorCapture::initializeSensors( int sn )
 
     mDevFwVer = mSlDevFwVer[sn];
     mDevPid = pid;
+
+    initMetrics();
+
     mInitialized = startCapture();
 
     return true;
 }
 
+void SensorCapture::initMetrics()
+{
+    MetricsRegistry& reg = MetricsRegistry::getInstance();
+
+    std::string labels = "serial=\"" + std::to_string(mDevSerial) + "\"";
+
+    mMetImu = reg.counter("zed_oc_imu_samples_total", "IMU samples received", labels);
+    mMetHidErr = reg.counter("zed_oc_hid_errors_total", "Failed or invalid HID reads", labels);
+    mMetImuRate = reg.gauge("zed_oc_imu_rate", "Measured IMU rate [Hz]", labels);
+    mMetSyncOffset = reg.gauge("zed_oc_sync_offset_seconds", "Offset of the sensor timestamps respect to the synchronized camera", labels);
+    mMetTsScaling = reg.gauge("zed_oc_ts_scaling", "MCU timestamp drift scaling factor", labels);
+
+    mImuRateAvg = 0.0;
+    mMetTsScaling->set(mNTPTsScaling);
+}
+
 void SensorCapture::getFirmwareVersion( uint16_t& fw_major, uint16_t& fw_minor )
 {
     if(mDevSerial==-1)
@@ -313,6 +334,8 @@ void SensorCapture::grabThreadFunc()
     mNewEnvData=false;
     mNewCamTempData=false;
 
+    TRACE_THREAD_NAME("zed_oc sensors " + std::to_string(mDevSerial));
+
     // Read sensor data
     unsigned char usbBuf[65];
 
@@ -320,7 +343,9 @@ void SensorCapture::grabThreadFunc()
 
     mFirstImuData = true;
 
-    uint64_t rel_mcu_ts = 0;
+    mRelMcuTs = 0;
+
+    mClockId = ClockSync::getInstance().registerClock(std::string("MCU ")+std::to_string(mDevSerial));
 
     mSysTsQueue.reserve(TS_SHIFT_VAL_COUNT);
     mMcuTsQueue.reserve(TS_SHIFT_VAL_COUNT);
@@ -341,227 +366,293 @@ void SensorCapture::grabThreadFunc()
 
         // Sensor data request
         usbBuf[1]=usb::REP_ID_SENSOR_DATA;
-        int res = hid_read_timeout( mDevHandle, usbBuf, 64, 2000 );
+        int res;
+        {
+            TRACE_SCOPE("hid_read");
+            res = hid_read_timeout( mDevHandle, usbBuf, 64, 2000 );
+        }
+        uint64_t rx_ts = getMonotonicTimestamp();
 
         // ----> Data received?
         if( res < static_cast<int>(sizeof(usb::RawData)) )  {
+            if(res!=0 && mMetHidErr) mMetHidErr->inc(); // `0` is a timeout
             hid_set_nonblocking( mDevHandle, 0 );
             continue;
         }
         // <---- Data received?
 
-        // ----> Received data are correct?
-        int target_struct_id = 0;
-        if (mDevPid==SL_USB_PROD_MCU_ZED2_REVA || mDevPid==SL_USB_PROD_MCU_ZED2i_REVA)
-            target_struct_id = usb::REP_ID_SENSOR_DATA;
-
-        if( usbBuf[0] != target_struct_id)
+        if( !processRawData(usbBuf, res, rx_ts) )
         {
-            if(mVerbose)
-            {
-                WARNING_OUT(mVerbose,std::string("REP_ID_SENSOR_DATA - Sensor Data type mismatch") );
-            }
-
             hid_set_nonblocking( mDevHandle, 0 );
-            continue;
         }
-        // <---- Received data are correct?
+    }
 
-        // Data structure static conversion
-        usb::RawData* data = (usb::RawData*)usbBuf;
+    ClockSync::getInstance().unregisterClock(mClockId);
+    mClockId = -1;
 
-        // ----> Timestamp update
-        uint64_t mcu_ts_nsec = static_cast<uint64_t>(std::round(static_cast<float>(data->timestamp)*TS_SCALE));
+    mGrabRunning = false;
+}
 
-        if(mFirstImuData && data->imu_not_valid!=1)
-        {
-            mStartSysTs = getWallTimestamp(); // Starting system timestamp
-            //std::cout << "SensorCapture: " << mStartSysTs << std::endl;
+bool SensorCapture::processRawData(const uint8_t* buf, int size, uint64_t rx_ts)
+{
+    // ----> Received data are correct?
+    int target_struct_id = 0;
+    if (mDevPid==SL_USB_PROD_MCU_ZED2_REVA || mDevPid==SL_USB_PROD_MCU_ZED2i_REVA)
+        target_struct_id = usb::REP_ID_SENSOR_DATA;
 
-            mLastMcuTs = mcu_ts_nsec;
-            mFirstImuData = false;
-            continue;
+    if( size < static_cast<int>(sizeof(usb::RawData)) || buf[0] != target_struct_id)
+    {
+        if(mVerbose)
+        {
+            WARNING_OUT(mVerbose,std::string("REP_ID_SENSOR_DATA - Sensor Data type mismatch") );
         }
+        if(mMetHidErr) mMetHidErr->inc();
 
-        uint64_t delta_mcu_ts_raw = mcu_ts_nsec - mLastMcuTs;
+        return false;
+    }
+    // <---- Received data are correct?
 
-        //std::cout << "Internal MCU freq: " << 1e9/delta_mcu_ts_raw << " Hz" << std::endl;
+    // Data structure static conversion
+    const usb::RawData* data = (const usb::RawData*)buf;
+
+    // ----> Timestamp update
+    uint64_t mcu_ts_nsec = static_cast<uint64_t>(std::round(static_cast<double>(data->timestamp)*TS_SCALE));
+
+    if(mFirstImuData && data->imu_not_valid!=1)
+    {
+        mStartSysTs = getMonotonicTimestamp(); // Starting system timestamp
+        //std::cout << "SensorCapture: " << mStartSysTs << std::endl;
 
         mLastMcuTs = mcu_ts_nsec;
-        // <---- Timestamp update
+        mFirstImuData = false;
+        return true;
+    }
+
+    uint64_t delta_mcu_ts_raw = mcu_ts_nsec - mLastMcuTs;
+
+    //std::cout << "Internal MCU freq: " << 1e9/delta_mcu_ts_raw << " Hz" << std::endl;
+
+    if(mMetImuRate && delta_mcu_ts_raw>0)
+    {
+        double rate = 1e9/static_cast<double>(delta_mcu_ts_raw);
+        mImuRateAvg = (mImuRateAvg==0.0)?rate:(mImuRateAvg + 0.01*(rate-mImuRateAvg));
+        mMetImuRate->set(mImuRateAvg);
+    }
+
+    mLastMcuTs = mcu_ts_nsec;
+    // <---- Timestamp update
+
+    // Apply timestamp drift scaling factor
+    mRelMcuTs +=  static_cast<uint64_t>(static_cast<double>(delta_mcu_ts_raw)*mNTPTsScaling);
 
-        // Apply timestamp drift scaling factor
-        rel_mcu_ts +=  static_cast<uint64_t>(static_cast<double>(delta_mcu_ts_raw)*mNTPTsScaling);
+    // mStartSysTs is synchronized to Video TS when sync is enabled using \ref VideoCapture::enableSensorSync
+    uint64_t current_data_ts = (mStartSysTs-mSyncOffset) + mRelMcuTs;
 
-        // mStartSysTs is synchronized to Video TS when sync is enabled using \ref VideoCapture::enableSensorSync
-        uint64_t current_data_ts = (mStartSysTs-mSyncOffset) + rel_mcu_ts;
+    // ----> Alignment to the host clock
+    // When not synchronized to a camera, the MCU clock is mapped to the host monotonic clock by the shared
+    // clock service, in the same time base of the other devices
+    ClockSync& sync = ClockSync::getInstance();
+    sync.addSample(mClockId, mcu_ts_nsec, rx_ts);
+#ifdef VIDEO_MOD_AVAILABLE
+    if(!mVideoPtr)
+#endif
+    {
+        sync.toHost(mClockId, mcu_ts_nsec, current_data_ts);
+    }
+    // <---- Alignment to the host clock
 
-        // ----> Camera/Sensors Synchronization
-        if( data->sync_capabilities != 0 ) // Synchronization active
+    // ----> Host clock domains
+    HostClock& clock = HostClock::getInstance();
+    clock.update();
+
+    uint64_t data_ts_wall = clock.toWall(current_data_ts);
+    uint64_t data_ts = (mClockSource==CLOCK_SOURCE::MONOTONIC)?current_data_ts:data_ts_wall;
+    // <---- Host clock domains
+
+    // ----> Camera/Sensors Synchronization
+    if( data->sync_capabilities != 0 ) // Synchronization active
+    {
+        if(mLastFrameSyncCount!=0 && (data->frame_sync!=0 || data->frame_sync_count>mLastFrameSyncCount))
         {
-            if(mLastFrameSyncCount!=0 && (data->frame_sync!=0 || data->frame_sync_count>mLastFrameSyncCount))
-            {
 #if 0 // Timestamp sync debug info
-                std::cout << "MCU sync information: " << std::endl;
-                std::cout << " * data->frame_sync: " << (int)data->frame_sync << std::endl;
-                std::cout << " * data->frame_sync_count: " << data->frame_sync_count << std::endl;
-                std::cout << " * mLastFrameSyncCount: " << mLastFrameSyncCount << std::endl;
-                std::cout << " * MCU timestamp scaling: " << mNTPTsScaling << std::endl;
+            std::cout << "MCU sync information: " << std::endl;
+            std::cout << " * data->frame_sync: " << (int)data->frame_sync << std::endl;
+            std::cout << " * data->frame_sync_count: " << data->frame_sync_count << std::endl;
+            std::cout << " * mLastFrameSyncCount: " << mLastFrameSyncCount << std::endl;
+            std::cout << " * MCU timestamp scaling: " << mNTPTsScaling << std::endl;
 #endif
-                mSysTsQueue.push_back( getSteadyTimestamp() );     // Steady host timestamp
-                mMcuTsQueue.push_back( current_data_ts );   // MCU timestamp
+            mSysTsQueue.push_back( getSteadyTimestamp() );     // Steady host timestamp
+            mMcuTsQueue.push_back( current_data_ts );   // MCU timestamp
 
-                // Once we have enough data, calculate the drift scaling factor
-                if (mSysTsQueue.size()==TS_SHIFT_VAL_COUNT && mMcuTsQueue.size() == TS_SHIFT_VAL_COUNT)
-                {
-                    //First and last ts
-                    int first_index = 5;
-                    if (mNTPAdjustedCount <= NTP_ADJUST_CT) {
-                        first_index = TS_SHIFT_VAL_COUNT/2;
-                    }
-
-                    uint64_t first_ts_imu = mMcuTsQueue.at(first_index);
-                    uint64_t last_ts_imu = mMcuTsQueue.at(mMcuTsQueue.size()-1);
-                    uint64_t first_ts_cam = mSysTsQueue.at(first_index);
-                    uint64_t last_ts_cam = mSysTsQueue.at(mSysTsQueue.size()-1);
-                    double scale = double(last_ts_cam-first_ts_cam) / double(last_ts_imu-first_ts_imu);
-                    //CLAMP
-                    if (scale > 1.2) scale = 1.2;
-                    if (scale < 0.8) scale = 0.8;
-
-                    //Adjust scaling continuoulsy. No jump so that ts(n) - ts(n-1) == 400Hz
-                    mNTPTsScaling*=scale;
-
-                    //scale will be applied to the next values, so clear the vector and wait until we have enough data again
-                    mMcuTsQueue.clear();
-                    mSysTsQueue.clear();
-
-                    // Count the number of completed time shift factor estimations
-                    mNTPAdjustedCount++;
+            // Once we have enough data, calculate the drift scaling factor
+            if (mSysTsQueue.size()==TS_SHIFT_VAL_COUNT && mMcuTsQueue.size() == TS_SHIFT_VAL_COUNT)
+            {
+                TRACE_SCOPE("ts scaling update");
+
+                //First and last ts
+                int first_index = 5;
+                if (mNTPAdjustedCount <= NTP_ADJUST_CT) {
+                    first_index = TS_SHIFT_VAL_COUNT/2;
+                }
+
+                uint64_t first_ts_imu = mMcuTsQueue.at(first_index);
+                uint64_t last_ts_imu = mMcuTsQueue.at(mMcuTsQueue.size()-1);
+                uint64_t first_ts_cam = mSysTsQueue.at(first_index);
+                uint64_t last_ts_cam = mSysTsQueue.at(mSysTsQueue.size()-1);
+                double scale = double(last_ts_cam-first_ts_cam) / double(last_ts_imu-first_ts_imu);
+                //CLAMP
+                if (scale > 1.2) scale = 1.2;
+                if (scale < 0.8) scale = 0.8;
+
+                //Adjust scaling continuoulsy. No jump so that ts(n) - ts(n-1) == 400Hz
+                mNTPTsScaling*=scale;
+                if(mMetTsScaling) mMetTsScaling->set(mNTPTsScaling);
+
+                //scale will be applied to the next values, so clear the vector and wait until we have enough data again
+                mMcuTsQueue.clear();
+                mSysTsQueue.clear();
+
+                // Count the number of completed time shift factor estimations
+                mNTPAdjustedCount++;
 
 #ifdef VIDEO_MOD_AVAILABLE
-                    // ----> Signal update offset to VideoCapture
-                    if(mVideoPtr)
-                    {
-                        mSyncTs = current_data_ts;
-                        mVideoPtr->setReadyToSync();
-                    }
-                    // <---- Update offset
-#endif //VIDEO_MOD_AVAILABLE
+                // ----> Signal update offset to VideoCapture
+                if(mVideoPtr)
+                {
+                    mSyncTs = current_data_ts;
+                    mVideoPtr->setReadyToSync();
                 }
+                // <---- Update offset
+#endif //VIDEO_MOD_AVAILABLE
             }
         }
-        mLastFrameSyncCount = data->frame_sync_count;
-        // <---- Camera/Sensors Synchronization
-
-        // ----> IMU data
-        mIMUMutex.lock();
-        mLastIMUData.sync = data->frame_sync;
-        mLastIMUData.valid = (data->imu_not_valid!=1)?(data::Imu::NEW_VAL):(data::Imu::OLD_VAL);
-        mLastIMUData.timestamp = current_data_ts;
-        mLastIMUData.aX = data->aX*ACC_SCALE;
-        mLastIMUData.aY = data->aY*ACC_SCALE;
-        mLastIMUData.aZ = data->aZ*ACC_SCALE;
-        mLastIMUData.gX = data->gX*GYRO_SCALE;
-        mLastIMUData.gY = data->gY*GYRO_SCALE;
-        mLastIMUData.gZ = data->gZ*GYRO_SCALE;
-        mLastIMUData.temp = data->imu_temp*TEMP_SCALE;
-        mNewIMUData = true;
-        mIMUMutex.unlock();
+    }
+#ifdef VIDEO_MOD_AVAILABLE
+    if(mVideoPtr && data->frame_sync!=0)
+        mVideoPtr->addImuSyncTimestamp(current_data_ts);
+#endif
+
+    mLastFrameSyncCount = data->frame_sync_count;
+    // <---- Camera/Sensors Synchronization
+
+    // ----> IMU data
+    mIMUMutex.lock();
+    mLastIMUData.sync = data->frame_sync;
+    mLastIMUData.valid = (data->imu_not_valid!=1)?(data::Imu::NEW_VAL):(data::Imu::OLD_VAL);
+    mLastIMUData.timestamp = data_ts;
+    mLastIMUData.timestamp_mono = current_data_ts;
+    mLastIMUData.timestamp_wall = data_ts_wall;
+    mLastIMUData.aX = data->aX*ACC_SCALE;
+    mLastIMUData.aY = data->aY*ACC_SCALE;
+    mLastIMUData.aZ = data->aZ*ACC_SCALE;
+    mLastIMUData.gX = data->gX*GYRO_SCALE;
+    mLastIMUData.gY = data->gY*GYRO_SCALE;
+    mLastIMUData.gZ = data->gZ*GYRO_SCALE;
+    mLastIMUData.temp = data->imu_temp*TEMP_SCALE;
+    mNewIMUData = true;
+    mIMUMutex.unlock();
+    if(mMetImu) mMetImu->inc();
+
+    //std::string msg = std::to_string(mLastMAGData.timestamp);
+    //INFO_OUT(msg);
+    // <---- IMU data
+
+    // ----> Magnetometer data
+    if(data->mag_valid == data::Magnetometer::NEW_VAL)
+    {
+        mMagMutex.lock();
+        mLastMagData.valid = data::Magnetometer::NEW_VAL;
+        mLastMagData.timestamp = data_ts;
+        mLastMagData.timestamp_mono = current_data_ts;
+        mLastMagData.timestamp_wall = data_ts_wall;
+        mLastMagData.mY = data->mY*MAG_SCALE;
+        mLastMagData.mZ = data->mZ*MAG_SCALE;
+        mLastMagData.mX = data->mX*MAG_SCALE;
+        mNewMagData = true;
+        mMagMutex.unlock();
 
         //std::string msg = std::to_string(mLastMAGData.timestamp);
         //INFO_OUT(msg);
-        // <---- IMU data
-
-        // ----> Magnetometer data
-        if(data->mag_valid == data::Magnetometer::NEW_VAL)
-        {
-            mMagMutex.lock();
-            mLastMagData.valid = data::Magnetometer::NEW_VAL;
-            mLastMagData.timestamp = current_data_ts;
-            mLastMagData.mY = data->mY*MAG_SCALE;
-            mLastMagData.mZ = data->mZ*MAG_SCALE;
-            mLastMagData.mX = data->mX*MAG_SCALE;
-            mNewMagData = true;
-            mMagMutex.unlock();
-
-            //std::string msg = std::to_string(mLastMAGData.timestamp);
-            //INFO_OUT(msg);
-        }
+    }
+    else
+    {
+        if(data->mag_valid==0)
+            mLastMagData.valid = data::Magnetometer::NOT_PRESENT;
+        else if(data->mag_valid==1)
+            mLastMagData.valid = data::Magnetometer::OLD_VAL;
         else
-        {
-            if(data->mag_valid==0)
-                mLastMagData.valid = data::Magnetometer::NOT_PRESENT;
-            else if(data->mag_valid==1)
-                mLastMagData.valid = data::Magnetometer::OLD_VAL;
-            else
-                mLastMagData.valid = data::Magnetometer::NEW_VAL;
-        }
-        // <---- Magnetometer data
+            mLastMagData.valid = data::Magnetometer::NEW_VAL;
+    }
+    // <---- Magnetometer data
 
-        // ----> Environmental data
-        if(data->env_valid == data::Environment::NEW_VAL)
+    // ----> Environmental data
+    if(data->env_valid == data::Environment::NEW_VAL)
+    {
+        mEnvMutex.lock();
+        mLastEnvData.valid = data::Environment::NEW_VAL;
+        mLastEnvData.timestamp = data_ts;
+        mLastEnvData.timestamp_mono = current_data_ts;
+        mLastEnvData.timestamp_wall = data_ts_wall;
+        mLastEnvData.temp = data->temp*TEMP_SCALE;
+        if( atLeast(mDevFwVer, ZED_2_FW::FW_3_9))
         {
-            mEnvMutex.lock();
-            mLastEnvData.valid = data::Environment::NEW_VAL;
-            mLastEnvData.timestamp = current_data_ts;
-            mLastEnvData.temp = data->temp*TEMP_SCALE;
-            if( atLeast(mDevFwVer, ZED_2_FW::FW_3_9))
-            {
-                mLastEnvData.press = data->press*PRESS_SCALE_NEW;
-                mLastEnvData.humid = data->humid*HUMID_SCALE_NEW;
-            }
-            else
-            {
-                mLastEnvData.press = data->press*PRESS_SCALE_OLD;
-                mLastEnvData.humid = data->humid*HUMID_SCALE_OLD;
-            }
-            mNewEnvData = true;
-            mEnvMutex.unlock();
-
-            //std::string msg = std::to_string(mLastENVData.timestamp);
-            //INFO_OUT(msg);
+            mLastEnvData.press = data->press*PRESS_SCALE_NEW;
+            mLastEnvData.humid = data->humid*HUMID_SCALE_NEW;
         }
         else
         {
-            if(data->env_valid==0)
-                mLastEnvData.valid = data::Environment::NOT_PRESENT;
-            else if(data->env_valid==1)
-                mLastEnvData.valid = data::Environment::OLD_VAL;
-            else
-                mLastEnvData.valid = data::Environment::NEW_VAL;
+            mLastEnvData.press = data->press*PRESS_SCALE_OLD;
+            mLastEnvData.humid = data->humid*HUMID_SCALE_OLD;
         }
-        // <---- Environmental data
+        mNewEnvData = true;
+        mEnvMutex.unlock();
 
-        // ----> Camera sensors temperature data
-        if(data->temp_cam_left != TEMP_NOT_VALID &&
-                data->temp_cam_left != TEMP_NOT_VALID &&
-                data->env_valid == data::Environment::NEW_VAL ) // Sensor temperature is linked to Environmental data acquisition at FW level
-        {
-            mCamTempMutex.lock();
-            mLastCamTempData.valid = data::Temperature::NEW_VAL;
-            mLastCamTempData.timestamp = current_data_ts;
-            mLastCamTempData.temp_left = data->temp_cam_left*TEMP_SCALE;
-            mLastCamTempData.temp_right = data->temp_cam_right*TEMP_SCALE;
-            mNewCamTempData=true;
-            mCamTempMutex.unlock();
-
-            //std::string msg = std::to_string(mLastCamTempData.timestamp);
-            //INFO_OUT(msg);
-        }
+        //std::string msg = std::to_string(mLastENVData.timestamp);
+        //INFO_OUT(msg);
+    }
+    else
+    {
+        if(data->env_valid==0)
+            mLastEnvData.valid = data::Environment::NOT_PRESENT;
+        else if(data->env_valid==1)
+            mLastEnvData.valid = data::Environment::OLD_VAL;
         else
-        {
-            mLastCamTempData.valid = data::Temperature::OLD_VAL;
-        }
-        // <---- Camera sensors temperature data
+            mLastEnvData.valid = data::Environment::NEW_VAL;
     }
+    // <---- Environmental data
 
-    mGrabRunning = false;
+    // ----> Camera sensors temperature data
+    if(data->temp_cam_left != TEMP_NOT_VALID &&
+            data->temp_cam_left != TEMP_NOT_VALID &&
+            data->env_valid == data::Environment::NEW_VAL ) // Sensor temperature is linked to Environmental data acquisition at FW level
+    {
+        mCamTempMutex.lock();
+        mLastCamTempData.valid = data::Temperature::NEW_VAL;
+        mLastCamTempData.timestamp = data_ts;
+        mLastCamTempData.timestamp_mono = current_data_ts;
+        mLastCamTempData.timestamp_wall = data_ts_wall;
+        mLastCamTempData.temp_left = data->temp_cam_left*TEMP_SCALE;
+        mLastCamTempData.temp_right = data->temp_cam_right*TEMP_SCALE;
+        mNewCamTempData=true;
+        mCamTempMutex.unlock();
+
+        //std::string msg = std::to_string(mLastCamTempData.timestamp);
+        //INFO_OUT(msg);
+    }
+    else
+    {
+        mLastCamTempData.valid = data::Temperature::OLD_VAL;
+    }
+    // <---- Camera sensors temperature data
+
+    return true;
 }
 
 #ifdef VIDEO_MOD_AVAILABLE
 void SensorCapture::updateTimestampOffset( uint64_t frame_ts)
 {
+    TRACE_SCOPE("ts offset update");
+
     static int64_t offset_sum = 0;
     static int count = 0;
     offset_sum += (static_cast<int64_t>(mSyncTs) - static_cast<int64_t>(frame_ts));
@@ -571,6 +662,7 @@ void SensorCapture::updateTimestampOffset( uint64_t frame_ts)
     {
         int64_t offset = offset_sum/count;
         mSyncOffset += offset;
+        if(mMetSyncOffset) mMetSyncOffset->set(static_cast<double>(mSyncOffset)*1e-9);
 #if 0
         std::cout << "Offset: " << offset << std::endl;
         std::cout << "mSyncOffset: " << mSyncOffset << std::endl;
@@ -0,0 +1,413 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "shmframering.hpp"
+
+#include <errno.h>            // for errno
+#include <signal.h>           // for kill
+#include <fcntl.h>            // for O_CREAT, O_RDWR, O_RDONLY
+#include <unistd.h>           // for usleep, close, ftruncate
+#include <sys/mman.h>         // for shm_open, shm_unlink, mmap, munmap
+#include <sys/stat.h>         // for fstat
+
+#include <new>                // for placement new
+
+namespace sl_oc {
+
+namespace video {
+
+static inline std::string shmName(std::string name)
+{
+    if(name.empty() || name[0]!='/')
+        name = "/" + name;
+    return name;
+}
+
+static inline uint8_t* slotAddress(const uint8_t* base, const ShmRingHeader* hdr, uint64_t seq)
+{
+    uint64_t slot = (seq-1) % hdr->slot_count;
+    return const_cast<uint8_t*>(base) + sizeof(ShmRingHeader) + slot*hdr->slot_stride;
+}
+
+// Check if an existing segment was left by a publisher that is no longer running
+static bool isStaleRing(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd==-1)
+        return (errno==ENOENT);
+
+    struct stat st;
+    bool stale = true;
+    if(fstat(fd, &st)==0 && static_cast<size_t>(st.st_size)>=sizeof(ShmRingHeader))
+    {
+        void* addr = mmap(nullptr, sizeof(ShmRingHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if(addr!=MAP_FAILED)
+        {
+            const ShmRingHeader* hdr = static_cast<const ShmRingHeader*>(addr);
+
+            // A segment with an unknown layout cannot be attributed: it is kept
+            if(hdr->magic==SHM_RING_MAGIC && hdr->version!=SHM_RING_VERSION)
+                stale = false;
+            else if(hdr->magic==SHM_RING_MAGIC && hdr->owner_pid>0)
+                stale = (kill(hdr->owner_pid, 0)==-1 && errno==ESRCH);
+
+            munmap(addr, sizeof(ShmRingHeader));
+        }
+    }
+    ::close(fd);
+
+    return stale;
+}
+
+// ----> ShmFramePublisher
+ShmFramePublisher::ShmFramePublisher(int verbose_lvl)
+{
+    mVerbose = verbose_lvl;
+}
+
+ShmFramePublisher::~ShmFramePublisher()
+{
+    destroy();
+}
+
+bool ShmFramePublisher::create(std::string name, uint16_t width, uint16_t height, uint8_t channels,
+                               int serial_number, uint8_t slot_count)
+{
+    destroy();
+
+    if(slot_count<2)
+        slot_count=2;
+
+    mName = shmName(name);
+
+    uint32_t data_size = static_cast<uint32_t>(width)*height*channels;
+    uint32_t slot_stride = sizeof(ShmSlotHeader) + data_size;
+    slot_stride = (slot_stride + 63) & ~63U; // Keep each slot 64 bytes aligned
+
+    mMapSize = sizeof(ShmRingHeader) + static_cast<size_t>(slot_stride)*slot_count;
+
+    int fd = shm_open(mName.c_str(), O_CREAT|O_EXCL|O_RDWR, 0644);
+    if(fd==-1 && errno==EEXIST)
+    {
+        // Remove a stale segment left by a crashed publisher, never a ring still in use
+        if(!isStaleRing(mName))
+        {
+            std::string msg = std::string("The shared memory '") + mName + "' is used by another publisher";
+            ERROR_OUT(mVerbose,msg);
+            mName.clear();
+            return false;
+        }
+
+        shm_unlink(mName.c_str());
+        fd = shm_open(mName.c_str(), O_CREAT|O_EXCL|O_RDWR, 0644);
+    }
+    if(fd==-1)
+    {
+        std::string msg = std::string("Cannot create the shared memory '") + mName + "': ["
+                + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+        ERROR_OUT(mVerbose,msg);
+        return false;
+    }
+
+    if(ftruncate(fd, mMapSize)==-1)
+    {
+        std::string msg = std::string("Cannot resize the shared memory '") + mName + "': ["
+                + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+        ERROR_OUT(mVerbose,msg);
+        ::close(fd);
+        shm_unlink(mName.c_str());
+        return false;
+    }
+
+    void* addr = mmap(nullptr, mMapSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the segment alive
+
+    if(addr==MAP_FAILED)
+    {
+        std::string msg = std::string("Cannot map the shared memory '") + mName + "': ["
+                + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+        ERROR_OUT(mVerbose,msg);
+        shm_unlink(mName.c_str());
+        return false;
+    }
+
+    mBase = static_cast<uint8_t*>(addr);
+
+    // ----> Ring initialization
+    for(uint8_t s=0; s<slot_count; s++)
+    {
+        ShmSlotHeader* slot = new (mBase + sizeof(ShmRingHeader) + s*slot_stride) ShmSlotHeader;
+        slot->seq.store(0, std::memory_order_relaxed);
+    }
+
+    mHeader = new (mBase) ShmRingHeader;
+    mHeader->version = SHM_RING_VERSION;
+    mHeader->slot_count = slot_count;
+    mHeader->slot_stride = slot_stride;
+    mHeader->data_size = data_size;
+    mHeader->width = width;
+    mHeader->height = height;
+    mHeader->channels = channels;
+    mHeader->serial_number = serial_number;
+    mHeader->owner_pid = static_cast<int32_t>(getpid());
+    mHeader->write_count.store(0, std::memory_order_relaxed);
+
+    // The magic value is written last: subscribers refuse the ring until it is fully initialized
+    std::atomic_thread_fence(std::memory_order_release);
+    mHeader->magic = SHM_RING_MAGIC;
+    // <---- Ring initialization
+
+    if(mVerbose)
+    {
+        std::string msg = std::string("Shared memory frame ring '") + mName + "' created: "
+                + std::to_string(slot_count) + " slots of " + std::to_string(data_size) + " bytes";
+        INFO_OUT(mVerbose,msg);
+    }
+
+    return true;
+}
+
+void ShmFramePublisher::destroy()
+{
+    if(!mBase)
+        return;
+
+    munmap(mBase, mMapSize);
+    shm_unlink(mName.c_str());
+
+    mBase = nullptr;
+    mHeader = nullptr;
+    mMapSize = 0;
+}
+
+void ShmFramePublisher::publish(const uint8_t* data, size_t size, uint64_t frame_id, uint64_t timestamp)
+{
+    if(!mHeader || !data)
+        return;
+
+    uint64_t seq = mHeader->write_count.load(std::memory_order_relaxed) + 1;
+
+    uint8_t* slot_addr = slotAddress(mBase, mHeader, seq);
+    ShmSlotHeader* slot = reinterpret_cast<ShmSlotHeader*>(slot_addr);
+
+    // Odd sequence: readers of the previous content of the slot will detect the overwrite
+    slot->seq.store(2*seq-1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->frame_id = frame_id;
+    slot->timestamp = timestamp;
+    memcpy(slot_addr+sizeof(ShmSlotHeader), data, size<mHeader->data_size?size:mHeader->data_size);
+
+    slot->seq.store(2*seq, std::memory_order_release);
+    mHeader->write_count.store(seq, std::memory_order_release);
+}
+// <---- ShmFramePublisher
+
+// ----> ShmFrameSubscriber
+ShmFrameSubscriber::ShmFrameSubscriber(int verbose_lvl)
+{
+    mVerbose = verbose_lvl;
+}
+
+ShmFrameSubscriber::~ShmFrameSubscriber()
+{
+    close();
+}
+
+bool ShmFrameSubscriber::open(std::string name)
+{
+    close();
+
+    name = shmName(name);
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd==-1)
+    {
+        if(mVerbose)
+        {
+            std::string msg = std::string("Cannot open the shared memory '") + name + "': ["
+                    + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+            ERROR_OUT(mVerbose,msg);
+        }
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st)==-1 || static_cast<size_t>(st.st_size)<sizeof(ShmRingHeader))
+    {
+        ERROR_OUT(mVerbose,std::string("Invalid shared memory size for '") + name + "'");
+        ::close(fd);
+        return false;
+    }
+
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if(addr==MAP_FAILED)
+    {
+        std::string msg = std::string("Cannot map the shared memory '") + name + "': ["
+                + std::to_string(errno) + std::string("] ") + std::string(strerror(errno));
+        ERROR_OUT(mVerbose,msg);
+        return false;
+    }
+
+    mBase = static_cast<const uint8_t*>(addr);
+    mMapSize = st.st_size;
+    mHeader = reinterpret_cast<const ShmRingHeader*>(mBase);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if(mHeader->magic!=SHM_RING_MAGIC || mHeader->version!=SHM_RING_VERSION ||
+            sizeof(ShmRingHeader)+static_cast<size_t>(mHeader->slot_stride)*mHeader->slot_count>mMapSize)
+    {
+        ERROR_OUT(mVerbose,std::string("The shared memory '") + name + "' is not a valid frame ring");
+        close();
+        return false;
+    }
+
+    // Start reading from the current position of the publisher
+    mLastSeq = mHeader->write_count.load(std::memory_order_acquire);
+    mDropped = 0;
+
+    if(mVerbose)
+    {
+        std::string msg = std::string("Shared memory frame ring '") + name + "' opened: "
+                + std::to_string(mHeader->width) + "x" + std::to_string(mHeader->height)
+                + " - SN: " + std::to_string(mHeader->serial_number);
+        INFO_OUT(mVerbose,msg);
+    }
+
+    return true;
+}
+
+void ShmFrameSubscriber::close()
+{
+    if(!mBase)
+        return;
+
+    munmap(const_cast<uint8_t*>(mBase), mMapSize);
+
+    mBase = nullptr;
+    mHeader = nullptr;
+    mMapSize = 0;
+}
+
+bool ShmFrameSubscriber::readSlot(uint64_t seq, ShmFrame& frame)
+{
+    const uint8_t* slot_addr = slotAddress(mBase, mHeader, seq);
+    const ShmSlotHeader* slot = reinterpret_cast<const ShmSlotHeader*>(slot_addr);
+
+    if(slot->seq.load(std::memory_order_acquire)!=2*seq)
+        return false;
+
+    frame.seq = seq;
+    frame.frame_id = slot->frame_id;
+    frame.timestamp = slot->timestamp;
+    frame.data = slot_addr+sizeof(ShmSlotHeader);
+    frame.width = mHeader->width;
+    frame.height = mHeader->height;
+    frame.channels = mHeader->channels;
+
+    // The metadata must not have been overwritten while reading them
+    return isValid(frame);
+}
+
+bool ShmFrameSubscriber::isValid(const ShmFrame& frame) const
+{
+    if(!mHeader || frame.seq==0)
+        return false;
+
+    const ShmSlotHeader* slot = reinterpret_cast<const ShmSlotHeader*>(slotAddress(mBase, mHeader, frame.seq));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot->seq.load(std::memory_order_relaxed)==2*frame.seq;
+}
+
+bool ShmFrameSubscriber::getLatestFrame(ShmFrame& frame)
+{
+    if(!mHeader)
+        return false;
+
+    // Retry if the publisher overwrites the slot while we read it
+    for(int i=0; i<3; i++)
+    {
+        uint64_t seq = mHeader->write_count.load(std::memory_order_acquire);
+        if(seq==0)
+            return false;
+
+        if(readSlot(seq, frame))
+        {
+            mLastSeq = seq;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ShmFrameSubscriber::getNextFrame(ShmFrame& frame, uint64_t timeout_msec)
+{
+    if(!mHeader)
+        return false;
+
+    // ----> Wait for a new frame
+    uint64_t time_count = timeout_msec*10;
+    uint64_t write_count = mHeader->write_count.load(std::memory_order_acquire);
+    while( write_count<=mLastSeq )
+    {
+        if(time_count==0)
+        {
+            return false;
+        }
+        time_count--;
+        usleep(100);
+        write_count = mHeader->write_count.load(std::memory_order_acquire);
+    }
+    // <---- Wait for a new frame
+
+    uint64_t seq = mLastSeq+1;
+
+    // Skip the frames already overwritten by the publisher. One slot is left as margin
+    // because it could be written while we read it
+    uint64_t oldest = (write_count>=mHeader->slot_count)?(write_count-mHeader->slot_count+2):1;
+    if(seq<oldest)
+    {
+        mDropped += oldest-seq;
+        seq = oldest;
+    }
+
+    for(; seq<=write_count; seq++)
+    {
+        if(readSlot(seq, frame))
+        {
+            mLastSeq = seq;
+            return true;
+        }
+        mDropped++;
+    }
+
+    mLastSeq = write_count;
+    return false;
+}
+// <---- ShmFrameSubscriber
+
+}
+
+}
@@ -0,0 +1,323 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "timinganalyzer.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace sl_oc {
+
+static const uint64_t TIMING_SUB_BINS = 1ULL << TIMING_SUB_BINS_BITS;     //!< Bins for each power of two
+static const size_t TIMING_HALF_BINS = TIMING_SUB_BINS + (63-TIMING_SUB_BINS_BITS)*TIMING_SUB_BINS; //!< Bins for each sign
+
+// ----> Histogram bins
+// The magnitudes below `TIMING_SUB_BINS` have one bin each, the others are split in `TIMING_SUB_BINS` bins for
+// each power of two. Negative values use the bins below `TIMING_HALF_BINS` in reversed order
+static inline size_t magnitudeBin(uint64_t mag)
+{
+    if(mag<TIMING_SUB_BINS)
+        return static_cast<size_t>(mag);
+
+    int exp = 63-__builtin_clzll(mag);
+    int shift = exp-TIMING_SUB_BINS_BITS;
+    uint64_t sub = (mag >> shift) & (TIMING_SUB_BINS-1);
+    return static_cast<size_t>(TIMING_SUB_BINS + shift*TIMING_SUB_BINS + sub);
+}
+
+static inline void magnitudeBounds(size_t bin, double& lo, double& hi)
+{
+    if(bin<TIMING_SUB_BINS)
+    {
+        lo = hi = static_cast<double>(bin);
+        return;
+    }
+
+    int shift = static_cast<int>((bin-TIMING_SUB_BINS)/TIMING_SUB_BINS);
+    uint64_t sub = (bin-TIMING_SUB_BINS)%TIMING_SUB_BINS;
+    lo = static_cast<double>((TIMING_SUB_BINS+sub) << shift);
+    hi = lo + static_cast<double>((1ULL << shift) - 1);
+}
+
+size_t RollingStats::binIndex(int64_t value)
+{
+    if(value>=0)
+        return TIMING_HALF_BINS + magnitudeBin(static_cast<uint64_t>(value));
+
+    uint64_t mag = (value==std::numeric_limits<int64_t>::min())?
+                static_cast<uint64_t>(std::numeric_limits<int64_t>::max()):static_cast<uint64_t>(-value);
+    return TIMING_HALF_BINS - 1 - magnitudeBin(mag);
+}
+
+void RollingStats::binBounds(size_t idx, double& lo, double& hi)
+{
+    if(idx>=TIMING_HALF_BINS)
+    {
+        magnitudeBounds(idx-TIMING_HALF_BINS, lo, hi);
+        return;
+    }
+
+    double mag_lo, mag_hi;
+    magnitudeBounds(TIMING_HALF_BINS-1-idx, mag_lo, mag_hi);
+    lo = -mag_hi;
+    hi = -mag_lo;
+}
+// <---- Histogram bins
+
+RollingStats::RollingStats( size_t window )
+{
+    mWindow = std::max<size_t>(1, window);
+}
+
+void RollingStats::reset(size_t window)
+{
+    if(window!=0)
+        mWindow = window;
+
+    mValues.clear();
+    mBins.clear();
+    mCount = 0;
+    mTotal = 0;
+    mSum = 0;
+    mMaxQueue.clear();
+    mMinQueue.clear();
+}
+
+void RollingStats::add(int64_t value)
+{
+    // The buffers are allocated with the first sample: unused statistics have no memory cost
+    if(mValues.empty())
+    {
+        mValues.resize(mWindow);
+        mBins.assign(2*TIMING_HALF_BINS, 0);
+    }
+
+    size_t pos = static_cast<size_t>(mTotal%mWindow);
+
+    // ----> Remove the oldest sample
+    if(mCount==mWindow)
+    {
+        int64_t old = mValues[pos];
+        mSum -= old;
+        mBins[binIndex(old)]--;
+        mCount--;
+    }
+    // <---- Remove the oldest sample
+
+    mValues[pos] = value;
+    mSum += value;
+    mBins[binIndex(value)]++;
+    mCount++;
+
+    // ----> Extrema of the window
+    while(!mMaxQueue.empty() && mMaxQueue.back().second<=value)
+        mMaxQueue.pop_back();
+    mMaxQueue.push_back(std::make_pair(mTotal, value));
+    while(mMaxQueue.front().first+mWindow<=mTotal)
+        mMaxQueue.pop_front();
+
+    while(!mMinQueue.empty() && mMinQueue.back().second>=value)
+        mMinQueue.pop_back();
+    mMinQueue.push_back(std::make_pair(mTotal, value));
+    while(mMinQueue.front().first+mWindow<=mTotal)
+        mMinQueue.pop_front();
+    // <---- Extrema of the window
+
+    mTotal++;
+}
+
+double RollingStats::getPercentile(double p) const
+{
+    if(mCount==0)
+        return 0.0;
+
+    p = std::min(1.0, std::max(0.0, p));
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p*mCount)));
+
+    uint64_t cumul = 0;
+    for(size_t i=0; i<mBins.size(); i++)
+    {
+        if(cumul+mBins[i]>=rank)
+        {
+            // The samples are supposed uniformly distributed inside the bin
+            double lo, hi;
+            binBounds(i, lo, hi);
+            double val = lo + (hi-lo)*(static_cast<double>(rank-cumul)-0.5)/mBins[i];
+
+            // The extrema are exact: the interpolated value is limited to them
+            val = std::max(val, static_cast<double>(mMinQueue.front().second));
+            val = std::min(val, static_cast<double>(mMaxQueue.front().second));
+            return val;
+        }
+        cumul += mBins[i];
+    }
+
+    return static_cast<double>(mMaxQueue.front().second);
+}
+
+StatsSummary RollingStats::getSummary() const
+{
+    StatsSummary summary;
+    if(mCount==0)
+        return summary;
+
+    summary.count = mCount;
+    summary.mean = getMean();
+    summary.p50 = getPercentile(0.50);
+    summary.p99 = getPercentile(0.99);
+    summary.min = static_cast<double>(mMinQueue.front().second);
+    summary.max = static_cast<double>(mMaxQueue.front().second);
+
+    return summary;
+}
+
+TimingAnalyzer::TimingAnalyzer( size_t window )
+    : mPeriod(window)
+    , mJitter(window)
+    , mSkew(window)
+    , mSyncOffset(window)
+{
+}
+
+void TimingAnalyzer::setNominalPeriod(uint64_t period_nsec)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    mNominalPeriod = period_nsec;
+}
+
+void TimingAnalyzer::reset(size_t window)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    mPeriod.reset(window);
+    mJitter.reset(window);
+    mSkew.reset(window);
+    mSyncOffset.reset(window);
+
+    mLastTs = 0;
+    mFrames = 0;
+    mLateFrames = 0;
+    mSyncs = 0;
+    mRecentFrames.clear();
+    mPendingSyncs.clear();
+}
+
+void TimingAnalyzer::addFrame(uint64_t ts, uint64_t rx_ts)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    mFrames++;
+
+    if(rx_ts!=0)
+        mSkew.add(static_cast<int64_t>(rx_ts-ts));
+
+    // ----> Period and jitter
+    if(mLastTs!=0 && ts>mLastTs)
+    {
+        int64_t period = static_cast<int64_t>(ts-mLastTs);
+
+        double nominal = static_cast<double>(mNominalPeriod);
+        if(nominal==0.0)
+            nominal = mPeriod.getMean();
+
+        if(nominal>0.0)
+        {
+            mJitter.add(period-static_cast<int64_t>(std::llround(nominal)));
+            if(period>TIMING_LATE_FACTOR*nominal)
+                mLateFrames++;
+        }
+
+        mPeriod.add(period);
+    }
+    mLastTs = ts;
+    // <---- Period and jitter
+
+    // ----> IMU sync signals received before the frame
+    for(auto it=mPendingSyncs.begin(); it!=mPendingSyncs.end(); ++it)
+    {
+        uint64_t prev = mSyncs;
+        matchSync(ts, *it);
+        if(mSyncs!=prev)
+        {
+            mPendingSyncs.erase(it);
+            break;
+        }
+    }
+
+    mRecentFrames.push_back(ts);
+    if(mRecentFrames.size()>TIMING_SYNC_HISTORY)
+        mRecentFrames.pop_front();
+    // <---- IMU sync signals received before the frame
+}
+
+void TimingAnalyzer::addImuSync(uint64_t ts)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    // ----> Frames received before the IMU sync signal
+    uint64_t prev = mSyncs;
+    for(auto it=mRecentFrames.rbegin(); it!=mRecentFrames.rend() && mSyncs==prev; ++it)
+        matchSync(*it, ts);
+
+    if(mSyncs!=prev)
+        return;
+    // <---- Frames received before the IMU sync signal
+
+    mPendingSyncs.push_back(ts);
+    if(mPendingSyncs.size()>TIMING_SYNC_HISTORY)
+        mPendingSyncs.pop_front();
+}
+
+void TimingAnalyzer::matchSync(uint64_t frame_ts, uint64_t sync_ts)
+{
+    // A sync signal belongs to a frame if it is closer than half a period
+    double period = static_cast<double>(mNominalPeriod);
+    if(period==0.0)
+        period = (mPeriod.getCount()>0)?mPeriod.getMean():1e8;
+
+    int64_t offset = static_cast<int64_t>(sync_ts-frame_ts);
+    if(std::llabs(offset)>=period/2.0)
+        return;
+
+    mSyncOffset.add(offset);
+    mSyncs++;
+}
+
+TimingReport TimingAnalyzer::getReport()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    TimingReport report;
+    report.frames = mFrames;
+    report.late_frames = mLateFrames;
+    report.syncs = mSyncs;
+    report.nominal_period = static_cast<double>(mNominalPeriod);
+    if(report.nominal_period==0.0)
+        report.nominal_period = mPeriod.getMean();
+
+    report.period = mPeriod.getSummary();
+    report.jitter = mJitter.getSummary();
+    report.arrival_skew = mSkew.getSummary();
+    report.sync_offset = mSyncOffset.getSummary();
+
+    return report;
+}
+
+}
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "tonecurve.hpp"
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace sl_oc {
+
+namespace video {
+
+static const size_t TONE_COPY_BLOCK = 8*1024;   // Bytes copied before being mapped, small enough to stay in L1
+
+ToneCurve::ToneCurve()
+{
+    for(int i=0; i<TONE_CURVE_SIZE; i++)
+        lut[i] = static_cast<uint8_t>(i);
+}
+
+ToneCurve ToneCurve::gamma(float gamma)
+{
+    ToneCurve curve;
+    if(gamma<=0.0f)
+        return curve;
+
+    const double exp = 1.0/gamma;
+    for(int i=0; i<TONE_CURVE_SIZE; i++)
+    {
+        double val = 255.0*std::pow(i/255.0, exp);
+        curve.lut[i] = static_cast<uint8_t>(std::min(255.0, std::round(val)));
+    }
+    return curve;
+}
+
+ToneCurve ToneCurve::fromPoints(const std::vector<std::pair<uint8_t,uint8_t>>& points)
+{
+    ToneCurve curve;
+    if(points.empty())
+        return curve;
+
+    size_t p = 0;
+    for(int i=0; i<TONE_CURVE_SIZE; i++)
+    {
+        while(p<points.size() && points[p].first<i)
+            p++;
+
+        if(p==0)
+            curve.lut[i] = points.front().second;
+        else if(p==points.size())
+            curve.lut[i] = points.back().second;
+        else
+        {
+            const std::pair<uint8_t,uint8_t>& a = points[p-1];
+            const std::pair<uint8_t,uint8_t>& b = points[p];
+            double t = (b.first==a.first)?1.0:static_cast<double>(i-a.first)/(b.first-a.first);
+            curve.lut[i] = static_cast<uint8_t>(std::round(a.second + t*(b.second-a.second)));
+        }
+    }
+    return curve;
+}
+
+void ToneCurve::apply(uint8_t* yuyv, size_t pixels) const
+{
+    size_t i = 0;
+
+#if defined(__aarch64__)
+    // The 256 entries are looked up with four 64 byte tables: `vqtbx4q_u8` leaves the lanes with an index out of
+    // its table unchanged
+    const uint8x16x4_t t0 = {{vld1q_u8(lut), vld1q_u8(lut+16), vld1q_u8(lut+32), vld1q_u8(lut+48)}};
+    const uint8x16x4_t t1 = {{vld1q_u8(lut+64), vld1q_u8(lut+80), vld1q_u8(lut+96), vld1q_u8(lut+112)}};
+    const uint8x16x4_t t2 = {{vld1q_u8(lut+128), vld1q_u8(lut+144), vld1q_u8(lut+160), vld1q_u8(lut+176)}};
+    const uint8x16x4_t t3 = {{vld1q_u8(lut+192), vld1q_u8(lut+208), vld1q_u8(lut+224), vld1q_u8(lut+240)}};
+    const uint8x16_t off = vdupq_n_u8(64);
+    for(; i+16<=pixels; i+=16)
+    {
+        // Y0 U Y1 V ... -> val[0] contains the luma bytes
+        uint8x16x2_t v = vld2q_u8(yuyv+2*i);
+        uint8x16_t idx = v.val[0];
+        uint8x16_t res = vqtbl4q_u8(t0, idx);
+        idx = vsubq_u8(idx, off);
+        res = vqtbx4q_u8(res, t1, idx);
+        idx = vsubq_u8(idx, off);
+        res = vqtbx4q_u8(res, t2, idx);
+        idx = vsubq_u8(idx, off);
+        res = vqtbx4q_u8(res, t3, idx);
+        v.val[0] = res;
+        vst2q_u8(yuyv+2*i, v);
+    }
+#else
+    // SSE2 has no byte shuffle: a table of 256 entries is faster with scalar loads, four pixels per iteration
+    // with all the loads before the stores
+    for(; i+4<=pixels; i+=4)
+    {
+        uint8_t* p = yuyv+2*i;
+        uint8_t y0 = lut[p[0]];
+        uint8_t y1 = lut[p[2]];
+        uint8_t y2 = lut[p[4]];
+        uint8_t y3 = lut[p[6]];
+        p[0] = y0;
+        p[2] = y1;
+        p[4] = y2;
+        p[6] = y3;
+    }
+#endif
+
+    for(; i<pixels; i++)
+        yuyv[2*i] = lut[yuyv[2*i]];
+}
+
+void ToneCurve::copy(uint8_t* dst, const uint8_t* src, size_t size) const
+{
+    size_t done = 0;
+    while(done<size)
+    {
+        size_t block = std::min(TONE_COPY_BLOCK, size-done);
+        memcpy(dst+done, src+done, block);
+        apply(dst+done, block/2);
+        done += block;
+    }
+}
+
+}
+
+}
@@ -0,0 +1,425 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "trace.hpp"
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+#include <unistd.h>           // for getpid, syscall
+#include <sys/syscall.h>      // for SYS_gettid
+
+namespace sl_oc {
+
+/*!
+ * \brief The event ring of a thread. Written only by its thread, read when the trace is saved
+ */
+struct TraceRing
+{
+    std::unique_ptr<TraceEvent[]> events;   // Event storage
+    uint64_t mask = 0;                      // Storage size - 1
+    std::atomic<uint64_t> write{0};         // Number of events written since the creation
+    std::atomic<uint64_t> clear_from{0};    // Index of the first event not discarded by Tracer::clear
+    int tid = 0;                            // Kernel thread id
+    std::string name;                       // Thread name
+    bool alive = true;                      // False when its thread has exited. Protected by the ring mutex
+};
+
+static const size_t TRACE_MAX_DEAD_RINGS = 8;  // Rings of exited threads kept until the trace is saved
+
+std::atomic<bool> Tracer::sEnabled{false};
+
+static std::mutex& ringMutex()
+{
+    static std::mutex m;
+    return m;
+}
+
+static std::vector<std::shared_ptr<TraceRing>>& rings()
+{
+    static std::vector<std::shared_ptr<TraceRing>> r;
+    return r;
+}
+
+static size_t sBufferSize = TRACE_DEFAULT_BUFFER_SIZE;
+static thread_local TraceRing* tRing = nullptr;
+static thread_local bool tExited = false;
+
+/*!
+ * \brief Marks the ring of a thread as dead when the thread exits, so that it can be saved and then recycled
+ */
+struct TraceRingOwner
+{
+    bool used = false;      // Set at the first event: the access constructs the object and registers its destructor
+
+    ~TraceRingOwner()
+    {
+        tExited = true;
+        if(!tRing)
+            return;
+
+        const std::lock_guard<std::mutex> lock(ringMutex());
+        tRing->alive = false;
+        tRing = nullptr;
+    }
+};
+static thread_local TraceRingOwner tRingOwner;
+
+static TraceRing* threadRing()
+{
+    if(tRing || tExited)
+        return tRing;
+
+    tRingOwner.used = true;
+
+    const int tid = static_cast<int>(syscall(SYS_gettid));
+
+    const std::lock_guard<std::mutex> lock(ringMutex());
+
+    size_t size = 1;
+    while(size<sBufferSize)
+        size <<= 1;
+
+    // ----> Recycle the ring of an exited thread
+    // A ring with no unsaved event is reused first. If too many exited threads have unsaved events, the oldest
+    // ring is reused and its events are lost, as when a ring is full
+    std::vector<std::shared_ptr<TraceRing>>& all = rings();
+    std::shared_ptr<TraceRing> ring;
+    size_t dead = 0;
+    for(auto& r : all)
+    {
+        if(r->alive)
+            continue;
+        dead++;
+        if(!ring && r->write.load(std::memory_order_relaxed)==r->clear_from.load(std::memory_order_relaxed))
+            ring = r;
+    }
+    if(!ring && dead>=TRACE_MAX_DEAD_RINGS)
+    {
+        for(auto& r : all)
+        {
+            if(!r->alive)
+            {
+                ring = r;
+                break;
+            }
+        }
+    }
+    // <---- Recycle the ring of an exited thread
+
+    if(ring)
+    {
+        // Moved to the end: the rings are ordered from the oldest exited thread
+        all.erase(std::find(all.begin(), all.end(), ring));
+        ring->write.store(0, std::memory_order_relaxed);
+        ring->clear_from.store(0, std::memory_order_relaxed);
+    }
+    else
+        ring = std::make_shared<TraceRing>();
+
+    if(!ring->events || ring->mask+1!=size)
+    {
+        ring->events.reset(new TraceEvent[size]);
+        ring->mask = size-1;
+    }
+
+    ring->tid = tid;
+    ring->name = "thread " + std::to_string(tid);
+    ring->alive = true;
+
+    all.push_back(ring);
+    tRing = ring.get();
+
+    return tRing;
+}
+
+void Tracer::enable(bool enable)
+{
+    sEnabled.store(enable, std::memory_order_relaxed);
+}
+
+void Tracer::setBufferSize(size_t events)
+{
+    const std::lock_guard<std::mutex> lock(ringMutex());
+    sBufferSize = std::max<size_t>(events, 16);
+}
+
+void Tracer::setThreadName(const std::string& name)
+{
+    TraceRing* ring = threadRing();
+    if(!ring)
+        return;
+
+    const std::lock_guard<std::mutex> lock(ringMutex());
+    ring->name = name;
+}
+
+void Tracer::record(const char* name, uint64_t start, uint64_t end)
+{
+    TraceRing* ring = threadRing();
+    if(!ring)
+        return; // Called by a thread local destructor after the exit of the thread
+
+    uint64_t idx = ring->write.load(std::memory_order_relaxed);
+    TraceEvent& evt = ring->events[idx & ring->mask];
+    evt.name = name;
+    evt.start = start;
+    evt.dur = end-start;
+    ring->write.store(idx+1, std::memory_order_release);
+}
+
+void Tracer::clear()
+{
+    const std::lock_guard<std::mutex> lock(ringMutex());
+
+    for(auto& ring : rings())
+        ring->clear_from.store(ring->write.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+/*!
+ * \brief Events of a thread copied out of its ring
+ */
+struct TraceThread
+{
+    int tid;
+    std::string name;
+    std::vector<TraceEvent> events;
+};
+
+/*!
+ * \brief Copy the events of all the rings. The events overwritten by their thread while copying are discarded.
+ *        The rings of the exited threads are freed once copied
+ */
+static void snapshot(std::vector<TraceThread>& threads)
+{
+    const std::lock_guard<std::mutex> lock(ringMutex());
+
+    threads.clear();
+    for(auto& ring : rings())
+    {
+        uint64_t size = ring->mask+1;
+        uint64_t end = ring->write.load(std::memory_order_acquire);
+        uint64_t begin = std::max(ring->clear_from.load(std::memory_order_relaxed), (end>size)?(end-size):0);
+
+        TraceThread th;
+        th.tid = ring->tid;
+        th.name = ring->name;
+        th.events.reserve(end-begin);
+        for(uint64_t i=begin; i<end; i++)
+            th.events.push_back(ring->events[i & ring->mask]);
+
+        // Drop the events overwritten in the meanwhile
+        uint64_t end_after = ring->write.load(std::memory_order_acquire);
+        if(end_after>begin+size)
+        {
+            size_t lost = std::min<size_t>(end_after-size-begin, th.events.size());
+            th.events.erase(th.events.begin(), th.events.begin()+lost);
+        }
+
+        if(!th.events.empty())
+            threads.push_back(std::move(th));
+    }
+
+    std::vector<std::shared_ptr<TraceRing>>& all = rings();
+    all.erase(std::remove_if(all.begin(), all.end(), [](const std::shared_ptr<TraceRing>& r){return !r->alive;}),
+              all.end());
+}
+
+static std::string jsonEscape(const std::string& str)
+{
+    std::string out;
+    for(char c : str)
+    {
+        if(c=='"' || c=='\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if(static_cast<unsigned char>(c)<0x20)
+            out += ' ';
+        else
+            out += c;
+    }
+    return out;
+}
+
+bool Tracer::saveChromeTrace(const std::string& filename)
+{
+    std::vector<TraceThread> threads;
+    snapshot(threads);
+
+    std::ofstream file(filename, std::ios::trunc);
+    if(!file.is_open())
+        return false;
+
+    int pid = getpid();
+
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    for(auto& th : threads)
+    {
+        file << (first?"":",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << th.tid
+             << ",\"args\":{\"name\":\"" << jsonEscape(th.name) << "\"}}";
+        first = false;
+
+        char buf[64];
+        for(auto& evt : th.events)
+        {
+            snprintf(buf, sizeof(buf), "\"ts\":%.3f,\"dur\":%.3f", evt.start*1e-3, evt.dur*1e-3);
+            file << ",\n{\"name\":\"" << jsonEscape(evt.name) << "\",\"cat\":\"zed_oc\",\"ph\":\"X\",\"pid\":" << pid
+                 << ",\"tid\":" << th.tid << "," << buf << "}";
+        }
+    }
+    file << "\n]}\n";
+
+    return !file.fail();
+}
+
+// ----> Minimal protobuf encoding
+static void pbVarint(std::string& out, uint64_t val)
+{
+    while(val>=0x80)
+    {
+        out += static_cast<char>((val&0x7F)|0x80);
+        val >>= 7;
+    }
+    out += static_cast<char>(val);
+}
+
+static void pbUint(std::string& out, uint32_t field, uint64_t val)
+{
+    pbVarint(out, static_cast<uint64_t>(field)<<3);
+    pbVarint(out, val);
+}
+
+static void pbBytes(std::string& out, uint32_t field, const std::string& data)
+{
+    pbVarint(out, (static_cast<uint64_t>(field)<<3)|2);
+    pbVarint(out, data.size());
+    out += data;
+}
+// <---- Minimal protobuf encoding
+
+// Field numbers of the Perfetto trace protos (perfetto/trace/trace_packet.proto and track_event/*.proto)
+enum {
+    PF_TRACE_PACKET = 1,                // Trace.packet
+    PF_PACKET_TIMESTAMP = 8,            // TracePacket.timestamp
+    PF_PACKET_SEQ_ID = 10,              // TracePacket.trusted_packet_sequence_id
+    PF_PACKET_TRACK_EVENT = 11,         // TracePacket.track_event
+    PF_PACKET_SEQ_FLAGS = 13,           // TracePacket.sequence_flags
+    PF_PACKET_TRACK_DESC = 60,          // TracePacket.track_descriptor
+    PF_EVENT_TYPE = 9,                  // TrackEvent.type
+    PF_EVENT_TRACK_UUID = 11,           // TrackEvent.track_uuid
+    PF_EVENT_CATEGORIES = 22,           // TrackEvent.categories
+    PF_EVENT_NAME = 23,                 // TrackEvent.name
+    PF_DESC_UUID = 1,                   // TrackDescriptor.uuid
+    PF_DESC_THREAD = 4,                 // TrackDescriptor.thread
+    PF_THREAD_PID = 1,                  // ThreadDescriptor.pid
+    PF_THREAD_TID = 2,                  // ThreadDescriptor.tid
+    PF_THREAD_NAME = 5,                 // ThreadDescriptor.thread_name
+    PF_SLICE_BEGIN = 1,                 // TrackEvent.Type.TYPE_SLICE_BEGIN
+    PF_SLICE_END = 2,                   // TrackEvent.Type.TYPE_SLICE_END
+    PF_SEQ_INCREMENTAL_STATE_CLEARED = 1
+};
+
+bool Tracer::savePerfettoTrace(const std::string& filename)
+{
+    std::vector<TraceThread> threads;
+    snapshot(threads);
+
+    std::ofstream file(filename, std::ios::binary|std::ios::trunc);
+    if(!file.is_open())
+        return false;
+
+    // Perfetto packets are stamped with CLOCK_BOOTTIME by default
+    struct timespec boot;
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    int64_t boot_offset = static_cast<int64_t>(boot.tv_sec)*1000000000LL + boot.tv_nsec
+            - static_cast<int64_t>(getMonotonicTimestamp());
+
+    int pid = getpid();
+    bool first = true;
+
+    for(auto& th : threads)
+    {
+        uint64_t uuid = (static_cast<uint64_t>(pid)<<32) | static_cast<uint32_t>(th.tid);
+
+        // ----> Thread track
+        std::string thread, desc, packet;
+        pbUint(thread, PF_THREAD_PID, pid);
+        pbUint(thread, PF_THREAD_TID, th.tid);
+        pbBytes(thread, PF_THREAD_NAME, th.name);
+        pbUint(desc, PF_DESC_UUID, uuid);
+        pbBytes(desc, PF_DESC_THREAD, thread);
+        pbUint(packet, PF_PACKET_SEQ_ID, 1);
+        if(first)
+            pbUint(packet, PF_PACKET_SEQ_FLAGS, PF_SEQ_INCREMENTAL_STATE_CLEARED);
+        pbBytes(packet, PF_PACKET_TRACK_DESC, desc);
+
+        std::string out;
+        pbBytes(out, PF_TRACE_PACKET, packet);
+        file << out;
+        first = false;
+        // <---- Thread track
+
+        // ----> Slices
+        // Begin/end pairs sorted by time. At the same time the ends come first, nested ends before their parents
+        // and parent begins before nested begins
+        struct Edge {uint64_t ts; bool begin; uint64_t key; const char* name;};
+        std::vector<Edge> edges;
+        edges.reserve(th.events.size()*2);
+        for(auto& evt : th.events)
+        {
+            uint64_t dur = std::max<uint64_t>(evt.dur, 1);
+            edges.push_back({evt.start, true, UINT64_MAX-dur, evt.name});
+            edges.push_back({evt.start+dur, false, UINT64_MAX-evt.start, evt.name});
+        }
+        std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b){
+            if(a.ts!=b.ts) return a.ts<b.ts;
+            if(a.begin!=b.begin) return !a.begin;
+            return a.key<b.key;
+        });
+
+        for(auto& e : edges)
+        {
+            std::string evt, pkt, msg;
+            pbUint(evt, PF_EVENT_TYPE, e.begin?PF_SLICE_BEGIN:PF_SLICE_END);
+            pbUint(evt, PF_EVENT_TRACK_UUID, uuid);
+            if(e.begin)
+            {
+                pbBytes(evt, PF_EVENT_CATEGORIES, "zed_oc");
+                pbBytes(evt, PF_EVENT_NAME, e.name);
+            }
+            pbUint(pkt, PF_PACKET_TIMESTAMP, static_cast<uint64_t>(static_cast<int64_t>(e.ts)+boot_offset));
+            pbUint(pkt, PF_PACKET_SEQ_ID, 1);
+            pbBytes(pkt, PF_PACKET_TRACK_EVENT, evt);
+            pbBytes(msg, PF_TRACE_PACKET, pkt);
+            file << msg;
+        }
+        // <---- Slices
+    }
+
+    return !file.fail();
+}
+
+}
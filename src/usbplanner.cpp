@@ -0,0 +1,301 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "usbplanner.hpp"
+
+#include <fstream>
+#include <map>
+#include <algorithm>
+
+#include <limits.h>           // for PATH_MAX
+#include <stdlib.h>           // for realpath
+
+namespace sl_oc {
+
+namespace video {
+
+UsbBandwidthPlanner::UsbBandwidthPlanner( std::string sysfs_root, int verbose_lvl )
+{
+    mSysfsRoot = sysfs_root;
+    mVerbose = verbose_lvl;
+}
+
+std::string UsbBandwidthPlanner::readSysfs( const std::string& path )
+{
+    std::string line;
+    std::ifstream file(path);
+    if( file.is_open() )
+        std::getline(file, line);
+    return line;
+}
+
+bool UsbBandwidthPlanner::getDeviceInfo( std::string dev_name, UsbDeviceInfo& info )
+{
+    info = UsbDeviceInfo();
+    info.dev_name = dev_name;
+
+    std::string name = dev_name;
+    size_t pos = name.rfind('/');
+    if( pos!=std::string::npos )
+        name = name.substr(pos+1);
+
+    // ----> USB interface of the video node
+    std::string link = mSysfsRoot + "/class/video4linux/" + name + "/device";
+    char resolved[PATH_MAX];
+    if( realpath(link.c_str(), resolved)==nullptr )
+    {
+        if(mVerbose)
+        {
+            std::string msg = std::string("Cannot resolve the sysfs device of '") + dev_name + "'";
+            INFO_OUT(mVerbose,msg);
+        }
+        return false;
+    }
+    std::string path = resolved;
+    // <---- USB interface of the video node
+
+    // ----> Walk up to the root hub
+    // The USB interface (e.g. `2-1.3:1.0`) is a child of the USB device (`2-1.3`), child of its hub (`2-1`),
+    // child of the root hub (`usb2`)
+    while( !path.empty() && path!="/" )
+    {
+        pos = path.rfind('/');
+        std::string node = path.substr(pos+1);
+        bool is_root = (node.compare(0,3,"usb")==0);
+        bool is_device = !is_root && node.find(':')==std::string::npos && node.find('-')!=std::string::npos;
+
+        if( is_root || is_device )
+        {
+            std::string speed = readSysfs(path + "/speed");
+            if( speed.empty() )
+                break;
+
+            int speed_mbps = static_cast<int>(atof(speed.c_str()));
+            if( info.links.empty() )
+            {
+                info.sysfs_path = path;
+                info.port_path = node;
+                info.speed_mbps = speed_mbps;
+                info.bus = atoi(readSysfs(path + "/busnum").c_str());
+            }
+
+            info.links.push_back(node);
+            info.link_speeds.push_back(speed_mbps);
+
+            if( is_root )
+                break;
+        }
+
+        path = path.substr(0,pos);
+    }
+    // <---- Walk up to the root hub
+
+    if( info.links.empty() )
+    {
+        if(mVerbose)
+        {
+            std::string msg = std::string("'") + dev_name + "' is not a USB device";
+            INFO_OUT(mVerbose,msg);
+        }
+        return false;
+    }
+
+    return true;
+}
+
+double UsbBandwidthPlanner::requiredBandwidth( RESOLUTION res, FPS fps )
+{
+    if( res>=RESOLUTION::LAST )
+        return 0.0;
+
+    // Side by side YUV 4:2:2 frames: 2 bytes per pixel, two images per frame
+    const Resolution& r = cameraResolution[static_cast<int>(res)];
+    double bits_per_frame = static_cast<double>(r.width*2) * r.height * 2 * 8;
+
+    return bits_per_frame * static_cast<int>(fps) / 1e6;
+}
+
+bool UsbBandwidthPlanner::check( const std::vector<UsbCameraConfig>& cams, std::vector<UsbLinkLoad>& loads )
+{
+    loads.clear();
+    std::map<std::string,size_t> link_idx;
+
+    for( const auto& cam : cams )
+    {
+        UsbDeviceInfo info;
+        if( !getDeviceInfo(cam.dev_name, info) )
+            continue;
+
+        double required = requiredBandwidth(cam.res, cam.fps);
+
+        for( size_t l=0; l<info.links.size(); l++ )
+        {
+            auto it = link_idx.find(info.links[l]);
+            if( it==link_idx.end() )
+            {
+                UsbLinkLoad load;
+                load.node = info.links[l];
+                load.speed_mbps = info.link_speeds[l];
+                load.capacity_mbps = info.link_speeds[l]*mUsableFraction;
+                it = link_idx.insert(std::make_pair(info.links[l],loads.size())).first;
+                loads.push_back(load);
+            }
+
+            loads[it->second].required_mbps += required;
+            loads[it->second].devices.push_back(cam.dev_name);
+        }
+    }
+
+    bool feasible = true;
+    for( const auto& load : loads )
+    {
+        if( load.capacity_mbps<=0.0 )
+        {
+            if(mVerbose)
+            {
+                std::string msg = std::string("USB link '") + load.node + "' has an unknown speed: not checked";
+                WARNING_OUT(mVerbose,msg);
+            }
+            continue;
+        }
+
+        if( load.required_mbps > load.capacity_mbps )
+        {
+            feasible = false;
+            if(mVerbose)
+            {
+                std::string msg = std::string("USB link '") + load.node + "' overloaded: " +
+                        std::to_string(static_cast<int>(load.required_mbps)) + " Mbps required, " +
+                        std::to_string(static_cast<int>(load.capacity_mbps)) + " Mbps available";
+                WARNING_OUT(mVerbose,msg);
+            }
+        }
+    }
+
+    return feasible;
+}
+
+bool UsbBandwidthPlanner::lowerConfig( UsbCameraConfig& cam )
+{
+    // ----> Lower the frame rate first
+    switch(cam.fps)
+    {
+    case FPS::FPS_100:
+        cam.fps = FPS::FPS_60;
+        return true;
+    case FPS::FPS_60:
+        cam.fps = FPS::FPS_30;
+        return true;
+    case FPS::FPS_30:
+        cam.fps = FPS::FPS_15;
+        return true;
+    default:
+        break;
+    }
+    // <---- Lower the frame rate first
+
+    // ----> Then the resolution, at the minimum frame rate
+    switch(cam.res)
+    {
+    case RESOLUTION::HD2K:
+        cam.res = RESOLUTION::HD1080;
+        return true;
+    case RESOLUTION::HD1080:
+        cam.res = RESOLUTION::HD720;
+        return true;
+    case RESOLUTION::HD720:
+        cam.res = RESOLUTION::VGA;
+        return true;
+    default:
+        return false;
+    }
+    // <---- Then the resolution, at the minimum frame rate
+}
+
+bool UsbBandwidthPlanner::recommend( std::vector<UsbCameraConfig>& cams )
+{
+    int verbose = mVerbose;
+    mVerbose = sl_oc::VERBOSITY::NONE; // no warnings for the intermediate configurations
+
+    bool feasible = false;
+    std::vector<UsbLinkLoad> loads;
+    while( !(feasible=check(cams, loads)) )
+    {
+        // ----> Most overloaded link
+        const UsbLinkLoad* worst = nullptr;
+        for( const auto& load : loads )
+        {
+            if( load.capacity_mbps>0.0 &&
+                    (worst==nullptr || load.required_mbps/load.capacity_mbps > worst->required_mbps/worst->capacity_mbps) )
+                worst = &load;
+        }
+        // <---- Most overloaded link
+
+        if( worst==nullptr )
+            break;
+
+        // ----> Most demanding camera on the link that can still be lowered
+        UsbCameraConfig* target = nullptr;
+        for( auto& cam : cams )
+        {
+            if( std::find(worst->devices.begin(), worst->devices.end(), cam.dev_name)==worst->devices.end() )
+                continue;
+
+            UsbCameraConfig lowered = cam;
+            if( !lowerConfig(lowered) )
+                continue;
+
+            if( target==nullptr || requiredBandwidth(cam.res,cam.fps)>requiredBandwidth(target->res,target->fps) )
+                target = &cam;
+        }
+        // <---- Most demanding camera on the link that can still be lowered
+
+        if( target==nullptr )
+            break;
+
+        lowerConfig(*target);
+    }
+
+    mVerbose = verbose;
+
+    if( mVerbose )
+    {
+        for( const auto& cam : cams )
+        {
+            std::string msg = cam.dev_name + ": " +
+                    std::to_string(cameraResolution[static_cast<int>(cam.res)].width) + "x" +
+                    std::to_string(cameraResolution[static_cast<int>(cam.res)].height) + "@" +
+                    std::to_string(static_cast<int>(cam.fps)) + "Hz - " +
+                    std::to_string(static_cast<int>(requiredBandwidth(cam.res,cam.fps))) + " Mbps";
+            INFO_OUT(mVerbose,msg);
+        }
+
+        if( !feasible )
+        {
+            WARNING_OUT(mVerbose,"No feasible USB configuration found");
+        }
+    }
+
+    return feasible;
+}
+
+}
+
+}
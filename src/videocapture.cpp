@@ -19,6 +19,9 @@
 ///////////////////////////////////////////////////////////////////////////
 
 #include "videocapture.hpp"
+#include "clocksync.hpp"
+#include "trace.hpp"
+#include "videodevice.hpp"
 
 #ifdef SENSORS_MOD_AVAILABLE
 #include "sensorcapture.hpp"
@@ -39,6 +42,7 @@
 #include <fstream>            // for char_traits, basic_istream::operator>>
 
 #include <cmath>              // for round
+#include <functional>         // for function
 
 #define IOCTL_RETRY 3
 
@@ -88,6 +92,8 @@
 #define DEFAULT_MIN_EXP    0
 #define DEFAULT_MAX_EXP    100
 
+#define EXP_SAMPLER_MAX_RATE 50.0f // Maximum exposure sampling rate [Hz]
+
 // Gain working zones
 #define GAIN_ZONE1_MIN 0
 #define GAIN_ZONE1_MAX 255
@@ -107,6 +113,19 @@
 #define EXP_RAW_MIN         2
 // <---- Camera Control
 
+// Maximum raw exposure for a frame rate
+static int exposureRawMax(int fps)
+{
+    if( fps <= 15 )
+        return EXP_RAW_MAX_15FPS;
+    else if( fps <= 30 )
+        return EXP_RAW_MAX_30FPS;
+    else if( fps <= 60 )
+        return EXP_RAW_MAX_60FPS;
+    else
+        return EXP_RAW_MAX_100FPS;
+}
+
 
 namespace sl_oc {
 
@@ -114,7 +133,9 @@ namespace video {
 
 VideoCapture::VideoCapture(VideoParams params)
 {
-    memcpy( &mParams, &params, sizeof(VideoParams) );
+    mParams = params;
+
+    mIO = mParams.device_io?mParams.device_io:V4L2DeviceIO::getInstance();
 
     if( mParams.verbose )
     {
@@ -133,14 +154,7 @@ VideoCapture::VideoCapture(VideoParams params)
     mGainSegMax = (GAIN_ZONE4_MAX-GAIN_ZONE4_MIN)+(GAIN_ZONE3_MAX-GAIN_ZONE3_MIN)+(GAIN_ZONE2_MAX-GAIN_ZONE2_MIN)+(GAIN_ZONE1_MAX-GAIN_ZONE1_MIN);
 
     // FPS mapping
-    if( mFps <= 15 )
-        mExpoureRawMax = EXP_RAW_MAX_15FPS;
-    else if( mFps <= 30 )
-        mExpoureRawMax = EXP_RAW_MAX_30FPS;
-    else if( mFps <= 60 )
-        mExpoureRawMax = EXP_RAW_MAX_60FPS;
-    else
-        mExpoureRawMax = EXP_RAW_MAX_100FPS;
+    mExpoureRawMax = exposureRawMax(mFps);
 }
 
 VideoCapture::~VideoCapture()
@@ -152,6 +166,13 @@ void VideoCapture::reset()
 {
     setLEDstatus( false );
 
+    // The auto exposure and the sampling threads access the sensor registers: they must be stopped first
+    disableHostAutoExposure();
+    disableExposureSampler();
+#ifdef SENSOR_LOG_AVAILABLE
+    enableAecAgcSensLogging(false);
+#endif
+
     mStopCapture = true;
 
     if( mGrabThread.joinable() )
@@ -159,6 +180,20 @@ void VideoCapture::reset()
         mGrabThread.join();
     }
 
+    // The frame publishers and the outputs are bound to the format of the current connection
+    disableShmPublisher();
+    disableFrameServer();
+    {
+        const std::lock_guard<std::mutex> lock(mOutMutex);
+        mOutputs.clear();
+    }
+
+    if(mClockId!=-1)
+    {
+        ClockSync::getInstance().unregisterClock(mClockId);
+        mClockId = -1;
+    }
+
     // ----> Stop capturing
     enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     if (mFileDesc != -1)
@@ -166,12 +201,12 @@ void VideoCapture::reset()
     // <---- Stop capturing
 
     // ----> deinit device
-    if( mInitialized && mBuffers)
+    // Note: the buffers are mapped also when the capture failed to start
+    if(mBuffers)
     {
         for (unsigned int i = 0; i < mBufCount; ++i)
-            munmap(mBuffers[i].start, mBuffers[i].length);
-        if (mBuffers)
-            free(mBuffers);
+            mIO->munmap(mBuffers[i].start, mBuffers[i].length);
+        free(mBuffers);
 
         mBuffers = nullptr;
     }
@@ -179,15 +214,13 @@ void VideoCapture::reset()
 
     if (mFileDesc)
     {
-        close(mFileDesc);
+        mIO->close(mFileDesc);
         mFileDesc=-1;
     }
 
-    if(mLastFrame.data)
-    {
-        delete [] mLastFrame.data;
-        mLastFrame.data = nullptr;
-    }
+    // The frame buffer is kept by the pool for the next connection
+    FramePool::getInstance().release(mLastFrame.data);
+    mLastFrame.data = nullptr;
 
     if( mParams.verbose && mInitialized)
     {
@@ -298,6 +331,8 @@ bool VideoCapture::initializeVideo( int devId/*=-1*/ )
         return false;
     }
 
+    initMetrics();
+
     mInitialized = startCapture();
 
     if( mParams.verbose && mInitialized)
@@ -320,6 +355,22 @@ bool VideoCapture::initializeVideo( int devId/*=-1*/ )
     return mInitialized;
 }
 
+void VideoCapture::initMetrics()
+{
+    MetricsRegistry& reg = MetricsRegistry::getInstance();
+
+    std::string labels = "serial=\"" + std::to_string(mSerialNumber) + "\",device=\"" + mDevName + "\"";
+
+    mMetFrames = reg.counter("zed_oc_frames_total", "Frames grabbed", labels);
+    mMetDropped = reg.counter("zed_oc_frames_dropped_total", "Frames lost by the driver or incomplete", labels);
+    mMetFps = reg.gauge("zed_oc_frame_rate", "Measured frame rate [Hz]", labels);
+    mMetLatency = reg.histogram("zed_oc_dqbuf_latency_seconds", "Delay between the capture and the dequeue of the frames",
+                                {0.0005,0.001,0.002,0.005,0.01,0.02,0.05,0.1}, labels);
+
+    mLastFrameTs = 0;
+    mFpsAvg = 0.0;
+}
+
 bool VideoCapture::openCamera( uint8_t devId )
 {
     mDevId = devId;
@@ -359,7 +410,7 @@ bool VideoCapture::openCamera( uint8_t devId )
     // ----> Open
     struct stat st;
     memset(&st, 0, sizeof (struct stat));
-    if (-1 == stat(mDevName.c_str(), &st))
+    if (-1 == mIO->stat(mDevName.c_str(), &st))
     {
         if(mParams.verbose)
         {
@@ -384,7 +435,7 @@ bool VideoCapture::openCamera( uint8_t devId )
 
     mFileDesc = 0;
 
-    mFileDesc = open(mDevName.c_str(), O_RDWR|O_NONBLOCK,0); // Reading are non blocking
+    mFileDesc = mIO->open(mDevName.c_str(), O_RDWR|O_NONBLOCK); // Reading are non blocking
 
     if (-1 == mFileDesc)
     {
@@ -400,6 +451,7 @@ bool VideoCapture::openCamera( uint8_t devId )
     // <---- Open
 
     int sn = getSerialNumber();
+    mSerialNumber = sn;
     if(mParams.verbose)
     {
         std::string msg = std::string("Opened camera with SN: ") + std::to_string(sn);
@@ -413,8 +465,6 @@ bool VideoCapture::openCamera( uint8_t devId )
     memset(&cropcap, 0, sizeof (v4l2_cropcap));
     struct v4l2_crop crop;
     memset(&crop, 0, sizeof (v4l2_crop));
-    struct v4l2_format fmt;
-    memset(&fmt, 0, sizeof (v4l2_format));
 
     if( -1==xioctl(mFileDesc, VIDIOC_QUERYCAP, &cap) )
     {
@@ -437,6 +487,51 @@ bool VideoCapture::openCamera( uint8_t devId )
         crop.c = cropcap.defrect; /* reset to default */
     }
 
+    if( !setFormat() )
+        return false;
+
+    if( !allocateFrame() )
+        return false;
+
+    if( !allocateBuffers() )
+    {
+        // Another device can be tried by `initializeVideo`: the buffers of this one must not be kept
+        releaseBuffers();
+        FramePool::getInstance().release(mLastFrame.data);
+        mLastFrame.data = nullptr;
+        return false;
+    }
+    // <---- Init
+
+    return true;
+}
+
+bool VideoCapture::allocateFrame()
+{
+    FramePool& pool = FramePool::getInstance();
+
+    pool.release(mLastFrame.data);
+
+    mLastFrame.width = mFrameWidth;
+    mLastFrame.height = mHeight;
+    mLastFrame.channels = mChannels;
+    size_t bufSize = static_cast<size_t>(mLastFrame.width) * mLastFrame.height * mLastFrame.channels;
+    mLastFrame.data = pool.acquire(bufSize, mParams.frame_huge_pages, mParams.frame_numa_node);
+
+    if(!mLastFrame.data)
+    {
+        ERROR_OUT(mParams.verbose,"Cannot allocate the frame buffer");
+        return false;
+    }
+
+    return true;
+}
+
+bool VideoCapture::setFormat()
+{
+    struct v4l2_format fmt;
+    memset(&fmt, 0, sizeof (v4l2_format));
+
     fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
     fmt.fmt.pix.field = V4L2_FIELD_ANY;
@@ -474,19 +569,18 @@ bool VideoCapture::openCamera( uint8_t devId )
         return false;
     }
 
+    mFrameWidth = (getCapturedEye()<0)?mWidth:mWidth/2;
+
     if( -1==input_set_framerate(mFps) )
     {
         ERROR_OUT(mParams.verbose,"Error setting the camera framerate");
     }
 
-    // ----> Output frame allocation
-    mLastFrame.width = mWidth;
-    mLastFrame.height = mHeight;
-    mLastFrame.channels = mChannels;
-    int bufSize = mLastFrame.width * mLastFrame.height * mLastFrame.channels;
-    mLastFrame.data = new unsigned char[bufSize];
-    // <---- Output frame allocation
+    return true;
+}
 
+bool VideoCapture::allocateBuffers()
+{
     struct v4l2_requestbuffers req;
     memset(&req, 0, sizeof (v4l2_requestbuffers));
 
@@ -532,7 +626,7 @@ bool VideoCapture::openCamera( uint8_t devId )
         mBuffers[mBufCount].length = buf.length;
 
         mBuffers[mBufCount].start =
-                mmap(nullptr /* start anywhere */,
+                mIO->mmap(nullptr /* start anywhere */,
                      buf.length,
                      PROT_READ | PROT_WRITE /* required */,
                      MAP_SHARED /* recommended */,
@@ -540,11 +634,252 @@ bool VideoCapture::openCamera( uint8_t devId )
     }
 
     mBufCount = req.count;
-    // <---- Init
 
     return true;
 }
 
+int VideoCapture::getCapturedEye()
+{
+    switch(mParams.capture_mode)
+    {
+    case CAPTURE_MODE::LEFT:
+        return 0;
+    case CAPTURE_MODE::RIGHT:
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+void VideoCapture::releaseBuffers()
+{
+    if(mBuffers)
+    {
+        for (unsigned int i = 0; i < mBufCount; ++i)
+            mIO->munmap(mBuffers[i].start, mBuffers[i].length);
+        free(mBuffers);
+        mBuffers = nullptr;
+    }
+
+    // The driver frees its buffers only when none is requested
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof (v4l2_requestbuffers));
+    req.count = 0;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    xioctl(mFileDesc, VIDIOC_REQBUFS, &req);
+}
+
+bool VideoCapture::reconfigure(RESOLUTION res, FPS fps)
+{
+    if(!mInitialized)
+    {
+        ERROR_OUT(mParams.verbose,"The camera must be initialized before changing its configuration");
+        return false;
+    }
+
+    if(mExternalGrab)
+    {
+        ERROR_OUT(mParams.verbose,"The configuration of a camera grabbed by a CameraGroup cannot be changed");
+        return false;
+    }
+
+    TRACE_SCOPE("reconfigure");
+    uint64_t start_ts = getMonotonicTimestamp();
+
+    const VideoParams old_params = mParams;
+    const int old_width = mWidth;
+    const int old_height = mHeight;
+    const int old_fps = mFps;
+
+    mParams.res = res;
+    mParams.fps = fps;
+    checkResFps();
+
+    if(mWidth==old_width && mHeight==old_height && mFps==old_fps)
+        return true;
+
+    bool size_changed = (mWidth!=old_width || mHeight!=old_height);
+
+    // ----> Stop the threads bound to the current configuration
+    bool ae_enabled = mAeEnabled;
+    disableHostAutoExposure();
+    bool exp_enabled = mExpSamplerEnabled;
+    float exp_rate = (mExpPeriodUsec>0)?(1e6f/mExpPeriodUsec):0.0f;
+    disableExposureSampler();
+
+    mStopCapture = true;
+    if( mGrabThread.joinable() )
+    {
+        mGrabThread.join();
+    }
+    // <---- Stop the threads bound to the current configuration
+
+    // The AEC/AGC ROIs are expressed in pixels: they are scaled to the new frame size
+    AecAgcRoi rois[2];
+    bool rois_ok = size_changed;
+    for(int s=0; s<2 && rois_ok; s++)
+        rois_ok = getROIforAECAGC(static_cast<CAM_SENS_POS>(s), rois[s].x, rois[s].y, rois[s].w, rois[s].h);
+
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    xioctl(mFileDesc, VIDIOC_STREAMOFF, &type);
+
+    // ----> New format
+    bool ok;
+    if(size_changed)
+    {
+        // The driver accepts a new frame size only when no buffer is allocated
+        releaseBuffers();
+        ok = setFormat() && allocateBuffers();
+        if(!ok)
+        {
+            ERROR_OUT(mParams.verbose,"The new configuration has been refused by the device. Restoring the previous one");
+            mParams = old_params;
+            checkResFps();
+            releaseBuffers();
+            if(!setFormat() || !allocateBuffers())
+            {
+                ERROR_OUT(mParams.verbose,"Cannot restore the previous configuration");
+                reset();
+                return false;
+            }
+        }
+    }
+    else
+    {
+        ok = (input_set_framerate(mFps)!=-1);
+        if(!ok)
+        {
+            ERROR_OUT(mParams.verbose,"The new frame rate has been refused by the device. Restoring the previous one");
+            mParams = old_params;
+            checkResFps();
+            input_set_framerate(mFps);
+        }
+    }
+    size_changed = (mWidth!=old_width || mHeight!=old_height);
+
+    mExpoureRawMax = exposureRawMax(mFps);
+
+    if(size_changed)
+    {
+        bool frame_ok;
+        {
+            const std::lock_guard<std::mutex> lock(mBufMutex);
+
+            frame_ok = allocateFrame();
+
+            if(mStatsEnabled && !mStatsCalc.configure(mStatsParams, mWidth, mHeight, getCapturedEye()))
+                mStatsEnabled = false;
+        }
+
+        if(!frame_ok)
+        {
+            reset();
+            return false;
+        }
+    }
+    // <---- New format
+
+    // ----> Restart
+    if( !startStreaming() )
+    {
+        reset();
+        return false;
+    }
+
+    mLastFrameTs = 0;
+    mFpsAvg = 0.0;
+    mGrabThread = std::thread( &VideoCapture::grabThreadFunc,this );
+    // <---- Restart
+
+    // ----> Update the services bound to the configuration
+    if(mTimingEnabled)
+    {
+        mTimingEnabled = false;
+        mTiming.reset();
+        mTiming.setNominalPeriod(mFps>0?(1000000000ULL/mFps):0);
+        mTimingEnabled = true;
+    }
+
+    if(size_changed && rois_ok)
+    {
+        for(int s=0; s<2; s++)
+        {
+            if(rois[s].w==0 || rois[s].h==0)
+                continue;
+
+            uint16_t x = static_cast<uint16_t>(rois[s].x*mWidth/old_width);
+            uint16_t y = static_cast<uint16_t>(rois[s].y*mHeight/old_height);
+            uint16_t w = static_cast<uint16_t>(std::min(rois[s].w*mWidth/old_width, mWidth/2-x));
+            uint16_t h = static_cast<uint16_t>(std::min(rois[s].h*mHeight/old_height, mHeight-y));
+            setROIforAECAGC(static_cast<CAM_SENS_POS>(s), x, y, w, h);
+        }
+    }
+
+    if(size_changed)
+    {
+        std::string shm_name;
+        uint8_t shm_slots = 0;
+        std::string srv_path;
+        FrameServerParams srv_params;
+        bool srv_enabled = false;
+        {
+            const std::lock_guard<std::mutex> lock(mPubMutex);
+            if(mShmPub)
+            {
+                shm_name = mShmPub->getName();
+                shm_slots = mShmPub->getSlotCount();
+            }
+            if(mFrameSrv)
+            {
+                srv_path = mFrameSrv->getSocketPath();
+                srv_params = mFrameSrv->getParams();
+                srv_enabled = true;
+            }
+        }
+
+        // The previous publishers are closed first, to release their names
+        if(!shm_name.empty())
+        {
+            disableShmPublisher();
+            enableShmPublisher(shm_name, shm_slots);
+        }
+        if(srv_enabled)
+        {
+            disableFrameServer();
+            enableFrameServer(srv_path, srv_params);
+        }
+
+        const std::lock_guard<std::mutex> lock(mOutMutex);
+        for(auto it=mOutputs.begin(); it!=mOutputs.end(); )
+        {
+            if(it->second->configure(it->second->getParams(), mFrameWidth, mHeight))
+                ++it;
+            else
+            {
+                WARNING_OUT(mParams.verbose,std::string("Output #") + std::to_string(it->first)
+                            + std::string(" removed: its crop rectangle is empty at the new resolution"));
+                it = mOutputs.erase(it);
+            }
+        }
+    }
+
+    if(ae_enabled)
+        enableHostAutoExposure(mAeParams, mAeMetering);
+    if(exp_enabled)
+        enableExposureSampler(exp_rate);
+    // <---- Update the services bound to the configuration
+
+    if(mParams.verbose)
+    {
+        std::string msg = std::string("New configuration applied in ")
+                + std::to_string((getMonotonicTimestamp()-start_ts)/1000000) + std::string(" msec");
+        INFO_OUT(mParams.verbose,msg);
+    }
+
+    return ok;
+}
+
 int VideoCapture::getSerialNumber()
 {
     /*if(!mInitialized)
@@ -596,6 +931,36 @@ int VideoCapture::getSerialNumber()
 }
 
 bool VideoCapture::startCapture()
+{
+    // Set priority
+    int priority = V4L2_PRIORITY_RECORD;
+    if( -1==xioctl(mFileDesc, VIDIOC_G_PRIORITY, &priority) )
+    {
+        if(mParams.verbose)
+        {
+            std::string msg = std::string("Cannot set priority for '") + mDevName + "': ["
+                    + std::to_string(errno) +std::string("] ") + std::string(strerror(errno));
+            ERROR_OUT(mParams.verbose,msg);
+        }
+
+        return false;
+    }
+
+    if( !startStreaming() )
+        return false;
+
+    mFirstFrame = true;
+
+    // With external grabbing the frames are retrieved by the owner (see CameraGroup) calling `grabFrame`
+    if(!mExternalGrab)
+    {
+        mGrabThread = std::thread( &VideoCapture::grabThreadFunc,this );
+    }
+
+    return true;
+}
+
+bool VideoCapture::startStreaming()
 {
     // ----> Start capturing
     enum v4l2_buf_type type;
@@ -619,20 +984,6 @@ bool VideoCapture::startCapture()
     }
     type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
-    // Set priority
-    int priority = V4L2_PRIORITY_RECORD;
-    if( -1==xioctl(mFileDesc, VIDIOC_G_PRIORITY, &priority) )
-    {
-        if(mParams.verbose)
-        {
-            std::string msg = std::string("Cannot set priority for '") + mDevName + "': ["
-                    + std::to_string(errno) +std::string("] ") + std::string(strerror(errno));
-            ERROR_OUT(mParams.verbose,msg);
-        }
-
-        return false;
-    }
-
     // Start streaming
     if( -1==xioctl(mFileDesc, VIDIOC_STREAMON, &type) )
     {
@@ -647,7 +998,8 @@ bool VideoCapture::startCapture()
     }
     // <---- Start capturing
 
-    mGrabThread = std::thread( &VideoCapture::grabThreadFunc,this );
+    mNewFrame = false;
+    mStopCapture = false;
 
     return true;
 }
@@ -670,7 +1022,7 @@ int VideoCapture::xioctl(int fd, uint64_t IOCTL_X, void *arg)
     int tries = IOCTL_RETRY;
     do
     {
-        ret = ioctl(fd, IOCTL_X, arg);
+        ret = mIO->ioctl(fd, IOCTL_X, arg);
         // usleep(1);
     } while (ret && tries-- &&
              ((errno == EINTR) || (errno == EAGAIN) || (errno == ETIMEDOUT)));
@@ -691,8 +1043,8 @@ SL_DEVICE VideoCapture::getCameraModel( std::string dev_name)
     sl_oc::video::SL_DEVICE camera_device = sl_oc::video::SL_DEVICE::NONE;
     int vid = 0, pid = 0;
     std::string modalias = "";
-    std::string name = dev_name.erase(0, 5); //remove /dev/
-    if (!(std::ifstream("/sys/class/video4linux/" + name + "/device/modalias") >> modalias))
+    std::string name = dev_name.substr(5); //remove /dev/
+    if (!mIO->readModalias(dev_name, modalias))
     {
         if(mParams.verbose>sl_oc::VERBOSITY::ERROR)
         {
@@ -756,9 +1108,6 @@ SL_DEVICE VideoCapture::getCameraModel( std::string dev_name)
 
 void VideoCapture::grabThreadFunc()
 {
-    mNewFrame = false;
-    mStopCapture = false;
-
     fd_set fds;
     struct timeval tv = {0};
 
@@ -772,119 +1121,304 @@ void VideoCapture::grabThreadFunc()
     tv.tv_usec = 0;
     select(mFileDesc + 1, &fds, nullptr, nullptr, &tv);
 
+    TRACE_THREAD_NAME("zed_oc video " + mDevName);
+
+    while (!mStopCapture)
+    {
+        mGrabRunning=true;
+
+        if( !grabFrame() )
+        {
+            usleep(200);
+        }
+    }
+
+    mGrabRunning = false;
+}
+
+bool VideoCapture::grabFrame( Frame* dst )
+{
     struct v4l2_buffer buf;
     memset(&(buf), 0, sizeof (buf));
     buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     buf.memory = V4L2_MEMORY_MMAP;
-    buf.bytesused = -1;
-    buf.length = 0;
-
-    uint64_t rel_ts = 0;
-    int capture_frame_count = 0;
-
-    mFirstFrame=true;
 
-    while (!mStopCapture)
+    int ret;
     {
-        mGrabRunning=true;
-
+        TRACE_SCOPE_ID(trace_dqbuf,"VIDIOC_DQBUF");
         mComMutex.lock();
-        int ret = ioctl(mFileDesc, VIDIOC_DQBUF, &buf);
+        ret = mIO->ioctl(mFileDesc, VIDIOC_DQBUF, &buf);
         mComMutex.unlock();
 
-        if (buf.bytesused == buf.length && ret == 0 && buf.index < mBufCount)
+        if( ret != 0 )
         {
-            mCurrentIndex = buf.index;
-            // get buffer timestamp in us
+            // Polling with no frame ready: not traced
+            TRACE_DISCARD(trace_dqbuf);
+        }
+    }
 
-            uint64_t ts_uvc = ((uint64_t) buf.timestamp.tv_sec) * (1000 * 1000) + ((uint64_t) buf.timestamp.tv_usec);
+    if( ret != 0 )
+    {
+        // No buffer ready: the device is opened in non blocking mode
+        return false;
+    }
 
-            if(mFirstFrame)
-            {
-                mStartTs = getWallTimestamp();
-                //std::cout << "VideoCapture: " << mStartTs << std::endl;
+    if( buf.bytesused != buf.length || buf.index >= mBufCount )
+    {
+        // Counted here: the next sequence gap must not count it again
+        if(mMetDropped) mMetDropped->inc();
+        mLastSequence = buf.sequence;
 
-#ifdef SENSORS_MOD_AVAILABLE
-                if(mSyncEnabled && mSensPtr)
-                {
-                    // Synchronize reference timestamp
-                    mSensPtr->setStartTimestamp(mStartTs);
-                }
-#endif
+        // Incomplete frame: give the buffer back to the driver
+        mComMutex.lock();
+        mIO->ioctl(mFileDesc, VIDIOC_QBUF, &buf);
+        mComMutex.unlock();
+        return false;
+    }
 
-                mFirstFrame = false;
-                mInitTs = ts_uvc;
-            }
+    mCurrentIndex = buf.index;
+    uint64_t rx_ts = getMonotonicTimestamp();
+    // get buffer timestamp in us
 
-            rel_ts = ts_uvc - mInitTs;
-            // cvt to ns
-            rel_ts *= 1000;
+    uint64_t ts_uvc = ((uint64_t) buf.timestamp.tv_sec) * (1000 * 1000) + ((uint64_t) buf.timestamp.tv_usec);
 
-            mBufMutex.lock();
-            if (mLastFrame.data != nullptr && mWidth != 0 && mHeight != 0 && mBuffers[mCurrentIndex].start != nullptr)
-            {
-                mLastFrame.frame_id++;
-                memcpy(mLastFrame.data, (unsigned char*) mBuffers[mCurrentIndex].start, mBuffers[mCurrentIndex].length);
-                mLastFrame.timestamp = mStartTs + rel_ts;
+    if(mFirstFrame)
+    {
+        // The UVC driver normally stamps the buffers with CLOCK_MONOTONIC: the timestamps are used as they are.
+        // Other clocks are mapped to the monotonic time of the first frame
+        mMonoBufTs = (buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK)==V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+        mStartTs = mMonoBufTs?(ts_uvc*1000):rx_ts;
 
-                //                static uint64_t last_ts=0;
-                //                std::cout << "[Video] Frame TS: " << static_cast<double>(mLastFrame.timestamp)/1e9 << " sec" << std::endl;
-                //                double dT = static_cast<double>(mLastFrame.timestamp-last_ts)/1e9;
-                //                last_ts = mLastFrame.timestamp;
-                //                std::cout << "[Video] Frame FPS: " << 1./dT << std::endl;
+        // Device clocks are aligned to the host monotonic clock by the shared clock service
+        if(!mMonoBufTs && mClockId==-1)
+        {
+            mClockId = ClockSync::getInstance().registerClock(mDevName);
+        }
+        //std::cout << "VideoCapture: " << mStartTs << std::endl;
 
 #ifdef SENSORS_MOD_AVAILABLE
-                if(mSensReadyToSync)
-                {
-                    mSensReadyToSync = false;
-                    mSensPtr->updateTimestampOffset(mLastFrame.timestamp);
-                }
+        if(mSyncEnabled && mSensPtr)
+        {
+            // Synchronize reference timestamp
+            mSensPtr->setStartTimestamp(mStartTs);
+        }
 #endif
 
-#ifdef SENSOR_LOG_AVAILABLE
-                // ----> AEC/AGC register logging
-                if(mLogEnable)
-                {
-                    static int frame_count =0;
+        mFirstFrame = false;
+        mInitTs = ts_uvc;
+    }
 
+    uint64_t rel_ts = ts_uvc - mInitTs;
+    // cvt to ns
+    rel_ts *= 1000;
 
-                    if((++frame_count)==mLogFrameSkip)
-                        frame_count = 0;
+    // ----> Host clock domains
+    HostClock& clock = HostClock::getInstance();
+    clock.update();
 
-                    if(frame_count==0)
-                    {
-                        saveLogDataLeft();
-                        saveLogDataRight();
-                    }
-                }
-                // <---- AEC/AGC register logging
-#endif
+    uint64_t ts_mono = mStartTs + rel_ts;
+    if(mClockId!=-1)
+    {
+        ClockSync& sync = ClockSync::getInstance();
+        sync.addSample(mClockId, ts_uvc*1000, rx_ts);
+        sync.toHost(mClockId, ts_uvc*1000, ts_mono);
+    }
+    uint64_t ts_wall = clock.toWall(ts_mono);
+    // <---- Host clock domains
+
+    if(mTimingEnabled)
+        mTiming.addFrame(ts_mono, rx_ts);
 
-                mNewFrame=true;
+    // ----> Metrics
+    if(mMetFrames)
+    {
+        mMetFrames->inc();
+
+        if(mLastFrameTs!=0)
+        {
+            uint32_t lost = buf.sequence - mLastSequence - 1;
+            if(lost>0 && lost<0x80000000)
+                mMetDropped->inc(lost);
+
+            if(ts_mono>mLastFrameTs)
+            {
+                double fps = 1e9/static_cast<double>(ts_mono-mLastFrameTs);
+                mFpsAvg = (mFpsAvg==0.0)?fps:(mFpsAvg + 0.1*(fps-mFpsAvg));
+                mMetFps->set(mFpsAvg);
             }
-            mBufMutex.unlock();
+        }
+        mLastSequence = buf.sequence;
+        mLastFrameTs = ts_mono;
+
+        mMetLatency->observe((rx_ts>ts_mono)?static_cast<double>(rx_ts-ts_mono)*1e-9:0.0);
+    }
+    // <---- Metrics
+
+    bool frame_ok = false;
 
-            mComMutex.lock();
-            ioctl(mFileDesc, VIDIOC_QBUF, &buf);
-            mComMutex.unlock();
+    mBufMutex.lock();
+    if (mLastFrame.data != nullptr && mWidth != 0 && mHeight != 0 && mBuffers[mCurrentIndex].start != nullptr)
+    {
+        frame_ok = true;
+        mLastFrame.frame_id++;
+        mLastFrame.timestamp_mono = ts_mono;
+        mLastFrame.timestamp_wall = ts_wall;
+        mLastFrame.timestamp = (mParams.clock_source==CLOCK_SOURCE::MONOTONIC)?ts_mono:ts_wall;
 
-            capture_frame_count++;
+        if(dst)
+        {
+            // External grabbing (see CameraGroup): the frame is copied only to the destination buffer
+            dst->frame_id = mLastFrame.frame_id;
+            dst->timestamp = mLastFrame.timestamp;
+            dst->timestamp_mono = mLastFrame.timestamp_mono;
+            dst->timestamp_wall = mLastFrame.timestamp_wall;
+            dst->width = mLastFrame.width;
+            dst->height = mLastFrame.height;
+            dst->channels = mLastFrame.channels;
+            TRACE_SCOPE("memcpy");
+            copyFrameData(*dst);
         }
         else
         {
-            if (buf.bytesused != buf.length)
+            TRACE_SCOPE("memcpy");
+            copyFrameData(mLastFrame);
+        }
+
+        if(mAeEnabled)
+            notifyAutoExposure(dst?dst->stats:mLastFrame.stats, mLastFrame.frame_id, rx_ts);
+
+        // ----> Exposure metadata
+        mGrabbedFrameId.store(mLastFrame.frame_id, std::memory_order_relaxed);
+        ExposureSample& exp_sample = dst?dst->exposure:mLastFrame.exposure;
+        if(!mExpSamplerEnabled || !getLastExposureSample(exp_sample))
+            exp_sample.valid = false;
+        // <---- Exposure metadata
+
+        //                static uint64_t last_ts=0;
+        //                std::cout << "[Video] Frame TS: " << static_cast<double>(mLastFrame.timestamp)/1e9 << " sec" << std::endl;
+        //                double dT = static_cast<double>(mLastFrame.timestamp-last_ts)/1e9;
+        //                last_ts = mLastFrame.timestamp;
+        //                std::cout << "[Video] Frame FPS: " << 1./dT << std::endl;
+
+#ifdef SENSORS_MOD_AVAILABLE
+        if(mSensReadyToSync)
+        {
+            mSensReadyToSync = false;
+            mSensPtr->updateTimestampOffset(mLastFrame.timestamp_mono);
+        }
+#endif
+
+#ifdef SENSOR_LOG_AVAILABLE
+        // ----> AEC/AGC register logging
+        // Only a request is enqueued: the registers are read and saved by the logger threads
+        if(mLogEnable && mRegLogger)
+        {
+            if((++mLogFrameCount)>=mLogFrameSkip)
             {
-                mComMutex.lock();
-                ioctl(mFileDesc, VIDIOC_QBUF, &buf);
-                mComMutex.unlock();
+                mLogFrameCount = 0;
+                mRegLogger->request(mLastFrame.frame_id, mLastFrame.timestamp);
             }
-            usleep(200);
-            buf.bytesused = -1;
-            buf.length = 0;
         }
+        // <---- AEC/AGC register logging
+#endif
+
+        if(!dst)
+            mNewFrame=true;
     }
+    mBufMutex.unlock();
 
-    mGrabRunning = false;
+    // ----> Frame publishing
+    // Note: the publishers are filled from the copied frame out of the frame mutex, to not delay the consumers
+    //       waiting in `getLastFrame`: the frame data are modified only by this thread
+    if(frame_ok)
+    {
+        TRACE_SCOPE("publish");
+        const Frame& out = dst?*dst:mLastFrame;
+        size_t out_size = static_cast<size_t>(out.width)*out.height*out.channels;
+
+        const std::lock_guard<std::mutex> lock(mPubMutex);
+        if(mShmPub)
+        {
+            mShmPub->publish(out.data, out_size, mLastFrame.frame_id, mLastFrame.timestamp);
+        }
+        if(mFrameSrv)
+        {
+            mFrameSrv->pushFrame(out.data, out_size, mLastFrame.frame_id, mLastFrame.timestamp);
+        }
+    }
+    // <---- Frame publishing
+
+    // ----> Consumer outputs
+    if(frame_ok)
+    {
+        const Frame& out = dst?*dst:mLastFrame;
+
+        const std::lock_guard<std::mutex> lock(mOutMutex);
+        if(!mOutputs.empty())
+        {
+            TRACE_SCOPE("outputs");
+            for(auto& item : mOutputs)
+                item.second->process(out);
+        }
+    }
+    // <---- Consumer outputs
+
+    TRACE_SCOPE("VIDIOC_QBUF");
+    mComMutex.lock();
+    mIO->ioctl(mFileDesc, VIDIOC_QBUF, &buf);
+    mComMutex.unlock();
+
+    return frame_ok;
+}
+
+void VideoCapture::copyFrameData(Frame& frame)
+{
+    const uint8_t* src = static_cast<const uint8_t*>(mBuffers[mCurrentIndex].start);
+    size_t size = mBuffers[mCurrentIndex].length;
+
+    // ----> Tone curve
+    // The requested curve is copied only when it changes, the lock is never taken while copying the frame
+    uint32_t curve_id = mToneCurveId.load(std::memory_order_acquire);
+    if(curve_id!=0 && curve_id!=mToneActiveId)
+    {
+        const std::lock_guard<std::mutex> lock(mToneMutex);
+        mToneActive = mToneCurve;
+        mToneActiveId = mToneCurveCount;
+    }
+    const ToneCurve* curve = (curve_id!=0)?&mToneActive:nullptr;
+    frame.tone_curve = curve?mToneActiveId:0;
+    // <---- Tone curve
+
+    if(mStatsEnabled)
+    {
+        mStatsCalc.copyFrame(frame.data, src, size, frame.stats, curve);
+    }
+    else if(mFrameWidth!=mWidth)
+    {
+        // Single image: only its half of each row is copied
+        const size_t src_row = static_cast<size_t>(mWidth)*mChannels;
+        const size_t dst_row = static_cast<size_t>(mFrameWidth)*mChannels;
+        const size_t offset = (getCapturedEye()==1)?dst_row:0;
+        if(size>=src_row*mHeight)
+        {
+            for(int row=0; row<mHeight; row++)
+            {
+                uint8_t* line = frame.data + row*dst_row;
+                memcpy(line, src + row*src_row + offset, dst_row);
+                if(curve)
+                    curve->apply(line, mFrameWidth);
+            }
+        }
+        frame.stats.valid = false;
+    }
+    else
+    {
+        if(curve)
+            curve->copy(frame.data, src, size);
+        else
+            memcpy(frame.data, src, size);
+        frame.stats.valid = false;
+    }
 }
 
 const Frame& VideoCapture::getLastFrame( uint64_t timeout_msec )
@@ -908,8 +1442,40 @@ const Frame& VideoCapture::getLastFrame( uint64_t timeout_msec )
     return mLastFrame;
 }
 
+uint64_t VideoCapture::measureFrameCopy()
+{
+    if(!mInitialized || mExternalGrab)
+        return 0;
+
+    const std::lock_guard<std::mutex> lock(mBufMutex);
+    if(mLastFrame.data==nullptr || mLastFrame.frame_id==0 || mBuffers[mCurrentIndex].start==nullptr)
+        return 0;
+
+    FramePool& pool = FramePool::getInstance();
+
+    Frame frame;
+    frame.width = mLastFrame.width;
+    frame.height = mLastFrame.height;
+    frame.channels = mLastFrame.channels;
+    size_t bufSize = static_cast<size_t>(frame.width) * frame.height * frame.channels;
+    frame.data = pool.acquire(bufSize, mParams.frame_huge_pages, mParams.frame_numa_node);
+    if(!frame.data)
+        return 0;
+
+    uint64_t start = getMonotonicTimestamp();
+    copyFrameData(frame);
+    uint64_t elapsed = getMonotonicTimestamp()-start;
+
+    pool.release(frame.data);
+    frame.data = nullptr;
+
+    return elapsed;
+}
+
 int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool safe, bool force)
 {
+    TRACE_SCOPE("XU control");
+
     if (len > 384)
         return -2;
 
@@ -924,9 +1490,11 @@ int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool saf
     xu_query_info.size = 2;
     xu_query_info.data = tmp;
 
-    const std::lock_guard<std::mutex> lock(mComMutex);
+    // The set/wait/get sequence of a command must not be interleaved with another command. The buffer queue
+    // ioctls do not depend on it: the grabbing thread is not stalled by the waits of the command
+    const std::lock_guard<std::mutex> lock(mXuMutex);
 
-    int io_err = ioctl(mFileDesc, UVCIOC_CTRL_QUERY, &xu_query_info);
+    int io_err = mIO->ioctl(mFileDesc, UVCIOC_CTRL_QUERY, &xu_query_info);
 
     //std::cerr << "[ll_VendorControl] '" << mDevName << "' [" << mDevId << "] - mFileDesc: " << mFileDesc << std::endl;
 
@@ -948,7 +1516,7 @@ int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool saf
     xu_query_send.size = static_cast<__u16> (len); //64 for USB2
     xu_query_send.data = buf;
 
-    io_err = ioctl(mFileDesc, UVCIOC_CTRL_QUERY, &xu_query_send);
+    io_err = mIO->ioctl(mFileDesc, UVCIOC_CTRL_QUERY, &xu_query_send);
     if (io_err != 0)
     {
         int res = errno;
@@ -1001,7 +1569,7 @@ int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool saf
                 xu_query.size = static_cast<__u16> (len),
                 xu_query.data = buf;
 
-        io_err = ioctl(mFileDesc, UVCIOC_CTRL_QUERY, &xu_query);
+        io_err = mIO->ioctl(mFileDesc, UVCIOC_CTRL_QUERY, &xu_query);
         if (io_err != 0) {
             int res = errno;
 
@@ -1451,6 +2019,8 @@ int VideoCapture::toggleLED(bool* value)
 
 int VideoCapture::getCameraControlSettings(int ctrl_id)
 {
+    TRACE_SCOPE("VIDIOC_G_CTRL");
+
     struct v4l2_control control_s;
     struct v4l2_queryctrl queryctrl;
     memset(&queryctrl, 0, sizeof (queryctrl));
@@ -1460,17 +2030,19 @@ int VideoCapture::getCameraControlSettings(int ctrl_id)
     // save_controls(fd);
     queryctrl.id = ctrl_id;
 
-    if (0 != ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl))
+    if (0 != mIO->ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl))
         return res;
 
     control_s.id = ctrl_id;
-    if (ioctl(mFileDesc, VIDIOC_G_CTRL, &control_s) == 0)
+    if (mIO->ioctl(mFileDesc, VIDIOC_G_CTRL, &control_s) == 0)
         res = (int) control_s.value;
 
     return res;
 }
 
-void VideoCapture::setCameraControlSettings(int ctrl_id, int ctrl_val) {
+int VideoCapture::setCameraControlSettings(int ctrl_id, int ctrl_val) {
+    TRACE_SCOPE("VIDIOC_S_CTRL");
+
     struct v4l2_control control_s;
     struct v4l2_queryctrl queryctrl;
     memset(&queryctrl, 0, sizeof (queryctrl));
@@ -1482,7 +2054,7 @@ void VideoCapture::setCameraControlSettings(int ctrl_id, int ctrl_val) {
 
     //std::cerr << "[setCameraControlSettings] '" << mDevName << "' [" << mDevId << "] - mFileDesc: " << mFileDesc << std::endl;
 
-    int res = ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl);
+    int res = mIO->ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl);
     if (0 == res) {
         min = queryctrl.minimum;
         max = queryctrl.maximum;
@@ -1506,10 +2078,11 @@ void VideoCapture::setCameraControlSettings(int ctrl_id, int ctrl_val) {
         control_s.value = ctrl_val;
 
 
-        if (ioctl(mFileDesc, VIDIOC_S_CTRL, &control_s) == 0)
-            return;
-    } else
-        return;
+        if (mIO->ioctl(mFileDesc, VIDIOC_S_CTRL, &control_s) == 0)
+            return 0;
+    }
+
+    return -1;
 }
 
 void VideoCapture::resetCameraControlSettings(int ctrl_id) {
@@ -1521,12 +2094,12 @@ void VideoCapture::resetCameraControlSettings(int ctrl_id) {
     int val_def;
     // save_controls(fd);
     queryctrl.id = ctrl_id;
-    ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl);
+    mIO->ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl);
     val_def = queryctrl.default_value;
 
     control_s.id = ctrl_id;
     control_s.value = val_def;
-    ioctl(mFileDesc, VIDIOC_S_CTRL, &control_s);
+    mIO->ioctl(mFileDesc, VIDIOC_S_CTRL, &control_s);
     return;
 }
 
@@ -1720,7 +2293,7 @@ void VideoCapture::resetAECAGC()
     setAECAGC(true);
 }
 
-bool VideoCapture::setROIforAECAGC(CAM_SENS_POS side, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+bool VideoCapture::checkROIforAECAGC(CAM_SENS_POS side, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
 {
     if(side!=CAM_SENS_POS::LEFT && side!=CAM_SENS_POS::RIGHT)
     {
@@ -1739,6 +2312,16 @@ bool VideoCapture::setROIforAECAGC(CAM_SENS_POS side, uint16_t x, uint16_t y, ui
         return false;
     }
 
+    return true;
+}
+
+bool VideoCapture::setROIforAECAGC(CAM_SENS_POS side, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    if(!checkROIforAECAGC(side, x, y, w, h))
+    {
+        return false;
+    }
+
     int x_start_high = x / 256;
     int x_start_low = (x - x_start_high * 256);
     int y_start_high = y / 256;
@@ -1810,41 +2393,57 @@ void VideoCapture::setGain(CAM_SENS_POS cam, int gain)
     else if (gain >= DEFAULT_MAX_GAIN)
         gain = DEFAULT_MAX_GAIN;
 
-    uint8_t ucGainH=0, ucGainM=0, ucGainL=0;
-
     int rawGain = calcRawGainValue(gain);
 
     int sensorId = static_cast<int>(cam);
+    setRawGain(sensorId, rawGain);
+}
+
+int VideoCapture::setRawGain(int sensorId, int rawGain)
+{
+    uint8_t ucGainH=0, ucGainM=0, ucGainL=0;
 
     ucGainM = (rawGain >> 8) & 0xff;
     ucGainL = rawGain & 0xff;
-    ll_isp_set_gain(ucGainH, ucGainM, ucGainL, sensorId);
-
+    return ll_isp_set_gain(ucGainH, ucGainM, ucGainL, sensorId);
 }
 
-int VideoCapture::getGain(CAM_SENS_POS cam)
+int VideoCapture::getRawGain(int sensorId)
 {
-    int rawGain=0;
-
     uint8_t val[3];
     memset(val, 0, 3);
 
-    int sensorId = static_cast<int>(cam);
     int r = ll_isp_get_gain(val, sensorId);
     if(r<0)
         return r;
 
-    rawGain = (int) ((val[1] << 8) + val[0]);
+    return (int) ((val[1] << 8) + val[0]);
+}
+
+int VideoCapture::getGain(CAM_SENS_POS cam)
+{
+    int rawGain = getRawGain(static_cast<int>(cam));
+    if(rawGain<0)
+        return rawGain;
+
     return calcGainValue(rawGain);
 }
 
 void VideoCapture::setExposure(CAM_SENS_POS cam, int exposure)
 {
-    unsigned char ucExpH, ucExpM, ucExpL;
-
     if(getAECAGC())
         setAECAGC(false);
 
+    int rawExp = calcRawExposureValue(exposure);
+
+    //std::cout << "Set Raw Exp: " << rawExp << std::endl;
+
+    int sensorId = static_cast<int>(cam);
+    setRawExposure(sensorId, rawExp);
+}
+
+int VideoCapture::calcRawExposureValue(int exposure)
+{
     if(exposure < DEFAULT_MIN_EXP)
         exposure = DEFAULT_MIN_EXP;
     if(exposure > DEFAULT_MAX_EXP)
@@ -1854,29 +2453,36 @@ void VideoCapture::setExposure(CAM_SENS_POS cam, int exposure)
     if(rawExp<EXP_RAW_MIN)
         rawExp = EXP_RAW_MIN;
 
-    //std::cout << "Set Raw Exp: " << rawExp << std::endl;
+    return rawExp;
+}
 
-    int sensorId = static_cast<int>(cam);
+int VideoCapture::setRawExposure(int sensorId, int rawExp)
+{
+    unsigned char ucExpH, ucExpM, ucExpL;
 
     ucExpH = (rawExp >> 12) & 0xff;
     ucExpM = (rawExp >> 4) & 0xff;
     ucExpL = (rawExp << 4) & 0xf0;
-    ll_isp_set_exposure(ucExpH, ucExpM, ucExpL, sensorId);
+    return ll_isp_set_exposure(ucExpH, ucExpM, ucExpL, sensorId);
 }
 
-int VideoCapture::getExposure(CAM_SENS_POS cam)
+int VideoCapture::getRawExposure(int sensorId)
 {
-    int rawExp=0;
-
     unsigned char val[3];
     memset(val, 0, 3);
 
-    int sensorId = static_cast<int>(cam);
-
     int r = ll_isp_get_exposure(val, sensorId);
     if(r<0)
         return r;
-    rawExp = (int) ((val[2] << 12) + (val[1] << 4) + (val[0] >> 4));
+
+    return (int) ((val[2] << 12) + (val[1] << 4) + (val[0] >> 4));
+}
+
+int VideoCapture::getExposure(CAM_SENS_POS cam)
+{
+    int rawExp = getRawExposure(static_cast<int>(cam));
+    if(rawExp<0)
+        return rawExp;
 
     //std::cout << "Get Raw Exp: " << rawExp << std::endl;
 
@@ -1935,81 +2541,313 @@ int VideoCapture::calcGainValue(int rawGain)
     return gain;
 }
 
-#ifdef SENSOR_LOG_AVAILABLE
-bool VideoCapture::enableAecAgcSensLogging(bool enable, int frame_skip/*=10*/)
+bool VideoCapture::captureSettings(CameraSettings& settings)
 {
-    if(!enable)
+    const std::lock_guard<std::mutex> lock(mSettingsMutex);
+    return readSettings(settings);
+}
+
+bool VideoCapture::readSettings(CameraSettings& settings, RawSettings* raw)
+{
+    if(!mInitialized)
+        return false;
+
+    CameraSettings cur;
+    cur.serial_number = mSerialNumber;
+
+    cur.brightness = getCameraControlSettings(LINUX_CTRL_BRIGHTNESS);
+    cur.contrast = getCameraControlSettings(LINUX_CTRL_CONTRAST);
+    cur.hue = getCameraControlSettings(LINUX_CTRL_HUE);
+    cur.saturation = getCameraControlSettings(LINUX_CTRL_SATURATION);
+    cur.sharpness = getCameraControlSettings(LINUX_CTRL_SHARPNESS);
+    cur.gamma = getCameraControlSettings(LINUX_CTRL_GAMMA);
+    cur.auto_white_balance = getCameraControlSettings(LINUX_CTRL_AWB_AUTO);
+    cur.white_balance = getCameraControlSettings(LINUX_CTRL_AWB);
+
+    if(cur.brightness<0 || cur.contrast<0 || cur.hue<0 || cur.saturation<0 || cur.sharpness<0 ||
+            cur.gamma<0 || cur.auto_white_balance<0 || cur.white_balance<0)
+        return false;
+    cur.auto_white_balance = (cur.auto_white_balance!=0)?1:0;
+
+    int aecL = ll_isp_is_aecagc(0);
+    int aecR = ll_isp_is_aecagc(1);
+    if(aecL<0 || aecR<0)
+        return false;
+    cur.aec_agc = (aecL && aecR)?1:0;
+
+    RawSettings cur_raw;
+    cur_raw.aec_agc[0] = aecL?1:0;
+    cur_raw.aec_agc[1] = aecR?1:0;
+
+    for(int s=0; s<2; s++)
+    {
+        CAM_SENS_POS side = static_cast<CAM_SENS_POS>(s);
+        if(!getROIforAECAGC(side, cur.roi[s].x, cur.roi[s].y, cur.roi[s].w, cur.roi[s].h))
+            return false;
+
+        cur_raw.gain[s] = getRawGain(s);
+        cur_raw.exposure[s] = getRawExposure(s);
+        if(cur_raw.gain[s]<0 || cur_raw.exposure[s]<0)
+            return false;
+
+        cur.gain[s] = calcGainValue(cur_raw.gain[s]);
+        cur.exposure[s] = static_cast<int>(std::round((100.0*cur_raw.exposure[s])/mExpoureRawMax));
+    }
+
+    settings = cur;
+    if(raw)
+        *raw = cur_raw;
+    return true;
+}
+
+int VideoCapture::applySettings(const CameraSettings& settings)
+{
+    const std::lock_guard<std::mutex> lock(mSettingsMutex);
+
+    if(settings.serial_number>=0 && settings.serial_number!=mSerialNumber)
     {
-        mLogEnable=false;
-        if(mLogFileLeft.is_open())
+        std::string msg = std::string("The settings of the camera SN") + std::to_string(settings.serial_number) +
+                " cannot be applied to the camera SN" + std::to_string(mSerialNumber);
+        ERROR_OUT(mParams.verbose,msg);
+        return -2;
+    }
+
+    // Only the differences with the current state are written
+    CameraSettings cur;
+    RawSettings cur_raw;
+    if(!readSettings(cur, &cur_raw))
+    {
+        ERROR_OUT(mParams.verbose,"Cannot read the current camera settings");
+        return -1;
+    }
+
+    // ----> Transaction
+    // Each write records how to restore the value read in `cur`. After a failure nothing else is written and the
+    // recorded writes are undone in reverse order. A failed write may be partial, so it is undone too
+    int changed = 0;
+    std::string failed;
+    std::vector<std::function<bool()>> undo;
+
+    auto write = [&](const std::string& name, const std::function<bool()>& apply, const std::function<bool()>& restore)
+    {
+        if(!failed.empty())
+            return;
+
+        undo.push_back(restore);
+        if(apply())
+            changed++;
+        else
+            failed = name;
+    };
+    // <---- Transaction
+
+    // ----> Image controls
+    const int ctrlIds[] = {LINUX_CTRL_BRIGHTNESS, LINUX_CTRL_CONTRAST, LINUX_CTRL_HUE,
+                           LINUX_CTRL_SATURATION, LINUX_CTRL_SHARPNESS};
+    const char* ctrlNames[] = {"Brightness", "Contrast", "Hue", "Saturation", "Sharpness"};
+    const int newVals[] = {settings.brightness, settings.contrast, settings.hue,
+                           settings.saturation, settings.sharpness};
+    const int curVals[] = {cur.brightness, cur.contrast, cur.hue,
+                           cur.saturation, cur.sharpness};
+
+    for(size_t i=0; i<sizeof(ctrlIds)/sizeof(int); i++)
+    {
+        if(newVals[i]>=0 && newVals[i]!=curVals[i])
         {
-            mLogFileLeft.close();
+            const int id = ctrlIds[i];
+            const int newVal = newVals[i];
+            const int curVal = curVals[i];
+            write(ctrlNames[i],
+                  [this,id,newVal]{return setCameraControlSettings(id, newVal)==0;},
+                  [this,id,curVal]{return setCameraControlSettings(id, curVal)==0;});
         }
-        if(mLogFileRight.is_open())
+    }
+
+    if(settings.gamma>=0 && settings.gamma!=cur.gamma)
+    {
+        auto writeGamma = [this](int gamma) {
+            return setGammaPreset(0,gamma)==0 && setGammaPreset(1,gamma)==0 &&
+                    setCameraControlSettings(LINUX_CTRL_GAMMA, gamma)==0;
+        };
+        write("Gamma", [&]{return writeGamma(settings.gamma);}, [writeGamma,cur]{return writeGamma(cur.gamma);});
+    }
+    // <---- Image controls
+
+    // ----> White Balance
+    int awb = (settings.auto_white_balance>=0)?settings.auto_white_balance:cur.auto_white_balance;
+
+    auto writeAwbAuto = [this](int active) {
+        return setCameraControlSettings(LINUX_CTRL_AWB_AUTO, active)==0;
+    };
+
+    if(awb==0 && cur.auto_white_balance!=0)
+    {
+        write("automatic White Balance", [&]{return writeAwbAuto(0);}, [writeAwbAuto]{return writeAwbAuto(1);});
+    }
+    if(awb==0 && settings.white_balance>=0 && settings.white_balance!=cur.white_balance)
+    {
+        const int curWb = cur.white_balance;
+        write("White Balance",
+              [&]{return setCameraControlSettings(LINUX_CTRL_AWB, settings.white_balance)==0;},
+              [this,curWb]{return setCameraControlSettings(LINUX_CTRL_AWB, curWb)==0;});
+    }
+    if(awb!=0 && cur.auto_white_balance==0)
+    {
+        write("automatic White Balance", [&]{return writeAwbAuto(1);}, [writeAwbAuto]{return writeAwbAuto(0);});
+    }
+    // <---- White Balance
+
+    // ----> Exposure and Gain
+    // The ROIs are written before enabling the automatic mode, so that it starts with the right metering
+    for(int s=0; s<2; s++)
+    {
+        if(settings.roi[s].w>0 && settings.roi[s]!=cur.roi[s])
         {
-            mLogFileRight.close();
+            const CAM_SENS_POS side = static_cast<CAM_SENS_POS>(s);
+            const AecAgcRoi newRoi = settings.roi[s];
+            const AecAgcRoi curRoi = cur.roi[s];
+            if(!checkROIforAECAGC(side, newRoi.x, newRoi.y, newRoi.w, newRoi.h))
+            {
+                WARNING_OUT(mParams.verbose,"Invalid AEC/AGC ROI ignored");
+                continue;
+            }
+            write("AEC/AGC ROI",
+                  [this,side,newRoi]{return setROIforAECAGC(side, newRoi.x, newRoi.y, newRoi.w, newRoi.h);},
+                  [this,side,curRoi]{return setROIforAECAGC(side, curRoi.x, curRoi.y, curRoi.w, curRoi.h);});
         }
-        return true;
     }
 
-    mLogFrameSkip = frame_skip;
+    int aec = (settings.aec_agc>=0)?settings.aec_agc:cur.aec_agc;
 
-    mLogFilenameLeft = getCurrentDateTime(DATE);
-    mLogFilenameLeft += "_";
-    mLogFilenameLeft += getCurrentDateTime(TIME);
-    mLogFilenameLeft += "_agc_aec_registers-LEFT.csv";
+    // The mode of each sensor is restored: they can differ
+    auto restoreAec = [this,cur_raw] {
+        return ll_isp_aecagc_enable(0, cur_raw.aec_agc[0]!=0)==0 && ll_isp_aecagc_enable(1, cur_raw.aec_agc[1]!=0)==0;
+    };
 
-    mLogFilenameRight = getCurrentDateTime(DATE);
-    mLogFilenameRight += "_";
-    mLogFilenameRight += getCurrentDateTime(TIME);
-    mLogFilenameRight += "_agc_aec_registers-RIGHT.csv";
-
-    mLogFileLeft.open(mLogFilenameLeft, std::ofstream::out );
-    mLogFileRight.open(mLogFilenameRight, std::ofstream::out );
+    if(aec==0)
+    {
+        // A single sensor in automatic mode is read as `aec_agc=0`: the manual mode must still be written
+        const bool mixed = (cur_raw.aec_agc[0]!=cur_raw.aec_agc[1]);
+        if(cur.aec_agc!=0 || (mixed && settings.aec_agc==0))
+        {
+            write("AEC/AGC mode", [this]{return setAECAGC(false)==0;}, restoreAec);
+        }
 
-    if(mLogFileLeft.bad())
+        if(mAeEnabled)
+        {
+            WARNING_OUT(mParams.verbose,"Gain and Exposure are not applied while the host auto exposure is enabled");
+        }
+        else
+        {
+            for(int s=0; s<2; s++)
+            {
+                if(settings.gain[s]>=0 && settings.gain[s]!=cur.gain[s])
+                {
+                    // The register value read is restored, not the rounded [0,100] value
+                    const int newRaw = calcRawGainValue(std::max(DEFAULT_MIN_GAIN, std::min(DEFAULT_MAX_GAIN, settings.gain[s])));
+                    const int curRaw = cur_raw.gain[s];
+                    write("Gain",
+                          [this,s,newRaw]{return setRawGain(s, newRaw)==0;},
+                          [this,s,curRaw]{return setRawGain(s, curRaw)==0;});
+                }
+                if(settings.exposure[s]>=0 && settings.exposure[s]!=cur.exposure[s])
+                {
+                    const int newRaw = calcRawExposureValue(settings.exposure[s]);
+                    const int curRaw = cur_raw.exposure[s];
+                    write("Exposure",
+                          [this,s,newRaw]{return setRawExposure(s, newRaw)==0;},
+                          [this,s,curRaw]{return setRawExposure(s, curRaw)==0;});
+                }
+            }
+        }
+    }
+    else if(cur.aec_agc==0)
     {
-        std::cerr << "Logging not started. Error creating the log file: '" << mLogFilenameLeft << "'" << std::endl;
-        mLogEnable = false;
-        return false;
+        write("AEC/AGC mode", [this]{return setAECAGC(true)==0;}, restoreAec);
     }
+    // <---- Exposure and Gain
 
-    if(mLogFileRight.bad())
+    // ----> Rollback
+    if(!failed.empty())
     {
-        std::cerr << "Logging not started. Error creating the log file: '" << mLogFilenameRight << "'" << std::endl;
-        mLogEnable = false;
-        mLogFileLeft.close();
-        return false;
+        bool restored = true;
+        for(auto it=undo.rbegin(); it!=undo.rend(); ++it)
+        {
+            if(!(*it)())
+                restored = false;
+        }
+
+        std::string msg = std::string("Cannot write the ") + failed + std::string(" control: ") +
+                (restored?std::string("the previous settings have been restored"):
+                          std::string("the previous settings cannot be fully restored"));
+        ERROR_OUT(mParams.verbose,msg);
+        return restored?-3:-4;
     }
+    // <---- Rollback
 
-    mLogFileLeft << "TIMESTAMP" << LOG_SEP;
-    mLogFileLeft << "OV580-ISP_EN_HIGH" << LOG_SEP;
-    mLogFileLeft << "OV580-yavg_low" << LOG_SEP;
-    mLogFileLeft << "OV580-yavg_high" << LOG_SEP;
-    mLogFileLeft << "OV580-interrupt_ctrl1";
+    return changed;
+}
+
+// Approximate linear gain of a raw gain value: each gain zone doubles the gain of the previous one
+static double rawGainToLinear(int rawGain)
+{
+    const int zones[4][2] = {{GAIN_ZONE1_MIN,GAIN_ZONE1_MAX},{GAIN_ZONE2_MIN,GAIN_ZONE2_MAX},
+                             {GAIN_ZONE3_MIN,GAIN_ZONE3_MAX},{GAIN_ZONE4_MIN,GAIN_ZONE4_MAX}};
 
-    mLogFileRight << "TIMESTAMP" << LOG_SEP;
-    mLogFileRight << "OV580-ISP_EN_HIGH" << LOG_SEP;
-    mLogFileRight << "OV580-yavg_low" << LOG_SEP;
-    mLogFileRight << "OV580-yavg_high" << LOG_SEP;
-    mLogFileRight << "OV580-interrupt_ctrl1";
+    for(int z=3; z>=0; z--)
+    {
+        if(rawGain>=zones[z][0])
+        {
+            double frac = static_cast<double>(std::min(rawGain,zones[z][1])-zones[z][0])/(zones[z][1]-zones[z][0]+1);
+            return static_cast<double>(1<<z)*(1.0+frac);
+        }
+    }
+    return 1.0;
+}
 
-    for (int addr = 0x00; addr <= 0x22; ++addr)
+#ifdef SENSOR_LOG_AVAILABLE
+bool VideoCapture::enableAecAgcSensLogging(bool enable, int frame_skip/*=10*/)
+{
+    // ----> Stop the current logger
+    RegisterLogger* logger;
     {
-        mLogFileLeft << LOG_SEP << "OV580-YAVG[0x" << std::hex << std::setfill('0') << std::setw(2) << addr << "]";
-        mLogFileRight << LOG_SEP << "OV580-YAVG[0x" << std::hex << std::setfill('0') << std::setw(2) << addr << "]";
+        const std::lock_guard<std::mutex> lock(mBufMutex);
+        logger = mRegLogger;
+        mRegLogger = nullptr;
+        mLogEnable = false;
     }
 
-    for (int addr = 0x3500; addr <= 0x3515; ++addr)
+    if(logger)
     {
-        mLogFileLeft << LOG_SEP << "OV4689-GAIN_EXP[0x" << std::hex << std::setfill('0') << std::setw(4) << addr << "]";
-        mLogFileRight << LOG_SEP << "OV4689-GAIN_EXP[0x" << std::hex << std::setfill('0') << std::setw(4) << addr << "]";
+        // The pending requests are processed before closing the file
+        logger->stop();
+        delete logger;
     }
+    // <---- Stop the current logger
 
-    mLogFileLeft << std::endl;
-    mLogFileRight << std::endl;
+    if(!enable)
+        return true;
 
+    mLogFilename = getCurrentDateTime(DATE);
+    mLogFilename += "_";
+    mLogFilename += getCurrentDateTime(TIME);
+    mLogFilename += "_agc_aec_registers.bin";
+
+    logger = new RegisterLogger(mParams.verbose);
+    if(!logger->start(mLogFilename, mSerialNumber,
+                      [this](int side, uint8_t* values){return readLogRegisters(side, values);}))
+    {
+        std::cerr << "Logging not started. Error creating the log file: '" << mLogFilename << "'" << std::endl;
+        delete logger;
+        return false;
+    }
+
+    const std::lock_guard<std::mutex> lock(mBufMutex);
+    mLogFrameSkip = std::max(1, frame_skip);
+    mLogFrameCount = 0;
+    mRegLogger = logger;
     mLogEnable = true;
+
     return true;
 }
 
@@ -2067,85 +2905,479 @@ void VideoCapture::saveAllSensorsRegisters(std::string filename)
     logFile.close();
 }
 
-void VideoCapture::saveLogDataLeft()
+int VideoCapture::readLogRegisters(int side, uint8_t* values)
 {
-    const int reg_count = 61;
-    uint8_t values[reg_count];
+    const uint64_t isp_base = (side==0)?0x80181000:0x80181800;
     int idx = 0;
 
     int res = 0;
-    res += ll_read_system_register( 0x80181002, &values[idx++]);
-    res += ll_read_system_register( 0x80181031, &values[idx++]);
-    res += ll_read_system_register( 0x80181032, &values[idx++]);
-    res += ll_read_system_register( 0x80181033, &values[idx++]);
+    res += ll_read_system_register( isp_base+0x02, &values[idx++]);
+    res += ll_read_system_register( isp_base+0x31, &values[idx++]);
+    res += ll_read_system_register( isp_base+0x32, &values[idx++]);
+    res += ll_read_system_register( isp_base+0x33, &values[idx++]);
 
     for(int reg_addr = 0x00; reg_addr <= 0x22; ++reg_addr)
     {
-        uint64_t addr = 0x801810C0+reg_addr;
+        uint64_t addr = isp_base+0xC0+reg_addr;
         res += ll_read_system_register( addr, &values[idx++]);
     }
 
     for (int addr = 0x3500; addr <= 0x3515; ++addr)
     {
-        res += ll_read_sensor_register( 0, 1, addr, &values[idx++]);
+        res += ll_read_sensor_register( side, 1, addr, &values[idx++]);
     }
 
-    mLogFileLeft << std::dec << mLastFrame.timestamp << LOG_SEP;
-    for(int i=0; i<reg_count; i++)
+    return res;
+}
+
+bool VideoCapture::resetAGCAECregisters() {
+    int res = 0;
+
+    res += ll_write_sensor_register( 0, 1, 0x3503, 0x04);
+    res += ll_write_sensor_register( 1, 1, 0x3503, 0x04);
+    res += ll_write_sensor_register( 0, 1, 0x3505, 0x00);
+    res += ll_write_sensor_register( 1, 1, 0x3505, 0x00);
+
+    return res==0;
+}
+#endif
+
+bool VideoCapture::enableShmPublisher(std::string name, uint8_t slot_count)
+{
+    if(!mInitialized)
     {
-        mLogFileLeft << "0x" << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(values[i]);
-        if(i==(reg_count-1))
-            mLogFileLeft << std::endl;
-        else
-            mLogFileLeft << LOG_SEP;
+        ERROR_OUT(mParams.verbose,"The camera must be initialized before enabling the shared memory publisher");
+        return false;
     }
+
+    if(name.empty())
+        name = std::string("/zed_oc_") + std::to_string(mSerialNumber);
+
+    ShmFramePublisher* pub = new ShmFramePublisher(mParams.verbose);
+    if(!pub->create(name, mFrameWidth, mHeight, mChannels, mSerialNumber, slot_count))
+    {
+        delete pub;
+        return false;
+    }
+
+    // The previous publisher is destroyed out of the lock, not to stall the grabbing thread
+    mPubMutex.lock();
+    std::swap(mShmPub, pub);
+    mPubMutex.unlock();
+
+    delete pub;
+
+    return true;
 }
 
-void VideoCapture::saveLogDataRight()
+void VideoCapture::disableShmPublisher()
 {
-    const int reg_count = 61;
-    uint8_t values[reg_count];
-    int idx = 0;
+    mPubMutex.lock();
+    ShmFramePublisher* pub = mShmPub;
+    mShmPub = nullptr;
+    mPubMutex.unlock();
 
-    int res = 0;
-    res += ll_read_system_register( 0x80181802, &values[idx++]);
-    res += ll_read_system_register( 0x80181831, &values[idx++]);
-    res += ll_read_system_register( 0x80181832, &values[idx++]);
-    res += ll_read_system_register( 0x80181833, &values[idx++]);
+    delete pub;
+}
 
-    for(int reg_addr = 0x00; reg_addr <= 0x22; ++reg_addr)
+bool VideoCapture::enableFrameServer(std::string socket_path, FrameServerParams params)
+{
+    if(!mInitialized)
     {
-        uint64_t addr = 0x801818C0+reg_addr;
-        res += ll_read_system_register( addr, &values[idx++]);
+        ERROR_OUT(mParams.verbose,"The camera must be initialized before enabling the frame server");
+        return false;
     }
 
-    for (int addr = 0x3500; addr <= 0x3515; ++addr)
+    if(socket_path.empty())
+        socket_path = std::string("/tmp/zed_oc_") + std::to_string(mSerialNumber) + ".sock";
+
+    FrameServer* srv = new FrameServer(params);
+    if(!srv->start(socket_path, mFrameWidth, mHeight, mChannels, mSerialNumber))
+    {
+        delete srv;
+        return false;
+    }
+
+    // The previous server thread is joined out of the lock, not to stall the grabbing thread
+    mPubMutex.lock();
+    std::swap(mFrameSrv, srv);
+    mPubMutex.unlock();
+
+    delete srv;
+
+    return true;
+}
+
+void VideoCapture::disableFrameServer()
+{
+    mPubMutex.lock();
+    FrameServer* srv = mFrameSrv;
+    mFrameSrv = nullptr;
+    mPubMutex.unlock();
+
+    delete srv;
+}
+
+int VideoCapture::addOutput(const OutputParams& params)
+{
+    if(!mInitialized)
     {
-        res += ll_read_sensor_register( 1, 1, addr, &values[idx++]);
+        ERROR_OUT(mParams.verbose,"The camera must be initialized before adding an output");
+        return -1;
     }
 
-    mLogFileRight << std::dec << mLastFrame.timestamp << LOG_SEP;
-    for(int i=0; i<reg_count; i++)
+    std::shared_ptr<FrameOutput> output = std::make_shared<FrameOutput>();
+    if(!output->configure(params, mFrameWidth, mHeight))
     {
-        mLogFileRight << "0x" << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(values[i]);
-        if(i==(reg_count-1))
-            mLogFileRight << std::endl;
-        else
-            mLogFileRight << LOG_SEP;
+        ERROR_OUT(mParams.verbose,"Invalid output parameters");
+        return -1;
     }
+
+    const std::lock_guard<std::mutex> lock(mOutMutex);
+    int id = mNextOutputId++;
+    mOutputs[id] = output;
+
+    return id;
 }
 
-bool VideoCapture::resetAGCAECregisters() {
-    int res = 0;
+void VideoCapture::removeOutput(int id)
+{
+    const std::lock_guard<std::mutex> lock(mOutMutex);
+    mOutputs.erase(id);
+}
 
-    res += ll_write_sensor_register( 0, 1, 0x3503, 0x04);
-    res += ll_write_sensor_register( 1, 1, 0x3503, 0x04);
-    res += ll_write_sensor_register( 0, 1, 0x3505, 0x00);
-    res += ll_write_sensor_register( 1, 1, 0x3505, 0x00);
+bool VideoCapture::getOutputFrame(int id, OutputFrame& frame, uint64_t timeout_msec)
+{
+    std::shared_ptr<FrameOutput> output;
+    {
+        const std::lock_guard<std::mutex> lock(mOutMutex);
+        auto it = mOutputs.find(id);
+        if(it==mOutputs.end())
+            return false;
+        output = it->second;
+    }
 
-    return res==0;
+    // The output is kept alive by the shared pointer if it is removed while waiting
+    return output->getFrame(frame, timeout_msec);
+}
+
+bool VideoCapture::enableTimingAnalysis(size_t window)
+{
+    if(!mInitialized)
+    {
+        ERROR_OUT(mParams.verbose,"The camera must be initialized before enabling the timing analysis");
+        return false;
+    }
+
+    mTimingEnabled = false;
+    mTiming.reset(window);
+    mTiming.setNominalPeriod(mFps>0?(1000000000ULL/mFps):0);
+    mTimingEnabled = true;
+
+    return true;
+}
+
+bool VideoCapture::enableFrameStats(const FrameStatsParams& params)
+{
+    if(!mInitialized)
+    {
+        ERROR_OUT(mParams.verbose,"The camera must be initialized before enabling the frame statistics");
+        return false;
+    }
+
+    const std::lock_guard<std::mutex> lock(mBufMutex);
+    if(!mStatsCalc.configure(params, mWidth, mHeight, getCapturedEye()))
+    {
+        ERROR_OUT(mParams.verbose,"Invalid frame statistics parameters");
+        return false;
+    }
+    mStatsParams = params;
+    mStatsEnabled = true;
+
+    return true;
+}
+
+void VideoCapture::disableFrameStats()
+{
+    const std::lock_guard<std::mutex> lock(mBufMutex);
+    mStatsEnabled = false;
+}
+
+uint32_t VideoCapture::setToneCurve(const ToneCurve& curve)
+{
+    const std::lock_guard<std::mutex> lock(mToneMutex);
+    mToneCurve = curve;
+
+    // `0` is reserved for "no curve"
+    if(++mToneCurveCount==0)
+        mToneCurveCount = 1;
+    mToneCurveId.store(mToneCurveCount, std::memory_order_release);
+
+    return mToneCurveCount;
+}
+
+bool VideoCapture::enableHostAutoExposure(const AutoExposureParams& params, const FrameStatsParams& metering)
+{
+    disableHostAutoExposure();
+
+    if(!enableFrameStats(metering))
+        return false;
+
+    std::vector<double> gain_table;
+    for(int g=DEFAULT_MIN_GAIN; g<=DEFAULT_MAX_GAIN; g++)
+        gain_table.push_back(rawGainToLinear(calcRawGainValue(g)));
+
+    float min_exposure = (100.0f*EXP_RAW_MIN)/mExpoureRawMax;
+    size_t roi_count = metering.rois.empty()?1:metering.rois.size();
+    if(!mAeCtrl.configure(params, roi_count, gain_table, min_exposure))
+    {
+        ERROR_OUT(mParams.verbose,"Invalid host auto exposure parameters");
+        return false;
+    }
+
+    // The host controller replaces the firmware control and starts from the current values
+    setAECAGC(false);
+    int exposure = getExposure(CAM_SENS_POS::LEFT);
+    int gain = getGain(CAM_SENS_POS::LEFT);
+    mAeCtrl.setState(exposure>=0?exposure:50, gain>=0?gain:0);
+
+    mAeParams = params;
+    mAeMetering = metering;
+    mAeStatus = mAeCtrl.getStatus();
+    mAeNewStats = false;
+    mAeStop = false;
+    mAeEnabled = true;
+    mAeThread = std::thread(&VideoCapture::aeThreadFunc, this);
+
+    return true;
+}
+
+void VideoCapture::disableHostAutoExposure()
+{
+    mAeEnabled = false;
+
+    {
+        const std::lock_guard<std::mutex> lock(mAeMutex);
+        mAeStop = true;
+    }
+    mAeCond.notify_one();
+
+    if(mAeThread.joinable())
+        mAeThread.join();
+}
+
+bool VideoCapture::getHostAutoExposureStatus(AutoExposureStatus& status)
+{
+    if(!mAeEnabled)
+        return false;
+
+    const std::lock_guard<std::mutex> lock(mAeMutex);
+    status = mAeStatus;
+    return true;
+}
+
+void VideoCapture::notifyAutoExposure(const FrameStats& stats, uint64_t frame_id, uint64_t rx_ts)
+{
+    {
+        const std::lock_guard<std::mutex> lock(mAeMutex);
+        mAeStats = stats;
+        mAeFrameId = frame_id;
+        mAeRxTs = rx_ts;
+        mAeNewStats = true;
+    }
+    mAeCond.notify_one();
+}
+
+void VideoCapture::aeThreadFunc()
+{
+    const uint64_t frame_period = (mFps>0)?(NSEC_PER_SEC/mFps):0;
+    int last_raw_exp = -1;
+    int last_raw_gain = -1;
+    uint64_t settle_until = 0;
+
+    FrameStats stats;
+    while(1)
+    {
+        uint64_t frame_id, rx_ts;
+        {
+            std::unique_lock<std::mutex> lock(mAeMutex);
+            mAeCond.wait(lock, [this]{return mAeNewStats || mAeStop;});
+            if(mAeStop)
+                break;
+            mAeNewStats = false;
+            stats = mAeStats;
+            frame_id = mAeFrameId;
+            rx_ts = mAeRxTs;
+        }
+
+        // The frames captured before the last change is effective are not metered
+        if(frame_id<=settle_until)
+            continue;
+
+        float exposure;
+        int gain;
+        bool changed = mAeCtrl.update(stats, exposure, gain);
+
+        uint64_t latency = 0;
+        if(changed)
+        {
+            TRACE_SCOPE("auto exposure");
+
+            int raw_exp = static_cast<int>(std::round(mExpoureRawMax*exposure/100.0f));
+            raw_exp = std::max(raw_exp, EXP_RAW_MIN);
+            int raw_gain = calcRawGainValue(gain);
+
+            // Only the changed registers are written: each write is a USB control transfer
+            for(int sensor=0; sensor<2; sensor++)
+            {
+                if(raw_exp!=last_raw_exp)
+                    setRawExposure(sensor, raw_exp);
+                if(raw_gain!=last_raw_gain)
+                    setRawGain(sensor, raw_gain);
+            }
+            last_raw_exp = raw_exp;
+            last_raw_gain = raw_gain;
+
+            latency = getMonotonicTimestamp()-rx_ts;
+        }
+
+        const std::lock_guard<std::mutex> lock(mAeMutex);
+        AutoExposureStatus status = mAeCtrl.getStatus();
+        status.overruns = mAeStatus.overruns;
+        status.latency_usec = mAeStatus.latency_usec;
+        if(changed)
+        {
+            settle_until = mAeFrameId + mAeCtrl.getSettleFrames();
+            status.latency_usec = latency*1e-3;
+            if(frame_period!=0 && latency>frame_period)
+                status.overruns++;
+        }
+        mAeStatus = status;
+    }
+}
+
+bool VideoCapture::enableExposureSampler(float rate_hz)
+{
+    if(!mInitialized)
+    {
+        ERROR_OUT(mParams.verbose,"The camera must be initialized before enabling the exposure sampling");
+        return false;
+    }
+
+    if(!(rate_hz>0.0f))
+    {
+        ERROR_OUT(mParams.verbose,"The exposure sampling rate must be positive");
+        return false;
+    }
+
+    if(rate_hz>EXP_SAMPLER_MAX_RATE)
+    {
+        WARNING_OUT(mParams.verbose,std::string("Exposure sampling rate limited to ") +
+                    std::to_string(static_cast<int>(EXP_SAMPLER_MAX_RATE)) + std::string(" Hz"));
+        rate_hz = EXP_SAMPLER_MAX_RATE;
+    }
+
+    disableExposureSampler();
+
+    mExpPeriodUsec = static_cast<uint64_t>(1e6/rate_hz);
+    mExpStop = false;
+    mExpSamplerEnabled = true;
+    mExpThread = std::thread(&VideoCapture::expSamplerThreadFunc, this);
+
+    return true;
+}
+
+void VideoCapture::disableExposureSampler()
+{
+    mExpSamplerEnabled = false;
+
+    {
+        const std::lock_guard<std::mutex> lock(mExpMutex);
+        mExpStop = true;
+    }
+    mExpCond.notify_one();
+
+    if(mExpThread.joinable())
+        mExpThread.join();
+
+    // The grabbing thread may be reading the last sample
+    publishExposureSample(ExposureSample());
+}
+
+void VideoCapture::publishExposureSample(const ExposureSample& sample)
+{
+    // Sequence lock writing: the readers retry while the sequence is odd or has changed
+    mExpSeq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    mExpSample = sample;
+    mExpSeq.fetch_add(1, std::memory_order_release);
+}
+
+bool VideoCapture::getLastExposureSample(ExposureSample& sample)
+{
+    // Sequence lock reading: retry if the sample has been modified while copying it
+    uint32_t seq;
+    do
+    {
+        seq = mExpSeq.load(std::memory_order_acquire);
+        if(seq&1)
+            continue;
+        sample = mExpSample;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while( (seq&1) || seq!=mExpSeq.load(std::memory_order_relaxed) );
+
+    return sample.valid;
+}
+
+void VideoCapture::expSamplerThreadFunc()
+{
+    while(1)
+    {
+        uint64_t start = getMonotonicTimestamp();
+
+        // ----> Register reading
+        ExposureSample sample;
+        sample.frame_id = mGrabbedFrameId.load(std::memory_order_relaxed);
+
+        bool ok = true;
+        for(int sensor=0; sensor<2 && ok; sensor++)
+        {
+            uint8_t val[3] = {0,0,0};
+            ok = ll_isp_get_exposure(val, sensor)>=0;
+            sample.exposure_raw[sensor] = (val[2] << 12) + (val[1] << 4) + (val[0] >> 4);
+            sample.exposure[sensor] = static_cast<int>(std::round((100.0*sample.exposure_raw[sensor])/mExpoureRawMax));
+
+            ok = ok && ll_isp_get_gain(val, sensor)>=0;
+            sample.gain_raw[sensor] = (val[1] << 8) + val[0];
+            sample.gain[sensor] = calcGainValue(sample.gain_raw[sensor]);
+        }
+
+        sample.timestamp_mono = getMonotonicTimestamp();
+        sample.valid = ok;
+        // <---- Register reading
+
+        if(ok)
+            publishExposureSample(sample);
+
+        // ----> Wait for the next period
+        uint64_t elapsed_usec = (getMonotonicTimestamp()-start)/1000;
+        uint64_t wait_usec = (mExpPeriodUsec>elapsed_usec)?(mExpPeriodUsec-elapsed_usec):0;
+
+        std::unique_lock<std::mutex> lock(mExpMutex);
+        if(mExpCond.wait_for(lock, std::chrono::microseconds(wait_usec), [this]{return mExpStop;}))
+            break;
+        // <---- Wait for the next period
+    }
+}
+
+bool VideoCapture::getTimingReport(TimingReport& report)
+{
+    if(!mTimingEnabled)
+        return false;
+
+    report = mTiming.getReport();
+    return true;
 }
-#endif
 
 #ifdef SENSORS_MOD_AVAILABLE
 bool VideoCapture::enableSensorSync( sensors::SensorCapture* sensCap )
@@ -2160,6 +3392,7 @@ bool VideoCapture::enableSensorSync( sensors::SensorCapture* sensCap )
     mSensPtr = sensCap;
 
     mSensPtr->setVideoPtr(this);
+    mSensPtr->setClockSource(mParams.clock_source);
 
     return true;
 }
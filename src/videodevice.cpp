@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "videodevice.hpp"
+
+#include <fstream>
+
+#include <fcntl.h>            // for open
+#include <unistd.h>           // for close
+#include <sys/ioctl.h>        // for ioctl
+#include <sys/mman.h>         // for mmap, munmap
+
+namespace sl_oc {
+
+namespace video {
+
+std::shared_ptr<VideoDeviceIO> V4L2DeviceIO::getInstance()
+{
+    static std::shared_ptr<VideoDeviceIO> instance = std::make_shared<V4L2DeviceIO>();
+    return instance;
+}
+
+bool V4L2DeviceIO::readModalias(const std::string& dev_name, std::string& modalias)
+{
+    std::string name = dev_name;
+    if(name.compare(0, 5, "/dev/")==0)
+        name.erase(0, 5);
+
+    return static_cast<bool>(std::ifstream("/sys/class/video4linux/" + name + "/device/modalias") >> modalias);
+}
+
+int V4L2DeviceIO::stat(const char* path, struct ::stat* st)
+{
+    return ::stat(path, st);
+}
+
+int V4L2DeviceIO::open(const char* path, int flags)
+{
+    return ::open(path, flags, 0);
+}
+
+int V4L2DeviceIO::close(int fd)
+{
+    return ::close(fd);
+}
+
+int V4L2DeviceIO::ioctl(int fd, unsigned long request, void* arg)
+{
+    return ::ioctl(fd, request, arg);
+}
+
+void* V4L2DeviceIO::mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset)
+{
+    return ::mmap(addr, length, prot, flags, fd, offset);
+}
+
+int V4L2DeviceIO::munmap(void* addr, size_t length)
+{
+    return ::munmap(addr, length);
+}
+
+}
+
+}